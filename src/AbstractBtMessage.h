@@ -98,6 +98,8 @@ public:
 
   void setUploading(bool uploading) { uploading_ = uploading; }
 
+  virtual size_t getUploadLength() CXX11_OVERRIDE { return 0; }
+
   cuid_t getCuid() const { return cuid_; }
 
   void setCuid(cuid_t cuid) { cuid_ = cuid; }
@@ -263,7 +263,13 @@ bool AbstractCommand::execute()
         size_t maxSegments = req_ ? req_->getMaxPipelinedRequest() : 1;
         size_t minSplitSize = calculateMinSplitSize();
         while (segments_.size() < maxSegments) {
-          auto segment = sm->getSegment(getCuid(), minSplitSize);
+          // Pipelined requests ask for the consecutive segments if
+          // possible.
+          auto segment =
+              segments_.empty()
+                  ? sm->getSegment(getCuid(), minSplitSize)
+                  : sm->getNextSegment(getCuid(), segments_.back(),
+                                       minSplitSize);
           if (!segment) {
             break;
           }
@@ -765,18 +771,30 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     return hostname;
   }
 
+  auto& dnsCache = e_->getDNSCache();
   e_->findAllCachedIPAddresses(std::back_inserter(addrs), hostname, port);
   if (!addrs.empty()) {
     auto ipaddr = addrs.front();
     A2_LOG_INFO(fmt(MSG_DNS_CACHE_HIT, getCuid(), hostname.c_str(),
                     strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+    dnsCache->countLookup(true);
     return ipaddr;
   }
+  if (dnsCache->isFailed(hostname, port)) {
+    dnsCache->countLookup(true);
+    // Retry after the cached failure expires, so that the name is
+    // resolved again then, instead of giving up on this URI.
+    req_->setWakeTime(dnsCache->getFailureExpiry(hostname, port));
+    throw DL_RETRY_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
+                           hostname.c_str(), "Failure is cached"),
+                       error_code::NAME_RESOLVE_ERROR);
+  }
 
   std::string ipaddr;
 #ifdef ENABLE_ASYNC_DNS
   if (getOption()->getAsBool(PREF_ASYNC_DNS)) {
     if (!asyncNameResolverMan_->started()) {
+      dnsCache->countLookup(false);
       asyncNameResolverMan_->startAsync(hostname, e_, this);
     }
     switch (asyncNameResolverMan_->getStatus()) {
@@ -786,6 +804,7 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
             ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
             ->setError();
       }
+      dnsCache->putFailure(hostname, port);
       throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                              hostname.c_str(),
                              asyncNameResolverMan_->getLastError().c_str()),
@@ -796,6 +815,7 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     case 1:
       asyncNameResolverMan_->getResolvedAddress(addrs);
       if (addrs.empty()) {
+        dnsCache->putFailure(hostname, port);
         throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                                hostname.c_str(), "No address returned"),
                            error_code::NAME_RESOLVE_ERROR);
@@ -811,7 +831,14 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     if (e_->getOption()->getAsBool(PREF_DISABLE_IPV6)) {
       res.setFamily(AF_INET);
     }
-    res.resolve(addrs, hostname);
+    dnsCache->countLookup(false);
+    try {
+      res.resolve(addrs, hostname);
+    }
+    catch (RecoverableException& e) {
+      dnsCache->putFailure(hostname, port);
+      throw;
+    }
   }
   A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname.c_str(),
                   strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
@@ -35,6 +35,9 @@
 #include "AbstractDiskWriter.h"
 
 #include <unistd.h>
+#ifdef HAVE_PWRITEV
+#include <sys/uio.h>
+#endif // HAVE_PWRITEV
 #ifdef HAVE_MMAP
 #include <sys/mman.h>
 #endif // HAVE_MMAP
@@ -53,6 +56,7 @@
 #include "DownloadFailureException.h"
 #include "error_code.h"
 #include "LogFactory.h"
+#include "SocketCore.h"
 
 namespace aria2 {
 
@@ -261,7 +265,9 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data,
   }
   else {
     ssize_t writtenLength = 0;
+#if defined(__MINGW32__) || !defined(HAVE_PWRITE)
     seek(offset);
+#endif // __MINGW32__ || !HAVE_PWRITE
     while ((size_t)writtenLength < len) {
 #ifdef __MINGW32__
       DWORD nwrite;
@@ -272,12 +278,21 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data,
       else {
         return -1;
       }
-#else  // !__MINGW32__
+#else // !__MINGW32__
       ssize_t ret = 0;
+#ifdef HAVE_PWRITE
+      // pwrite does not need preceding lseek, which saves one system
+      // call per write.
+      while ((ret = a2pwrite(fd_, data + writtenLength, len - writtenLength,
+                             offset + writtenLength)) == -1 &&
+             errno == EINTR)
+        ;
+#else  // !HAVE_PWRITE
       while ((ret = write(fd_, data + writtenLength, len - writtenLength)) ==
                  -1 &&
              errno == EINTR)
         ;
+#endif // !HAVE_PWRITE
       if (ret == -1) {
         return -1;
       }
@@ -300,8 +315,8 @@ ssize_t AbstractDiskWriter::readDataInternal(unsigned char* data, size_t len,
     return readlen;
   }
   else {
-    seek(offset);
 #ifdef __MINGW32__
+    seek(offset);
     DWORD nread;
     if (ReadFile(fd_, data, len, &nread, 0)) {
       return nread;
@@ -309,15 +324,66 @@ ssize_t AbstractDiskWriter::readDataInternal(unsigned char* data, size_t len,
     else {
       return -1;
     }
-#else  // !__MINGW32__
+#else // !__MINGW32__
     ssize_t ret = 0;
+#ifdef HAVE_PREAD
+    while ((ret = a2pread(fd_, data, len, offset)) == -1 && errno == EINTR)
+      ;
+#else  // !HAVE_PREAD
+    seek(offset);
     while ((ret = read(fd_, data, len)) == -1 && errno == EINTR)
       ;
+#endif // !HAVE_PREAD
     return ret;
 #endif // !__MINGW32__
   }
 }
 
+ssize_t AbstractDiskWriter::writeVectorInternal(const a2iovec* iov,
+                                                size_t iovcnt, int64_t offset)
+{
+  size_t total = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    total += iov[i].A2IOVEC_LEN;
+  }
+#if defined(HAVE_PWRITEV) && defined(a2pwritev)
+  if (!mapaddr_) {
+    ssize_t ret;
+    while ((ret = a2pwritev(fd_, iov, iovcnt, offset)) == -1 && errno == EINTR)
+      ;
+    if (ret == -1) {
+      return -1;
+    }
+    // pwritev may write less than requested.  Write the remaining
+    // data one buffer at a time.
+    size_t skip = ret;
+    for (size_t i = 0; i < iovcnt; ++i) {
+      size_t len = iov[i].A2IOVEC_LEN;
+      if (skip >= len) {
+        skip -= len;
+        offset += len;
+        continue;
+      }
+      auto data = reinterpret_cast<const unsigned char*>(iov[i].A2IOVEC_BASE);
+      if (writeDataInternal(data + skip, len - skip, offset + skip) < 0) {
+        return -1;
+      }
+      skip = 0;
+      offset += len;
+    }
+    return total;
+  }
+#endif // HAVE_PWRITEV && a2pwritev
+  for (size_t i = 0; i < iovcnt; ++i) {
+    auto data = reinterpret_cast<const unsigned char*>(iov[i].A2IOVEC_BASE);
+    if (writeDataInternal(data, iov[i].A2IOVEC_LEN, offset) < 0) {
+      return -1;
+    }
+    offset += iov[i].A2IOVEC_LEN;
+  }
+  return total;
+}
+
 void AbstractDiskWriter::seek(int64_t offset)
 {
   assert(offset >= 0);
@@ -425,31 +491,48 @@ void AbstractDiskWriter::ensureMmapWrite(size_t len, int64_t offset)
 #endif // HAVE_MMAP || __MINGW32__
 }
 
-void AbstractDiskWriter::writeData(const unsigned char* data, size_t len,
-                                   int64_t offset)
+void AbstractDiskWriter::throwWriteError(int errNum)
 {
-  ensureMmapWrite(len, offset);
-  if (writeDataInternal(data, len, offset) < 0) {
-    int errNum = fileError();
-    if (
+  if (
 // If the error indicates disk full situation, throw
 // DownloadFailureException and abort download instantly.
 #ifdef __MINGW32__
-        errNum == ERROR_DISK_FULL || errNum == ERROR_HANDLE_DISK_FULL
+      errNum == ERROR_DISK_FULL || errNum == ERROR_HANDLE_DISK_FULL
 #else  // !__MINGW32__
-        errNum == ENOSPC
+      errNum == ENOSPC
 #endif // !__MINGW32__
-        ) {
-      throw DOWNLOAD_FAILURE_EXCEPTION3(
-          errNum,
-          fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
-          error_code::NOT_ENOUGH_DISK_SPACE);
-    }
-    else {
-      throw DL_ABORT_EX3(errNum, fmt(EX_FILE_WRITE, filename_.c_str(),
-                                     fileStrerror(errNum).c_str()),
-                         error_code::FILE_IO_ERROR);
-    }
+      ) {
+    throw DOWNLOAD_FAILURE_EXCEPTION3(
+        errNum,
+        fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
+        error_code::NOT_ENOUGH_DISK_SPACE);
+  }
+  else {
+    throw DL_ABORT_EX3(errNum, fmt(EX_FILE_WRITE, filename_.c_str(),
+                                   fileStrerror(errNum).c_str()),
+                       error_code::FILE_IO_ERROR);
+  }
+}
+
+void AbstractDiskWriter::writeData(const unsigned char* data, size_t len,
+                                   int64_t offset)
+{
+  ensureMmapWrite(len, offset);
+  if (writeDataInternal(data, len, offset) < 0) {
+    throwWriteError(fileError());
+  }
+}
+
+void AbstractDiskWriter::writeDataVector(const a2iovec* iov, size_t iovcnt,
+                                         int64_t offset)
+{
+  size_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].A2IOVEC_LEN;
+  }
+  ensureMmapWrite(len, offset);
+  if (writeVectorInternal(iov, iovcnt, offset) < 0) {
+    throwWriteError(fileError());
   }
 }
 
@@ -458,14 +541,31 @@ ssize_t AbstractDiskWriter::readData(unsigned char* data, size_t len,
 {
   ssize_t ret;
   if ((ret = readDataInternal(data, len, offset)) < 0) {
-    int errNum = fileError();
-    throw DL_ABORT_EX3(errNum, fmt(EX_FILE_READ, filename_.c_str(),
-                                   fileStrerror(errNum).c_str()),
-                       error_code::FILE_IO_ERROR);
+    throwReadError(fileError());
   }
   return ret;
 }
 
+void AbstractDiskWriter::throwReadError(int errNum)
+{
+  throw DL_ABORT_EX3(errNum, fmt(EX_FILE_READ, filename_.c_str(),
+                                 fileStrerror(errNum).c_str()),
+                     error_code::FILE_IO_ERROR);
+}
+
+ssize_t AbstractDiskWriter::sendFile(SocketCore& socket, size_t len,
+                                     int64_t offset)
+{
+#ifdef HAVE_SENDFILE
+  if (fd_ == A2_BAD_FD) {
+    return -1;
+  }
+  return socket.sendFile(fd_, offset, len);
+#else  // !HAVE_SENDFILE
+  return -1;
+#endif // !HAVE_SENDFILE
+}
+
 void AbstractDiskWriter::truncate(int64_t length)
 {
   if (fd_ == A2_BAD_FD) {
@@ -578,4 +678,23 @@ void AbstractDiskWriter::dropCache(int64_t len, int64_t offset)
 #endif // HAVE_POSIX_FADVISE
 }
 
+int AbstractDiskWriter::dupForRead(int64_t offset, size_t len)
+{
+#if defined(HAVE_PREAD) && !defined(__MINGW32__)
+  if (fd_ == A2_BAD_FD) {
+    return -1;
+  }
+  int fd;
+  while ((fd = dup(fd_)) == -1 && errno == EINTR)
+    ;
+  // If the fd runs out, the caller reads the data by itself.
+  if (fd != -1) {
+    util::make_fd_cloexec(fd);
+  }
+  return fd;
+#else  // !HAVE_PREAD || __MINGW32__
+  return -1;
+#endif // !HAVE_PREAD || __MINGW32__
+}
+
 } // namespace aria2
@@ -62,6 +62,9 @@ private:
                             int64_t offset);
   ssize_t readDataInternal(unsigned char* data, size_t len, int64_t offset);
 
+  ssize_t writeVectorInternal(const a2iovec* iov, size_t iovcnt,
+                              int64_t offset);
+
   void seek(int64_t offset);
 
   void ensureMmapWrite(size_t len, int64_t offset);
@@ -69,6 +72,18 @@ private:
 protected:
   void createFile(int addFlags = 0);
 
+  // Throws the exception for the write error errNum.  If errNum
+  // indicates disk full situation, DownloadFailureException is
+  // thrown.
+  void throwWriteError(int errNum);
+
+  // Throws the exception for the read error errNum.
+  void throwReadError(int errNum);
+
+#ifndef __MINGW32__
+  int getFd() const { return fd_; }
+#endif // !__MINGW32__
+
 public:
   AbstractDiskWriter(const std::string& filename);
   virtual ~AbstractDiskWriter();
@@ -85,6 +100,12 @@ public:
   virtual ssize_t readData(unsigned char* data, size_t len,
                            int64_t offset) CXX11_OVERRIDE;
 
+  virtual ssize_t sendFile(SocketCore& socket, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE;
+
   virtual void truncate(int64_t length) CXX11_OVERRIDE;
 
   // File must be opened before calling this function.
@@ -100,6 +121,8 @@ public:
   virtual void enableMmap() CXX11_OVERRIDE;
 
   virtual void dropCache(int64_t len, int64_t offset) CXX11_OVERRIDE;
+
+  virtual int dupForRead(int64_t offset, size_t len) CXX11_OVERRIDE;
 };
 
 } // namespace aria2
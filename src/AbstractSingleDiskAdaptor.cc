@@ -39,6 +39,7 @@
 #include "FileEntry.h"
 #include "TruncFileAllocationIterator.h"
 #include "WrDiskCacheEntry.h"
+#include "FileRegion.h"
 #include "LogFactory.h"
 #ifdef HAVE_SOME_FALLOCATE
 #include "FallocFileAllocationIterator.h"
@@ -82,6 +83,24 @@ ssize_t AbstractSingleDiskAdaptor::readData(unsigned char* data, size_t len,
   return diskWriter_->readData(data, len, offset);
 }
 
+ssize_t AbstractSingleDiskAdaptor::sendFile(SocketCore& socket, size_t len,
+                                            int64_t offset)
+{
+  return diskWriter_->sendFile(socket, len, offset);
+}
+
+bool AbstractSingleDiskAdaptor::getFileRegions(
+    std::vector<FileRegion>& regions, size_t dataOffset, int64_t offset,
+    size_t len)
+{
+  int fd = diskWriter_->dupForRead(offset, len);
+  if (fd == -1) {
+    return false;
+  }
+  regions.emplace_back(fd, offset, len, dataOffset);
+  return true;
+}
+
 ssize_t AbstractSingleDiskAdaptor::readDataDropCache(unsigned char* data,
                                                      size_t len, int64_t offset)
 {
@@ -94,11 +113,39 @@ ssize_t AbstractSingleDiskAdaptor::readDataDropCache(unsigned char* data,
   return rv;
 }
 
-void AbstractSingleDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+void AbstractSingleDiskAdaptor::writeCache(WrDiskCacheEntry* entry)
 {
+  if (diskWriter_->acceptsDataOwnership()) {
+    for (auto& d : entry->getDataSet()) {
+      A2_LOG_DEBUG(
+          fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff, d->len));
+      std::unique_ptr<unsigned char[]> data(d->data);
+      d->data = nullptr;
+      diskWriter_->writeDataOwned(std::move(data), d->offset, d->len, d->goff);
+    }
+    return;
+  }
+  // Adjacent data cells are written by one writeDataVector() call.
+  a2iovec iov[A2_IOV_MAX];
+  size_t iovcnt = 0;
+  int64_t start = 0;
+  int64_t end = 0;
   for (auto& d : entry->getDataSet()) {
     A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff, d->len));
-    writeData(d->data + d->offset, d->len, d->goff);
+    if (iovcnt > 0 && (d->goff != end || iovcnt == A2_IOV_MAX)) {
+      diskWriter_->writeDataVector(iov, iovcnt, start);
+      iovcnt = 0;
+    }
+    if (iovcnt == 0) {
+      start = end = d->goff;
+    }
+    iov[iovcnt].A2IOVEC_BASE = reinterpret_cast<char*>(d->data + d->offset);
+    iov[iovcnt].A2IOVEC_LEN = d->len;
+    ++iovcnt;
+    end += d->len;
+  }
+  if (iovcnt > 0) {
+    diskWriter_->writeDataVector(iov, iovcnt, start);
   }
 }
 
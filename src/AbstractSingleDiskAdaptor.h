@@ -70,7 +70,14 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+  virtual void writeCache(WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+
+  virtual ssize_t sendFile(SocketCore& socket, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  virtual bool getFileRegions(std::vector<FileRegion>& regions,
+                              size_t dataOffset, int64_t offset,
+                              size_t len) CXX11_OVERRIDE;
 
   virtual bool fileExists() CXX11_OVERRIDE;
 
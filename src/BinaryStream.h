@@ -58,6 +58,10 @@ public:
   // default implementation does nothing. If sparse is true, the
   // implementation may create sparse file (with holes).
   virtual void allocate(int64_t offset, int64_t length, bool sparse) {}
+
+  // Waits for the completion of the writes queued by writeData(). The
+  // default implementation does nothing.
+  virtual void flush() {}
 };
 
 } // namespace aria2
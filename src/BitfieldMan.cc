@@ -460,18 +460,15 @@ bool BitfieldMan::getInorderMissingUnusedIndex(
 }
 
 namespace {
-template <typename Array>
-bool copyBitfield(unsigned char* dst, const Array& src, size_t blocks)
+// Clears unused bits in the last byte of bitfield and returns true if
+// bitfield has at least one set bit.
+bool finishMissingBitfield(unsigned char* bitfield, size_t blocks)
 {
-  unsigned char bits = 0;
-  size_t len = (blocks + 7) / 8;
-  for (size_t i = 0; i < len - 1; ++i) {
-    dst[i] = src[i];
-    bits |= dst[i];
+  if (blocks == 0) {
+    return false;
   }
-  dst[len - 1] = src[len - 1] & bitfield::lastByteMask(blocks);
-  bits |= dst[len - 1];
-  return bits != 0;
+  bitfield[(blocks + 7) / 8 - 1] &= bitfield::lastByteMask(blocks);
+  return bitfield::countSetBit(bitfield, blocks) != 0;
 }
 } // namespace
 
@@ -480,12 +477,13 @@ bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield,
 {
   assert(len == bitfieldLength_);
   if (filterEnabled_) {
-    return copyBitfield(misbitfield, ~array(bitfield_) & array(filterBitfield_),
-                        blocks_);
+    memmove(misbitfield, filterBitfield_, len);
   }
   else {
-    return copyBitfield(misbitfield, ~array(bitfield_), blocks_);
+    memset(misbitfield, 0xff, len);
   }
+  bitfield::andNotBits(misbitfield, bitfield_, len);
+  return finishMissingBitfield(misbitfield, blocks_);
 }
 
 bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
@@ -496,15 +494,12 @@ bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
   if (bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
+  memmove(misbitfield, peerBitfield, len);
+  bitfield::andNotBits(misbitfield, bitfield_, len);
   if (filterEnabled_) {
-    return copyBitfield(misbitfield, ~array(bitfield_) & array(peerBitfield) &
-                                         array(filterBitfield_),
-                        blocks_);
-  }
-  else {
-    return copyBitfield(misbitfield, ~array(bitfield_) & array(peerBitfield),
-                        blocks_);
+    bitfield::andBits(misbitfield, filterBitfield_, len);
   }
+  return finishMissingBitfield(misbitfield, blocks_);
 }
 
 bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
@@ -516,17 +511,13 @@ bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
   if (bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
+  memmove(misbitfield, peerBitfield, len);
+  bitfield::andNotBits(misbitfield, bitfield_, len);
+  bitfield::andNotBits(misbitfield, useBitfield_, len);
   if (filterEnabled_) {
-    return copyBitfield(misbitfield,
-                        ~array(bitfield_) & ~array(useBitfield_) &
-                            array(peerBitfield) & array(filterBitfield_),
-                        blocks_);
-  }
-  else {
-    return copyBitfield(misbitfield, ~array(bitfield_) & ~array(useBitfield_) &
-                                         array(peerBitfield),
-                        blocks_);
+    bitfield::andBits(misbitfield, filterBitfield_, len);
   }
+  return finishMissingBitfield(misbitfield, blocks_);
 }
 
 size_t BitfieldMan::countMissingBlock() const { return cachedNumMissingBlock_; }
@@ -535,8 +526,7 @@ size_t BitfieldMan::countMissingBlockNow() const
 {
   if (filterEnabled_) {
     return bitfield::countSetBit(filterBitfield_, blocks_) -
-           bitfield::countSetBitSlow(array(bitfield_) & array(filterBitfield_),
-                                     blocks_);
+           bitfield::countSetBitAnd(bitfield_, filterBitfield_, blocks_);
   }
   else {
     return blocks_ - bitfield::countSetBit(bitfield_, blocks_);
@@ -60,7 +60,10 @@ public:
 
   virtual bool isUploading() = 0;
 
-  uint8_t getId() { return id_; }
+  // Returns the number of bytes of payload this message uploads.
+  virtual size_t getUploadLength() = 0;
+
+  uint8_t getId() const { return id_; }
 
   virtual void doReceivedAction() = 0;
 
@@ -42,6 +42,7 @@
 namespace aria2 {
 
 class BtMessage;
+class BufferSlice;
 class BtHandshakeMessage;
 class BtAllowedFastMessage;
 class BtBitfieldMessage;
@@ -55,6 +56,7 @@ class BtKeepAliveMessage;
 class BtNotInterestedMessage;
 class BtPieceMessage;
 class BtPortMessage;
+class BtPreparedMessage;
 class BtRejectMessage;
 class BtRequestMessage;
 class BtUnchokeMessage;
@@ -105,6 +107,12 @@ public:
 
   virtual std::unique_ptr<BtHaveNoneMessage> createHaveNoneMessage() = 0;
 
+  // Creates the message which sends data, the messages already
+  // serialized in wire format.  id and name are those of the
+  // messages in data.
+  virtual std::unique_ptr<BtPreparedMessage>
+  createPreparedMessage(uint8_t id, const char* name, BufferSlice data) = 0;
+
   virtual std::unique_ptr<BtRejectMessage>
   createRejectMessage(size_t index, int32_t begin, int32_t length) = 0;
 
@@ -0,0 +1,102 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BtPieceHashCheckCommand.h"
+#include "DownloadEngine.h"
+#include "BtRuntime.h"
+#include "BtPieceHashChecker.h"
+#include "RequestGroup.h"
+#include "DownloadFailureException.h"
+#include "Logger.h"
+#include "LogFactory.h"
+#include "message.h"
+
+namespace aria2 {
+
+BtPieceHashCheckCommand::BtPieceHashCheckCommand(cuid_t cuid,
+                                                 RequestGroup* requestGroup,
+                                                 DownloadEngine* e)
+    : Command(cuid), requestGroup_(requestGroup), e_(e), completionFd_(-1)
+{
+  requestGroup_->increaseNumCommand();
+}
+
+BtPieceHashCheckCommand::~BtPieceHashCheckCommand()
+{
+  // Unverified pieces must not be saved in the control file as
+  // in-flight pieces.  The control file is saved after all commands
+  // of the download are gone.
+  if (btRuntime_ && btRuntime_->getPieceHashChecker()) {
+    btRuntime_->getPieceHashChecker()->cancel();
+  }
+  if (completionFd_ != -1) {
+    e_->deleteFdForReadCheck(completionFd_, this);
+  }
+  requestGroup_->decreaseNumCommand();
+}
+
+bool BtPieceHashCheckCommand::execute()
+{
+  if (btRuntime_->isHalt()) {
+    return true;
+  }
+  const auto& checker = btRuntime_->getPieceHashChecker();
+  try {
+    checker->checkFinished();
+  }
+  catch (DownloadFailureException& e) {
+    A2_LOG_ERROR_EX(EX_DOWNLOAD_ABORTED, e);
+    requestGroup_->setLastErrorCode(e.getErrorCode(), e.what());
+    requestGroup_->setHaltRequested(true);
+    e_->setRefreshInterval(std::chrono::milliseconds(0));
+    return true;
+  }
+  e_->addCommand(std::unique_ptr<Command>(this));
+  return false;
+}
+
+void BtPieceHashCheckCommand::setBtRuntime(
+    const std::shared_ptr<BtRuntime>& btRuntime)
+{
+  btRuntime_ = btRuntime;
+  if (completionFd_ != -1) {
+    e_->deleteFdForReadCheck(completionFd_, this);
+  }
+  completionFd_ = btRuntime_->getPieceHashChecker()->getCompletionFd();
+  if (completionFd_ != -1) {
+    e_->addFdForReadCheck(completionFd_, this);
+  }
+}
+
+} // namespace aria2
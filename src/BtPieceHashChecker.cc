@@ -0,0 +1,197 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BtPieceHashChecker.h"
+
+#include <vector>
+
+#include "HashWorkerPool.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "PeerStorage.h"
+#include "Piece.h"
+#include "DiskAdaptor.h"
+#include "WrDiskCacheEntry.h"
+#include "DownloadFailureException.h"
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "message.h"
+#include "fmt.h"
+#include "util.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+BtPieceHashChecker::BtPieceHashChecker(
+    HashWorkerPool* hashWorkerPool, DownloadContext* downloadContext,
+    const std::shared_ptr<PieceStorage>& pieceStorage,
+    const std::shared_ptr<PeerStorage>& peerStorage)
+    : hashWorkerPool_(hashWorkerPool),
+      hashJobGroup_(
+          std::make_shared<HashJobGroup>(downloadContext->getPieceHashType())),
+      downloadContext_(downloadContext),
+      pieceStorage_(pieceStorage),
+      peerStorage_(peerStorage),
+      cancelled_(false)
+{
+}
+
+BtPieceHashChecker::~BtPieceHashChecker() { cancel(); }
+
+bool BtPieceHashChecker::canSubmit() const
+{
+  return !cancelled_ &&
+         entries_.size() < hashWorkerPool_->getNumThreads() * 2;
+}
+
+void BtPieceHashChecker::submit(const std::shared_ptr<Piece>& piece,
+                                cuid_t cuid, const std::string& ipaddr)
+{
+  auto job = make_unique<HashJob>();
+  job->index = piece->getIndex();
+  job->length = piece->getLength();
+  job->data = make_unique<unsigned char[]>(job->length);
+  try {
+    piece->getDataWithWrCache(job->data.get(),
+                              downloadContext_->getPieceLength(),
+                              pieceStorage_->getDiskAdaptor(), &job->reads);
+  }
+  catch (RecoverableException& e) {
+    piece->clearAllBlock(pieceStorage_->getWrDiskCache());
+    throw;
+  }
+  A2_LOG_DEBUG(fmt("Submitted piece for hash check. index=%lu",
+                   static_cast<unsigned long>(piece->getIndex())));
+  entries_[piece->getIndex()] = Entry{piece, cuid, ipaddr};
+  hashWorkerPool_->submit(hashJobGroup_, std::move(job));
+}
+
+int BtPieceHashChecker::getCompletionFd() const
+{
+  return hashJobGroup_->getCompletionFd();
+}
+
+size_t BtPieceHashChecker::checkFinished()
+{
+  // Always collect, so that the completion fd does not stay readable.
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  hashWorkerPool_->collect(*hashJobGroup_, jobs);
+  for (auto& job : jobs) {
+    auto i = entries_.find(job->index);
+    if (i == std::end(entries_)) {
+      continue;
+    }
+    auto entry = std::move((*i).second);
+    entries_.erase(i);
+    if (!entry.piece->pieceComplete()) {
+      // The piece was reset while it was being verified.
+      continue;
+    }
+    if (job->readError) {
+      onReadError(entry, job->getReadErrorString());
+    }
+    else if (job->digest == downloadContext_->getPieceHash(job->index)) {
+      onNewPiece(entry);
+    }
+    else {
+      onWrongPiece(entry);
+    }
+  }
+  return jobs.size();
+}
+
+void BtPieceHashChecker::onNewPiece(const Entry& entry)
+{
+  const auto& piece = entry.piece;
+  if (piece->getWrDiskCacheEntry()) {
+    piece->flushWrCache(pieceStorage_->getWrDiskCache());
+    if (piece->getWrDiskCacheEntry()->getError() !=
+        WrDiskCacheEntry::CACHE_ERR_SUCCESS) {
+      piece->clearAllBlock(pieceStorage_->getWrDiskCache());
+      throw DOWNLOAD_FAILURE_EXCEPTION2(
+          fmt("Write disk cache flush failure index=%lu",
+              static_cast<unsigned long>(piece->getIndex())),
+          piece->getWrDiskCacheEntry()->getErrorCode());
+    }
+  }
+  A2_LOG_INFO(fmt(MSG_GOT_NEW_PIECE, entry.cuid,
+                  static_cast<unsigned long>(piece->getIndex())));
+  pieceStorage_->completePiece(piece);
+  pieceStorage_->advertisePiece(entry.cuid, piece->getIndex(),
+                                global::wallclock());
+}
+
+void BtPieceHashChecker::onWrongPiece(const Entry& entry)
+{
+  const auto& piece = entry.piece;
+  A2_LOG_INFO(fmt(MSG_GOT_WRONG_PIECE, entry.cuid,
+                  static_cast<unsigned long>(piece->getIndex())));
+  piece->clearAllBlock(pieceStorage_->getWrDiskCache());
+  piece->destroyHashContext();
+  pieceStorage_->cancelPiece(piece, entry.cuid);
+  peerStorage_->addBadPeer(entry.ipaddr);
+}
+
+void BtPieceHashChecker::onReadError(const Entry& entry,
+                                     const std::string& error)
+{
+  const auto& piece = entry.piece;
+  A2_LOG_ERROR(fmt("Failed to read piece index=%lu for hash check: %s",
+                   static_cast<unsigned long>(piece->getIndex()),
+                   error.c_str()));
+  piece->clearAllBlock(pieceStorage_->getWrDiskCache());
+  piece->destroyHashContext();
+  pieceStorage_->cancelPiece(piece, entry.cuid);
+}
+
+void BtPieceHashChecker::cancel()
+{
+  if (cancelled_) {
+    return;
+  }
+  cancelled_ = true;
+  hashWorkerPool_->cancel(*hashJobGroup_);
+  for (auto& e : entries_) {
+    const auto& piece = e.second.piece;
+    A2_LOG_DEBUG(fmt("Hash check of piece index=%lu was cancelled.",
+                     static_cast<unsigned long>(piece->getIndex())));
+    piece->clearAllBlock(pieceStorage_->getWrDiskCache());
+    piece->destroyHashContext();
+    pieceStorage_->cancelPiece(piece, e.second.cuid);
+  }
+  entries_.clear();
+}
+
+} // namespace aria2
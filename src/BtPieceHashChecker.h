@@ -0,0 +1,129 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BT_PIECE_HASH_CHECKER_H
+#define D_BT_PIECE_HASH_CHECKER_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+#include <map>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class HashWorkerPool;
+class HashJobGroup;
+class DownloadContext;
+class PieceStorage;
+class PeerStorage;
+class Piece;
+
+// Verifies the hash of the pieces completed during BitTorrent download
+// in HashWorkerPool, so that hashing a large piece does not block
+// DownloadEngine.  The data of the piece on disk is read by the
+// worker threads too if the DiskAdaptor supports it; otherwise it is
+// read in the calling thread.  The results are handled in
+// checkFinished(), which BtPieceHashCheckCommand calls when the
+// completion fd becomes readable: a good piece is completed and
+// advertised to the peers, and a bad piece is cleared and the peer
+// which sent it is banned.  A piece which the worker thread failed to
+// read is cleared without banning the peer.
+class BtPieceHashChecker {
+public:
+  BtPieceHashChecker(HashWorkerPool* hashWorkerPool,
+                     DownloadContext* downloadContext,
+                     const std::shared_ptr<PieceStorage>& pieceStorage,
+                     const std::shared_ptr<PeerStorage>& peerStorage);
+
+  // Calls cancel().
+  ~BtPieceHashChecker();
+
+  // Returns true if submit() can be called now.  This returns false
+  // after cancel() or when the worker threads have enough pieces to
+  // process, to bound the memory used for the piece data.
+  bool canSubmit() const;
+
+  // Submits piece, which must be complete, for verification.  cuid
+  // and ipaddr identify the peer which sent the last block of piece.
+  // If the data cannot be read, the blocks of piece are cleared and
+  // the exception is rethrown.
+  void submit(const std::shared_ptr<Piece>& piece, cuid_t cuid,
+              const std::string& ipaddr);
+
+  // Handles the pieces verified so far and returns the number of
+  // them.  Throws DownloadFailureException if the verified data
+  // cannot be written to the disk.
+  size_t checkFinished();
+
+  // Returns the number of pieces submitted but not handled yet.
+  size_t countPending() const { return entries_.size(); }
+
+  // Returns the file descriptor which becomes readable when
+  // checkFinished() has pieces to handle.
+  int getCompletionFd() const;
+
+  // Discards the pieces not handled yet; their blocks are cleared so
+  // that they are downloaded again.  No piece can be submitted after
+  // this call.
+  void cancel();
+
+private:
+  struct Entry {
+    std::shared_ptr<Piece> piece;
+    cuid_t cuid;
+    std::string ipaddr;
+  };
+
+  void onNewPiece(const Entry& entry);
+
+  void onWrongPiece(const Entry& entry);
+
+  void onReadError(const Entry& entry, const std::string& error);
+
+  HashWorkerPool* hashWorkerPool_;
+  std::shared_ptr<HashJobGroup> hashJobGroup_;
+  DownloadContext* downloadContext_;
+  std::shared_ptr<PieceStorage> pieceStorage_;
+  std::shared_ptr<PeerStorage> peerStorage_;
+  // Pieces being verified, keyed by piece index.
+  std::map<size_t, Entry> entries_;
+  bool cancelled_;
+};
+
+} // namespace aria2
+
+#endif // D_BT_PIECE_HASH_CHECKER_H
@@ -61,6 +61,9 @@
 #include "WrDiskCacheEntry.h"
 #include "DownloadFailureException.h"
 #include "BtRejectMessage.h"
+#ifdef HAVE_STD_THREAD
+#include "BtPieceHashChecker.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -72,8 +75,10 @@ BtPieceMessage::BtPieceMessage(size_t index, int32_t begin, int32_t blockLength)
       begin_(begin),
       blockLength_(blockLength),
       data_(nullptr),
+      blockCapacity_(0),
       downloadContext_(nullptr),
-      peerStorage_(nullptr)
+      peerStorage_(nullptr),
+      pieceHashChecker_(nullptr)
 {
   setUploading(true);
 }
@@ -82,6 +87,21 @@ BtPieceMessage::~BtPieceMessage() = default;
 
 void BtPieceMessage::setMsgPayload(const unsigned char* data) { data_ = data; }
 
+void BtPieceMessage::setBlock(std::unique_ptr<unsigned char[]> block,
+                              size_t capacity)
+{
+  block_ = std::move(block);
+  blockCapacity_ = capacity;
+}
+
+void BtPieceMessage::releaseBlock()
+{
+  auto diskCache = getPieceStorage()->getWrDiskCache();
+  if (block_ && diskCache) {
+    diskCache->releaseBuffer(block_.release(), blockCapacity_);
+  }
+}
+
 std::unique_ptr<BtPieceMessage>
 BtPieceMessage::create(const unsigned char* data, size_t dataLength)
 {
@@ -113,27 +133,57 @@ void BtPieceMessage::doReceivedAction()
                      static_cast<unsigned long>(slot->getBlockIndex())));
     if (piece->hasBlock(slot->getBlockIndex())) {
       A2_LOG_DEBUG("Already have this block.");
+      releaseBlock();
       return;
     }
+    auto block = getBlock();
+    bool hashUpdated = false;
     if (piece->getWrDiskCacheEntry()) {
-      // Write Disk Cache enabled. Unfortunately, it incurs extra data
-      // copy.
-      auto dataCopy = new unsigned char[blockLength_];
-      memcpy(dataCopy, data_ + 9, blockLength_);
-      piece->updateWrCache(getPieceStorage()->getWrDiskCache(), dataCopy, 0,
-                           blockLength_, blockLength_, offset);
+      if (block_) {
+        // The block was received into its own buffer, which is moved
+        // to the cache.  The cache may free it before the call
+        // returns, so update hash first.
+        piece->updateHash(begin_, block, blockLength_);
+        hashUpdated = true;
+        piece->moveWrCache(getPieceStorage()->getWrDiskCache(), offset,
+                           std::move(block_), blockLength_, blockCapacity_);
+      }
+      else {
+        // Write Disk Cache enabled. Unfortunately, it incurs extra
+        // data copy.  The blocks following this one are coalesced
+        // into the same cache buffer.
+        int64_t pieceEnd =
+            static_cast<int64_t>(index_) * downloadContext_->getPieceLength() +
+            piece->getLength();
+        piece->copyWrCache(getPieceStorage()->getWrDiskCache(), offset, block,
+                           blockLength_, pieceEnd - offset);
+      }
     }
     else {
-      getPieceStorage()->getDiskAdaptor()->writeData(data_ + 9, blockLength_,
+      getPieceStorage()->getDiskAdaptor()->writeData(block, blockLength_,
                                                      offset);
     }
+    if (!hashUpdated) {
+      piece->updateHash(begin_, block, blockLength_);
+    }
+    releaseBlock();
     piece->completeBlock(slot->getBlockIndex());
     A2_LOG_DEBUG(fmt(
         MSG_PIECE_BITFIELD, getCuid(),
         util::toHex(piece->getBitfield(), piece->getBitfieldLength()).c_str()));
-    piece->updateHash(begin_, data_ + 9, blockLength_);
     getBtMessageDispatcher()->removeOutstandingRequest(slot);
     if (piece->pieceComplete()) {
+#ifdef HAVE_STD_THREAD
+      // Hashing whole piece is expensive.  Let worker threads do it
+      // if possible.
+      if (pieceHashChecker_ &&
+          (getPieceStorage()->isEndGame() || !piece->isHashCalculated()) &&
+          pieceHashChecker_->canSubmit()) {
+        pieceHashChecker_->submit(piece, getCuid(),
+                                  getPeer()->getIPAddress());
+        return;
+      }
+#endif // HAVE_STD_THREAD
       if (checkPieceHash(piece)) {
         onNewPiece(piece);
       }
@@ -148,6 +198,7 @@ void BtPieceMessage::doReceivedAction()
     A2_LOG_DEBUG(fmt("CUID#%" PRId64
                      " - RequestSlot not found, index=%lu, begin=%d",
                      getCuid(), static_cast<unsigned long>(index_), begin_));
+    releaseBlock();
   }
 }
 
@@ -213,14 +264,29 @@ void BtPieceMessage::send()
 void BtPieceMessage::pushPieceData(int64_t offset, int32_t length) const
 {
   assert(length <= static_cast<int32_t>(MAX_BLOCK_LENGTH));
-  auto buf = std::vector<unsigned char>(length + MESSAGE_HEADER_LENGTH);
+  auto peerConnection = getPeerConnection();
+  if (peerConnection->canPushDiskData()) {
+    // Only the header is copied.  The block is sent from the file
+    // directly when the send buffer reaches it.
+    auto buf = peerConnection->allocateBuffer(MESSAGE_HEADER_LENGTH);
+    createMessageHeader(buf.data());
+    peerConnection->pushBytes(std::move(buf));
+    const auto& peer = getPeer();
+    peerConnection->pushDiskData(
+        getPieceStorage()->getDiskAdaptor(), offset, length,
+        make_unique<PieceSendUpdate>(downloadContext_, peer, 0));
+    peer->updateUploadSpeed(length);
+    downloadContext_->updateUploadSpeed(length);
+    return;
+  }
+  auto buf = peerConnection->allocateBuffer(length + MESSAGE_HEADER_LENGTH);
   createMessageHeader(buf.data());
   ssize_t r;
   r = getPieceStorage()->getDiskAdaptor()->readData(
       buf.data() + MESSAGE_HEADER_LENGTH, length, offset);
   if (r == length) {
     const auto& peer = getPeer();
-    getPeerConnection()->pushBytes(
+    peerConnection->pushBytes(
         std::move(buf), make_unique<PieceSendUpdate>(downloadContext_, peer,
                                                      MESSAGE_HEADER_LENGTH));
     peer->updateUploadSpeed(length);
@@ -330,4 +396,9 @@ void BtPieceMessage::setPeerStorage(PeerStorage* peerStorage)
   peerStorage_ = peerStorage;
 }
 
+void BtPieceMessage::setPieceHashChecker(BtPieceHashChecker* pieceHashChecker)
+{
+  pieceHashChecker_ = pieceHashChecker;
+}
+
 } // namespace aria2
@@ -42,6 +42,7 @@ namespace aria2 {
 class Piece;
 class DownloadContext;
 class PeerStorage;
+class BtPieceHashChecker;
 
 class BtPieceMessage : public AbstractBtMessage {
 private:
@@ -49,8 +50,14 @@ private:
   int32_t begin_;
   int32_t blockLength_;
   const unsigned char* data_;
+  // The block received separately from the message payload.  If
+  // this is not null, data_ only contains the message header.
+  std::unique_ptr<unsigned char[]> block_;
+  // The size of block_
+  size_t blockCapacity_;
   DownloadContext* downloadContext_;
   PeerStorage* peerStorage_;
+  BtPieceHashChecker* pieceHashChecker_;
 
   static size_t MESSAGE_HEADER_LENGTH;
 
@@ -62,6 +69,9 @@ private:
 
   void pushPieceData(int64_t offset, int32_t length) const;
 
+  // Returns block_ to the write disk cache for reuse.
+  void releaseBlock();
+
 public:
   BtPieceMessage(size_t index = 0, int32_t begin = 0, int32_t blockLength = 0);
 
@@ -79,20 +89,35 @@ public:
 
   void setBegin(int32_t begin) { begin_ = begin; }
 
-  const unsigned char* getBlock() const { return data_ + 9; }
+  const unsigned char* getBlock() const
+  {
+    return block_ ? block_.get() : data_ + 9;
+  }
 
   int32_t getBlockLength() const { return blockLength_; }
 
+  virtual size_t getUploadLength() CXX11_OVERRIDE { return blockLength_; }
+
   // Sets message payload data. Caller must not change or free data
   // before doReceivedAction().
   void setMsgPayload(const unsigned char* data);
 
+  // Sets the buffer holding the block, which was received separately
+  // from the message header.  It is moved to the write disk cache
+  // without copying if possible.  block can be null.  capacity is the
+  // size of block.
+  void setBlock(std::unique_ptr<unsigned char[]> block, size_t capacity);
+
   void setBlockLength(int32_t blockLength) { blockLength_ = blockLength; }
 
   void setDownloadContext(DownloadContext* downloadContext);
 
   void setPeerStorage(PeerStorage* peerStorage);
 
+  // If pieceHashChecker is not nullptr, the piece whose hash is not
+  // calculated incrementally is verified by it asynchronously.
+  void setPieceHashChecker(BtPieceHashChecker* pieceHashChecker);
+
   static std::unique_ptr<BtPieceMessage> create(const unsigned char* data,
                                                 size_t dataLength);
 
@@ -37,8 +37,12 @@
 
 #include "common.h"
 
+#include <memory>
+
 namespace aria2 {
 
+class BtPieceHashChecker;
+
 class BtRuntime {
 private:
   int64_t uploadLengthAtStartup_;
@@ -51,6 +55,8 @@ private:
   // Minimum number of peers. This value is used for getting more peers from
   // tracker. 0 means always the number of peers is under minimum.
   int minPeers_;
+  // nullptr unless the piece hashes are verified by HashWorkerPool.
+  std::shared_ptr<BtPieceHashChecker> pieceHashChecker_;
 
 public:
   BtRuntime();
@@ -97,6 +103,16 @@ public:
 
   int getMaxPeers() const { return maxPeers_; }
 
+  const std::shared_ptr<BtPieceHashChecker>& getPieceHashChecker() const
+  {
+    return pieceHashChecker_;
+  }
+
+  void setPieceHashChecker(std::shared_ptr<BtPieceHashChecker> checker)
+  {
+    pieceHashChecker_ = std::move(checker);
+  }
+
   static const int DEFAULT_MAX_PEERS = 55;
   static const int DEFAULT_MIN_PEERS = 40;
 };
@@ -85,6 +85,12 @@
 #include "PieceStorage.h"
 #include "PeerStorage.h"
 #include "fmt.h"
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#include "SingletonHolder.h"
+#include "BtPieceHashChecker.h"
+#include "BtPieceHashCheckCommand.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -180,6 +186,18 @@ void BtSetup::setup(std::vector<std::unique_ptr<Command>>& commands,
       c->setBtRuntime(btRuntime);
       commands.push_back(std::move(c));
     }
+#ifdef HAVE_STD_THREAD
+    const auto& hashWorkerPool = SingletonHolder<HashWorkerPool>::instance();
+    if (hashWorkerPool) {
+      btRuntime->setPieceHashChecker(std::make_shared<BtPieceHashChecker>(
+          hashWorkerPool.get(), requestGroup->getDownloadContext().get(),
+          pieceStorage, peerStorage));
+      auto c =
+          make_unique<BtPieceHashCheckCommand>(e->newCUID(), requestGroup, e);
+      c->setBtRuntime(btRuntime);
+      commands.push_back(std::move(c));
+    }
+#endif // HAVE_STD_THREAD
   }
   if (btReg->getTcpPort() == 0) {
     static int families[] = {AF_INET, AF_INET6};
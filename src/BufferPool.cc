@@ -0,0 +1,270 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BufferPool.h"
+
+#include <cassert>
+#include <array>
+#include <vector>
+
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// The largest class holds BitTorrent PIECE message of 16KiB block,
+// and the receive buffer of PeerConnection.
+constexpr std::array<size_t, 4> SIZE_CLASSES{{64, 512, 4_k, 17_k}};
+constexpr size_t NO_SIZE_CLASS = SIZE_CLASSES.size();
+
+size_t findSizeClass(size_t length)
+{
+  for (size_t i = 0; i < SIZE_CLASSES.size(); ++i) {
+    if (length <= SIZE_CLASSES[i]) {
+      return i;
+    }
+  }
+  return NO_SIZE_CLASS;
+}
+} // namespace
+
+// The state of BufferPool.  It is referenced by BufferPool and by
+// each buffer allocated from it, and deleted when the last one of
+// them goes away.
+struct BufferPoolImpl {
+  typedef BufferSlice::Block Block;
+
+  BufferPoolImpl(size_t maxFreeBytes)
+      : refCount(1),
+        maxFreeBytes(maxFreeBytes),
+        numHits(0),
+        numMisses(0),
+        inUseBytes(0),
+        freeBytes(0)
+  {
+  }
+
+  ~BufferPoolImpl()
+  {
+    for (auto& freeList : freeLists) {
+      for (auto block : freeList) {
+        deleteBlock(block);
+      }
+    }
+  }
+
+  static Block* newBlock(size_t capacity)
+  {
+    auto block = reinterpret_cast<Block*>(
+        new unsigned char[sizeof(Block) + capacity]);
+    block->capacity = capacity;
+    return block;
+  }
+
+  static void deleteBlock(Block* block)
+  {
+    delete[] reinterpret_cast<unsigned char*>(block);
+  }
+
+  Block* get(size_t length)
+  {
+    auto sizeClass = findSizeClass(length);
+    Block* block;
+    if (sizeClass == NO_SIZE_CLASS) {
+      ++numMisses;
+      block = newBlock(length);
+    }
+    else if (freeLists[sizeClass].empty()) {
+      ++numMisses;
+      block = newBlock(SIZE_CLASSES[sizeClass]);
+    }
+    else {
+      ++numHits;
+      block = freeLists[sizeClass].back();
+      freeLists[sizeClass].pop_back();
+      freeBytes -= block->capacity;
+    }
+    block->refCount = 1;
+    block->pool = this;
+    block->sizeClass = sizeClass;
+    inUseBytes += block->capacity;
+    ++refCount;
+    return block;
+  }
+
+  void put(Block* block)
+  {
+    inUseBytes -= block->capacity;
+    if (block->sizeClass == NO_SIZE_CLASS ||
+        freeBytes + block->capacity > maxFreeBytes) {
+      deleteBlock(block);
+    }
+    else {
+      freeLists[block->sizeClass].push_back(block);
+      freeBytes += block->capacity;
+    }
+    unref();
+  }
+
+  void unref()
+  {
+    if (--refCount == 0) {
+      delete this;
+    }
+  }
+
+  std::array<std::vector<Block*>, SIZE_CLASSES.size()> freeLists;
+  size_t refCount;
+  size_t maxFreeBytes;
+  uint64_t numHits;
+  uint64_t numMisses;
+  size_t inUseBytes;
+  size_t freeBytes;
+};
+
+BufferSlice::BufferSlice() : block_(nullptr), offset_(0), length_(0) {}
+
+BufferSlice::BufferSlice(Block* block, size_t length)
+    : block_(block), offset_(0), length_(length)
+{
+}
+
+BufferSlice::BufferSlice(const BufferSlice& other)
+    : block_(other.block_), offset_(other.offset_), length_(other.length_)
+{
+  if (block_) {
+    ++block_->refCount;
+  }
+}
+
+BufferSlice::BufferSlice(BufferSlice&& other) noexcept
+    : block_(other.block_),
+      offset_(other.offset_),
+      length_(other.length_)
+{
+  other.block_ = nullptr;
+  other.offset_ = other.length_ = 0;
+}
+
+BufferSlice::~BufferSlice() { release(); }
+
+BufferSlice& BufferSlice::operator=(const BufferSlice& other)
+{
+  if (other.block_) {
+    ++other.block_->refCount;
+  }
+  release();
+  block_ = other.block_;
+  offset_ = other.offset_;
+  length_ = other.length_;
+  return *this;
+}
+
+BufferSlice& BufferSlice::operator=(BufferSlice&& other) noexcept
+{
+  if (this != &other) {
+    release();
+    block_ = other.block_;
+    offset_ = other.offset_;
+    length_ = other.length_;
+    other.block_ = nullptr;
+    other.offset_ = other.length_ = 0;
+  }
+  return *this;
+}
+
+void BufferSlice::release()
+{
+  if (!block_ || --block_->refCount > 0) {
+    return;
+  }
+  if (block_->pool) {
+    block_->pool->put(block_);
+  }
+  else {
+    BufferPoolImpl::deleteBlock(block_);
+  }
+  block_ = nullptr;
+}
+
+BufferSlice BufferSlice::allocate(size_t length)
+{
+  auto block = BufferPoolImpl::newBlock(length);
+  block->refCount = 1;
+  block->pool = nullptr;
+  block->sizeClass = NO_SIZE_CLASS;
+  return BufferSlice(block, length);
+}
+
+BufferSlice BufferSlice::slice(size_t offset, size_t length) const
+{
+  assert(offset + length <= length_);
+  BufferSlice s(*this);
+  s.offset_ += offset;
+  s.length_ = length;
+  return s;
+}
+
+const size_t BufferPool::DEFAULT_MAX_FREE_BYTES = 4_m;
+
+BufferPool::BufferPool(size_t maxFreeBytes)
+    : impl_(new BufferPoolImpl(maxFreeBytes))
+{
+}
+
+BufferPool::~BufferPool() { impl_->unref(); }
+
+BufferSlice BufferPool::allocate(size_t length)
+{
+  return BufferSlice(impl_->get(length), length);
+}
+
+uint64_t BufferPool::getNumHits() const { return impl_->numHits; }
+
+uint64_t BufferPool::getNumMisses() const { return impl_->numMisses; }
+
+size_t BufferPool::getInUseBytes() const { return impl_->inUseBytes; }
+
+size_t BufferPool::getFreeBytes() const { return impl_->freeBytes; }
+
+size_t BufferPool::getCapacity(size_t length)
+{
+  auto sizeClass = findSizeClass(length);
+  if (sizeClass == NO_SIZE_CLASS) {
+    return length;
+  }
+  return SIZE_CLASSES[sizeClass];
+}
+
+} // namespace aria2
@@ -0,0 +1,155 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BUFFER_POOL_H
+#define D_BUFFER_POOL_H
+
+#include "common.h"
+
+
+namespace aria2 {
+
+struct BufferPoolImpl;
+
+// Reference to length bytes of memory starting at offset in a
+// reference-counted buffer.  Copying the slice shares the buffer.
+// The buffer is released, or returned to BufferPool, when the last
+// slice referring to it is destroyed.  The reference count is stored
+// in the header placed in front of the data, so that sharing a
+// buffer allocates nothing.  This class is not thread-safe.
+class BufferSlice {
+public:
+  BufferSlice();
+
+  BufferSlice(const BufferSlice& other);
+
+  BufferSlice(BufferSlice&& other) noexcept;
+
+  ~BufferSlice();
+
+  BufferSlice& operator=(const BufferSlice& other);
+
+  BufferSlice& operator=(BufferSlice&& other) noexcept;
+
+  // Returns the slice of length bytes in a buffer newly allocated
+  // from heap, not from BufferPool.
+  static BufferSlice allocate(size_t length);
+
+  unsigned char* data() const
+  {
+    return reinterpret_cast<unsigned char*>(block_ + 1) + offset_;
+  }
+
+  size_t size() const { return length_; }
+
+  bool empty() const { return length_ == 0; }
+
+  // Returns true if no other slice refers to the same buffer.
+  bool unique() const { return block_ && block_->refCount == 1; }
+
+  // Returns the slice referring to length bytes starting at offset
+  // in this slice.
+  BufferSlice slice(size_t offset, size_t length) const;
+
+private:
+  friend class BufferPool;
+  friend struct BufferPoolImpl;
+
+  // The header of the buffer.  The data follows it.
+  struct Block {
+    size_t refCount;
+    // The pool the buffer belongs to, or nullptr.
+    BufferPoolImpl* pool;
+    // The size class in the pool.
+    size_t sizeClass;
+    // The number of bytes of the data.
+    size_t capacity;
+  };
+
+  BufferSlice(Block* block, size_t length);
+
+  void release();
+
+  Block* block_;
+  size_t offset_;
+  size_t length_;
+};
+
+// Pool of buffers with fixed size classes.  A buffer returned by
+// allocate() goes back to the free list of its size class when it is
+// released, so that the next allocation of the similar size does not
+// hit the heap: a hit allocates no memory at all.  The request larger
+// than the largest size class is allocated from heap directly.  The
+// buffers may outlive the pool.  This class is not thread-safe.
+class BufferPool {
+public:
+  // The free buffers are kept up to maxFreeBytes in total.  The
+  // buffers released beyond that are freed.
+  BufferPool(size_t maxFreeBytes = DEFAULT_MAX_FREE_BYTES);
+
+  ~BufferPool();
+
+  // Don't allow copying
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // Returns the slice of length bytes.  The content of the buffer is
+  // unspecified.
+  BufferSlice allocate(size_t length);
+
+  // Returns the number of allocations served from the free lists.
+  uint64_t getNumHits() const;
+
+  // Returns the number of allocations which allocated new memory.
+  uint64_t getNumMisses() const;
+
+  // Returns the number of bytes of the buffers in use.
+  size_t getInUseBytes() const;
+
+  // Returns the number of bytes of the buffers in the free lists.
+  size_t getFreeBytes() const;
+
+  static const size_t DEFAULT_MAX_FREE_BYTES;
+
+  // Returns the capacity of the buffer allocated for length bytes.
+  // Returns length if it is larger than the largest size class.
+  static size_t getCapacity(size_t length);
+
+private:
+  BufferPoolImpl* impl_;
+};
+
+} // namespace aria2
+
+#endif // D_BUFFER_POOL_H
@@ -52,13 +52,15 @@ CheckIntegrityCommand::CheckIntegrityCommand(cuid_t cuid,
                                              RequestGroup* requestGroup,
                                              DownloadEngine* e,
                                              CheckIntegrityEntry* entry)
-    : RealtimeCommand{cuid, requestGroup, e}, entry_{entry}
+    : RealtimeCommand{cuid, requestGroup, e}, entry_{entry}, waitFd_{-1}
 {
 }
 
 CheckIntegrityCommand::~CheckIntegrityCommand()
 {
-  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
+  // The fd is closed when entry_ is dropped.
+  setWaitFd(-1);
+  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry(entry_);
 }
 
 bool CheckIntegrityCommand::executeInternal()
@@ -92,11 +94,32 @@ bool CheckIntegrityCommand::executeInternal()
     return true;
   }
   else {
+    int fd = entry_->getWaitFd();
+    if (fd != -1) {
+      // The worker threads are hashing all pieces read so far.  Sleep
+      // until one of them finishes.
+      setWaitFd(fd);
+      setStatusInactive();
+    }
     getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
     return false;
   }
 }
 
+void CheckIntegrityCommand::setWaitFd(int fd)
+{
+  if (fd == waitFd_) {
+    return;
+  }
+  if (waitFd_ != -1) {
+    getDownloadEngine()->deleteFdForReadCheck(waitFd_, this);
+  }
+  waitFd_ = fd;
+  if (waitFd_ != -1) {
+    getDownloadEngine()->addFdForReadCheck(waitFd_, this);
+  }
+}
+
 bool CheckIntegrityCommand::handleException(Exception& e)
 {
   A2_LOG_ERROR_EX(fmt(MSG_FILE_VALIDATION_FAILURE, getCuid()), e);
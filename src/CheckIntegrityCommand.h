@@ -46,6 +46,11 @@ class CheckIntegrityEntry;
 class CheckIntegrityCommand : public RealtimeCommand {
 private:
   CheckIntegrityEntry* entry_;
+  // The fd registered to DownloadEngine to wait for the validator, or
+  // -1.
+  int waitFd_;
+
+  void setWaitFd(int fd);
 
 public:
   CheckIntegrityCommand(cuid_t cuid, RequestGroup* requestGroup,
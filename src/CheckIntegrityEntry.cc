@@ -76,6 +76,11 @@ int64_t CheckIntegrityEntry::getCurrentLength()
 
 bool CheckIntegrityEntry::finished() { return validator_->finished(); }
 
+int CheckIntegrityEntry::getWaitFd() const
+{
+  return validator_ ? validator_->getWaitFd() : -1;
+}
+
 void CheckIntegrityEntry::cutTrailingGarbage()
 {
   getRequestGroup()->getPieceStorage()->getDiskAdaptor()->cutTrailingGarbage();
@@ -75,6 +75,9 @@ public:
 
   virtual bool finished() CXX11_OVERRIDE;
 
+  // See IteratableValidator::getWaitFd().
+  int getWaitFd() const;
+
   virtual bool isValidationReady() = 0;
 
   virtual void initValidator() = 0;
@@ -43,7 +43,11 @@ Command::Command(cuid_t cuid)
       readEvent_(false),
       writeEvent_(false),
       errorEvent_(false),
-      hupEvent_(false)
+      hupEvent_(false),
+      readyList_(nullptr),
+      ready_(false),
+      wakeupTime_(Timer::zero()),
+      timerEntry_(this)
 {
 }
 
@@ -57,7 +61,14 @@ void Command::transitStatus()
   }
 }
 
-void Command::setStatus(STATUS status) { status_ = status; }
+void Command::setStatus(STATUS status)
+{
+  status_ = status;
+  if (readyList_ && !ready_ && statusMatch(STATUS_ACTIVE)) {
+    ready_ = true;
+    readyList_->push_back(this);
+  }
+}
 
 void Command::readEventReceived() { readEvent_ = true; }
 
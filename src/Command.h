@@ -37,6 +37,13 @@
 
 #include "common.h"
 
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "TimerA2.h"
+#include "TimerWheel.h"
+
 namespace aria2 {
 
 typedef int64_t cuid_t;
@@ -61,6 +68,31 @@ private:
   bool errorEvent_;
   bool hupEvent_;
 
+  // The list of commands which DownloadEngine executes in the next
+  // iteration.  This command is appended to it when its status is
+  // changed to the one which matches STATUS_ACTIVE.  nullptr if this
+  // command is not waiting in DownloadEngine.
+  std::vector<Command*>* readyList_;
+
+  // true if this command is in *readyList_.
+  bool ready_;
+
+  // The position of this command in DownloadEngine's command list.
+  // Valid only if readyList_ is not nullptr.
+  std::list<std::unique_ptr<Command>>::iterator enginePos_;
+
+  // The time at which DownloadEngine makes this command ready even if
+  // no event occurs for it.  Zero if no wakeup is scheduled.
+  Timer wakeupTime_;
+
+  // The entry of DownloadEngine's timer wheel, which makes this
+  // command ready at wakeupTime_ or when it has not been executed
+  // for the refresh interval, whichever comes first.  Linked only
+  // while readyList_ is not nullptr.
+  TimerWheel::Entry timerEntry_;
+
+  friend class DownloadEngine;
+
 protected:
   bool readEventEnabled() const { return readEvent_; }
 
@@ -79,11 +111,11 @@ public:
 
   cuid_t getCuid() const { return cuid_; }
 
-  void setStatusActive() { status_ = STATUS_ACTIVE; }
+  void setStatusActive() { setStatus(STATUS_ACTIVE); }
 
-  void setStatusInactive() { status_ = STATUS_INACTIVE; }
+  void setStatusInactive() { setStatus(STATUS_INACTIVE); }
 
-  void setStatusRealtime() { status_ = STATUS_REALTIME; }
+  void setStatusRealtime() { setStatus(STATUS_REALTIME); }
 
   void setStatus(STATUS status);
 
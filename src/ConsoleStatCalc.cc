@@ -379,8 +379,11 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
         o << "--";
       }
       o << "%)]";
-      if (e->getCheckIntegrityMan()->hasNext()) {
-        o << "(+" << e->getCheckIntegrityMan()->countEntryInQueue() << ")";
+      // Other entries may be verified at the same time.
+      auto numOthers = e->getCheckIntegrityMan()->countPickedEntry() - 1 +
+                       e->getCheckIntegrityMan()->countEntryInQueue();
+      if (numOthers > 0) {
+        o << "(+" << numOthers << ")";
       }
     }
   }
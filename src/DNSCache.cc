@@ -34,9 +34,13 @@
 /* copyright --> */
 #include "DNSCache.h"
 #include "A2STR.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
+const std::chrono::seconds DNSCache::DEFAULT_TTL(300);
+const std::chrono::seconds DNSCache::DEFAULT_NEGATIVE_TTL(30);
+
 DNSCache::AddrEntry::AddrEntry(const std::string& addr)
     : addr_(addr), good_(true)
 {
@@ -56,7 +60,10 @@ DNSCache::AddrEntry& DNSCache::AddrEntry::operator=(const AddrEntry& c)
 }
 
 DNSCache::CacheEntry::CacheEntry(const std::string& hostname, uint16_t port)
-    : hostname_(hostname), port_(port)
+    : hostname_(hostname),
+      port_(port),
+      registeredTime_(global::wallclock()),
+      failed_(false)
 {
 }
 
@@ -70,6 +77,8 @@ DNSCache::CacheEntry& DNSCache::CacheEntry::operator=(const CacheEntry& c)
     hostname_ = c.hostname_;
     port_ = c.port_;
     addrEntries_ = c.addrEntries_;
+    registeredTime_ = c.registeredTime_;
+    failed_ = c.failed_;
   }
   return *this;
 }
@@ -146,7 +155,13 @@ bool DNSCache::CacheEntry::operator==(const CacheEntry& e) const
   return hostname_ == e.hostname_ && port_ == e.port_;
 }
 
-DNSCache::DNSCache() {}
+DNSCache::DNSCache(std::chrono::seconds ttl, std::chrono::seconds negativeTtl)
+    : ttl_(std::move(ttl)),
+      negativeTtl_(std::move(negativeTtl)),
+      numHits_(0),
+      numMisses_(0)
+{
+}
 
 DNSCache::DNSCache(const DNSCache& c) = default;
 
@@ -156,15 +171,35 @@ DNSCache& DNSCache::operator=(const DNSCache& c)
 {
   if (this != &c) {
     entries_ = c.entries_;
+    ttl_ = c.ttl_;
+    negativeTtl_ = c.negativeTtl_;
+    numHits_ = c.numHits_;
+    numMisses_ = c.numMisses_;
   }
   return *this;
 }
 
-const std::string& DNSCache::find(const std::string& hostname,
-                                  uint16_t port) const
+bool DNSCache::expired(const CacheEntry& e) const
+{
+  return e.registeredTime_.difference(global::wallclock()) >=
+         (e.failed_ ? negativeTtl_ : ttl_);
+}
+
+DNSCache::CacheEntrySet::const_iterator
+DNSCache::findEntry(const std::string& hostname, uint16_t port) const
 {
   auto target = std::make_shared<CacheEntry>(hostname, port);
   auto i = entries_.find(target);
+  if (i == entries_.end() || expired(*(*i))) {
+    return entries_.end();
+  }
+  return i;
+}
+
+const std::string& DNSCache::find(const std::string& hostname,
+                                  uint16_t port) const
+{
+  auto i = findEntry(hostname, port);
   if (i == entries_.end()) {
     return A2STR::NIL;
   }
@@ -173,12 +208,40 @@ const std::string& DNSCache::find(const std::string& hostname,
   }
 }
 
+bool DNSCache::isFailed(const std::string& hostname, uint16_t port) const
+{
+  auto i = findEntry(hostname, port);
+  return i != entries_.end() && (*i)->failed_;
+}
+
+Timer DNSCache::getFailureExpiry(const std::string& hostname,
+                                 uint16_t port) const
+{
+  auto i = findEntry(hostname, port);
+  if (i == entries_.end() || !(*i)->failed_) {
+    return global::wallclock();
+  }
+  Timer expiry((*i)->registeredTime_);
+  expiry.advance(negativeTtl_);
+  return expiry;
+}
+
+bool DNSCache::contains(const std::string& hostname, uint16_t port) const
+{
+  return findEntry(hostname, port) != entries_.end();
+}
+
 void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
                    uint16_t port)
 {
   auto target = std::make_shared<CacheEntry>(hostname, port);
   auto i = entries_.lower_bound(target);
   if (i != entries_.end() && *(*i) == *target) {
+    if ((*i)->failed_ || expired(*(*i))) {
+      // Start over the expired entry or the failure with the new
+      // result of the name resolution.
+      **i = *target;
+    }
     (*i)->add(ipaddr);
   }
   else {
@@ -187,6 +250,19 @@ void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
   }
 }
 
+void DNSCache::putFailure(const std::string& hostname, uint16_t port)
+{
+  auto target = std::make_shared<CacheEntry>(hostname, port);
+  target->failed_ = true;
+  auto i = entries_.lower_bound(target);
+  if (i != entries_.end() && *(*i) == *target) {
+    **i = *target;
+  }
+  else {
+    entries_.insert(i, target);
+  }
+}
+
 void DNSCache::markBad(const std::string& hostname, const std::string& ipaddr,
                        uint16_t port)
 {
@@ -203,4 +279,14 @@ void DNSCache::remove(const std::string& hostname, uint16_t port)
   entries_.erase(target);
 }
 
+void DNSCache::countLookup(bool hit)
+{
+  if (hit) {
+    ++numHits_;
+  }
+  else {
+    ++numMisses_;
+  }
+}
+
 } // namespace aria2
@@ -41,8 +41,10 @@
 #include <set>
 #include <algorithm>
 #include <vector>
+#include <chrono>
 
 #include "a2functional.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
@@ -63,6 +65,10 @@ private:
     std::string hostname_;
     uint16_t port_;
     std::vector<AddrEntry> addrEntries_;
+    // The time when the name was resolved.
+    Timer registeredTime_;
+    // true if the name resolution failed.  addrEntries_ is empty.
+    bool failed_;
 
     CacheEntry(const std::string& hostname, uint16_t port);
     CacheEntry(const CacheEntry& c);
@@ -102,8 +108,24 @@ private:
       CacheEntrySet;
   CacheEntrySet entries_;
 
+  std::chrono::seconds ttl_;
+  std::chrono::seconds negativeTtl_;
+  uint64_t numHits_;
+  uint64_t numMisses_;
+
+  bool expired(const CacheEntry& e) const;
+
+  // Returns the entry for hostname and port which is not expired, or
+  // entries_.end().
+  CacheEntrySet::const_iterator findEntry(const std::string& hostname,
+                                          uint16_t port) const;
+
 public:
-  DNSCache();
+  // Neither getaddrinfo() nor the c-ares API aria2 uses reports the
+  // TTL of the resolved addresses, so they expire after ttl.  The
+  // failure of the name resolution is cached for negativeTtl.
+  DNSCache(std::chrono::seconds ttl = DEFAULT_TTL,
+           std::chrono::seconds negativeTtl = DEFAULT_NEGATIVE_TTL);
   DNSCache(const DNSCache& c);
   ~DNSCache();
 
@@ -115,20 +137,47 @@ public:
   void findAll(OutputIterator out, const std::string& hostname,
                uint16_t port) const
   {
-    std::shared_ptr<CacheEntry> target(new CacheEntry(hostname, port));
-    auto i = entries_.find(target);
+    auto i = findEntry(hostname, port);
     if (i != entries_.end()) {
       (*i)->getAllGoodAddrs(out);
     }
   }
 
+  // Returns true if the name resolution of hostname failed within
+  // negativeTtl.
+  bool isFailed(const std::string& hostname, uint16_t port) const;
+
+  // Returns the time when the cached failure of the name resolution
+  // of hostname expires.  If the failure is not cached, returns the
+  // current time.
+  Timer getFailureExpiry(const std::string& hostname, uint16_t port) const;
+
+  // Returns true if the result of the name resolution of hostname,
+  // either success or failure, is cached and not expired.
+  bool contains(const std::string& hostname, uint16_t port) const;
+
   void put(const std::string& hostname, const std::string& ipaddr,
            uint16_t port);
 
+  // Caches the failure of the name resolution of hostname.  The
+  // addresses cached for hostname are removed.
+  void putFailure(const std::string& hostname, uint16_t port);
+
   void markBad(const std::string& hostname, const std::string& ipaddr,
                uint16_t port);
 
   void remove(const std::string& hostname, uint16_t port);
+
+  // Counts the lookup of the name resolution, whether it is answered
+  // from this cache.
+  void countLookup(bool hit);
+
+  uint64_t getNumHits() const { return numHits_; }
+
+  uint64_t getNumMisses() const { return numMisses_; }
+
+  static const std::chrono::seconds DEFAULT_TTL;
+  static const std::chrono::seconds DEFAULT_NEGATIVE_TTL;
 };
 
 } // namespace aria2
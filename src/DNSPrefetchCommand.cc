@@ -0,0 +1,108 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DNSPrefetchCommand.h"
+
+#include <vector>
+
+#include "DownloadEngine.h"
+#include "DNSCache.h"
+#include "AsyncNameResolverMan.h"
+#include "RequestGroupMan.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "message.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+DNSPrefetchCommand::DNSPrefetchCommand(cuid_t cuid, DownloadEngine* e,
+                                       std::string hostname, uint16_t port)
+    : Command(cuid),
+      e_(e),
+      asyncNameResolverMan_(make_unique<AsyncNameResolverMan>()),
+      hostname_(std::move(hostname)),
+      port_(port)
+{
+  configureAsyncNameResolverMan(asyncNameResolverMan_.get(), e_->getOption());
+  setStatus(Command::STATUS_ONESHOT_REALTIME);
+}
+
+DNSPrefetchCommand::~DNSPrefetchCommand()
+{
+  asyncNameResolverMan_->disableNameResolverCheck(e_, this);
+}
+
+bool DNSPrefetchCommand::execute()
+{
+  if (e_->isHaltRequested()) {
+    return true;
+  }
+  if (!asyncNameResolverMan_->started()) {
+    A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - Prefetching the address of %s",
+                     getCuid(), hostname_.c_str()));
+    asyncNameResolverMan_->startAsync(hostname_, e_, this);
+  }
+  auto& dnsCache = e_->getDNSCache();
+  std::vector<std::string> addrs;
+  switch (asyncNameResolverMan_->getStatus()) {
+  case -1:
+    A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(), hostname_.c_str(),
+                    asyncNameResolverMan_->getLastError().c_str()));
+    dnsCache->putFailure(hostname_, port_);
+    break;
+  case 0:
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  case 1:
+    asyncNameResolverMan_->getResolvedAddress(addrs);
+    if (addrs.empty()) {
+      A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
+                      hostname_.c_str(), "No address returned"));
+      dnsCache->putFailure(hostname_, port_);
+      break;
+    }
+    A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname_.c_str(),
+                    strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+    for (const auto& addr : addrs) {
+      dnsCache->put(hostname_, addr, port_);
+    }
+    break;
+  }
+  e_->getRequestGroupMan()->onHostnamePrefetched(hostname_, port_);
+  return true;
+}
+
+} // namespace aria2
@@ -36,6 +36,7 @@
 
 #include <cstring>
 #include <vector>
+#include <limits>
 
 #include "prefs.h"
 #include "message.h"
@@ -54,6 +55,7 @@
 #include "BtBitfieldMessage.h"
 #include "BtHaveNoneMessage.h"
 #include "BtAllowedFastMessage.h"
+#include "BtPreparedMessage.h"
 #include "DlAbortEx.h"
 #include "BtExtendedMessage.h"
 #include "HandshakeExtensionMessage.h"
@@ -77,6 +79,7 @@
 #include "fmt.h"
 #include "RequestGroup.h"
 #include "RequestGroupMan.h"
+#include "DownloadShaper.h"
 #include "bittorrent_helper.h"
 #include "UTMetadataRequestFactory.h"
 #include "UTMetadataRequestTracker.h"
@@ -217,7 +220,7 @@ void DefaultBtInteractive::addBitfieldMessageToQueue()
       dispatcher_->addMessageToQueue(messageFactory_->createHaveAllMessage());
     }
     else if (pieceStorage_->getCompletedLength() > 0) {
-      dispatcher_->addMessageToQueue(messageFactory_->createBitfieldMessage());
+      addSharedBitfieldMessageToQueue();
     }
     else {
       dispatcher_->addMessageToQueue(messageFactory_->createHaveNoneMessage());
@@ -225,11 +228,18 @@ void DefaultBtInteractive::addBitfieldMessageToQueue()
   }
   else {
     if (pieceStorage_->getCompletedLength() > 0) {
-      dispatcher_->addMessageToQueue(messageFactory_->createBitfieldMessage());
+      addSharedBitfieldMessageToQueue();
     }
   }
 }
 
+void DefaultBtInteractive::addSharedBitfieldMessageToQueue()
+{
+  dispatcher_->addMessageToQueue(messageFactory_->createPreparedMessage(
+      BtBitfieldMessage::ID, BtBitfieldMessage::NAME,
+      pieceStorage_->getBitfieldMessage()));
+}
+
 void DefaultBtInteractive::addAllowedFastMessageToQueue()
 {
   if (peer_->isFastExtensionEnabled()) {
@@ -264,14 +274,15 @@ void DefaultBtInteractive::decideChoking()
 
 void DefaultBtInteractive::checkHave()
 {
-  std::vector<size_t> haveIndexes;
+  size_t numHaves;
 
-  lastHaveIndex_ = pieceStorage_->getAdvertisedPieceIndexes(haveIndexes, cuid_,
-                                                            lastHaveIndex_);
+  haveMessages_.clear();
+  lastHaveIndex_ = pieceStorage_->getAdvertisedPieceMessages(
+      haveMessages_, numHaves, lastHaveIndex_);
 
   // Use bitfield message if it is equal to or less than the total
   // size of have messages.
-  if (5 + pieceStorage_->getBitfieldLength() <= haveIndexes.size() * 9) {
+  if (5 + pieceStorage_->getBitfieldLength() <= numHaves * 9) {
     if (peer_->isFastExtensionEnabled() &&
         pieceStorage_->allDownloadFinished()) {
       dispatcher_->addMessageToQueue(messageFactory_->createHaveAllMessage());
@@ -279,13 +290,16 @@ void DefaultBtInteractive::checkHave()
       return;
     }
 
-    dispatcher_->addMessageToQueue(messageFactory_->createBitfieldMessage());
+    addSharedBitfieldMessageToQueue();
 
     return;
   }
 
-  for (auto idx : haveIndexes) {
-    dispatcher_->addMessageToQueue(messageFactory_->createHaveMessage(idx));
+  // The have messages are shared among all peers.  We just push
+  // the slices of them.
+  for (auto& data : haveMessages_) {
+    dispatcher_->addMessageToQueue(messageFactory_->createPreparedMessage(
+        BtHaveMessage::ID, BtHaveMessage::NAME, std::move(data)));
   }
 }
 
@@ -298,15 +312,24 @@ void DefaultBtInteractive::sendKeepAlive()
   }
 }
 
+namespace {
+// The maximum number of bytes asked to DownloadShaper at once
+constexpr size_t MAX_READ_QUOTA = 64_k;
+} // namespace
+
 size_t DefaultBtInteractive::receiveMessages()
 {
   size_t countOldOutstandingRequest = dispatcher_->countOutstandingRequest();
   size_t msgcount = 0;
+  auto shaper = requestGroupMan_->getDownloadShaper();
+  auto group = downloadContext_->getOwnerRequestGroup();
+  bool limited = shaper->isLimited(group);
+  if (limited) {
+    // Read exactly the quota granted by the shaper.  The messages
+    // already buffered are processed even if no quota is granted.
+    peerConnection_->setReadQuota(shaper->acquire(group, MAX_READ_QUOTA));
+  }
   while (1) {
-    if (requestGroupMan_->doesOverallDownloadSpeedExceed() ||
-        downloadContext_->getOwnerRequestGroup()->doesDownloadSpeedExceed()) {
-      break;
-    }
     auto message = btMessageReceiver_->receiveMessage();
     if (!message) {
       break;
@@ -337,6 +360,10 @@ size_t DefaultBtInteractive::receiveMessages()
       break;
     }
   }
+  if (limited) {
+    shaper->release(group, peerConnection_->getReadQuota());
+    peerConnection_->setReadQuota(std::numeric_limits<size_t>::max());
+  }
 
   if (!pieceStorage_->isEndGame() &&
       countOldOutstandingRequest > dispatcher_->countOutstandingRequest() &&
@@ -42,6 +42,7 @@
 
 #include "TimerA2.h"
 #include "Command.h"
+#include "BufferPool.h"
 
 namespace aria2 {
 
@@ -126,6 +127,8 @@ private:
 
   // The last haveIndex we have advertised to the peer.
   uint64_t lastHaveIndex_;
+  // Reused in checkHave() to avoid the allocation in each call.
+  std::vector<BufferSlice> haveMessages_;
 
   size_t allowedFastSetSize_;
   Timer keepAliveTimer_;
@@ -147,6 +150,7 @@ private:
   uint16_t tcpPort_;
 
   void addBitfieldMessageToQueue();
+  void addSharedBitfieldMessageToQueue();
   void addAllowedFastMessageToQueue();
   void addHandshakeExtendedMessageToQueue();
   void decideChoking();
@@ -54,6 +54,7 @@
 #include "a2algo.h"
 #include "RequestGroupMan.h"
 #include "RequestGroup.h"
+#include "UploadScheduler.h"
 #include "util.h"
 #include "fmt.h"
 #include "PeerConnection.h"
@@ -86,12 +87,18 @@ void DefaultBtMessageDispatcher::addMessageToQueue(
 void DefaultBtMessageDispatcher::sendMessagesInternal()
 {
   auto tempQueue = std::vector<std::unique_ptr<BtMessage>>{};
+  auto scheduler = requestGroupMan_->getUploadScheduler();
+  auto group = downloadContext_->getOwnerRequestGroup();
+  // Once the scheduler refuses to give budget, the remaining uploading
+  // messages are deferred without asking it again in this round.
+  bool throttled = false;
   while (!messageQueue_.empty()) {
     auto msg = std::move(messageQueue_.front());
     messageQueue_.pop_front();
     if (msg->isUploading()) {
-      if (requestGroupMan_->doesOverallUploadSpeedExceed() ||
-          downloadContext_->getOwnerRequestGroup()->doesUploadSpeedExceed()) {
+      if (throttled ||
+          !scheduler->acquire(group, cuid_, msg->getUploadLength())) {
+        throttled = true;
         tempQueue.push_back(std::move(msg));
         continue;
       }
@@ -52,6 +52,7 @@
 #include "BtPortMessage.h"
 #include "BtHaveAllMessage.h"
 #include "BtHaveNoneMessage.h"
+#include "BtPreparedMessage.h"
 #include "BtRejectMessage.h"
 #include "BtSuggestPieceMessage.h"
 #include "BtAllowedFastMessage.h"
@@ -84,6 +85,7 @@ DefaultBtMessageFactory::DefaultBtMessageFactory()
       routingTable_{nullptr},
       taskQueue_{nullptr},
       taskFactory_{nullptr},
+      pieceHashChecker_{nullptr},
       metadataGetMode_(false)
 {
 }
@@ -155,6 +157,7 @@ DefaultBtMessageFactory::createBtMessage(const unsigned char* data,
       }
       m->setDownloadContext(downloadContext_);
       m->setPeerStorage(peerStorage_);
+      m->setPieceHashChecker(pieceHashChecker_);
       msg = std::move(m);
       break;
     }
@@ -370,6 +373,15 @@ DefaultBtMessageFactory::createHaveNoneMessage()
   return msg;
 }
 
+std::unique_ptr<BtPreparedMessage>
+DefaultBtMessageFactory::createPreparedMessage(uint8_t id, const char* name,
+                                               BufferSlice data)
+{
+  auto msg = make_unique<BtPreparedMessage>(id, name, std::move(data));
+  setCommonProperty(msg.get());
+  return msg;
+}
+
 std::unique_ptr<BtRejectMessage>
 DefaultBtMessageFactory::createRejectMessage(size_t index, int32_t begin,
                                              int32_t length)
@@ -435,6 +447,12 @@ void DefaultBtMessageFactory::setPeerStorage(PeerStorage* peerStorage)
   peerStorage_ = peerStorage;
 }
 
+void DefaultBtMessageFactory::setPieceHashChecker(
+    BtPieceHashChecker* pieceHashChecker)
+{
+  pieceHashChecker_ = pieceHashChecker;
+}
+
 void DefaultBtMessageFactory::setBtMessageDispatcher(
     BtMessageDispatcher* dispatcher)
 {
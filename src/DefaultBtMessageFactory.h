@@ -53,6 +53,7 @@ class DHTNode;
 class DHTRoutingTable;
 class DHTTaskQueue;
 class DHTTaskFactory;
+class BtPieceHashChecker;
 
 class DefaultBtMessageFactory : public BtMessageFactory {
 private:
@@ -80,6 +81,8 @@ private:
 
   DHTTaskFactory* taskFactory_;
 
+  BtPieceHashChecker* pieceHashChecker_;
+
   bool metadataGetMode_;
 
   void setCommonProperty(AbstractBtMessage* msg);
@@ -136,6 +139,10 @@ public:
   virtual std::unique_ptr<BtHaveNoneMessage>
   createHaveNoneMessage() CXX11_OVERRIDE;
 
+  virtual std::unique_ptr<BtPreparedMessage>
+  createPreparedMessage(uint8_t id, const char* name,
+                        BufferSlice data) CXX11_OVERRIDE;
+
   virtual std::unique_ptr<BtRejectMessage>
   createRejectMessage(size_t index, int32_t begin,
                       int32_t length) CXX11_OVERRIDE;
@@ -157,6 +164,8 @@ public:
 
   void setPeerStorage(PeerStorage* peerStorage);
 
+  void setPieceHashChecker(BtPieceHashChecker* pieceHashChecker);
+
   void setCuid(cuid_t cuid) { cuid_ = cuid; }
 
   void setDHTEnabled(bool enabled) { dhtEnabled_ = enabled; }
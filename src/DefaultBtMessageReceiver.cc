@@ -130,6 +130,8 @@ std::unique_ptr<BtMessage> DefaultBtMessageReceiver::receiveMessage()
   if (msg->getId() == BtPieceMessage::ID) {
     auto piecemsg = static_cast<BtPieceMessage*>(msg.get());
     piecemsg->setMsgPayload(peerConnection_->getMsgPayloadBuffer());
+    auto capacity = peerConnection_->getPieceBlockCapacity();
+    piecemsg->setBlock(peerConnection_->popPieceBlock(), capacity);
   }
   return msg;
 }
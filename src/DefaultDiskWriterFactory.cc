@@ -35,12 +35,22 @@
 #include "DefaultDiskWriterFactory.h"
 #include "DefaultDiskWriter.h"
 #include "a2functional.h"
+#ifdef HAVE_IO_URING
+#include "UringDiskWriter.h"
+#include "SingletonHolder.h"
+#endif // HAVE_IO_URING
 
 namespace aria2 {
 
 std::unique_ptr<DiskWriter>
 DefaultDiskWriterFactory::newDiskWriter(const std::string& filename)
 {
+#ifdef HAVE_IO_URING
+  auto& ring = SingletonHolder<IOUring>::instance();
+  if (ring) {
+    return make_unique<UringDiskWriter>(filename, ring.get());
+  }
+#endif // HAVE_IO_URING
   return make_unique<DefaultDiskWriter>(filename);
 }
 
@@ -34,6 +34,8 @@
 /* copyright --> */
 #include "DefaultPieceStorage.h"
 
+#include <cassert>
+#include <cstring>
 #include <numeric>
 #include <algorithm>
 
@@ -71,6 +73,8 @@
 #include "SimpleRandomizer.h"
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
+#include "BtHaveMessage.h"
+#include "BtBitfieldMessage.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -710,29 +714,12 @@ int32_t DefaultPieceStorage::getPieceLength(size_t index)
 void DefaultPieceStorage::advertisePiece(cuid_t cuid, size_t index,
                                          Timer registeredTime)
 {
+#ifdef ENABLE_BITTORRENT
+  appendHaveMessage(nextHaveIndex_, index);
+#endif // ENABLE_BITTORRENT
   haves_.emplace_back(nextHaveIndex_++, cuid, index, std::move(registeredTime));
 }
 
-uint64_t DefaultPieceStorage::getAdvertisedPieceIndexes(
-    std::vector<size_t>& indexes, cuid_t myCuid, uint64_t lastHaveIndex)
-{
-  auto it =
-      std::upper_bound(std::begin(haves_), std::end(haves_), lastHaveIndex,
-                       [](uint64_t lastHaveIndex, const HaveEntry& have) {
-                         return lastHaveIndex < have.haveIndex;
-                       });
-
-  if (it == std::end(haves_)) {
-    return lastHaveIndex;
-  }
-
-  for (; it != std::end(haves_); ++it) {
-    indexes.push_back((*it).index);
-  }
-
-  return (*(std::end(haves_) - 1)).haveIndex;
-}
-
 void DefaultPieceStorage::removeAdvertisedPiece(const Timer& expiry)
 {
   auto it = std::upper_bound(std::begin(haves_), std::end(haves_), expiry,
@@ -745,7 +732,89 @@ void DefaultPieceStorage::removeAdvertisedPiece(const Timer& expiry)
           static_cast<unsigned long>(std::distance(std::begin(haves_), it))));
 
   haves_.erase(std::begin(haves_), it);
+
+#ifdef ENABLE_BITTORRENT
+  // Remove the chunks all of which messages were removed.
+  while (!haveChunks_.empty()) {
+    const auto& chunk = haveChunks_.front();
+    if (!haves_.empty() &&
+        chunk.firstHaveIndex + chunk.numHaves > haves_.front().haveIndex) {
+      break;
+    }
+    haveChunks_.pop_front();
+  }
+#endif // ENABLE_BITTORRENT
+}
+
+#ifdef ENABLE_BITTORRENT
+namespace {
+constexpr size_t HAVE_MESSAGE_LENGTH = 9;
+constexpr size_t HAVES_PER_CHUNK = 128;
+} // namespace
+
+void DefaultPieceStorage::appendHaveMessage(uint64_t haveIndex, size_t index)
+{
+  if (haveChunks_.empty() || haveChunks_.back().numHaves == HAVES_PER_CHUNK) {
+    haveChunks_.push_back(HaveChunk{
+        haveIndex, 0,
+        BufferSlice::allocate(HAVES_PER_CHUNK * HAVE_MESSAGE_LENGTH)});
+  }
+  auto& chunk = haveChunks_.back();
+  // The slices returned by getAdvertisedPieceMessages() refer to
+  // the former part of the chunk only, so that it is safe to write
+  // here.
+  auto p = chunk.data.data() + chunk.numHaves * HAVE_MESSAGE_LENGTH;
+  bittorrent::createPeerMessageString(p, HAVE_MESSAGE_LENGTH, 5,
+                                      BtHaveMessage::ID);
+  bittorrent::setIntParam(p + 5, index);
+  ++chunk.numHaves;
+}
+
+uint64_t DefaultPieceStorage::getAdvertisedPieceMessages(
+    std::vector<BufferSlice>& messages, size_t& numHaves,
+    uint64_t lastHaveIndex)
+{
+  numHaves = 0;
+  if (haves_.empty() || haves_.back().haveIndex <= lastHaveIndex) {
+    return lastHaveIndex;
+  }
+  auto first = std::max(lastHaveIndex + 1, haves_.front().haveIndex);
+  auto it = std::upper_bound(std::begin(haveChunks_), std::end(haveChunks_),
+                             first, [](uint64_t first, const HaveChunk& chunk) {
+                               return first < chunk.firstHaveIndex;
+                             });
+  assert(it != std::begin(haveChunks_));
+  --it;
+  for (; it != std::end(haveChunks_); ++it) {
+    const auto& chunk = *it;
+    size_t offset = std::max(first, chunk.firstHaveIndex) -
+                    chunk.firstHaveIndex;
+    size_t n = chunk.numHaves - offset;
+    messages.push_back(chunk.data.slice(offset * HAVE_MESSAGE_LENGTH,
+                                        n * HAVE_MESSAGE_LENGTH));
+    numHaves += n;
+  }
+  return haves_.back().haveIndex;
+}
+
+BufferSlice DefaultPieceStorage::getBitfieldMessage()
+{
+  auto bitfield = bitfieldMan_->getBitfield();
+  auto bitfieldLength = bitfieldMan_->getBitfieldLength();
+  if (bitfieldMessage_.size() != 5 + bitfieldLength ||
+      memcmp(bitfieldMessage_.data() + 5, bitfield, bitfieldLength) != 0) {
+    // Don't overwrite the old message, which may be still in the send
+    // buffer of other peers.
+    bitfieldMessage_ = BufferSlice::allocate(5 + bitfieldLength);
+    bittorrent::createPeerMessageString(bitfieldMessage_.data(),
+                                        bitfieldMessage_.size(),
+                                        1 + bitfieldLength,
+                                        BtBitfieldMessage::ID);
+    memcpy(bitfieldMessage_.data() + 5, bitfield, bitfieldLength);
+  }
+  return bitfieldMessage_;
 }
+#endif // ENABLE_BITTORRENT
 
 void DefaultPieceStorage::markAllPiecesDone() { bitfieldMan_->setAllBit(); }
 
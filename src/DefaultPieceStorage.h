@@ -89,6 +89,22 @@ private:
   uint64_t nextHaveIndex_;
   std::deque<HaveEntry> haves_;
 
+#ifdef ENABLE_BITTORRENT
+  // HAVE messages in wire format for the entries in haves_.  A chunk
+  // holds up to HAVES_PER_CHUNK messages of consecutive haveIndex.
+  struct HaveChunk {
+    uint64_t firstHaveIndex;
+    size_t numHaves;
+    BufferSlice data;
+  };
+  std::deque<HaveChunk> haveChunks_;
+
+  // The BITFIELD message returned by getBitfieldMessage() last time.
+  BufferSlice bitfieldMessage_;
+
+  void appendHaveMessage(uint64_t haveIndex, size_t index);
+#endif // ENABLE_BITTORRENT
+
   std::shared_ptr<PieceStatMan> pieceStatMan_;
 
   std::unique_ptr<PieceSelector> pieceSelector_;
@@ -169,6 +185,13 @@ public:
   getMissingFastPiece(const std::shared_ptr<Peer>& peer,
                       const std::vector<size_t>& excludedIndexes, cuid_t cuid);
 
+  virtual uint64_t
+  getAdvertisedPieceMessages(std::vector<BufferSlice>& messages,
+                             size_t& numHaves,
+                             uint64_t lastHaveIndex) CXX11_OVERRIDE;
+
+  virtual BufferSlice getBitfieldMessage() CXX11_OVERRIDE;
+
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece() CXX11_OVERRIDE;
@@ -241,10 +264,6 @@ public:
   virtual void advertisePiece(cuid_t cuid, size_t index,
                               Timer registeredTime) CXX11_OVERRIDE;
 
-  virtual uint64_t
-  getAdvertisedPieceIndexes(std::vector<size_t>& indexes, cuid_t myCuid,
-                            uint64_t lastHaveIndex) CXX11_OVERRIDE;
-
   virtual void removeAdvertisedPiece(const Timer& expiry) CXX11_OVERRIDE;
 
   virtual void markAllPiecesDone() CXX11_OVERRIDE;
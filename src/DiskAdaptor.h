@@ -49,6 +49,8 @@ class FileEntry;
 class FileAllocationIterator;
 class WrDiskCacheEntry;
 class OpenedFileCounter;
+class SocketCore;
+class FileRegion;
 
 class DiskAdaptor : public BinaryStream {
 public:
@@ -111,8 +113,32 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) = 0;
 
-  // Writes cached data to the underlying disk.
-  virtual void writeCache(const WrDiskCacheEntry* entry) = 0;
+  // Writes cached data to the underlying disk.  If the DiskWriter
+  // accepts the ownership of the buffers, the buffers of the data
+  // cells are handed to it and the data member of those cells is set
+  // to nullptr.
+  virtual void writeCache(WrDiskCacheEntry* entry) = 0;
+
+  // Sends up to len bytes of data at offset to socket using
+  // DiskWriter::sendFile().  Returns the number of bytes sent, or -1
+  // if zero-copy send is not supported.  The default implementation
+  // returns -1.
+  virtual ssize_t sendFile(SocketCore& socket, size_t len, int64_t offset)
+  {
+    return -1;
+  }
+
+  // Appends the regions of the files holding the data in [offset,
+  // offset + len) to regions, so that another thread reads them.
+  // The data at offset goes to dataOffset of the buffer given to
+  // FileRegion::read().  Returns false if this is not supported, in
+  // which case regions is unchanged and the caller uses readData()
+  // instead.  The default implementation returns false.
+  virtual bool getFileRegions(std::vector<FileRegion>& regions,
+                              size_t dataOffset, int64_t offset, size_t len)
+  {
+    return false;
+  }
 
   void setFileAllocationMethod(FileAllocationMethod method)
   {
@@ -37,8 +37,14 @@
 
 #include "BinaryStream.h"
 
+#include <memory>
+
+#include "a2netcompat.h"
+
 namespace aria2 {
 
+class SocketCore;
+
 /**
  * Interface for writing to a binary stream of bytes.
  *
@@ -85,6 +91,50 @@ public:
 
   // Drops cache in range [offset, offset + len)
   virtual void dropCache(int64_t len, int64_t offset) {}
+
+  // Returns a duplicate of the file descriptor, with which another
+  // thread reads the range [offset, offset + len) with pread().  The
+  // data written to the range so far can be read through it.  The
+  // caller closes it.  Returns -1 if this is not supported or no fd
+  // is available.  The default implementation returns -1.
+  virtual int dupForRead(int64_t offset, size_t len) { return -1; }
+
+  // Writes iovcnt buffers in iov to the contiguous region starting at
+  // offset.  The default implementation calls writeData() for each
+  // buffer.
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset)
+  {
+    for (size_t i = 0; i < iovcnt; ++i) {
+      writeData(reinterpret_cast<const unsigned char*>(iov[i].A2IOVEC_BASE),
+                iov[i].A2IOVEC_LEN, offset);
+      offset += iov[i].A2IOVEC_LEN;
+    }
+  }
+
+  // Returns true if writeDataOwned() keeps the given buffer instead
+  // of copying or writing it synchronously.  If this returns false,
+  // the caller should prefer writeDataVector() for adjacent buffers.
+  virtual bool acceptsDataOwnership() const { return false; }
+
+  // Writes len bytes at data.get()+begin to offset.  The ownership of
+  // data, which must be allocated by new[], is taken by this object.
+  // The default implementation calls writeData().
+  virtual void writeDataOwned(std::unique_ptr<unsigned char[]> data,
+                              size_t begin, size_t len, int64_t offset)
+  {
+    writeData(data.get() + begin, len, offset);
+  }
+
+  // Sends up to len bytes of data at offset to socket without copying
+  // them to user space.  Returns the number of bytes sent, which is 0
+  // if socket is not writable.  Returns -1 if zero-copy send is not
+  // supported, in which case the caller must use readData() instead.
+  // The default implementation returns -1.
+  virtual ssize_t sendFile(SocketCore& socket, size_t len, int64_t offset)
+  {
+    return -1;
+  }
 };
 
 } // namespace aria2
@@ -58,6 +58,7 @@
 #include "prefs.h"
 #include "fmt.h"
 #include "RequestGroupMan.h"
+#include "DownloadShaper.h"
 #include "wallclock.h"
 #include "SinkStreamFilter.h"
 #include "FileEntry.h"
@@ -94,7 +95,7 @@ DownloadCommand::DownloadCommand(
     }
   }
 
-  peerStat_ = req->initPeerStat();
+  peerStat_ = req->initPeerStat(getCuid());
   peerStat_->downloadStart();
   getSegmentMan()->registerPeerStat(peerStat_);
 
@@ -132,13 +133,14 @@ void flushWrDiskCacheEntry(WrDiskCache* wrDiskCache,
 
 bool DownloadCommand::executeInternal()
 {
-  if (getDownloadEngine()
-          ->getRequestGroupMan()
-          ->doesOverallDownloadSpeedExceed() ||
-      getRequestGroup()->doesDownloadSpeedExceed()) {
+  auto shaper = getDownloadEngine()->getRequestGroupMan()->getDownloadShaper();
+  if (!shaper->canDownload(getRequestGroup())) {
     addCommandSelf();
     disableReadCheckSocket();
     disableWriteCheckSocket();
+    // The quota is handed out every tick.  Make sure that this
+    // command is executed again by then.
+    getDownloadEngine()->addWakeup(this, DownloadShaper::TICK);
     return false;
   }
   setReadCheckSocket(getSocket());
@@ -157,8 +159,16 @@ bool DownloadCommand::executeInternal()
     // read data from socket here, we will get EOF and leaves 2nd
     // response unprocessed.  To prevent this, we don't read from
     // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-          !getSocket()->wantWrite();
+    // Read exactly the quota granted by the shaper, and give back what
+    // was not read.
+    size_t quota = shaper->acquire(getRequestGroup(),
+                                   getSocketRecvBuffer()->getCapacity());
+    if (quota > 0) {
+      size_t nread = getSocketRecvBuffer()->recv(quota);
+      shaper->release(getRequestGroup(), quota - nread);
+      eof = nread == 0 && !getSocket()->wantRead() &&
+            !getSocket()->wantWrite();
+    }
   }
   if (!eof) {
     size_t bufSize;
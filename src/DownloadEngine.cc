@@ -67,6 +67,8 @@
 #include "DownloadContext.h"
 #include "fmt.h"
 #include "wallclock.h"
+#include "BufferPool.h"
+#include "SocketPool.h"
 #ifdef ENABLE_BITTORRENT
 #include "BtRegistry.h"
 #endif // ENABLE_BITTORRENT
@@ -75,6 +77,10 @@
 #endif // ENABLE_WEBSOCKET
 #include "Option.h"
 #include "util_security.h"
+#ifdef HAVE_IO_URING
+#include "IOUring.h"
+#include "SingletonHolder.h"
+#endif // HAVE_IO_URING
 
 namespace aria2 {
 
@@ -92,11 +98,15 @@ volatile sig_atomic_t globalHaltRequested = 0;
 
 namespace {
 constexpr auto DEFAULT_REFRESH_INTERVAL = 1_s;
+// The timer wheel covers DEFAULT_REFRESH_INTERVAL in one round.
+constexpr auto TIMER_WHEEL_RESOLUTION = std::chrono::milliseconds(10);
+constexpr size_t TIMER_WHEEL_SLOTS = 128;
 } // namespace
 
 DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
     : eventPoll_(std::move(eventPoll)),
       haltRequested_(0),
+      socketPool_(make_unique<SocketPool>()),
       noWait_(true),
       refreshInterval_(DEFAULT_REFRESH_INTERVAL),
       lastRefresh_(Timer::zero()),
@@ -108,7 +118,9 @@ DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
       asyncDNSServers_(nullptr),
 #endif // HAVE_ARES_ADDR_NODE
       dnsCache_(make_unique<DNSCache>()),
-      option_(nullptr)
+      bufferPool_(make_unique<BufferPool>()),
+      option_(nullptr),
+      timerWheel_(TIMER_WHEEL_RESOLUTION, TIMER_WHEEL_SLOTS)
 {
   unsigned char sessionId[20];
   util::generateRandomKey(sessionId);
@@ -155,6 +167,79 @@ public:
 };
 } // namespace
 
+std::unique_ptr<Command> DownloadEngine::detachCommand(Command* command)
+{
+  auto com = std::move(*command->enginePos_);
+  commands_.erase(command->enginePos_);
+  timerWheel_.remove(&command->timerEntry_);
+  command->wakeupTime_ = Timer::zero();
+  command->readyList_ = nullptr;
+  command->ready_ = false;
+  return com;
+}
+
+namespace {
+void executeCommand(std::unique_ptr<Command> com)
+{
+  com->transitStatus();
+  if (com->execute()) {
+    com.reset();
+  }
+  else {
+    com->clearIOEvents();
+    com.release();
+  }
+}
+} // namespace
+
+void DownloadEngine::executeReadyCommands()
+{
+  // Commands which become ready while executing the commands below
+  // will be executed in the next iteration.
+  std::vector<Command*> ready;
+  ready.swap(readyCommands_);
+  for (auto command : ready) {
+    if (!command->statusMatch(Command::STATUS_ACTIVE)) {
+      // Status was changed back to inactive after it became ready.
+      command->ready_ = false;
+      command->clearIOEvents();
+      continue;
+    }
+    executeCommand(detachCommand(command));
+  }
+}
+
+void DownloadEngine::wakeupCommands()
+{
+  std::vector<TimerWheel::Entry*> expired;
+  timerWheel_.expire(global::wallclock(), expired);
+  for (auto entry : expired) {
+    auto command = entry->getCommand();
+    command->wakeupTime_ = Timer::zero();
+    // A ready command is executed anyway.  Don't downgrade the
+    // realtime one.
+    if (!command->statusMatch(Command::STATUS_ACTIVE)) {
+      command->setStatusActive();
+    }
+  }
+}
+
+void DownloadEngine::executeAllCommands()
+{
+  // All commands are executed below.  Mark them ready so that they
+  // are not appended to readyCommands_ while waiting for their turn.
+  readyCommands_.clear();
+  for (auto& command : commands_) {
+    command->ready_ = true;
+  }
+  // Commands added while executing the commands below will be
+  // executed in the next iteration.
+  size_t max = commands_.size();
+  for (size_t i = 0; i < max; ++i) {
+    executeCommand(detachCommand(commands_.front().get()));
+  }
+}
+
 int DownloadEngine::run(bool oneshot)
 {
   GlobalHaltRequestedFinalizer ghrf;
@@ -165,16 +250,29 @@ int DownloadEngine::run(bool oneshot)
     noWait_ = false;
     global::wallclock().reset();
     calculateStatistics();
-    if (lastRefresh_.difference(global::wallclock()) + A2_DELTA_MILLIS >=
-        refreshInterval_) {
+    // All commands are executed in the first iteration and when
+    // setRefreshInterval() shortened the interval.  Otherwise, the
+    // commands not executed for a while are made ready by
+    // timerWheel_.
+    if (lastRefresh_.isZero() ||
+        (refreshInterval_ < DEFAULT_REFRESH_INTERVAL &&
+         lastRefresh_.difference(global::wallclock()) + A2_DELTA_MILLIS >=
+             refreshInterval_)) {
       refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
       lastRefresh_ = global::wallclock();
-      executeCommand(commands_, Command::STATUS_ALL);
+      executeAllCommands();
     }
     else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+      wakeupCommands();
+      executeReadyCommands();
     }
     executeCommand(routineCommands_, Command::STATUS_ALL);
+#ifdef HAVE_IO_URING
+    if (SingletonHolder<IOUring>::instance()) {
+      // Submits the writes queued in this iteration in batch.
+      SingletonHolder<IOUring>::instance()->submit();
+    }
+#endif // HAVE_IO_URING
     afterEachIteration();
     if (!noWait_ && oneshot) {
       return 1;
@@ -191,8 +289,8 @@ void DownloadEngine::waitData()
     tv.tv_sec = tv.tv_usec = 0;
   }
   else {
-    auto t =
-        std::chrono::duration_cast<std::chrono::microseconds>(refreshInterval_);
+    auto t = std::chrono::duration_cast<std::chrono::microseconds>(
+        timerWheel_.getTimeout(Timer(), refreshInterval_));
     tv.tv_sec = t.count() / 1000000;
     tv.tv_usec = t.count() % 1000000;
   }
@@ -227,6 +325,16 @@ bool DownloadEngine::deleteSocketForWriteCheck(
                                   EventPoll::EVENT_WRITE);
 }
 
+bool DownloadEngine::addFdForReadCheck(int fd, Command* command)
+{
+  return eventPoll_->addEvents(fd, command, EventPoll::EVENT_READ);
+}
+
+bool DownloadEngine::deleteFdForReadCheck(int fd, Command* command)
+{
+  return eventPoll_->deleteEvents(fd, command, EventPoll::EVENT_READ);
+}
+
 void DownloadEngine::calculateStatistics()
 {
   if (statCalc_) {
@@ -301,74 +409,15 @@ void DownloadEngine::addRoutineCommand(std::unique_ptr<Command> command)
   routineCommands_.push_back(std::move(command));
 }
 
-void DownloadEngine::poolSocket(const std::string& key,
-                                const SocketPoolEntry& entry)
-{
-  A2_LOG_INFO(fmt("Pool socket for %s", key.c_str()));
-  std::multimap<std::string, SocketPoolEntry>::value_type p(key, entry);
-  socketPool_.insert(p);
-}
-
-void DownloadEngine::evictSocketPool()
-{
-  if (socketPool_.empty()) {
-    return;
-  }
-
-  std::multimap<std::string, SocketPoolEntry> newPool;
-  A2_LOG_DEBUG("Scanning SocketPool and erasing timed out entry.");
-  for (auto& elem : socketPool_) {
-    if (!elem.second.isTimeout()) {
-      newPool.insert(elem);
-    }
-  }
-  A2_LOG_DEBUG(
-      fmt("%lu entries removed.",
-          static_cast<unsigned long>(socketPool_.size() - newPool.size())));
-  socketPool_ = std::move(newPool);
-}
-
-namespace {
-std::string createSockPoolKey(const std::string& host, uint16_t port,
-                              const std::string& username,
-                              const std::string& proxyhost, uint16_t proxyport)
-{
-  std::string key;
-  if (!username.empty()) {
-    key += util::percentEncode(username);
-    key += "@";
-  }
-  key += fmt("%s(%u)", host.c_str(), port);
-  if (!proxyhost.empty()) {
-    key += fmt("/%s(%u)", proxyhost.c_str(), proxyport);
-  }
-  return key;
-}
-} // namespace
-
-void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
-                                const std::string& username,
-                                const std::string& proxyhost,
-                                uint16_t proxyport,
-                                const std::shared_ptr<SocketCore>& sock,
+void DownloadEngine::poolSocket(const SocketPoolKey& key,
+                                const std::shared_ptr<SocketCore>& socket,
                                 const std::string& options,
                                 std::chrono::seconds timeout)
 {
-  SocketPoolEntry e(sock, options, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, username, proxyhost, proxyport),
-             e);
+  socketPool_->put(key, socket, options, std::move(timeout));
 }
 
-void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
-                                const std::string& proxyhost,
-                                uint16_t proxyport,
-                                const std::shared_ptr<SocketCore>& sock,
-                                std::chrono::seconds timeout)
-{
-  SocketPoolEntry e(sock, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport),
-             e);
-}
+void DownloadEngine::evictSocketPool() { socketPool_->evict(); }
 
 namespace {
 bool getPeerInfo(Endpoint& res, const std::shared_ptr<SocketCore>& socket)
@@ -386,23 +435,20 @@ bool getPeerInfo(Endpoint& res, const std::shared_ptr<SocketCore>& socket)
 }
 } // namespace
 
+namespace {
+bool isTLS(const std::shared_ptr<Request>& request)
+{
+  return request->getProtocol() == "https";
+}
+} // namespace
+
 void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
                                 const std::shared_ptr<Request>& proxyRequest,
                                 const std::shared_ptr<SocketCore>& socket,
                                 std::chrono::seconds timeout)
 {
-  if (proxyRequest) {
-    // If proxy is defined, then pool socket with its hostname.
-    poolSocket(request->getHost(), request->getPort(), proxyRequest->getHost(),
-               proxyRequest->getPort(), socket, std::move(timeout));
-    return;
-  }
-
-  Endpoint peerInfo;
-  if (getPeerInfo(peerInfo, socket)) {
-    poolSocket(peerInfo.addr, peerInfo.port, A2STR::NIL, 0, socket,
-               std::move(timeout));
-  }
+  poolSocket(request, A2STR::NIL, proxyRequest, socket, A2STR::NIL,
+             std::move(timeout));
 }
 
 void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
@@ -414,50 +460,30 @@ void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
 {
   if (proxyRequest) {
     // If proxy is defined, then pool socket with its hostname.
-    poolSocket(request->getHost(), request->getPort(), username,
-               proxyRequest->getHost(), proxyRequest->getPort(), socket,
-               options, std::move(timeout));
+    poolSocket(SocketPoolKey(request->getHost(), request->getPort(), username,
+                             proxyRequest->getHost(), proxyRequest->getPort(),
+                             isTLS(request)),
+               socket, options, std::move(timeout));
     return;
   }
 
   Endpoint peerInfo;
   if (getPeerInfo(peerInfo, socket)) {
-    poolSocket(peerInfo.addr, peerInfo.port, username, A2STR::NIL, 0, socket,
-               options, std::move(timeout));
+    poolSocket(SocketPoolKey(peerInfo.addr, peerInfo.port, username,
+                             A2STR::NIL, 0, isTLS(request)),
+               socket, options, std::move(timeout));
   }
 }
 
-std::multimap<std::string, DownloadEngine::SocketPoolEntry>::iterator
-DownloadEngine::findSocketPoolEntry(const std::string& key)
-{
-  std::pair<std::multimap<std::string, SocketPoolEntry>::iterator,
-            std::multimap<std::string, SocketPoolEntry>::iterator>
-      range = socketPool_.equal_range(key);
-  for (auto i = range.first, eoi = range.second; i != eoi; ++i) {
-    const SocketPoolEntry& e = (*i).second;
-    // We assume that if socket is readable it means peer shutdowns
-    // connection and the socket will receive EOF. So skip it.
-    if (!e.isTimeout() && !e.getSocket()->isReadable(0)) {
-      A2_LOG_INFO(fmt("Found socket for %s", key.c_str()));
-      return i;
-    }
-  }
-  return socketPool_.end();
-}
-
 std::shared_ptr<SocketCore>
 DownloadEngine::popPooledSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& proxyhost,
-                                uint16_t proxyport)
+                                uint16_t proxyport, bool tls)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    socketPool_.erase(i);
-  }
-  return s;
+  std::string options;
+  return socketPool_->pop(
+      options,
+      SocketPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport, tls));
 }
 
 std::shared_ptr<SocketCore>
@@ -466,29 +492,22 @@ DownloadEngine::popPooledSocket(std::string& options, const std::string& ipaddr,
                                 const std::string& proxyhost,
                                 uint16_t proxyport)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, username, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    options = (*i).second.getOptions();
-    socketPool_.erase(i);
-  }
-  return s;
+  return socketPool_->pop(
+      options,
+      SocketPoolKey(ipaddr, port, username, proxyhost, proxyport, false));
 }
 
 std::shared_ptr<SocketCore>
 DownloadEngine::popPooledSocket(const std::vector<std::string>& ipaddrs,
-                                uint16_t port)
+                                uint16_t port, bool tls)
 {
-  std::shared_ptr<SocketCore> s;
+  std::vector<SocketPoolKey> keys;
+  keys.reserve(ipaddrs.size());
   for (const auto& ipaddr : ipaddrs) {
-    s = popPooledSocket(ipaddr, port, A2STR::NIL, 0);
-    if (s) {
-      break;
-    }
+    keys.push_back(SocketPoolKey(ipaddr, port, A2STR::NIL, A2STR::NIL, 0, tls));
   }
-  return s;
+  std::string options;
+  return socketPool_->pop(options, keys);
 }
 
 std::shared_ptr<SocketCore>
@@ -496,34 +515,13 @@ DownloadEngine::popPooledSocket(std::string& options,
                                 const std::vector<std::string>& ipaddrs,
                                 uint16_t port, const std::string& username)
 {
-  std::shared_ptr<SocketCore> s;
+  std::vector<SocketPoolKey> keys;
+  keys.reserve(ipaddrs.size());
   for (const auto& ipaddr : ipaddrs) {
-    s = popPooledSocket(options, ipaddr, port, username, A2STR::NIL, 0);
-    if (s) {
-      break;
-    }
+    keys.push_back(
+        SocketPoolKey(ipaddr, port, username, A2STR::NIL, 0, false));
   }
-  return s;
-}
-
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, const std::string& options,
-    std::chrono::seconds timeout)
-    : socket_(socket), options_(options), timeout_(std::move(timeout))
-{
-}
-
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, std::chrono::seconds timeout)
-    : socket_(socket), timeout_(std::move(timeout))
-{
-}
-
-DownloadEngine::SocketPoolEntry::~SocketPoolEntry() = default;
-
-bool DownloadEngine::SocketPoolEntry::isTimeout() const
-{
-  return registeredTime_.difference(global::wallclock()) >= timeout_;
+  return socketPool_->pop(options, keys);
 }
 
 cuid_t DownloadEngine::newCUID() { return cuidCounter_.newID(); }
@@ -577,14 +575,45 @@ void DownloadEngine::setRefreshInterval(std::chrono::milliseconds interval)
 
 void DownloadEngine::addCommand(std::vector<std::unique_ptr<Command>> commands)
 {
-  commands_.insert(commands_.end(),
-                   std::make_move_iterator(std::begin(commands)),
-                   std::make_move_iterator(std::end(commands)));
+  for (auto& command : commands) {
+    addCommand(std::move(command));
+  }
 }
 
 void DownloadEngine::addCommand(std::unique_ptr<Command> command)
 {
-  commands_.push_back(std::move(command));
+  auto com = command.get();
+  com->enginePos_ = commands_.insert(commands_.end(), std::move(command));
+  com->readyList_ = &readyCommands_;
+  addTimer(com);
+  // Let Command::setStatus() append this command to readyCommands_
+  // if it is already active.
+  com->setStatus(com->status_);
+}
+
+void DownloadEngine::addTimer(Command* command)
+{
+  auto t = global::wallclock();
+  t.advance(DEFAULT_REFRESH_INTERVAL);
+  if (!command->wakeupTime_.isZero()) {
+    t = std::min(t, command->wakeupTime_);
+  }
+  timerWheel_.add(&command->timerEntry_, t);
+}
+
+void DownloadEngine::addWakeup(Command* command,
+                               std::chrono::milliseconds timeout)
+{
+  auto t = global::wallclock();
+  t.advance(timeout);
+  if (!command->wakeupTime_.isZero() && command->wakeupTime_ <= t) {
+    return;
+  }
+  command->wakeupTime_ = t;
+  if (command->readyList_ && t < command->timerEntry_.getExpiry()) {
+    timerWheel_.remove(&command->timerEntry_);
+    timerWheel_.add(&command->timerEntry_, t);
+  }
 }
 
 void DownloadEngine::setRequestGroupMan(std::unique_ptr<RequestGroupMan> rgman)
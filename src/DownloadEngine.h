@@ -39,12 +39,14 @@
 
 #include <string>
 #include <deque>
+#include <list>
 #include <map>
 #include <vector>
 #include <memory>
 
 #include "a2netcompat.h"
 #include "TimerA2.h"
+#include "TimerWheel.h"
 #include "a2io.h"
 #include "CUIDCounter.h"
 #include "FileAllocationMan.h"
@@ -65,6 +67,9 @@ class AuthConfigFactory;
 class Request;
 class EventPoll;
 class Command;
+class BufferPool;
+class SocketPool;
+class SocketPoolKey;
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
@@ -93,36 +98,7 @@ private:
 
   int haltRequested_;
 
-  class SocketPoolEntry {
-  private:
-    std::shared_ptr<SocketCore> socket_;
-    // protocol specific option string
-    std::string options_;
-
-    std::chrono::seconds timeout_;
-
-    Timer registeredTime_;
-
-  public:
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    const std::string& option, std::chrono::seconds timeout);
-
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    std::chrono::seconds timeout);
-
-    ~SocketPoolEntry();
-
-    bool isTimeout() const;
-
-    const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
-
-    const std::string& getOptions() const { return options_; }
-  };
-
-  // key = IP address:port, value = SocketPoolEntry
-  std::multimap<std::string, SocketPoolEntry> socketPool_;
-
-  Timer lastSocketPoolScan_;
+  std::unique_ptr<SocketPool> socketPool_;
 
   bool noWait_;
 
@@ -143,6 +119,9 @@ private:
 
   std::unique_ptr<DNSCache> dnsCache_;
 
+  // Pool of the buffers used by BitTorrent peer connections.
+  std::unique_ptr<BufferPool> bufferPool_;
+
   std::unique_ptr<AuthConfigFactory> authConfigFactory_;
 
 #ifdef ENABLE_WEBSOCKET
@@ -158,19 +137,47 @@ private:
 
   void afterEachIteration();
 
-  void poolSocket(const std::string& key, const SocketPoolEntry& entry);
+  // Removes command from commands_ and returns it.
+  std::unique_ptr<Command> detachCommand(Command* command);
+
+  // Executes commands in readyCommands_, that is, commands whose
+  // status matches Command::STATUS_ACTIVE.
+  void executeReadyCommands();
 
-  std::multimap<std::string, SocketPoolEntry>::iterator
-  findSocketPoolEntry(const std::string& key);
+  // Executes all commands in commands_ regardless of their status.
+  void executeAllCommands();
+
+  // Makes the commands whose entry of timerWheel_ has expired ready.
+  void wakeupCommands();
+
+  // Links the entry of command, which waits in commands_, to
+  // timerWheel_.
+  void addTimer(Command* command);
+
+  void poolSocket(const SocketPoolKey& key,
+                  const std::shared_ptr<SocketCore>& socket,
+                  const std::string& options, std::chrono::seconds timeout);
 
   std::unique_ptr<RequestGroupMan> requestGroupMan_;
   std::unique_ptr<FileAllocationMan> fileAllocationMan_;
   std::unique_ptr<CheckIntegrityMan> checkIntegrityMan_;
   Option* option_;
+  // Commands in commands_ whose status matches
+  // Command::STATUS_ACTIVE.  Commands are appended to this list by
+  // Command::setStatus(), so that we don't have to scan all commands
+  // in each iteration.  This must outlive commands_.
+  std::vector<Command*> readyCommands_;
   // Ensure that Commands are cleaned up before requestGroupMan_ is
   // deleted.
   std::deque<std::unique_ptr<Command>> routineCommands_;
-  std::deque<std::unique_ptr<Command>> commands_;
+  std::list<std::unique_ptr<Command>> commands_;
+  // Makes the commands in commands_ ready at the time given by
+  // addWakeup(), or when they have not been executed for
+  // DEFAULT_REFRESH_INTERVAL.  The latter replaces the periodic pass
+  // over all commands, which costs O(number of commands) in one
+  // iteration, and spreads it over iterations.  This must be
+  // destroyed before commands_, which own the entries.
+  TimerWheel timerWheel_;
 
   std::unique_ptr<util::security::HMAC> tokenHMAC_;
   std::unique_ptr<util::security::HMACResult> tokenExpected_;
@@ -195,6 +202,11 @@ public:
   bool deleteSocketForWriteCheck(const std::shared_ptr<SocketCore>& socket,
                                  Command* command);
 
+  // Checks the readability of fd, which is not a socket, such as the
+  // completion fd of HashJobGroup.
+  bool addFdForReadCheck(int fd, Command* command);
+  bool deleteFdForReadCheck(int fd, Command* command);
+
 #ifdef ENABLE_ASYNC_DNS
 
   bool addNameResolverCheck(const std::shared_ptr<AsyncNameResolver>& resolver,
@@ -208,6 +220,13 @@ public:
 
   void addCommand(std::unique_ptr<Command> command);
 
+  // Makes command ready after timeout elapses, even if no event
+  // occurs for it.  This is for the commands which wait for the
+  // quota of the speed limit.  The wakeup is cancelled when command
+  // is executed.  If the earlier wakeup has been scheduled, it is
+  // kept.
+  void addWakeup(Command* command, std::chrono::milliseconds timeout);
+
   const std::unique_ptr<RequestGroupMan>& getRequestGroupMan() const
   {
     return requestGroupMan_;
@@ -247,12 +266,6 @@ public:
 
   void addRoutineCommand(std::unique_ptr<Command> command);
 
-  void poolSocket(const std::string& ipaddr, uint16_t port,
-                  const std::string& username, const std::string& proxyhost,
-                  uint16_t proxyport, const std::shared_ptr<SocketCore>& sock,
-                  const std::string& options,
-                  std::chrono::seconds timeout = 15_s);
-
   void poolSocket(const std::shared_ptr<Request>& request,
                   const std::string& username,
                   const std::shared_ptr<Request>& proxyRequest,
@@ -260,20 +273,16 @@ public:
                   const std::string& options,
                   std::chrono::seconds timeout = 15_s);
 
-  void poolSocket(const std::string& ipaddr, uint16_t port,
-                  const std::string& proxyhost, uint16_t proxyport,
-                  const std::shared_ptr<SocketCore>& sock,
-                  std::chrono::seconds timeout = 15_s);
-
   void poolSocket(const std::shared_ptr<Request>& request,
                   const std::shared_ptr<Request>& proxyRequest,
                   const std::shared_ptr<SocketCore>& socket,
                   std::chrono::seconds timeout = 15_s);
 
+  // tls must be true if the socket is for HTTPS connection.
   std::shared_ptr<SocketCore> popPooledSocket(const std::string& ipaddr,
                                               uint16_t port,
                                               const std::string& proxyhost,
-                                              uint16_t proxyport);
+                                              uint16_t proxyport, bool tls);
 
   std::shared_ptr<SocketCore>
   popPooledSocket(std::string& options, const std::string& ipaddr,
@@ -281,7 +290,8 @@ public:
                   const std::string& proxyhost, uint16_t proxyport);
 
   std::shared_ptr<SocketCore>
-  popPooledSocket(const std::vector<std::string>& ipaddrs, uint16_t port);
+  popPooledSocket(const std::vector<std::string>& ipaddrs, uint16_t port,
+                  bool tls);
 
   std::shared_ptr<SocketCore>
   popPooledSocket(std::string& options, const std::vector<std::string>& ipaddrs,
@@ -289,6 +299,11 @@ public:
 
   void evictSocketPool();
 
+  const std::unique_ptr<SocketPool>& getSocketPool() const
+  {
+    return socketPool_;
+  }
+
   const std::unique_ptr<CookieStorage>& getCookieStorage() const;
 
 #ifdef ENABLE_BITTORRENT
@@ -300,6 +315,8 @@ public:
 
   cuid_t newCUID();
 
+  const std::unique_ptr<DNSCache>& getDNSCache() const { return dnsCache_; }
+
   const std::string& findCachedIPAddress(const std::string& hostname,
                                          uint16_t port) const;
 
@@ -318,12 +335,22 @@ public:
 
   void removeCachedIPAddress(const std::string& hostname, uint16_t port);
 
+  BufferPool* getBufferPool() const { return bufferPool_.get(); }
+
   void setAuthConfigFactory(std::unique_ptr<AuthConfigFactory> factory);
 
   const std::unique_ptr<AuthConfigFactory>& getAuthConfigFactory() const;
 
+  // Executes all commands once when interval elapses, if it is
+  // shorter than the default one.  Passing 0 executes them in the
+  // next iteration.
   void setRefreshInterval(std::chrono::milliseconds interval);
 
+  const std::chrono::milliseconds& getRefreshInterval() const
+  {
+    return refreshInterval_;
+  }
+
   const std::string getSessionId() const { return sessionId_; }
 
 #ifdef HAVE_ARES_ADDR_NODE
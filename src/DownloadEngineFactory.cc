@@ -78,6 +78,10 @@
 #include "FileAllocationEntry.h"
 #include "HttpListenCommand.h"
 #include "LogFactory.h"
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#include "SingletonHolder.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -159,7 +163,17 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
     e->setRequestGroupMan(std::move(requestGroupMan));
   }
   e->setFileAllocationMan(make_unique<FileAllocationMan>());
-  e->setCheckIntegrityMan(make_unique<CheckIntegrityMan>());
+  {
+    auto checkIntegrityMan = make_unique<CheckIntegrityMan>();
+#ifdef HAVE_STD_THREAD
+    auto& hashWorkerPool = SingletonHolder<HashWorkerPool>::instance();
+    if (hashWorkerPool) {
+      // Verify as many downloads at once as there are hash threads.
+      checkIntegrityMan->setMaxPicked(hashWorkerPool->getNumThreads());
+    }
+#endif // HAVE_STD_THREAD
+    e->setCheckIntegrityMan(std::move(checkIntegrityMan));
+  }
   e->addRoutineCommand(
       make_unique<FillRequestGroupCommand>(e->newCUID(), e.get()));
   e->addRoutineCommand(make_unique<FileAllocationDispatcherCommand>(
@@ -167,7 +181,7 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
   e->addRoutineCommand(make_unique<CheckIntegrityDispatcherCommand>(
       e->newCUID(), e->getCheckIntegrityMan().get(), e.get()));
   e->addRoutineCommand(
-      make_unique<EvictSocketPoolCommand>(e->newCUID(), e.get(), 30_s));
+      make_unique<EvictSocketPoolCommand>(e->newCUID(), e.get(), 5_s));
 
   if (op->getAsInt(PREF_AUTO_SAVE_INTERVAL) > 0) {
     e->addRoutineCommand(make_unique<AutoSaveCommand>(
@@ -0,0 +1,265 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DownloadShaper.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "RequestGroup.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+const std::chrono::milliseconds DownloadShaper::TICK(100);
+
+DownloadShaper::DownloadShaper(int maxOverallDownloadSpeedLimit)
+    : overall_(maxOverallDownloadSpeedLimit), lastTick_(Timer::zero())
+{
+}
+
+void DownloadShaper::setMaxOverallDownloadSpeedLimit(int speed)
+{
+  overall_.setRate(speed);
+}
+
+void DownloadShaper::tick(const Timer& now)
+{
+  if (lastTick_.difference(now) < TICK) {
+    return;
+  }
+  lastTick_ = now;
+  size_t numActive = 0;
+  for (auto i = std::begin(classes_); i != std::end(classes_);) {
+    auto& cls = (*i).second;
+    cls.ceil.refill(now);
+    if (cls.active) {
+      ++numActive;
+    }
+    else {
+      // The RequestGroup has not downloaded anything.  Its quota is
+      // returned to overall_, so that it is handed out to the others
+      // below.
+      if (cls.quota > 0) {
+        overall_.refund(cls.quota);
+      }
+      cls.quota = 0;
+      if (cls.ceil.isFull()) {
+        i = classes_.erase(i);
+        continue;
+      }
+    }
+    ++i;
+  }
+  if (overall_.isLimited() && numActive > 0) {
+    overall_.refill(now);
+    distribute(numActive);
+  }
+  for (auto& e : classes_) {
+    e.second.active = false;
+    e.second.hungry = false;
+  }
+}
+
+int64_t DownloadShaper::getHeadroom(const Class& cls) const
+{
+  // Don't let the quota grow beyond the burst size.
+  auto cap = overall_.getBurst();
+  if (cls.ceil.isLimited()) {
+    cap = std::min(cap, std::max(static_cast<int64_t>(0),
+                                 cls.ceil.getTokens()));
+  }
+  return std::max(static_cast<int64_t>(0), cap - cls.quota);
+}
+
+int64_t DownloadShaper::give(Class& cls, int64_t length)
+{
+  auto n = std::min(std::min(length, getHeadroom(cls)), overall_.getTokens());
+  if (n <= 0) {
+    return 0;
+  }
+  overall_.consume(n);
+  cls.quota += n;
+  return n;
+}
+
+void DownloadShaper::distribute(size_t numActive)
+{
+  if (overall_.getTokens() <= 0) {
+    return;
+  }
+  // First, each active RequestGroup is assured the same share.
+  auto share =
+      std::max(static_cast<int64_t>(1),
+               overall_.getTokens() / static_cast<int64_t>(numActive));
+  std::vector<Class*> hungry;
+  for (auto& e : classes_) {
+    auto& cls = e.second;
+    if (!cls.active) {
+      continue;
+    }
+    give(cls, share);
+    if (cls.hungry) {
+      hungry.push_back(&cls);
+    }
+  }
+  // Then the share left unused is lent to the RequestGroups which ran
+  // out of quota in the last tick.  The ones with higher priority
+  // borrow first, and the ones with the same priority borrow the
+  // same amount.
+  std::stable_sort(std::begin(hungry), std::end(hungry),
+                   [](const Class* lhs, const Class* rhs) {
+                     return lhs->priority > rhs->priority;
+                   });
+  for (auto i = std::begin(hungry);
+       i != std::end(hungry) && overall_.getTokens() > 0;) {
+    auto priority = (*i)->priority;
+    auto j = std::find_if(i, std::end(hungry), [priority](const Class* cls) {
+      return cls->priority != priority;
+    });
+    std::vector<Class*> borrowers(i, j);
+    // The share a RequestGroup cannot take is lent to the others with
+    // the same priority in the next round.
+    while (overall_.getTokens() > 0 && !borrowers.empty()) {
+      auto lend = std::max(static_cast<int64_t>(1),
+                           overall_.getTokens() /
+                               static_cast<int64_t>(borrowers.size()));
+      std::vector<Class*> next;
+      for (auto cls : borrowers) {
+        auto n = give(*cls, lend);
+        cls->borrowedLength += n;
+        if (n == lend) {
+          next.push_back(cls);
+        }
+      }
+      borrowers.swap(next);
+    }
+    i = j;
+  }
+}
+
+DownloadShaper::Class& DownloadShaper::getClass(RequestGroup* group,
+                                                const Timer& now)
+{
+  auto i = classes_.find(group->getGID());
+  if (i == std::end(classes_)) {
+    i = classes_
+            .insert(std::make_pair(
+                group->getGID(),
+                Class{TokenBucket(group->getMaxDownloadSpeedLimit()), 0,
+                      group->getDownloadPriority(), false, false, 0, 0}))
+            .first;
+    // Starts counting the elapsed time from now.
+    (*i).second.ceil.refill(now);
+  }
+  else {
+    auto& cls = (*i).second;
+    cls.ceil.setRate(group->getMaxDownloadSpeedLimit());
+    cls.priority = group->getDownloadPriority();
+  }
+  return (*i).second;
+}
+
+size_t DownloadShaper::acquire(RequestGroup* group, size_t length)
+{
+  if (!isLimited(group)) {
+    return length;
+  }
+  tick(global::wallclock());
+  auto& cls = getClass(group, global::wallclock());
+  cls.active = true;
+  auto n = static_cast<int64_t>(length);
+  if (cls.ceil.isLimited()) {
+    n = std::min(n, cls.ceil.getTokens());
+  }
+  if (overall_.isLimited()) {
+    if (n > cls.quota) {
+      n = cls.quota;
+      cls.hungry = true;
+    }
+    if (n <= 0) {
+      return 0;
+    }
+    cls.quota -= n;
+  }
+  else if (n <= 0) {
+    return 0;
+  }
+  cls.ceil.consume(n);
+  cls.grantedLength += n;
+  return n;
+}
+
+void DownloadShaper::release(RequestGroup* group, size_t length)
+{
+  if (!isLimited(group)) {
+    return;
+  }
+  auto i = classes_.find(group->getGID());
+  if (i == std::end(classes_)) {
+    return;
+  }
+  auto& cls = (*i).second;
+  cls.ceil.refund(length);
+  if (overall_.isLimited()) {
+    cls.quota += length;
+  }
+  cls.grantedLength -= length;
+}
+
+bool DownloadShaper::canDownload(RequestGroup* group)
+{
+  if (!isLimited(group)) {
+    return true;
+  }
+  tick(global::wallclock());
+  auto& cls = getClass(group, global::wallclock());
+  if (!cls.ceil.available()) {
+    cls.active = true;
+    return false;
+  }
+  if (overall_.isLimited() && cls.quota <= 0) {
+    cls.active = true;
+    cls.hungry = true;
+    return false;
+  }
+  return true;
+}
+
+bool DownloadShaper::isLimited(RequestGroup* group) const
+{
+  return overall_.isLimited() || group->getMaxDownloadSpeedLimit() > 0;
+}
+
+} // namespace aria2
@@ -0,0 +1,136 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DOWNLOAD_SHAPER_H
+#define D_DOWNLOAD_SHAPER_H
+
+#include "common.h"
+
+#include <map>
+#include <chrono>
+
+#include "TokenBucket.h"
+#include "TimerA2.h"
+#include "GroupId.h"
+
+namespace aria2 {
+
+class RequestGroup;
+
+// Hierarchical token bucket shaper for downloads.  The tokens of the
+// overall bucket, which enforces --max-overall-download-limit, are
+// handed out every TICK to the RequestGroups which are downloading.
+// Each of them is assured an equal share.  The share a RequestGroup
+// cannot use is lent to the RequestGroups which ran out of their
+// quota, the ones with higher --download-priority first.  Each
+// RequestGroup is also capped by its own bucket, which enforces
+// --max-download-limit.
+class DownloadShaper {
+public:
+  struct Class {
+    // The ceil of the RequestGroup
+    TokenBucket ceil;
+    // The bytes the RequestGroup can download under the overall
+    // limit.
+    int64_t quota;
+    int priority;
+    // true if the RequestGroup asked for quota in the current tick.
+    bool active;
+    // true if the RequestGroup got less than it asked for in the
+    // current tick.
+    bool hungry;
+    // The number of bytes granted so far.
+    int64_t grantedLength;
+    // The number of bytes borrowed from the share of the others so
+    // far.
+    int64_t borrowedLength;
+  };
+
+  DownloadShaper(int maxOverallDownloadSpeedLimit = 0);
+
+  // 0 means unlimited.
+  void setMaxOverallDownloadSpeedLimit(int speed);
+
+  int getMaxOverallDownloadSpeedLimit() const { return overall_.getRate(); }
+
+  // Returns the number of bytes, at most length, group can download
+  // now, and charges them to the quota of group.  Returns 0 if group
+  // has to wait for the next tick.
+  size_t acquire(RequestGroup* group, size_t length);
+
+  // Gives back length bytes acquired but not downloaded.
+  void release(RequestGroup* group, size_t length);
+
+  // Returns true if group can download now.  This function does not
+  // charge anything, but if it returns false, group gets the quota in
+  // the following ticks.
+  bool canDownload(RequestGroup* group);
+
+  // Returns true if the download of group is limited by either the
+  // overall limit or its own limit.
+  bool isLimited(RequestGroup* group) const;
+
+  // Refills the buckets and hands out the quota if TICK has passed
+  // since the last call.  acquire() and canDownload() call this
+  // function.
+  void tick(const Timer& now);
+
+  const TokenBucket& getOverallBucket() const { return overall_; }
+
+  const std::map<a2_gid_t, Class>& getClasses() const { return classes_; }
+
+  // The interval the quota is handed out.
+  static const std::chrono::milliseconds TICK;
+
+private:
+  Class& getClass(RequestGroup* group, const Timer& now);
+
+  // Returns the quota cls can take.
+  int64_t getHeadroom(const Class& cls) const;
+
+  // Gives at most length bytes of the tokens of overall_ to cls.
+  // Returns the number of bytes given.
+  int64_t give(Class& cls, int64_t length);
+
+  // Hands out the tokens of overall_ among numActive active classes.
+  void distribute(size_t numActive);
+
+  TokenBucket overall_;
+  std::map<a2_gid_t, Class> classes_;
+  Timer lastTick_;
+};
+
+} // namespace aria2
+
+#endif // D_DOWNLOAD_SHAPER_H
@@ -0,0 +1,114 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "FileRegion.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <cerrno>
+
+#include "a2io.h"
+
+namespace aria2 {
+
+FileRegion::FileRegion(int fd, int64_t offset, size_t length,
+                       size_t dataOffset)
+    : fd_(fd), offset_(offset), length_(length), dataOffset_(dataOffset)
+{
+}
+
+FileRegion::~FileRegion()
+{
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+FileRegion::FileRegion(FileRegion&& c)
+    : fd_(c.fd_),
+      offset_(c.offset_),
+      length_(c.length_),
+      dataOffset_(c.dataOffset_)
+{
+  c.fd_ = -1;
+}
+
+FileRegion& FileRegion::operator=(FileRegion&& c)
+{
+  if (this != &c) {
+    if (fd_ != -1) {
+      close(fd_);
+    }
+    fd_ = c.fd_;
+    offset_ = c.offset_;
+    length_ = c.length_;
+    dataOffset_ = c.dataOffset_;
+    c.fd_ = -1;
+  }
+  return *this;
+}
+
+ssize_t FileRegion::read(unsigned char* data, bool dropCache) const
+{
+#ifdef HAVE_PREAD
+  data += dataOffset_;
+  size_t nread = 0;
+  while (nread < length_) {
+    ssize_t r;
+    while ((r = a2pread(fd_, data + nread, length_ - nread,
+                        offset_ + nread)) == -1 &&
+           errno == EINTR)
+      ;
+    if (r == -1) {
+      return -1;
+    }
+    if (r == 0) {
+      break;
+    }
+    nread += r;
+  }
+#ifdef HAVE_POSIX_FADVISE
+  if (dropCache) {
+    posix_fadvise(fd_, offset_, nread, POSIX_FADV_DONTNEED);
+  }
+#endif // HAVE_POSIX_FADVISE
+  return nread;
+#else  // !HAVE_PREAD
+  errno = ENOSYS;
+  return -1;
+#endif // !HAVE_PREAD
+}
+
+} // namespace aria2
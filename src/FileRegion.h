@@ -0,0 +1,81 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_FILE_REGION_H
+#define D_FILE_REGION_H
+
+#include "common.h"
+
+namespace aria2 {
+
+// A range of a file to be read by a thread other than the one
+// running DownloadEngine.  The file descriptor is a duplicate owned
+// by this object and is only read with pread(), so that the original
+// one can be used, or closed, at the same time.
+class FileRegion {
+public:
+  // fd is closed by this object.  The region [offset, offset+length)
+  // of the file is read to dataOffset of the buffer given to read().
+  FileRegion(int fd, int64_t offset, size_t length, size_t dataOffset);
+
+  ~FileRegion();
+
+  FileRegion(FileRegion&& c);
+  FileRegion& operator=(FileRegion&& c);
+
+  FileRegion(const FileRegion&) = delete;
+  FileRegion& operator=(const FileRegion&) = delete;
+
+  int64_t getOffset() const { return offset_; }
+
+  size_t getLength() const { return length_; }
+
+  size_t getDataOffset() const { return dataOffset_; }
+
+  // Reads the region to data+getDataOffset().  If dropCache is true,
+  // the page cache of the region is dropped after reading it.
+  // Returns the number of bytes read, which is less than getLength()
+  // only at the end of the file, or -1 with errno set on error.
+  ssize_t read(unsigned char* data, bool dropCache) const;
+
+private:
+  int fd_;
+  int64_t offset_;
+  size_t length_;
+  size_t dataOffset_;
+};
+
+} // namespace aria2
+
+#endif // D_FILE_REGION_H
@@ -90,7 +90,7 @@ std::unique_ptr<Command> FtpInitiateConnectionCommand::createNextCommandProxied(
   if (proxyMethod == V_GET) {
     pooledSocket = getDownloadEngine()->popPooledSocket(
         getRequest()->getHost(), getRequest()->getPort(),
-        proxyRequest->getHost(), proxyRequest->getPort());
+        proxyRequest->getHost(), proxyRequest->getPort(), false);
   }
   else {
     pooledSocket = getDownloadEngine()->popPooledSocket(
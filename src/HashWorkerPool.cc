@@ -0,0 +1,234 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "HashWorkerPool.h"
+
+#include <cerrno>
+#include <map>
+#include <algorithm>
+
+#include "MessageDigest.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "util.h"
+#include "a2io.h"
+
+namespace aria2 {
+
+HashJob::HashJob() : index(0), length(0), dropCache(false), readError(0) {}
+
+std::string HashJob::getReadErrorString() const
+{
+  if (readError == -1) {
+    return "data is too short";
+  }
+  return util::safeStrerror(readError);
+}
+
+HashJobGroup::HashJobGroup(const std::string& hashType)
+    : hashType_(hashType),
+      numPending_(0),
+      cancelled_(false),
+      completionFds_{-1, -1},
+      notified_(false)
+{
+  if (!MessageDigest::supports(hashType_)) {
+    throw DL_ABORT_EX(fmt("Hash type %s is not supported.", hashType_.c_str()));
+  }
+#ifndef __MINGW32__
+  if (pipe(completionFds_) == -1) {
+    int errNum = errno;
+    throw DL_ABORT_EX(
+        fmt("Failed to create pipe: %s", util::safeStrerror(errNum).c_str()));
+  }
+  for (auto fd : completionFds_) {
+    util::make_fd_cloexec(fd);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+#endif // !__MINGW32__
+}
+
+HashJobGroup::~HashJobGroup()
+{
+  for (auto fd : completionFds_) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+void HashJobGroup::notifyCompletion()
+{
+  if (notified_ || completionFds_[1] == -1) {
+    return;
+  }
+  notified_ = true;
+  char c = 0;
+  while (write(completionFds_[1], &c, 1) == -1 && errno == EINTR)
+    ;
+}
+
+void HashJobGroup::clearCompletion()
+{
+  if (!notified_) {
+    return;
+  }
+  notified_ = false;
+  char c;
+  while (read(completionFds_[0], &c, 1) == -1 && errno == EINTR)
+    ;
+}
+
+HashWorkerPool::HashWorkerPool(size_t numThreads) : stop_(false)
+{
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads_.emplace_back(&HashWorkerPool::run, this);
+  }
+}
+
+HashWorkerPool::~HashWorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+    queue_.clear();
+  }
+  jobCond_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+void HashWorkerPool::submit(const std::shared_ptr<HashJobGroup>& group,
+                            std::unique_ptr<HashJob> job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++group->numPending_;
+    queue_.emplace_back(group, std::move(job));
+  }
+  jobCond_.notify_one();
+}
+
+void HashWorkerPool::collect(HashJobGroup& group,
+                             std::vector<std::unique_ptr<HashJob>>& out,
+                             std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (group.finished_.empty() && group.numPending_ > 0 &&
+      timeout.count() > 0) {
+    finishedCond_.wait_for(lock, timeout,
+                           [&group] { return !group.finished_.empty(); });
+  }
+  for (auto& job : group.finished_) {
+    out.push_back(std::move(job));
+  }
+  group.finished_.clear();
+  group.clearCompletion();
+}
+
+size_t HashWorkerPool::countPending(const HashJobGroup& group)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return group.numPending_;
+}
+
+void HashWorkerPool::cancel(HashJobGroup& group)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto i = std::remove_if(
+      std::begin(queue_), std::end(queue_),
+      [&group](const std::pair<std::shared_ptr<HashJobGroup>,
+                               std::unique_ptr<HashJob>>& item) {
+        return item.first.get() == &group;
+      });
+  group.numPending_ -= std::distance(i, std::end(queue_));
+  queue_.erase(i, std::end(queue_));
+  group.finished_.clear();
+  group.clearCompletion();
+  group.cancelled_ = true;
+}
+
+void HashWorkerPool::run()
+{
+  // The message digest contexts owned by this thread, keyed by hash
+  // type.
+  std::map<std::string, std::unique_ptr<MessageDigest>> ctxs;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    jobCond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+    auto group = std::move(queue_.front().first);
+    auto job = std::move(queue_.front().second);
+    queue_.pop_front();
+    lock.unlock();
+
+    for (auto& region : job->reads) {
+      auto nread = region.read(job->data.get(), job->dropCache);
+      if (nread == -1) {
+        job->readError = errno;
+        break;
+      }
+      if (static_cast<size_t>(nread) < region.getLength()) {
+        job->readError = -1;
+        break;
+      }
+    }
+    // Close the file descriptors now.
+    job->reads.clear();
+    if (job->readError == 0) {
+      auto& ctx = ctxs[group->getHashType()];
+      if (!ctx) {
+        ctx = MessageDigest::create(group->getHashType());
+      }
+      else {
+        ctx->reset();
+      }
+      ctx->update(job->data.get(), job->length);
+      job->digest = ctx->digest();
+    }
+
+    lock.lock();
+    --group->numPending_;
+    if (!group->cancelled_) {
+      group->finished_.push_back(std::move(job));
+      group->notifyCompletion();
+      finishedCond_.notify_all();
+    }
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,172 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HASH_WORKER_POOL_H
+#define D_HASH_WORKER_POOL_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "FileRegion.h"
+
+namespace aria2 {
+
+// Data to be hashed by HashWorkerPool.
+struct HashJob {
+  HashJob();
+
+  // Arbitrary value to identify the job, such as piece index.
+  size_t index;
+  std::unique_ptr<unsigned char[]> data;
+  size_t length;
+  // The regions of files the worker thread reads into data before
+  // hashing it, so that the thread running DownloadEngine does not
+  // block on the disk.  The rest of data is filled by the submitter.
+  std::vector<FileRegion> reads;
+  // true if the page cache of reads is dropped after reading them.
+  bool dropCache;
+  // Set by the worker thread if reads failed: errno, or -1 if a file
+  // is too short.  data is not hashed then.
+  int readError;
+  // The digest of data.  This is set by the worker thread.
+  std::string digest;
+
+  // Returns the description of readError.
+  std::string getReadErrorString() const;
+};
+
+// The jobs submitted by one user of HashWorkerPool.  The finished
+// jobs are kept in this object until they are collected.
+class HashJobGroup {
+public:
+  // Throws DlAbortEx if hashType is not supported or the completion
+  // pipe cannot be created.
+  HashJobGroup(const std::string& hashType);
+
+  ~HashJobGroup();
+
+  HashJobGroup(const HashJobGroup&) = delete;
+  HashJobGroup& operator=(const HashJobGroup&) = delete;
+
+  const std::string& getHashType() const { return hashType_; }
+
+  // Returns the file descriptor which becomes readable when a job of
+  // this group finishes, and stays readable until the finished jobs
+  // are collected.  The user registers it to DownloadEngine to be
+  // woken up.  Returns -1 on Windows, where it is not available.
+  int getCompletionFd() const { return completionFds_[0]; }
+
+private:
+  friend class HashWorkerPool;
+
+  // Makes the completion fd readable.  Called with the pool's mutex
+  // held.
+  void notifyCompletion();
+
+  // Makes the completion fd unreadable.  Called with the pool's mutex
+  // held.
+  void clearCompletion();
+
+  std::string hashType_;
+  std::deque<std::unique_ptr<HashJob>> finished_;
+  // The number of jobs submitted but not finished yet.
+  size_t numPending_;
+  bool cancelled_;
+  // The pipe written by the worker threads to wake the user up.
+  int completionFds_[2];
+  // true if a byte is in the pipe.
+  bool notified_;
+};
+
+// Fixed number of threads which read and compute the message digest
+// of the submitted data.  All functions except for the worker threads
+// must be called from the thread running DownloadEngine.  The worker
+// threads touch nothing but the jobs, including the file descriptors
+// they own, the message digest contexts they own and the completion
+// pipe of HashJobGroup.
+class HashWorkerPool {
+public:
+  HashWorkerPool(size_t numThreads);
+
+  // Stops and joins the worker threads.  The queued jobs are
+  // discarded.
+  ~HashWorkerPool();
+
+  size_t getNumThreads() const { return threads_.size(); }
+
+  void submit(const std::shared_ptr<HashJobGroup>& group,
+              std::unique_ptr<HashJob> job);
+
+  // Moves the finished jobs of group to out and makes the completion
+  // fd of group unreadable.  If no job is finished, waits for the
+  // completion of one at most timeout.  The commands run by
+  // DownloadEngine must not block: they wait for the completion fd
+  // instead.
+  void collect(HashJobGroup& group, std::vector<std::unique_ptr<HashJob>>& out,
+               std::chrono::milliseconds timeout = std::chrono::milliseconds());
+
+  // Returns the number of jobs of group submitted but not finished
+  // yet.
+  size_t countPending(const HashJobGroup& group);
+
+  // Drops the queued and finished jobs of group.  The jobs being
+  // processed are discarded when they finish.  group must not be
+  // used after this call.
+  void cancel(HashJobGroup& group);
+
+private:
+  void run();
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  // Notified when a job is queued or the pool is stopped.
+  std::condition_variable jobCond_;
+  // Notified when a job is finished.
+  std::condition_variable finishedCond_;
+  std::deque<std::pair<std::shared_ptr<HashJobGroup>, std::unique_ptr<HashJob>>>
+      queue_;
+  bool stop_;
+};
+
+} // namespace aria2
+
+#endif // D_HASH_WORKER_POOL_H
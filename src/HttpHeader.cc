@@ -33,6 +33,9 @@
  */
 /* copyright --> */
 #include "HttpHeader.h"
+
+#include <algorithm>
+
 #include "Range.h"
 #include "util.h"
 #include "A2STR.h"
@@ -51,6 +54,11 @@ void HttpHeader::put(int hdKey, const std::string& value)
   table_.insert(vt);
 }
 
+void HttpHeader::put(int hdKey, std::string&& value)
+{
+  table_.emplace(hdKey, std::move(value));
+}
+
 void HttpHeader::remove(int hdKey) { table_.erase(hdKey); }
 
 bool HttpHeader::defined(int hdKey) const { return table_.count(hdKey); }
@@ -260,4 +268,16 @@ int idInterestingHeader(const char* hdName)
   }
 }
 
+int idInterestingHeader(const char* first, const char* last)
+{
+  // Longer than any interesting header name, including the
+  // terminating NULL.
+  char hdName[32];
+  if (last - first >= static_cast<ptrdiff_t>(sizeof(hdName))) {
+    return HttpHeader::MAX_INTERESTING_HEADER;
+  }
+  *std::transform(first, last, hdName, util::toLowerChar) = '\0';
+  return idInterestingHeader(hdName);
+}
+
 } // namespace aria2
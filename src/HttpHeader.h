@@ -100,6 +100,7 @@ public:
 
   // For all methods, use lowercased header field name.
   void put(int hdKey, const std::string& value);
+  void put(int hdKey, std::string&& value);
   bool defined(int hdKey) const;
   const std::string& find(int hdKey) const;
   std::vector<std::string> findAll(int hdKey) const;
@@ -163,6 +164,10 @@ public:
 
 int idInterestingHeader(const char* hdName);
 
+// Same as above, but the header field name is given by the range
+// [first, last) and it is compared case-insensitively.
+int idInterestingHeader(const char* first, const char* last);
+
 } // namespace
 
 #endif // D_HTTP_HEADER_H
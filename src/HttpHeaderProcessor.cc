@@ -34,6 +34,7 @@
 /* copyright --> */
 #include "HttpHeaderProcessor.h"
 
+#include <cstring>
 #include <vector>
 
 #include "HttpHeader.h"
@@ -79,6 +80,7 @@ HttpHeaderProcessor::HttpHeaderProcessor(ParserMode mode)
       state_(mode == CLIENT_PARSER ? PREV_RES_VERSION : PREV_METHOD),
       lastBytesProcessed_(0),
       lastFieldHdKey_(HttpHeader::MAX_INTERESTING_HEADER),
+      hasLastField_(false),
       result_(new HttpHeader())
 {
 }
@@ -99,27 +101,53 @@ size_t getToken(std::string& buf, const unsigned char* data, size_t length,
 } // namespace
 
 namespace {
-size_t getFieldNameToken(std::string& buf, const unsigned char* data,
-                         size_t length, size_t off)
+size_t findFieldNameEnd(const unsigned char* data, size_t length, size_t off)
 {
   size_t j = off;
   while (j < length && data[j] != ':' && !util::isLws(data[j]) &&
          !util::isCRLF(data[j])) {
     ++j;
   }
+  return j;
+}
+} // namespace
+
+namespace {
+size_t getFieldNameToken(std::string& buf, const unsigned char* data,
+                         size_t length, size_t off)
+{
+  size_t j = findFieldNameEnd(data, length, off);
   buf.append(&data[off], &data[j]);
   return j - 1;
 }
 } // namespace
 
+namespace {
+// Returns the position of the first CR or LF in data[off..length), or
+// length if there is none.  memchr() is usually vectorized, which is
+// much faster than checking byte by byte for long field values.
+size_t findEol(const unsigned char* data, size_t length, size_t off)
+{
+  auto last = data + length;
+  auto lf = static_cast<const unsigned char*>(
+      memchr(data + off, '\n', length - off));
+  if (lf) {
+    last = lf;
+  }
+  auto cr = static_cast<const unsigned char*>(
+      memchr(data + off, '\r', last - (data + off)));
+  if (cr) {
+    last = cr;
+  }
+  return last - data;
+}
+} // namespace
+
 namespace {
 size_t getText(std::string& buf, const unsigned char* data, size_t length,
                size_t off)
 {
-  size_t j = off;
-  while (j < length && !util::isCRLF(data[j])) {
-    ++j;
-  }
+  size_t j = findEol(data, length, off);
   buf.append(&data[off], &data[j]);
   return j - 1;
 }
@@ -129,11 +157,7 @@ namespace {
 size_t ignoreText(std::string& buf, const unsigned char* data, size_t length,
                   size_t off)
 {
-  size_t j = off;
-  while (j < length && !util::isCRLF(data[j])) {
-    ++j;
-  }
-  return j - 1;
+  return findEol(data, length, off) - 1;
 }
 } // namespace
 
@@ -245,6 +269,7 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
         throw DL_ABORT_EX("Bad Status-Line: missing status-code");
       }
 
+      i = getToken(buf_, data, length, i);
       break;
 
     case PREV_STATUS_CODE:
@@ -326,7 +351,7 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
 
     case PREV_FIELD_NAME:
       if (util::isLws(c)) {
-        if (lastFieldName_.empty()) {
+        if (!hasLastField_) {
           throw DL_ABORT_EX("Bad HTTP header: field name starts with LWS");
         }
         // Evil Multi-line header field
@@ -334,11 +359,11 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
         break;
       }
 
-      if (!lastFieldName_.empty()) {
+      if (hasLastField_) {
         if (lastFieldHdKey_ != HttpHeader::MAX_INTERESTING_HEADER) {
           result_->put(lastFieldHdKey_, util::strip(buf_));
         }
-        lastFieldName_.clear();
+        hasLastField_ = false;
         lastFieldHdKey_ = HttpHeader::MAX_INTERESTING_HEADER;
         buf_.clear();
       }
@@ -356,8 +381,23 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
         throw DL_ABORT_EX("Bad HTTP header: field name starts with ':'");
       }
 
-      state_ = FIELD_NAME;
-      i = getFieldNameToken(lastFieldName_, data, length, i);
+      {
+        // If the whole field name is in data, look it up in place
+        // without copying it into lastFieldName_.
+        size_t j = findFieldNameEnd(data, length, i);
+        if (j < length && data[j] == ':') {
+          lastFieldHdKey_ =
+              idInterestingHeader(reinterpret_cast<const char*>(&data[i]),
+                                  reinterpret_cast<const char*>(&data[j]));
+          hasLastField_ = true;
+          state_ = PREV_FIELD_VALUE;
+          i = j;
+          break;
+        }
+        state_ = FIELD_NAME;
+        lastFieldName_.append(&data[i], &data[j]);
+        i = j - 1;
+      }
       break;
 
     case FIELD_NAME:
@@ -368,6 +408,8 @@ bool HttpHeaderProcessor::parse(const unsigned char* data, size_t length)
       if (c == ':') {
         util::lowercase(lastFieldName_);
         lastFieldHdKey_ = idInterestingHeader(lastFieldName_.c_str());
+        lastFieldName_.clear();
+        hasLastField_ = true;
         state_ = PREV_FIELD_VALUE;
         break;
       }
@@ -481,6 +523,7 @@ void HttpHeaderProcessor::clear()
   buf_.clear();
   lastFieldName_.clear();
   lastFieldHdKey_ = HttpHeader::MAX_INTERESTING_HEADER;
+  hasLastField_ = false;
   result_.reset(new HttpHeader());
   headers_.clear();
 }
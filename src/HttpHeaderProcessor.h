@@ -87,6 +87,9 @@ private:
   std::string buf_;
   std::string lastFieldName_;
   int lastFieldHdKey_;
+  // true if the name of the last header field is parsed and its value
+  // is not put into result_ yet.
+  bool hasLastField_;
   std::unique_ptr<HttpHeader> result_;
   std::string headers_;
 };
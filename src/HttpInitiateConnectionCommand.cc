@@ -77,7 +77,8 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
     std::shared_ptr<SocketCore> pooledSocket =
         getDownloadEngine()->popPooledSocket(
             getRequest()->getHost(), getRequest()->getPort(),
-            proxyRequest->getHost(), proxyRequest->getPort());
+            proxyRequest->getHost(), proxyRequest->getPort(),
+            getRequest()->getProtocol() == "https");
     std::string proxyMethod = resolveProxyMethod(getRequest()->getProtocol());
     if (!pooledSocket) {
       A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
@@ -117,8 +118,9 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
   }
   else {
     std::shared_ptr<SocketCore> pooledSocket =
-        getDownloadEngine()->popPooledSocket(resolvedAddresses,
-                                             getRequest()->getPort());
+        getDownloadEngine()->popPooledSocket(
+            resolvedAddresses, getRequest()->getPort(),
+            getRequest()->getProtocol() == "https");
     if (!pooledSocket) {
       A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
       createSocket();
@@ -0,0 +1,420 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IOUring.h"
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <linux/io_uring.h>
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+#include "DlAbortEx.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "util.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+// The number of submission queue entries.  This is also the maximum
+// number of writes in flight.
+const unsigned DEFAULT_ENTRIES = 64;
+// The maximum number of bytes in flight.  If this is exceeded, write()
+// waits for the completion of the preceding writes.
+const size_t MAX_BYTES_IN_FLIGHT = 16_m;
+// The maximum number of bytes written by one submission queue entry.
+const size_t MAX_WRITE_LENGTH = 1_g;
+} // namespace
+
+namespace {
+int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+} // namespace
+
+namespace {
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags)
+{
+  return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                 nullptr, 0);
+}
+} // namespace
+
+struct IOUring::Request {
+  Status* status;
+  int fd;
+  // IORING_OP_WRITE or IORING_OP_READ.
+  uint8_t opcode;
+  // The owner of the written data.  This is null for reads.
+  std::unique_ptr<unsigned char[]> owner;
+  unsigned char* data;
+  size_t len;
+  // The number of bytes transferred so far.
+  size_t done;
+  int64_t offset;
+  // If not null, done is stored here on completion.
+  size_t* result;
+};
+
+IOUring::IOUring()
+    : fd_(-1),
+      sqRing_(nullptr),
+      sqRingSize_(0),
+      cqRing_(nullptr),
+      cqRingSize_(0),
+      sqes_(nullptr),
+      sqesSize_(0),
+      sqHead_(nullptr),
+      sqTail_(nullptr),
+      sqMask_(0),
+      sqEntries_(0),
+      cqHead_(nullptr),
+      cqTail_(nullptr),
+      cqMask_(0),
+      cqes_(nullptr),
+      numUnsubmitted_(0),
+      numInFlight_(0),
+      bytesInFlight_(0)
+{
+}
+
+IOUring::~IOUring()
+{
+  try {
+    while (numInFlight_ > 0) {
+      enter(1);
+    }
+  }
+  catch (RecoverableException& e) {
+    // The remaining requests may still be referenced by the kernel.
+    // Leave them alone.
+    A2_LOG_ERROR_EX("Waiting for io_uring requests failed", e);
+  }
+  if (sqes_) {
+    munmap(sqes_, sqesSize_);
+  }
+  if (cqRing_ && cqRing_ != sqRing_) {
+    munmap(cqRing_, cqRingSize_);
+  }
+  if (sqRing_) {
+    munmap(sqRing_, sqRingSize_);
+  }
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+std::unique_ptr<IOUring> IOUring::create()
+{
+  std::unique_ptr<IOUring> ring(new IOUring());
+  if (!ring->init(DEFAULT_ENTRIES)) {
+    return nullptr;
+  }
+  return ring;
+}
+
+bool IOUring::init(unsigned entries)
+{
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  fd_ = ioUringSetup(entries, &params);
+  if (fd_ == -1) {
+    int errNum = errno;
+    A2_LOG_INFO(
+        fmt("io_uring_setup failed: %s", util::safeStrerror(errNum).c_str()));
+    return false;
+  }
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    A2_LOG_INFO("io_uring does not support IORING_OP_READ/WRITE");
+    return false;
+  }
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  auto p = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (p == MAP_FAILED) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("Mapping io_uring submission queue failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    return false;
+  }
+  sqRing_ = p;
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cqRing_ = sqRing_;
+  }
+  else {
+    p = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (p == MAP_FAILED) {
+      int errNum = errno;
+      A2_LOG_INFO(fmt("Mapping io_uring completion queue failed: %s",
+                      util::safeStrerror(errNum).c_str()));
+      return false;
+    }
+    cqRing_ = p;
+  }
+  sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+  p = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (p == MAP_FAILED) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("Mapping io_uring submission queue entries failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(p);
+
+  auto sq = static_cast<unsigned char*>(sqRing_);
+  sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  // We always use the submission queue entry at the same index as
+  // the slot of the submission queue.
+  auto sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  for (unsigned i = 0; i < sqEntries_; ++i) {
+    sqArray[i] = i;
+  }
+  auto cq = static_cast<unsigned char*>(cqRing_);
+  cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  A2_LOG_INFO(fmt("io_uring initialized with %u entries", sqEntries_));
+  return true;
+}
+
+void IOUring::write(Status& status, int fd,
+                    std::unique_ptr<unsigned char[]> data, size_t begin,
+                    size_t len, int64_t offset)
+{
+  // The completion queue has twice as many entries as the submission
+  // queue, so it never overflows as long as the number of requests in
+  // flight is not larger than the submission queue.
+  while (numInFlight_ >= sqEntries_ ||
+         (numInFlight_ > 0 && bytesInFlight_ + len > MAX_BYTES_IN_FLIGHT) ||
+         overlaps(fd, offset, len)) {
+    enter(1);
+  }
+  auto p = data.get() + begin;
+  auto req = new Request{&status, fd,     IORING_OP_WRITE, std::move(data), p,
+                         len,     0,      offset,          nullptr};
+  inFlight_.push_back(req);
+  ++status.pending;
+  ++numInFlight_;
+  bytesInFlight_ += len;
+  prepare(req);
+}
+
+ssize_t IOUring::read(int fd, unsigned char* data, size_t len, int64_t offset)
+{
+  while (numInFlight_ >= sqEntries_ || overlaps(fd, offset, len)) {
+    enter(1);
+  }
+  Status status;
+  size_t nread = 0;
+  auto req = new Request{&status, fd,     IORING_OP_READ, nullptr, data,
+                         len,     0,      offset,         &nread};
+  inFlight_.push_back(req);
+  ++status.pending;
+  ++numInFlight_;
+  prepare(req);
+  wait(status);
+  if (status.errNum != 0) {
+    errno = status.errNum;
+    return -1;
+  }
+  return nread;
+}
+
+void IOUring::waitRange(int fd, int64_t offset, size_t len)
+{
+  while (overlaps(fd, offset, len)) {
+    enter(1);
+  }
+}
+
+bool IOUring::overlaps(int fd, int64_t offset, size_t len) const
+{
+  for (auto req : inFlight_) {
+    if (req->opcode == IORING_OP_WRITE && req->fd == fd &&
+        req->offset < offset + static_cast<int64_t>(len) &&
+        offset < req->offset + static_cast<int64_t>(req->len)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void IOUring::prepare(Request* req)
+{
+  unsigned tail = *sqTail_;
+  auto sqe = &sqes_[tail & sqMask_];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = req->opcode;
+  sqe->fd = req->fd;
+  sqe->addr = reinterpret_cast<uintptr_t>(req->data + req->done);
+  sqe->len = std::min(req->len - req->done, MAX_WRITE_LENGTH);
+  sqe->off = req->offset + req->done;
+  sqe->user_data = reinterpret_cast<uintptr_t>(req);
+  __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+  ++numUnsubmitted_;
+}
+
+void IOUring::submit()
+{
+  if (numInFlight_ == 0) {
+    return;
+  }
+  try {
+    enter(0);
+  }
+  catch (RecoverableException& e) {
+    // The failure is recorded to Status of each request.
+    A2_LOG_ERROR_EX("Submitting io_uring requests failed", e);
+  }
+}
+
+void IOUring::wait(Status& status)
+{
+  while (status.pending > 0) {
+    enter(1);
+  }
+}
+
+void IOUring::enter(unsigned minComplete)
+{
+  unsigned toSubmit = numUnsubmitted_;
+  for (;;) {
+    int rv = ioUringEnter(fd_, toSubmit, minComplete,
+                          minComplete > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (rv >= 0) {
+      numUnsubmitted_ -= rv;
+      break;
+    }
+    int errNum = errno;
+    if (errNum == EINTR) {
+      continue;
+    }
+    if ((errNum == EAGAIN || errNum == EBUSY) && toSubmit > 0 &&
+        numInFlight_ > numUnsubmitted_) {
+      // The kernel is short of resources.  Wait for the completion
+      // of the submitted requests.  The rest will be submitted in
+      // the next call.
+      toSubmit = 0;
+      minComplete = 1;
+      continue;
+    }
+    failUnsubmitted(errNum);
+    reap();
+    throw DL_ABORT_EX3(errNum, fmt("io_uring_enter failed: %s",
+                                   util::safeStrerror(errNum).c_str()),
+                       error_code::FILE_IO_ERROR);
+  }
+  reap();
+}
+
+void IOUring::reap()
+{
+  unsigned head = *cqHead_;
+  unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    auto cqe = &cqes_[head & cqMask_];
+    auto req = reinterpret_cast<Request*>(cqe->user_data);
+    if (cqe->res < 0) {
+      complete(req, -cqe->res);
+    }
+    else if (req->opcode == IORING_OP_READ) {
+      // Like pread(), a short read is returned to the caller as is.
+      req->done += cqe->res;
+      complete(req, 0);
+    }
+    else if (cqe->res == 0) {
+      complete(req, EIO);
+    }
+    else {
+      req->done += cqe->res;
+      if (req->done == req->len) {
+        complete(req, 0);
+      }
+      else {
+        // Short write.  Write the remaining part.
+        prepare(req);
+      }
+    }
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+void IOUring::failUnsubmitted(int errNum)
+{
+  unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  unsigned tail = *sqTail_;
+  for (unsigned i = head; i != tail; ++i) {
+    complete(reinterpret_cast<Request*>(sqes_[i & sqMask_].user_data),
+             errNum);
+  }
+  __atomic_store_n(sqTail_, head, __ATOMIC_RELEASE);
+  numUnsubmitted_ = 0;
+}
+
+void IOUring::complete(Request* req, int errNum)
+{
+  std::unique_ptr<Request> r(req);
+  inFlight_.erase(std::find(std::begin(inFlight_), std::end(inFlight_), req));
+  --numInFlight_;
+  if (req->opcode == IORING_OP_WRITE) {
+    bytesInFlight_ -= req->len;
+  }
+  auto& status = *req->status;
+  --status.pending;
+  if (req->result) {
+    *req->result = req->done;
+  }
+  if (errNum != 0 && status.errNum == 0) {
+    status.errNum = errNum;
+  }
+}
+
+} // namespace aria2
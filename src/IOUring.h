@@ -0,0 +1,160 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_IO_URING_H
+#define D_IO_URING_H
+
+#include "common.h"
+
+#include <memory>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace aria2 {
+
+// Thin wrapper of Linux io_uring instance used to write file data
+// without blocking the event loop.  The submitted writes are sent to
+// the kernel in batch when submit() is called, which DownloadEngine
+// does once per iteration, or when the number of outstanding
+// requests reaches the limit.  Reads go through the same ring, so
+// that they are ordered after the writes to the same range.
+class IOUring {
+public:
+  // Tracks the writes submitted on behalf of one file.  The object
+  // must outlive the writes referring to it: call wait() before
+  // destroying it.
+  struct Status {
+    Status() : pending(0), errNum(0) {}
+    // The number of writes not completed yet.
+    size_t pending;
+    // errno of the first failed write, or 0.
+    int errNum;
+  };
+
+  ~IOUring();
+
+  // Creates io_uring instance.  Returns nullptr if io_uring is not
+  // available, for example, the kernel is too old or the system call
+  // is blocked.
+  static std::unique_ptr<IOUring> create();
+
+  // Queues the write of len bytes at data.get()+begin to fd at
+  // offset.  The ownership of data is taken by this object.  The
+  // result is recorded to status.  This function may block if too
+  // many bytes are in flight, or if a write to fd overlapping the
+  // range is in flight: the kernel may complete the writes in any
+  // order, so the preceding one must finish first not to overwrite
+  // this data.
+  void write(Status& status, int fd, std::unique_ptr<unsigned char[]> data,
+             size_t begin, size_t len, int64_t offset);
+
+  // Reads up to len bytes from fd at offset to data, after the writes
+  // to fd overlapping the range complete.  Blocks until the read
+  // completes, and returns the number of bytes read.  Returns -1 and
+  // sets errno on error.
+  ssize_t read(int fd, unsigned char* data, size_t len, int64_t offset);
+
+  // Blocks until the writes to fd overlapping [offset, offset+len)
+  // complete.  The other writes are left in flight.
+  void waitRange(int fd, int64_t offset, size_t len);
+
+  // Submits the queued writes to the kernel and processes the
+  // completed ones.  This function does not block.
+  void submit();
+
+  // Blocks until all writes recorded to status complete.
+  void wait(Status& status);
+
+  size_t getNumInFlight() const { return numInFlight_; }
+
+private:
+  struct Request;
+
+  IOUring();
+
+  bool init(unsigned entries);
+
+  // Pushes the remaining part of req to the submission queue.
+  void prepare(Request* req);
+
+  // Calls io_uring_enter.  If minComplete > 0, waits for that many
+  // completions.
+  void enter(unsigned minComplete);
+
+  // Processes completion queue entries.
+  void reap();
+
+  // Fails the requests which the kernel has not consumed yet.
+  void failUnsubmitted(int errNum);
+
+  void complete(Request* req, int errNum);
+
+  // Returns true if a write to fd overlapping [offset, offset+len) is
+  // in flight.  Reads are not taken into account.
+  bool overlaps(int fd, int64_t offset, size_t len) const;
+
+  int fd_;
+
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned sqMask_;
+  unsigned sqEntries_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  unsigned cqMask_;
+  io_uring_cqe* cqes_;
+
+  // The number of entries pushed to the submission queue but not
+  // consumed by the kernel.
+  unsigned numUnsubmitted_;
+  // The requests not completed yet.
+  std::vector<Request*> inFlight_;
+  // The number of requests not completed yet.
+  size_t numInFlight_;
+  // The number of bytes of requests not completed yet.
+  size_t bytesInFlight_;
+};
+
+} // namespace aria2
+
+#endif // D_IO_URING_H
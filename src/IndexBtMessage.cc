@@ -48,11 +48,16 @@ std::vector<unsigned char> IndexBtMessage::createMessage()
    * total: 9bytes
    */
   auto msg = std::vector<unsigned char>(MESSAGE_LENGTH);
-  bittorrent::createPeerMessageString(msg.data(), MESSAGE_LENGTH, 5, getId());
-  bittorrent::setIntParam(&msg[5], index_);
+  writeMessage(msg.data());
   return msg;
 }
 
+void IndexBtMessage::writeMessage(unsigned char* data) const
+{
+  bittorrent::createPeerMessageString(data, MESSAGE_LENGTH, 5, getId());
+  bittorrent::setIntParam(&data[5], index_);
+}
+
 std::string IndexBtMessage::toString() const
 {
   return fmt("%s index=%lu", getName(), static_cast<unsigned long>(index_));
@@ -67,6 +67,13 @@ public:
 
   virtual std::vector<unsigned char> createMessage() CXX11_OVERRIDE;
 
+  virtual size_t getMessageLength() const CXX11_OVERRIDE
+  {
+    return MESSAGE_LENGTH;
+  }
+
+  virtual void writeMessage(unsigned char* data) const CXX11_OVERRIDE;
+
   virtual std::string toString() const CXX11_OVERRIDE;
 };
 
@@ -152,8 +152,9 @@ bool InitiatorMSEHandshakeCommand::executeInternal()
     }
     case INITIATOR_RECEIVE_PAD_D: {
       if (mseHandshake_->receivePad()) {
-        auto peerConnection =
-            make_unique<PeerConnection>(getCuid(), getPeer(), getSocket());
+        auto peerConnection = make_unique<PeerConnection>(
+            getCuid(), getPeer(), getSocket(),
+            getDownloadEngine()->getBufferPool());
         if (mseHandshake_->getNegotiatedCryptoType() ==
             MSEHandshake::CRYPTO_ARC4) {
           size_t buflen = mseHandshake_->getBufferLength();
@@ -56,14 +56,22 @@ void ARC4Encryptor::init(const unsigned char* key, size_t keyLength)
 void ARC4Encryptor::encrypt(size_t len, unsigned char* out,
                             const unsigned char* in)
 {
-  for (auto c = 0u; c < len; ++c) {
-    i = (i + 1) & 0xff;
-    j = (j + state_[i]) & 0xff;
-    auto sj = state_[i];
-    auto si = state_[i] = state_[j];
-    state_[j] = sj;
-    out[c] = in[c] ^ state_[(si + sj) & 0xff];
+  // Work on local copies of the indexes.  Since out may alias them,
+  // updating the members directly forces the compiler to store and
+  // reload them for each byte.
+  auto si = i;
+  auto sj = j;
+  for (size_t c = 0; c < len; ++c) {
+    si = (si + 1) & 0xff;
+    auto a = state_[si];
+    sj = (sj + a) & 0xff;
+    auto b = state_[sj];
+    state_[si] = b;
+    state_[sj] = a;
+    out[c] = in[c] ^ state_[(a + b) & 0xff];
   }
+  i = si;
+  j = sj;
 }
 
 } // namespace aria2
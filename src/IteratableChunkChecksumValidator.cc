@@ -51,70 +51,170 @@
 #include "MessageDigest.h"
 #include "fmt.h"
 #include "DlAbortEx.h"
+#include "FileRegion.h"
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
 IteratableChunkChecksumValidator::IteratableChunkChecksumValidator(
     const std::shared_ptr<DownloadContext>& dctx,
-    const std::shared_ptr<PieceStorage>& pieceStorage)
+    const std::shared_ptr<PieceStorage>& pieceStorage,
+    HashWorkerPool* hashWorkerPool)
     : dctx_(dctx),
       pieceStorage_(pieceStorage),
       bitfield_(make_unique<BitfieldMan>(dctx_->getPieceLength(),
                                          dctx_->getTotalLength())),
-      currentIndex_(0)
+      currentIndex_(0),
+      hashWorkerPool_(hashWorkerPool),
+      nextIndex_(0),
+      waiting_(false)
 {
 }
 
-IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator() = default;
+IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator()
+{
+#ifdef HAVE_STD_THREAD
+  if (hashJobGroup_) {
+    hashWorkerPool_->cancel(*hashJobGroup_);
+  }
+#endif // HAVE_STD_THREAD
+}
+
+int64_t IteratableChunkChecksumValidator::getPieceOffset(size_t index) const
+{
+  return static_cast<int64_t>(index) * dctx_->getPieceLength();
+}
+
+size_t IteratableChunkChecksumValidator::getPieceLength(size_t index) const
+{
+  // When validating last piece
+  if (index + 1 == dctx_->getNumPieces()) {
+    return dctx_->getTotalLength() - getPieceOffset(index);
+  }
+  else {
+    return dctx_->getPieceLength();
+  }
+}
+
+void IteratableChunkChecksumValidator::checkPiece(
+    size_t index, const std::string& actualChecksum)
+{
+  if (actualChecksum == dctx_->getPieceHashes()[index]) {
+    bitfield_->setBit(index);
+  }
+  else {
+    A2_LOG_INFO(fmt(EX_INVALID_CHUNK_CHECKSUM, static_cast<unsigned long>(index),
+                    getPieceOffset(index),
+                    util::toHex(dctx_->getPieceHashes()[index]).c_str(),
+                    util::toHex(actualChecksum).c_str()));
+    bitfield_->unsetBit(index);
+  }
+}
+
+void IteratableChunkChecksumValidator::onReadError(size_t index,
+                                                   const Exception& ex)
+{
+  A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece index=%lu."
+                      " Some part of file may be missing."
+                      " Continue operation.",
+                      static_cast<unsigned long>(index)),
+                  ex);
+  bitfield_->unsetBit(index);
+}
 
 void IteratableChunkChecksumValidator::validateChunk()
 {
-  if (!finished()) {
-    std::string actualChecksum;
+  if (finished()) {
+    return;
+  }
+#ifdef HAVE_STD_THREAD
+  if (hashWorkerPool_) {
+    validateChunkInWorker();
+  }
+  else
+#endif // HAVE_STD_THREAD
+  {
     try {
-      actualChecksum = calculateActualChecksum();
-      if (actualChecksum == dctx_->getPieceHashes()[currentIndex_]) {
-        bitfield_->setBit(currentIndex_);
-      }
-      else {
-        A2_LOG_INFO(
-            fmt(EX_INVALID_CHUNK_CHECKSUM,
-                static_cast<unsigned long>(currentIndex_),
-                static_cast<int64_t>(getCurrentOffset()),
-                util::toHex(dctx_->getPieceHashes()[currentIndex_]).c_str(),
-                util::toHex(actualChecksum).c_str()));
-        bitfield_->unsetBit(currentIndex_);
-      }
+      checkPiece(currentIndex_, calculateActualChecksum());
     }
     catch (RecoverableException& ex) {
-      A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece index=%lu."
-                          " Some part of file may be missing."
-                          " Continue operation.",
-                          static_cast<unsigned long>(currentIndex_)),
-                      ex);
-      bitfield_->unsetBit(currentIndex_);
+      onReadError(currentIndex_, ex);
     }
-
     ++currentIndex_;
-    if (finished()) {
-      pieceStorage_->setBitfield(bitfield_->getBitfield(),
-                                 bitfield_->getBitfieldLength());
-    }
+  }
+  if (finished()) {
+    pieceStorage_->setBitfield(bitfield_->getBitfield(),
+                               bitfield_->getBitfieldLength());
   }
 }
 
-std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+#ifdef HAVE_STD_THREAD
+void IteratableChunkChecksumValidator::validateChunkInWorker()
 {
-  int64_t offset = getCurrentOffset();
-  size_t length;
-  // When validating last piece
-  if (currentIndex_ + 1 == dctx_->getNumPieces()) {
-    length = dctx_->getTotalLength() - offset;
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  hashWorkerPool_->collect(*hashJobGroup_, jobs);
+  // Keep at most two pieces per thread in flight so that memory usage
+  // is bounded.  The worker threads read the pieces if the
+  // DiskAdaptor supports it.  Otherwise, they are read here, at most
+  // one piece per thread in one call.
+  size_t numThreads = hashWorkerPool_->getNumThreads();
+  size_t numSubmitted = 0, numRead = 0;
+  for (; numRead < numThreads && nextIndex_ < dctx_->getNumPieces() &&
+         nextIndex_ - currentIndex_ - jobs.size() < numThreads * 2;
+       ++nextIndex_) {
+    auto job = make_unique<HashJob>();
+    job->index = nextIndex_;
+    job->length = getPieceLength(nextIndex_);
+    job->data = make_unique<unsigned char[]>(job->length);
+    job->dropCache = true;
+    try {
+      if (!pieceStorage_->getDiskAdaptor()->getFileRegions(
+              job->reads, 0, getPieceOffset(nextIndex_), job->length)) {
+        readPiece(job->data.get(), nextIndex_);
+        ++numRead;
+      }
+    }
+    catch (RecoverableException& ex) {
+      onReadError(nextIndex_, ex);
+      ++currentIndex_;
+      continue;
+    }
+    hashWorkerPool_->submit(hashJobGroup_, std::move(job));
+    ++numSubmitted;
   }
-  else {
-    length = dctx_->getPieceLength();
+  // If all pieces in flight are being processed, the caller waits for
+  // getWaitFd() rather than spinning the event loop.
+  waiting_ =
+      jobs.empty() && numSubmitted == 0 && nextIndex_ > currentIndex_;
+  for (auto& job : jobs) {
+    if (job->readError) {
+      onReadError(job->index,
+                  DL_ABORT_EX(fmt(EX_FILE_READ, dctx_->getBasePath().c_str(),
+                                  job->getReadErrorString().c_str())));
+    }
+    else {
+      checkPiece(job->index, job->digest);
+    }
   }
-  return digest(offset, length);
+  currentIndex_ += jobs.size();
+}
+#endif // HAVE_STD_THREAD
+
+int IteratableChunkChecksumValidator::getWaitFd() const
+{
+#ifdef HAVE_STD_THREAD
+  if (waiting_) {
+    return hashJobGroup_->getCompletionFd();
+  }
+#endif // HAVE_STD_THREAD
+  return -1;
+}
+
+std::string IteratableChunkChecksumValidator::calculateActualChecksum()
+{
+  return digest(getPieceOffset(currentIndex_), getPieceLength(currentIndex_));
 }
 
 void IteratableChunkChecksumValidator::init()
@@ -122,6 +222,16 @@ void IteratableChunkChecksumValidator::init()
   ctx_ = MessageDigest::create(dctx_->getPieceHashType());
   bitfield_->clearAllBit();
   currentIndex_ = 0;
+  nextIndex_ = 0;
+  waiting_ = false;
+#ifdef HAVE_STD_THREAD
+  if (hashWorkerPool_) {
+    if (hashJobGroup_) {
+      hashWorkerPool_->cancel(*hashJobGroup_);
+    }
+    hashJobGroup_ = std::make_shared<HashJobGroup>(dctx_->getPieceHashType());
+  }
+#endif // HAVE_STD_THREAD
 }
 
 std::string IteratableChunkChecksumValidator::digest(int64_t offset,
@@ -144,6 +254,22 @@ std::string IteratableChunkChecksumValidator::digest(int64_t offset,
   return ctx_->digest();
 }
 
+void IteratableChunkChecksumValidator::readPiece(unsigned char* buf,
+                                                 size_t index)
+{
+  int64_t offset = getPieceOffset(index);
+  size_t length = getPieceLength(index);
+  for (size_t nread = 0; nread < length;) {
+    size_t r = pieceStorage_->getDiskAdaptor()->readDataDropCache(
+        buf + nread, length - nread, offset + nread);
+    if (r == 0) {
+      throw DL_ABORT_EX(
+          fmt(EX_FILE_READ, dctx_->getBasePath().c_str(), "data is too short"));
+    }
+    nread += r;
+  }
+}
+
 bool IteratableChunkChecksumValidator::finished() const
 {
   if (currentIndex_ >= dctx_->getNumPieces()) {
@@ -156,7 +282,7 @@ bool IteratableChunkChecksumValidator::finished() const
 
 int64_t IteratableChunkChecksumValidator::getCurrentOffset() const
 {
-  return static_cast<int64_t>(currentIndex_) * dctx_->getPieceLength();
+  return getPieceOffset(currentIndex_);
 }
 
 int64_t IteratableChunkChecksumValidator::getTotalLength() const
@@ -46,23 +46,53 @@ class DownloadContext;
 class PieceStorage;
 class BitfieldMan;
 class MessageDigest;
+class HashWorkerPool;
+class HashJobGroup;
+class Exception;
 
 class IteratableChunkChecksumValidator : public IteratableValidator {
 private:
   std::shared_ptr<DownloadContext> dctx_;
   std::shared_ptr<PieceStorage> pieceStorage_;
   std::unique_ptr<BitfieldMan> bitfield_;
+  // The number of pieces validated so far.
   size_t currentIndex_;
   std::unique_ptr<MessageDigest> ctx_;
+  HashWorkerPool* hashWorkerPool_;
+  std::shared_ptr<HashJobGroup> hashJobGroup_;
+  // The index of the next piece to be submitted to hashWorkerPool_.
+  size_t nextIndex_;
+  // true if all pieces in flight are being hashed and no more piece
+  // can be submitted.
+  bool waiting_;
+
+  int64_t getPieceOffset(size_t index) const;
+
+  size_t getPieceLength(size_t index) const;
+
+  // Updates bitfield_ depending on whether actualChecksum matches the
+  // hash of the piece index.
+  void checkPiece(size_t index, const std::string& actualChecksum);
+
+  void onReadError(size_t index, const Exception& ex);
 
   std::string calculateActualChecksum();
 
   std::string digest(int64_t offset, size_t length);
 
+  void readPiece(unsigned char* buf, size_t index);
+
+#ifdef HAVE_STD_THREAD
+  void validateChunkInWorker();
+#endif // HAVE_STD_THREAD
+
 public:
+  // If hashWorkerPool is not null, the pieces are read and hashed by
+  // hashWorkerPool.
   IteratableChunkChecksumValidator(
       const std::shared_ptr<DownloadContext>& dctx,
-      const std::shared_ptr<PieceStorage>& pieceStorage);
+      const std::shared_ptr<PieceStorage>& pieceStorage,
+      HashWorkerPool* hashWorkerPool = nullptr);
 
   virtual ~IteratableChunkChecksumValidator();
 
@@ -72,6 +102,10 @@ public:
 
   virtual bool finished() const CXX11_OVERRIDE;
 
+  // Returns the completion fd of the hash jobs while all pieces in
+  // flight are being hashed.
+  virtual int getWaitFd() const CXX11_OVERRIDE;
+
   virtual int64_t getCurrentOffset() const CXX11_OVERRIDE;
 
   virtual int64_t getTotalLength() const CXX11_OVERRIDE;
@@ -59,6 +59,12 @@ public:
 
   virtual bool finished() const = 0;
 
+  // Returns the file descriptor which becomes readable when
+  // validateChunk() can make progress again, or -1 if validateChunk()
+  // can be called at any time.  The default implementation returns
+  // -1.
+  virtual int getWaitFd() const { return -1; }
+
   virtual int64_t getCurrentOffset() const = 0;
 
   virtual int64_t getTotalLength() const = 0;
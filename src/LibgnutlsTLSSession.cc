@@ -37,6 +37,9 @@
 #include <gnutls/x509.h>
 
 #include "TLSContext.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
 #include "util.h"
 #include "SocketCore.h"
 
@@ -350,6 +353,16 @@ int GnuTLSSession::tlsConnect(const std::string& hostname, TLSVersion& version,
   }
 
   version = getProtocolFromSession(sslSession_);
+  // TLS 1.3 sessions arrive as tickets after the handshake and are
+  // stored by newSessionTicketHook().  The resumed TLS 1.2 session is
+  // stored again so that the next connection can resume it again.
+  if (!sessionCacheKey_.empty()
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+      && gnutls_protocol_get_version(sslSession_) != GNUTLS_TLS1_3
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  ) {
+    storeSession();
+  }
 
   return TLS_ERR_OK;
 }
@@ -371,6 +384,58 @@ int GnuTLSSession::tlsAccept(TLSVersion& version)
   }
 }
 
+void GnuTLSSession::setSessionCacheKey(const std::string& key)
+{
+  sessionCacheKey_ = key;
+  gnutls_session_set_ptr(sslSession_, this);
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  gnutls_handshake_set_hook_function(sslSession_,
+                                     GNUTLS_HANDSHAKE_NEW_SESSION_TICKET,
+                                     GNUTLS_HOOK_POST, newSessionTicketHook);
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  auto data = tlsContext_->getSessionCache().take(key);
+  if (data.empty()) {
+    return;
+  }
+  auto rv = gnutls_session_set_data(sslSession_, data.data(), data.size());
+  if (rv != GNUTLS_E_SUCCESS) {
+    A2_LOG_DEBUG(fmt("Failed to restore TLS session for %s. Cause: %s",
+                     key.c_str(), gnutls_strerror(rv)));
+  }
+}
+
+bool GnuTLSSession::isSessionResumed()
+{
+  return gnutls_session_is_resumed(sslSession_);
+}
+
+void GnuTLSSession::storeSession()
+{
+  gnutls_datum_t data;
+  if (gnutls_session_get_data2(sslSession_, &data) != GNUTLS_E_SUCCESS) {
+    return;
+  }
+  tlsContext_->getSessionCache().put(
+      sessionCacheKey_, std::string(data.data, data.data + data.size));
+  gnutls_free(data.data);
+}
+
+int GnuTLSSession::newSessionTicketHook(gnutls_session_t session,
+                                        unsigned int htype, unsigned int when,
+                                        unsigned int incoming,
+                                        const gnutls_datum_t* msg)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  auto tlsSession =
+      static_cast<GnuTLSSession*>(gnutls_session_get_ptr(session));
+  if (tlsSession && incoming &&
+      gnutls_protocol_get_version(session) == GNUTLS_TLS1_3) {
+    tlsSession->storeSession();
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  return 0;
+}
+
 std::string GnuTLSSession::getLastErrorString() { return gnutls_strerror(rv_); }
 
 } // namespace aria2
@@ -60,10 +60,22 @@ public:
   virtual int tlsAccept(TLSVersion& version) CXX11_OVERRIDE;
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
+  virtual void setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isSessionResumed() CXX11_OVERRIDE;
+
+  // Handshake hook function which stores the session when TLS 1.3
+  // session ticket is received.
+  static int newSessionTicketHook(gnutls_session_t session, unsigned int htype,
+                                  unsigned int when, unsigned int incoming,
+                                  const gnutls_datum_t* msg);
 
 private:
+  void storeSession();
   gnutls_session_t sslSession_;
   GnuTLSContext* tlsContext_;
+  // The key of the session cache.  Empty if session resumption is
+  // not enabled.
+  std::string sessionCacheKey_;
   // Last error code from gnutls library functions
   int rv_;
 };
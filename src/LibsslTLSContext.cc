@@ -45,6 +45,7 @@
 #include "fmt.h"
 #include "message.h"
 #include "BufferedFile.h"
+#include "LibsslTLSSession.h"
 
 namespace {
 struct bio_deleter {
@@ -158,6 +159,15 @@ OpenSSLTLSContext::OpenSSLTLSContext(TLSSessionSide side, TLSVersion minVer)
   }
 #endif // OPENSSL_NO_ECDH
 #endif // OPENSSL_VERSION_NUMBER >= 0x0090800fL
+
+  if (side_ == TLS_CLIENT) {
+    // The sessions are kept in TLSSessionCache, which is keyed by
+    // host, instead of the internal cache of OpenSSL.
+    SSL_CTX_set_session_cache_mode(sslCtx_,
+                                   SSL_SESS_CACHE_CLIENT |
+                                       SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(sslCtx_, OpenSSLTLSSession::newSessionCallback);
+  }
 }
 
 OpenSSLTLSContext::~OpenSSLTLSContext() { SSL_CTX_free(sslCtx_); }
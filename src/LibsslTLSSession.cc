@@ -39,6 +39,8 @@
 #include <openssl/x509v3.h>
 
 #include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
 #include "util.h"
 #include "SocketCore.h"
 
@@ -53,6 +55,20 @@ const unsigned char* ASN1_STRING_get0_data(ASN1_STRING* x)
 } // namespace
 #endif // !OPENSSL_101_API
 
+namespace {
+std::string serializeSession(SSL_SESSION* session)
+{
+  auto len = i2d_SSL_SESSION(session, nullptr);
+  if (len <= 0) {
+    return "";
+  }
+  std::string data(len, '\0');
+  auto p = reinterpret_cast<unsigned char*>(&data[0]);
+  i2d_SSL_SESSION(session, &p);
+  return data;
+}
+} // namespace
+
 TLSSession* TLSSession::make(TLSContext* ctx)
 {
   return new OpenSSLTLSSession(static_cast<OpenSSLTLSContext*>(ctx));
@@ -327,6 +343,17 @@ int OpenSSLTLSSession::tlsConnect(const std::string& hostname,
       return TLS_ERR_ERROR;
     }
   }
+  // The resumed TLS 1.2 session is not reissued by the server.  Put
+  // it back to the cache so that the next connection can resume it
+  // again.  TLS 1.3 sessions are single use and new ones arrive as
+  // tickets after the handshake.
+  if (!sessionCacheKey_.empty() && SSL_session_reused(ssl_)
+#ifdef TLS1_3_VERSION
+      && SSL_version(ssl_) != TLS1_3_VERSION
+#endif // TLS1_3_VERSION
+  ) {
+    storeSession(SSL_get_session(ssl_));
+  }
 
   return TLS_ERR_OK;
 }
@@ -336,6 +363,55 @@ int OpenSSLTLSSession::tlsAccept(TLSVersion& version)
   return handshake(version);
 }
 
+void OpenSSLTLSSession::setSessionCacheKey(const std::string& key)
+{
+  sessionCacheKey_ = key;
+  SSL_set_app_data(ssl_, this);
+  auto data = tlsContext_->getSessionCache().take(key);
+  if (data.empty()) {
+    return;
+  }
+  ERR_clear_error();
+  auto p = reinterpret_cast<const unsigned char*>(data.data());
+  auto session = d2i_SSL_SESSION(nullptr, &p, data.size());
+  if (!session) {
+    A2_LOG_DEBUG(fmt("Failed to restore TLS session for %s. Cause: %s",
+                     key.c_str(), ERR_error_string(ERR_get_error(), nullptr)));
+    return;
+  }
+  SSL_set_session(ssl_, session);
+  SSL_SESSION_free(session);
+}
+
+bool OpenSSLTLSSession::isSessionResumed()
+{
+  return SSL_session_reused(ssl_);
+}
+
+void OpenSSLTLSSession::storeSession(SSL_SESSION* session)
+{
+  if (!session) {
+    return;
+  }
+#if !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10101000L
+  if (!SSL_SESSION_is_resumable(session)) {
+    return;
+  }
+#endif // !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10101000L
+  tlsContext_->getSessionCache().put(sessionCacheKey_,
+                                     serializeSession(session));
+}
+
+int OpenSSLTLSSession::newSessionCallback(SSL* ssl, SSL_SESSION* session)
+{
+  auto tlsSession = static_cast<OpenSSLTLSSession*>(SSL_get_app_data(ssl));
+  if (tlsSession && !tlsSession->sessionCacheKey_.empty()) {
+    tlsSession->storeSession(session);
+  }
+  // We keep the serialized copy, not the reference to session.
+  return 0;
+}
+
 std::string OpenSSLTLSSession::getLastErrorString()
 {
   if (rv_ <= 0) {
@@ -61,11 +61,21 @@ public:
   virtual int tlsAccept(TLSVersion& version) CXX11_OVERRIDE;
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
+  virtual void setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isSessionResumed() CXX11_OVERRIDE;
+
+  // Callback for SSL_CTX_sess_set_new_cb().  Stores the new session
+  // in the session cache of the TLSContext.
+  static int newSessionCallback(SSL* ssl, SSL_SESSION* session);
 
 private:
   int handshake(TLSVersion& version);
+  void storeSession(SSL_SESSION* session);
   SSL* ssl_;
   OpenSSLTLSContext* tlsContext_;
+  // The key of the session cache.  Empty if session resumption is
+  // not enabled.
+  std::string sessionCacheKey_;
   // Last error code from openSSL library functions
   int rv_;
 };
@@ -52,6 +52,7 @@
 #include "SimpleRandomizer.h"
 #include "WrDiskCacheEntry.h"
 #include "OpenedFileCounter.h"
+#include "FileRegion.h"
 
 namespace aria2 {
 
@@ -369,6 +370,59 @@ ssize_t MultiDiskAdaptor::readDataDropCache(unsigned char* data, size_t len,
   return readData(data, len, offset, true);
 }
 
+ssize_t MultiDiskAdaptor::sendFile(SocketCore& socket, size_t len,
+                                   int64_t offset)
+{
+  auto first = findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  int64_t fileOffset = offset - (*first)->getFileEntry()->getOffset();
+  ssize_t sendLength = calculateLength((*first).get(), fileOffset, len);
+  openIfNot((*first).get(), &DiskWriterEntry::openFile);
+  if (!(*first)->isOpen()) {
+    throwOnDiskWriterNotOpened((*first).get(), offset);
+  }
+  return (*first)->getDiskWriter()->sendFile(socket, sendLength, fileOffset);
+}
+
+const size_t MultiDiskAdaptor::MAX_FILE_REGIONS = 16;
+
+bool MultiDiskAdaptor::getFileRegions(std::vector<FileRegion>& regions,
+                                      size_t dataOffset, int64_t offset,
+                                      size_t len)
+{
+  auto first = findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  auto numRegions = regions.size();
+  auto fail = [&]() {
+    regions.erase(std::begin(regions) + numRegions, std::end(regions));
+    return false;
+  };
+  size_t rem = len;
+  int64_t fileOffset = offset - (*first)->getFileEntry()->getOffset();
+  for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi && rem > 0;
+       ++i, fileOffset = 0) {
+    size_t length = calculateLength((*i).get(), fileOffset, rem);
+    if (length == 0) {
+      continue;
+    }
+    if (regions.size() - numRegions == MAX_FILE_REGIONS) {
+      return fail();
+    }
+    openIfNot((*i).get(), &DiskWriterEntry::openFile);
+    if (!(*i)->isOpen()) {
+      throwOnDiskWriterNotOpened((*i).get(), offset + (len - rem));
+    }
+    int fd = (*i)->getDiskWriter()->dupForRead(fileOffset, length);
+    if (fd == -1) {
+      return fail();
+    }
+    regions.emplace_back(fd, fileOffset, length, dataOffset + (len - rem));
+    rem -= length;
+  }
+  if (rem > 0) {
+    return fail();
+  }
+  return true;
+}
+
 ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
                                    int64_t offset, bool dropCache)
 {
@@ -410,11 +464,76 @@ ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
   return totalReadLength;
 }
 
-void MultiDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+void MultiDiskAdaptor::writeCache(WrDiskCacheEntry* entry)
 {
+  // The data cells are sorted by offset.  The adjacent data cells in
+  // the same file are written by one writeDataVector() call.
+  a2iovec iov[A2_IOV_MAX];
+  size_t iovcnt = 0;
+  DiskWriterEntry* dwent = nullptr;
+  int64_t fileStart = 0;
+  int64_t end = 0;
+  auto flush = [&]() {
+    openIfNot(dwent, &DiskWriterEntry::openFile);
+    if (!dwent->isOpen()) {
+      throwOnDiskWriterNotOpened(
+          dwent, dwent->getFileEntry()->getOffset() + fileStart);
+    }
+    dwent->getDiskWriter()->writeDataVector(iov, iovcnt, fileStart);
+    iovcnt = 0;
+  };
   for (auto& d : entry->getDataSet()) {
     A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff, d->len));
-    writeData(d->data + d->offset, d->len, d->goff);
+    auto data = d->data + d->offset;
+    auto goff = d->goff;
+    size_t rem = d->len;
+    auto first = (*findFirstDiskWriterEntry(diskWriterEntries_, goff)).get();
+    int64_t firstOffset = goff - first->getFileEntry()->getOffset();
+    auto& firstWriter = first->getDiskWriter();
+    if (calculateLength(first, firstOffset, rem) == static_cast<ssize_t>(rem) &&
+        firstWriter && firstWriter->acceptsDataOwnership()) {
+      // The data cell is in one file.  Hand its buffer to the
+      // DiskWriter.
+      if (iovcnt > 0) {
+        flush();
+      }
+      dwent = first;
+      openIfNot(dwent, &DiskWriterEntry::openFile);
+      if (!dwent->isOpen()) {
+        throwOnDiskWriterNotOpened(dwent, goff);
+      }
+      std::unique_ptr<unsigned char[]> buf(d->data);
+      d->data = nullptr;
+      dwent->getDiskWriter()->writeDataOwned(std::move(buf), d->offset, rem,
+                                             firstOffset);
+      continue;
+    }
+    while (rem > 0) {
+      if (!dwent || !isInRange(dwent, goff)) {
+        if (iovcnt > 0) {
+          flush();
+        }
+        dwent = (*findFirstDiskWriterEntry(diskWriterEntries_, goff)).get();
+      }
+      int64_t fileOffset = goff - dwent->getFileEntry()->getOffset();
+      size_t len = calculateLength(dwent, fileOffset, rem);
+      if (iovcnt > 0 && (fileOffset != end || iovcnt == A2_IOV_MAX)) {
+        flush();
+      }
+      if (iovcnt == 0) {
+        fileStart = end = fileOffset;
+      }
+      iov[iovcnt].A2IOVEC_BASE = reinterpret_cast<char*>(data);
+      iov[iovcnt].A2IOVEC_LEN = len;
+      ++iovcnt;
+      end += len;
+      data += len;
+      goff += len;
+      rem -= len;
+    }
+  }
+  if (iovcnt > 0) {
+    flush();
   }
 }
 
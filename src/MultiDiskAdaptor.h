@@ -133,7 +133,21 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+  virtual void writeCache(WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+
+  // Sends the data in the file containing offset only.  The data
+  // beyond the end of that file are sent by the next call.
+  virtual ssize_t sendFile(SocketCore& socket, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  // Returns false if the range spans more than MAX_FILE_REGIONS
+  // files, so that a piece of many small files does not use up file
+  // descriptors.
+  virtual bool getFileRegions(std::vector<FileRegion>& regions,
+                              size_t dataOffset, int64_t offset,
+                              size_t len) CXX11_OVERRIDE;
+
+  static const size_t MAX_FILE_REGIONS;
 
   virtual bool fileExists() CXX11_OVERRIDE;
 
@@ -76,6 +76,12 @@
 #ifdef ENABLE_ASYNC_DNS
 #include "AsyncNameResolver.h"
 #endif // ENABLE_ASYNC_DNS
+#ifdef HAVE_IO_URING
+#include "IOUring.h"
+#endif // HAVE_IO_URING
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -161,7 +167,18 @@ MultiUrlRequestInfo::MultiUrlRequestInfo(
 #endif // !HAVE_SIGACTION
 }
 
-MultiUrlRequestInfo::~MultiUrlRequestInfo() = default;
+MultiUrlRequestInfo::~MultiUrlRequestInfo()
+{
+  // DiskWriters and validators refer to the io_uring instance and
+  // the hash worker threads.  Destroy them first.
+  e_.reset();
+#ifdef HAVE_IO_URING
+  SingletonHolder<IOUring>::clear();
+#endif // HAVE_IO_URING
+#ifdef HAVE_STD_THREAD
+  SingletonHolder<HashWorkerPool>::clear();
+#endif // HAVE_STD_THREAD
+}
 
 void MultiUrlRequestInfo::printMessageForContinue()
 {
@@ -180,6 +197,27 @@ int MultiUrlRequestInfo::prepare()
   try {
     SingletonHolder<Notifier>::instance(make_unique<Notifier>());
 
+#ifdef HAVE_IO_URING
+    if (option_->getAsBool(PREF_ENABLE_IO_URING)) {
+      auto ring = IOUring::create();
+      if (ring) {
+        SingletonHolder<IOUring>::instance(std::move(ring));
+      }
+      else {
+        A2_LOG_WARN("io_uring is not available. Files are written "
+                    "synchronously.");
+      }
+    }
+#endif // HAVE_IO_URING
+#if defined(HAVE_STD_THREAD) && !defined(__MINGW32__)
+    // On Windows, select() cannot wait for the completion pipe of the
+    // worker threads.
+    if (option_->getAsInt(PREF_PIECE_HASH_THREADS) > 0) {
+      SingletonHolder<HashWorkerPool>::instance(make_unique<HashWorkerPool>(
+          option_->getAsInt(PREF_PIECE_HASH_THREADS)));
+    }
+#endif // HAVE_STD_THREAD && !__MINGW32__
+
 #ifdef ENABLE_SSL
     if (option_->getAsBool(PREF_ENABLE_RPC) &&
         option_->getAsBool(PREF_RPC_SECURE)) {
@@ -235,6 +235,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->hide();
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_DOWNLOAD_PRIORITY, TEXT_DOWNLOAD_PRIORITY, "0", 0, 100));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_BITTORRENT);
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->setInitialOption(true);
+    op->setChangeOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_DOWNLOAD_RESULT, TEXT_DOWNLOAD_RESULT, A2_V_DEFAULT,
@@ -263,6 +276,16 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+#ifdef HAVE_IO_URING
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_IO_URING,
+                                               TEXT_ENABLE_IO_URING, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_EXPERIMENTAL);
+    handlers.push_back(op);
+  }
+#endif // HAVE_IO_URING
 #if defined(HAVE_MMAP) || defined(__MINGW32__)
   {
     OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_MMAP,
@@ -623,6 +646,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+#ifdef HAVE_STD_THREAD
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_PIECE_HASH_THREADS, TEXT_PIECE_HASH_THREADS, "0", 0, 64));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_CHECKSUM);
+    handlers.push_back(op);
+  }
+#endif // HAVE_STD_THREAD
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_QUIET, TEXT_QUIET, A2_V_FALSE, OptionHandler::OPT_ARG, 'q'));
@@ -1157,9 +1189,12 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     handlers.push_back(op);
   }
   {
-    OptionHandler* op(new NumberOptionHandler(PREF_MAX_HTTP_PIPELINING,
-                                              NO_DESCRIPTION, "2", 1, 8));
-    op->hide();
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_HTTP_PIPELINING, TEXT_MAX_HTTP_PIPELINING, "2", 1, 8));
+    op->addTag(TAG_HTTP);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
   {
@@ -1479,6 +1514,18 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+#ifdef HAVE_SENDFILE
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_BT_ENABLE_SENDFILE,
+                                               TEXT_BT_ENABLE_SENDFILE,
+                                               A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_BITTORRENT);
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_EXPERIMENTAL);
+    handlers.push_back(op);
+  }
+#endif // HAVE_SENDFILE
   {
     OptionHandler* op(new DefaultOptionHandler(PREF_BT_EXCLUDE_TRACKER,
                                                TEXT_BT_EXCLUDE_TRACKER,
@@ -43,12 +43,14 @@
 #include "LogFactory.h"
 #include "Logger.h"
 #include "BtHandshakeMessage.h"
+#include "BtPieceMessage.h"
 #include "SocketCore.h"
 #include "a2netcompat.h"
 #include "ARC4Encryptor.h"
 #include "fmt.h"
 #include "util.h"
 #include "Peer.h"
+#include "WrDiskCache.h"
 
 namespace aria2 {
 
@@ -59,24 +61,43 @@ enum {
   // Reading 4 bytes message length
   BT_MSG_READ_LENGTH,
   // Reading message payload following message length
-  BT_MSG_READ_PAYLOAD
+  BT_MSG_READ_PAYLOAD,
+  // Reading the block of PIECE message into pieceBlock_
+  BT_MSG_READ_PIECE_BLOCK
 };
 } // namespace
 
+namespace {
+// The length of PIECE message payload preceding the block: 1 byte
+// ID, 4 bytes index and 4 bytes begin.
+constexpr size_t PIECE_PAYLOAD_HEADER_LENGTH = 9;
+} // namespace
+
 PeerConnection::PeerConnection(cuid_t cuid, const std::shared_ptr<Peer>& peer,
-                               const std::shared_ptr<SocketCore>& socket)
+                               const std::shared_ptr<SocketCore>& socket,
+                               BufferPool* bufferPool)
     : cuid_(cuid),
       peer_(peer),
       socket_(socket),
+      bufferPool_(bufferPool),
       msgState_(BT_MSG_PREV_READ_LENGTH),
       bufferCapacity_(MAX_BUFFER_CAPACITY),
-      resbuf_(make_unique<unsigned char[]>(bufferCapacity_)),
+      resbuf_(allocateBuffer(bufferCapacity_)),
       resbufLength_(0),
       currentPayloadLength_(0),
       resbufOffset_(0),
       msgOffset_(0),
       socketBuffer_(socket),
       encryptionEnabled_(false),
+      encryptionBatchLength_(0),
+      sendFileEnabled_(false),
+      pieceBlockEnabled_(false),
+      diskCache_(nullptr),
+      pieceBlockCapacity_(0),
+      pieceBlockLength_(0),
+      pieceBlockOffset_(0),
+      expectPieceBlock_(false),
+      readQuota_(std::numeric_limits<size_t>::max()),
       prevPeek_(false)
 {
 }
@@ -87,18 +108,92 @@ void PeerConnection::pushBytes(std::vector<unsigned char> data,
                                std::unique_ptr<ProgressUpdate> progressUpdate)
 {
   if (encryptionEnabled_) {
+    if (!progressUpdate && appendToEncryptionBatch(data.data(), data.size())) {
+      return;
+    }
+    // The batched messages must be sent before this message.
+    flushEncryptionBatch();
     encryptor_->encrypt(data.size(), data.data(), data.data());
   }
   socketBuffer_.pushBytes(std::move(data), std::move(progressUpdate));
 }
 
+void PeerConnection::pushBytes(BufferSlice data,
+                               std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  if (encryptionEnabled_) {
+    if (!progressUpdate && appendToEncryptionBatch(data.data(), data.size())) {
+      return;
+    }
+    // The batched messages must be sent before this message.
+    flushEncryptionBatch();
+    if (data.unique()) {
+      encryptor_->encrypt(data.size(), data.data(), data.data());
+    }
+    else {
+      // Other connections may send the same data.  Encrypt them into
+      // a new buffer.
+      auto buf = allocateBuffer(data.size());
+      encryptor_->encrypt(data.size(), buf.data(), data.data());
+      data = std::move(buf);
+    }
+  }
+  socketBuffer_.pushSlice(std::move(data), std::move(progressUpdate));
+}
+
+bool PeerConnection::appendToEncryptionBatch(const unsigned char* data,
+                                             size_t length)
+{
+  if (length > ENCRYPTION_BATCH_CAPACITY) {
+    return false;
+  }
+  if (encryptionBatchLength_ + length > ENCRYPTION_BATCH_CAPACITY) {
+    flushEncryptionBatch();
+  }
+  if (encryptionBatch_.empty()) {
+    encryptionBatch_ = allocateBuffer(ENCRYPTION_BATCH_CAPACITY);
+  }
+  memcpy(encryptionBatch_.data() + encryptionBatchLength_, data, length);
+  encryptionBatchLength_ += length;
+  return true;
+}
+
+void PeerConnection::flushEncryptionBatch()
+{
+  if (encryptionBatchLength_ == 0) {
+    return;
+  }
+  encryptor_->encrypt(encryptionBatchLength_, encryptionBatch_.data(),
+                      encryptionBatch_.data());
+  socketBuffer_.pushSlice(encryptionBatch_.slice(0, encryptionBatchLength_));
+  encryptionBatch_ = BufferSlice();
+  encryptionBatchLength_ = 0;
+}
+
+BufferSlice PeerConnection::allocateBuffer(size_t length)
+{
+  if (bufferPool_) {
+    return bufferPool_->allocate(length);
+  }
+  return BufferSlice::allocate(length);
+}
+
+void PeerConnection::pushDiskData(
+    std::shared_ptr<DiskAdaptor> diskAdaptor, int64_t offset, size_t length,
+    std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  assert(canPushDiskData());
+  socketBuffer_.pushDiskData(std::move(diskAdaptor), offset, length,
+                             std::move(progressUpdate));
+}
+
 bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength)
 {
   while (1) {
     bool done = false;
     size_t i;
     for (i = resbufOffset_; i < resbufLength_ && !done; ++i) {
-      unsigned char c = resbuf_[i];
+      unsigned char c = resbuf_.data()[i];
       switch (msgState_) {
       case (BT_MSG_PREV_READ_LENGTH):
         msgOffset_ = i;
@@ -142,15 +237,20 @@ bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength)
     resbufOffset_ = i;
     if (done) {
       if (data) {
-        memcpy(data, resbuf_.get() + msgOffset_ + 4, currentPayloadLength_);
+        memcpy(data, resbuf_.data() + msgOffset_ + 4, currentPayloadLength_);
       }
       dataLength = currentPayloadLength_;
+      expectPieceBlock_ =
+          pieceBlockEnabled_ &&
+          currentPayloadLength_ > PIECE_PAYLOAD_HEADER_LENGTH &&
+          resbuf_.data()[msgOffset_ + 4] == BtPieceMessage::ID;
       return true;
     }
     else {
       assert(resbufOffset_ == resbufLength_);
       if (resbufLength_ != 0) {
-        if (resbufLength_ - msgOffset_ == currentPayloadLength_ + 4) {
+        if (msgState_ == BT_MSG_PREV_READ_LENGTH ||
+            resbufLength_ - msgOffset_ == currentPayloadLength_ + 4) {
           // All bytes in buffer have been processed, so clear it
           // away.
           resbufLength_ = 0;
@@ -160,23 +260,54 @@ bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength)
         else {
           // Shift buffer so that resbuf_[msgOffset_] moves to
           // rebuf_[0].
-          memmove(resbuf_.get(), resbuf_.get() + msgOffset_,
+          memmove(resbuf_.data(), resbuf_.data() + msgOffset_,
                   resbufLength_ - msgOffset_);
           resbufLength_ -= msgOffset_;
           resbufOffset_ = resbufLength_;
           msgOffset_ = 0;
         }
       }
+      if (pieceBlockEnabled_ && msgState_ == BT_MSG_READ_PAYLOAD &&
+          currentPayloadLength_ > PIECE_PAYLOAD_HEADER_LENGTH &&
+          resbufLength_ >= 4 + PIECE_PAYLOAD_HEADER_LENGTH &&
+          resbuf_.data()[4] == BtPieceMessage::ID) {
+        beginReadPieceBlock();
+      }
+      if (readQuota_ == 0) {
+        break;
+      }
+      if (msgState_ == BT_MSG_READ_PIECE_BLOCK) {
+        if (readPieceBlock()) {
+          if (data) {
+            memcpy(data, resbuf_.data() + 4, PIECE_PAYLOAD_HEADER_LENGTH);
+            memcpy(data + PIECE_PAYLOAD_HEADER_LENGTH, pieceBlock_.get(),
+                   pieceBlockLength_);
+          }
+          dataLength = currentPayloadLength_;
+          return true;
+        }
+        if (socket_->wantRead() || socket_->wantWrite()) {
+          break;
+        }
+        continue;
+      }
       size_t nread;
+      if (expectPieceBlock_ &&
+          resbufLength_ < 4 + PIECE_PAYLOAD_HEADER_LENGTH) {
+        // PIECE messages usually come in a row.  Read the header only,
+        // so that the block can be read into its own buffer.
+        nread = 4 + PIECE_PAYLOAD_HEADER_LENGTH - resbufLength_;
+      }
       // To reduce the amount of copy involved in buffer shift, large
       // payload will be read exactly.
-      if (currentPayloadLength_ > 4_k) {
+      else if (currentPayloadLength_ > 4_k) {
         nread = currentPayloadLength_ + 4 - resbufLength_;
       }
       else {
         nread = bufferCapacity_ - resbufLength_;
       }
-      readData(resbuf_.get() + resbufLength_, nread, encryptionEnabled_);
+      nread = std::min(nread, readQuota_);
+      readData(resbuf_.data() + resbufLength_, nread, encryptionEnabled_);
       if (nread == 0) {
         if (socket_->wantRead() || socket_->wantWrite()) {
           break;
@@ -194,6 +325,51 @@ bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength)
   return false;
 }
 
+void PeerConnection::beginReadPieceBlock()
+{
+  // The message header is at resbuf_[0].  The block bytes already
+  // read are moved to the new buffer.
+  auto headerLength = 4 + PIECE_PAYLOAD_HEADER_LENGTH;
+  pieceBlockLength_ = currentPayloadLength_ - PIECE_PAYLOAD_HEADER_LENGTH;
+  pieceBlockOffset_ = resbufLength_ - headerLength;
+  if (diskCache_ && pieceBlockLength_ <= WrDiskCache::BUFFER_SIZE) {
+    pieceBlock_.reset(diskCache_->allocateBuffer());
+    pieceBlockCapacity_ = WrDiskCache::BUFFER_SIZE;
+  }
+  else {
+    pieceBlock_.reset(new unsigned char[pieceBlockLength_]);
+    pieceBlockCapacity_ = pieceBlockLength_;
+  }
+  memcpy(pieceBlock_.get(), resbuf_.data() + headerLength, pieceBlockOffset_);
+  resbufLength_ = resbufOffset_ = headerLength;
+  msgState_ = BT_MSG_READ_PIECE_BLOCK;
+}
+
+bool PeerConnection::readPieceBlock()
+{
+  size_t nread = std::min(pieceBlockLength_ - pieceBlockOffset_, readQuota_);
+  readData(pieceBlock_.get() + pieceBlockOffset_, nread, encryptionEnabled_);
+  if (nread == 0) {
+    if (socket_->wantRead() || socket_->wantWrite()) {
+      return false;
+    }
+    peer_->setDisconnectedGracefully(true);
+    throw DL_ABORT_EX(EX_EOF_FROM_PEER);
+  }
+  pieceBlockOffset_ += nread;
+  if (pieceBlockOffset_ < pieceBlockLength_) {
+    return false;
+  }
+  msgState_ = BT_MSG_PREV_READ_LENGTH;
+  expectPieceBlock_ = true;
+  return true;
+}
+
+std::unique_ptr<unsigned char[]> PeerConnection::popPieceBlock()
+{
+  return std::move(pieceBlock_);
+}
+
 bool PeerConnection::receiveHandshake(unsigned char* data, size_t& dataLength,
                                       bool peek)
 {
@@ -205,7 +381,7 @@ bool PeerConnection::receiveHandshake(unsigned char* data, size_t& dataLength,
   size_t remaining = BtHandshakeMessage::MESSAGE_LENGTH - resbufLength_;
   if (remaining > 0) {
     size_t temp = remaining;
-    readData(resbuf_.get() + resbufLength_, remaining, encryptionEnabled_);
+    readData(resbuf_.data() + resbufLength_, remaining, encryptionEnabled_);
     if (remaining == 0 && !socket_->wantRead() && !socket_->wantWrite()) {
       // we got EOF
       A2_LOG_DEBUG(fmt("CUID#%" PRId64
@@ -220,7 +396,7 @@ bool PeerConnection::receiveHandshake(unsigned char* data, size_t& dataLength,
     }
   }
   size_t writeLength = std::min(resbufLength_, dataLength);
-  memcpy(data, resbuf_.get(), writeLength);
+  memcpy(data, resbuf_.data(), writeLength);
   dataLength = writeLength;
   if (retval && !peek) {
     resbufLength_ = 0;
@@ -232,6 +408,9 @@ void PeerConnection::readData(unsigned char* data, size_t& length,
                               bool encryption)
 {
   socket_->readData(data, length);
+  if (readQuota_ != std::numeric_limits<size_t>::max()) {
+    readQuota_ -= length;
+  }
   if (encryption) {
     decryptor_->encrypt(length, data, data);
   }
@@ -249,22 +428,23 @@ void PeerConnection::enableEncryption(std::unique_ptr<ARC4Encryptor> encryptor,
 void PeerConnection::presetBuffer(const unsigned char* data, size_t length)
 {
   size_t nwrite = std::min(bufferCapacity_, length);
-  memcpy(resbuf_.get(), data, nwrite);
+  memcpy(resbuf_.data(), data, nwrite);
   resbufLength_ = length;
 }
 
 bool PeerConnection::sendBufferIsEmpty() const
 {
-  return socketBuffer_.sendBufferIsEmpty();
+  return encryptionBatchLength_ == 0 && socketBuffer_.sendBufferIsEmpty();
 }
 
 size_t PeerConnection::getBufferEntrySize() const
 {
-  return socketBuffer_.getBufferEntrySize();
+  return socketBuffer_.getBufferEntrySize() + (encryptionBatchLength_ > 0);
 }
 
 ssize_t PeerConnection::sendPendingData()
 {
+  flushEncryptionBatch();
   ssize_t writtenLength = socketBuffer_.send();
   A2_LOG_DEBUG(fmt("sent %ld byte(s).", static_cast<long int>(writtenLength)));
   return writtenLength;
@@ -272,15 +452,15 @@ ssize_t PeerConnection::sendPendingData()
 
 const unsigned char* PeerConnection::getMsgPayloadBuffer() const
 {
-  return resbuf_.get() + msgOffset_ + 4;
+  return resbuf_.data() + msgOffset_ + 4;
 }
 
 void PeerConnection::reserveBuffer(size_t minSize)
 {
   if (bufferCapacity_ < minSize) {
     bufferCapacity_ = minSize;
-    auto buf = make_unique<unsigned char[]>(bufferCapacity_);
-    memcpy(buf.get(), resbuf_.get(), resbufLength_);
+    auto buf = allocateBuffer(bufferCapacity_);
+    memcpy(buf.data(), resbuf_.data(), resbufLength_);
     resbuf_ = std::move(buf);
   }
 }
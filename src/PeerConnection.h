@@ -39,8 +39,10 @@
 
 #include <unistd.h>
 #include <memory>
+#include <limits>
 
 #include "SocketBuffer.h"
+#include "BufferPool.h"
 #include "Command.h"
 #include "a2functional.h"
 #include "BtConstants.h"
@@ -50,23 +52,31 @@ namespace aria2 {
 class Peer;
 class SocketCore;
 class ARC4Encryptor;
+class DiskAdaptor;
+class WrDiskCache;
 
 // The maximum length of buffer. If the message length (including 4
 // bytes length and payload length) is larger than this value, it is
 // dropped.
 constexpr size_t MAX_BUFFER_CAPACITY = MAX_BLOCK_LENGTH + 128;
 
+// The capacity of the buffer where outgoing messages are coalesced
+// before they are encrypted.
+constexpr size_t ENCRYPTION_BATCH_CAPACITY = 4_k;
+
 class PeerConnection {
 private:
   cuid_t cuid_;
   std::shared_ptr<Peer> peer_;
   std::shared_ptr<SocketCore> socket_;
+  // The pool the buffers are allocated from.  It can be null.
+  BufferPool* bufferPool_;
 
   int msgState_;
   // The capacity of the buffer resbuf_
   size_t bufferCapacity_;
   // The internal buffer of incoming handshakes and messages
-  std::unique_ptr<unsigned char[]> resbuf_;
+  BufferSlice resbuf_;
   // The number of bytes written in resbuf_
   size_t resbufLength_;
   // The length of message (not handshake) currently receiving
@@ -81,6 +91,32 @@ private:
   bool encryptionEnabled_;
   std::unique_ptr<ARC4Encryptor> encryptor_;
   std::unique_ptr<ARC4Encryptor> decryptor_;
+  // Outgoing messages which are not encrypted yet.  They are
+  // encrypted at once when the batch is flushed.
+  BufferSlice encryptionBatch_;
+  // The number of bytes written in encryptionBatch_
+  size_t encryptionBatchLength_;
+
+  bool sendFileEnabled_;
+
+  bool pieceBlockEnabled_;
+  // The buffers of pieceBlock_ are allocated from this cache if
+  // possible.
+  WrDiskCache* diskCache_;
+  // The buffer the block of PIECE message is read into.  The header
+  // of the message is kept in resbuf_.
+  std::unique_ptr<unsigned char[]> pieceBlock_;
+  // The size of pieceBlock_
+  size_t pieceBlockCapacity_;
+  size_t pieceBlockLength_;
+  // The number of bytes read in pieceBlock_
+  size_t pieceBlockOffset_;
+  // True if the last message was a PIECE message.  The next message
+  // is likely to be a PIECE message too.
+  bool expectPieceBlock_;
+
+  // The number of bytes receiveMessage() can read from the socket.
+  size_t readQuota_;
 
   bool prevPeek_;
 
@@ -88,9 +124,28 @@ private:
 
   ssize_t sendData(const unsigned char* data, size_t length, bool encryption);
 
+  // Appends data to encryptionBatch_.  Returns false if data is too
+  // large to be batched.
+  bool appendToEncryptionBatch(const unsigned char* data, size_t length);
+
+  // Encrypts the messages in encryptionBatch_ and pushes them into
+  // send buffer.
+  void flushEncryptionBatch();
+
+  // Starts reading the block of the PIECE message, whose header is
+  // in resbuf_, into pieceBlock_.
+  void beginReadPieceBlock();
+
+  // Reads the block of the PIECE message into pieceBlock_.  Returns
+  // true if whole block has been read.
+  bool readPieceBlock();
+
 public:
+  // If bufferPool is not null, the receive buffer and the buffers
+  // returned by allocateBuffer() are allocated from it.
   PeerConnection(cuid_t cuid, const std::shared_ptr<Peer>& peer,
-                 const std::shared_ptr<SocketCore>& socket);
+                 const std::shared_ptr<SocketCore>& socket,
+                 BufferPool* bufferPool = nullptr);
 
   ~PeerConnection();
 
@@ -100,6 +155,32 @@ public:
                  std::unique_ptr<ProgressUpdate> progressUpdate =
                      std::unique_ptr<ProgressUpdate>{});
 
+  // Pushes data into send buffer.  If encryption is enabled and the
+  // buffer of data is shared by other slices, the data are encrypted
+  // into a new buffer, so that the other slices are not affected.
+  void pushBytes(BufferSlice data,
+                 std::unique_ptr<ProgressUpdate> progressUpdate =
+                     std::unique_ptr<ProgressUpdate>{});
+
+  // Returns a buffer of length bytes for outgoing message.
+  BufferSlice allocateBuffer(size_t length);
+
+  // Returns true if pushDiskData() can be used.  The data must be
+  // encrypted in memory if encryption is enabled, so this function
+  // returns false in that case.
+  bool canPushDiskData() const
+  {
+    return sendFileEnabled_ && !encryptionEnabled_;
+  }
+
+  // Pushes length bytes of data at offset in diskAdaptor into send
+  // buffer.  The data are sent without copying them to user space if
+  // possible.  canPushDiskData() must return true.
+  void pushDiskData(std::shared_ptr<DiskAdaptor> diskAdaptor, int64_t offset,
+                    size_t length,
+                    std::unique_ptr<ProgressUpdate> progressUpdate =
+                        std::unique_ptr<ProgressUpdate>{});
+
   bool receiveMessage(unsigned char* data, size_t& dataLength);
 
   /**
@@ -114,6 +195,36 @@ public:
   void enableEncryption(std::unique_ptr<ARC4Encryptor> encryptor,
                         std::unique_ptr<ARC4Encryptor> decryptor);
 
+  // Enables pushDiskData().
+  void enableSendFile() { sendFileEnabled_ = true; }
+
+  // Makes receiveMessage() read the block of PIECE message into a
+  // separate buffer, which is returned by popPieceBlock(), so that it
+  // can be moved to the write disk cache without copying.  In that
+  // case, the payload buffer only contains the message header.  The
+  // buffer is allocated by diskCache->allocateBuffer() if diskCache
+  // is not null and the block fits in it.
+  void enablePieceBlockBuffer(WrDiskCache* diskCache)
+  {
+    pieceBlockEnabled_ = true;
+    diskCache_ = diskCache;
+  }
+
+  // Returns the buffer holding the block of the PIECE message last
+  // received by receiveMessage(), or nullptr if the block is in the
+  // payload buffer.
+  std::unique_ptr<unsigned char[]> popPieceBlock();
+
+  // Returns the size of the buffer popPieceBlock() returns.
+  size_t getPieceBlockCapacity() const { return pieceBlockCapacity_; }
+
+  // Limits the number of bytes receiveMessage() reads from the
+  // socket.  When the quota runs out, receiveMessage() returns false
+  // as if no more data were available.  Unlimited by default.
+  void setReadQuota(size_t quota) { readQuota_ = quota; }
+
+  size_t getReadQuota() const { return readQuota_; }
+
   void presetBuffer(const unsigned char* data, size_t length);
 
   bool sendBufferIsEmpty() const;
@@ -122,7 +233,7 @@ public:
 
   ssize_t sendPendingData();
 
-  const unsigned char* getBuffer() const { return resbuf_.get(); }
+  const unsigned char* getBuffer() const { return resbuf_.data(); }
 
   size_t getBufferLength() const { return resbufLength_; }
 
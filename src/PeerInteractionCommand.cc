@@ -72,6 +72,8 @@
 #include "RequestGroup.h"
 #include "DefaultExtensionMessageFactory.h"
 #include "RequestGroupMan.h"
+#include "UploadScheduler.h"
+#include "DownloadShaper.h"
 #include "ExtensionMessageRegistry.h"
 #include "bittorrent_helper.h"
 #include "UTMetadataRequestFactory.h"
@@ -137,6 +139,7 @@ PeerInteractionCommand::PeerInteractionCommand(
   factory->setDownloadContext(requestGroup_->getDownloadContext().get());
   factory->setPieceStorage(pieceStorage.get());
   factory->setPeerStorage(peerStorage.get());
+  factory->setPieceHashChecker(btRuntime_->getPieceHashChecker().get());
   factory->setExtensionMessageFactory(extensionMessageFactory.get());
   factory->setPeer(getPeer());
   if (family == AF_INET) {
@@ -156,7 +159,8 @@ PeerInteractionCommand::PeerInteractionCommand(
   }
 
   if (!peerConnection) {
-    peerConnection = make_unique<PeerConnection>(cuid, getPeer(), getSocket());
+    peerConnection = make_unique<PeerConnection>(cuid, getPeer(), getSocket(),
+                                                 e->getBufferPool());
   }
   else {
     if (sequence_ == RECEIVER_WAIT_HANDSHAKE &&
@@ -173,6 +177,14 @@ PeerInteractionCommand::PeerInteractionCommand(
   size_t bitfieldPayloadSize =
       1 + (requestGroup_->getDownloadContext()->getNumPieces() + 7) / 8;
   peerConnection->reserveBuffer(bitfieldPayloadSize);
+  if (getOption()->getAsBool(PREF_BT_ENABLE_SENDFILE)) {
+    peerConnection->enableSendFile();
+  }
+  // The received blocks can be moved to the write disk cache without
+  // copying.
+  if (pieceStorage->getWrDiskCache()) {
+    peerConnection->enablePieceBlockBuffer(pieceStorage->getWrDiskCache());
+  }
 
   auto dispatcher = make_unique<DefaultBtMessageDispatcher>();
   auto dispatcherPtr = dispatcher.get();
@@ -345,12 +357,15 @@ bool PeerInteractionCommand::executeInternal()
         updateKeepAlive();
       }
 
-      if (getDownloadEngine()
-              ->getRequestGroupMan()
-              ->doesOverallDownloadSpeedExceed() ||
-          requestGroup_->doesDownloadSpeedExceed()) {
+      if (!getDownloadEngine()
+               ->getRequestGroupMan()
+               ->getDownloadShaper()
+               ->canDownload(requestGroup_)) {
         disableReadCheckSocket();
         setNoCheck(true);
+        // The quota is handed out every tick.  Make sure that this
+        // command is executed again by then.
+        getDownloadEngine()->addWakeup(this, DownloadShaper::TICK);
       }
       else {
         setReadCheckSocket(getSocket());
@@ -360,13 +375,21 @@ bool PeerInteractionCommand::executeInternal()
       break;
     }
   }
-  if ((btInteractive_->countPendingMessage() > 0 ||
-       btInteractive_->isSendingMessageInProgress()) &&
-      !getDownloadEngine()
-           ->getRequestGroupMan()
-           ->doesOverallUploadSpeedExceed() &&
-      !requestGroup_->doesUploadSpeedExceed()) {
-    setWriteCheckSocket(getSocket());
+  if (btInteractive_->countPendingMessage() > 0 ||
+      btInteractive_->isSendingMessageInProgress()) {
+    auto e = getDownloadEngine();
+    auto scheduler = e->getRequestGroupMan()->getUploadScheduler();
+    // Data in the send buffer has already been charged to the budget.
+    if (btInteractive_->isSendingMessageInProgress() ||
+        scheduler->canUpload(requestGroup_, getCuid())) {
+      setWriteCheckSocket(getSocket());
+    }
+    else {
+      disableWriteCheckSocket();
+      // The budget is handed out every tick.  Make sure that this
+      // command is executed again by then.
+      e->addWakeup(this, UploadScheduler::TICK);
+    }
   }
   else {
     disableWriteCheckSocket();
@@ -75,7 +75,8 @@ PeerReceiveHandshakeCommand::PeerReceiveHandshakeCommand(
     }
   }
   else {
-    peerConnection_ = make_unique<PeerConnection>(cuid, getPeer(), getSocket());
+    peerConnection_ = make_unique<PeerConnection>(cuid, getPeer(), getSocket(),
+                                                  e->getBufferPool());
   }
 }
 
@@ -35,6 +35,7 @@
 #include "Piece.h"
 
 #include <array>
+#include <cstring>
 #include <cassert>
 
 #include "util.h"
@@ -48,6 +49,7 @@
 #include "fmt.h"
 #include "DiskAdaptor.h"
 #include "MessageDigest.h"
+#include "FileRegion.h"
 
 namespace aria2 {
 
@@ -274,6 +276,48 @@ Piece::getDigestWithWrCache(size_t pieceLength,
   return mdctx->digest();
 }
 
+namespace {
+void readWithCheck(unsigned char* buf,
+                   const std::shared_ptr<DiskAdaptor>& adaptor, int64_t offset,
+                   size_t len)
+{
+  if (len == 0) {
+    return;
+  }
+  ssize_t nread = adaptor->readData(buf, len, offset);
+  if ((size_t)nread != len) {
+    throw DL_ABORT_EX(fmt(EX_FILE_READ, "n/a", "data is too short"));
+  }
+}
+} // namespace
+
+void Piece::getDataWithWrCache(unsigned char* buf, size_t pieceLength,
+                               const std::shared_ptr<DiskAdaptor>& adaptor,
+                               std::vector<FileRegion>* regions)
+{
+  int64_t start = static_cast<int64_t>(index_) * pieceLength;
+  auto readGap = [&](int64_t goff, size_t len) {
+    if (len == 0 ||
+        (regions &&
+         adaptor->getFileRegions(*regions, goff - start, goff, len))) {
+      return;
+    }
+    readWithCheck(buf + (goff - start), adaptor, goff, len);
+  };
+  int64_t goff = start;
+  if (wrCache_) {
+    const WrDiskCacheEntry::DataCellSet& dataSet = wrCache_->getDataSet();
+    for (auto& d : dataSet) {
+      if (goff < d->goff) {
+        readGap(goff, d->goff - goff);
+      }
+      memcpy(buf + (d->goff - start), d->data + d->offset, d->len);
+      goff = d->goff + d->len;
+    }
+  }
+  readGap(goff, start + length_ - goff);
+}
+
 void Piece::destroyHashContext()
 {
   mdctx_.reset();
@@ -331,42 +375,55 @@ void Piece::clearWrCache(WrDiskCache* diskCache)
   wrCache_->clear();
 }
 
-void Piece::updateWrCache(WrDiskCache* diskCache, unsigned char* data,
-                          size_t offset, size_t len, size_t capacity,
-                          int64_t goff)
+void Piece::copyWrCache(WrDiskCache* diskCache, int64_t goff,
+                        const unsigned char* data, size_t len, size_t reserve)
 {
   if (!diskCache) {
     return;
   }
   assert(wrCache_);
-  A2_LOG_DEBUG(fmt("updateWrCache entry=%p", wrCache_.get()));
-  auto cell = new WrDiskCacheEntry::DataCell();
-  cell->goff = goff;
-  cell->data = data;
-  cell->offset = offset;
-  cell->len = len;
-  cell->capacity = capacity;
+  A2_LOG_DEBUG(fmt("copyWrCache entry=%p", wrCache_.get()));
+  size_t size = wrCache_->getSize();
+  wrCache_->cacheData(goff, data, len, reserve);
   bool rv;
-  rv = wrCache_->cacheData(cell);
-  assert(rv);
-  rv = diskCache->update(wrCache_.get(), len);
+  rv = diskCache->update(wrCache_.get(), wrCache_->getSize() - size);
   assert(rv);
 }
 
-size_t Piece::appendWrCache(WrDiskCache* diskCache, int64_t goff,
-                            const unsigned char* data, size_t len)
+void Piece::moveWrCache(WrDiskCache* diskCache, int64_t goff,
+                        std::unique_ptr<unsigned char[]> data, size_t len,
+                        size_t capacity)
 {
   if (!diskCache) {
-    return 0;
+    return;
   }
   assert(wrCache_);
-  size_t delta = wrCache_->append(goff, data, len);
-  bool rv;
-  if (delta > 0) {
-    rv = diskCache->update(wrCache_.get(), delta);
+  A2_LOG_DEBUG(fmt("moveWrCache entry=%p", wrCache_.get()));
+  if (wrCache_->coalesce(goff, data.get(), len)) {
+    diskCache->releaseBuffer(data.release(), capacity);
+    bool rv;
+    rv = diskCache->update(wrCache_.get(), 0);
     assert(rv);
+    return;
   }
-  return delta;
+  auto cell = make_unique<WrDiskCacheEntry::DataCell>();
+  cell->goff = goff;
+  cell->data = data.get();
+  cell->offset = 0;
+  cell->len = len;
+  cell->capacity = capacity;
+  if (!wrCache_->cacheData(cell.get())) {
+    A2_LOG_WARN(fmt("WrDiskCacheEntry already has data at goff=%" PRId64,
+                    goff));
+    diskCache->releaseBuffer(data.release(), capacity);
+    return;
+  }
+  // Now the cache owns them.
+  cell.release();
+  data.release();
+  bool rv;
+  rv = diskCache->update(wrCache_.get(), capacity);
+  assert(rv);
 }
 
 void Piece::releaseWrCache(WrDiskCache* diskCache)
@@ -52,6 +52,7 @@ class WrDiskCache;
 class WrDiskCacheEntry;
 class DiskAdaptor;
 class MessageDigest;
+class FileRegion;
 
 class Piece {
 private:
@@ -162,6 +163,15 @@ public:
   // cached data and data on disk.
   std::string getDigestWithWrCache(size_t pieceLength,
                                    const std::shared_ptr<DiskAdaptor>& adaptor);
+
+  // Copies the data of this piece to buf, which must be at least
+  // getLength() bytes long, using cached data and data on disk.  If
+  // regions is not null, the data on disk is not read here if
+  // possible: the regions to read into buf are appended to regions
+  // instead.
+  void getDataWithWrCache(unsigned char* buf, size_t pieceLength,
+                          const std::shared_ptr<DiskAdaptor>& adaptor,
+                          std::vector<FileRegion>* regions = nullptr);
   /**
    * Loses current bitfield state.
    */
@@ -178,15 +188,21 @@ public:
                    const std::shared_ptr<DiskAdaptor>& diskAdaptor);
   void flushWrCache(WrDiskCache* diskCache);
   void clearWrCache(WrDiskCache* diskCache);
-  void updateWrCache(WrDiskCache* diskCache, unsigned char* data, size_t offset,
-                     size_t len, size_t capacity, int64_t goff);
-  void updateWrCache(WrDiskCache* diskCache, unsigned char* data, size_t offset,
-                     size_t len, int64_t goff)
-  {
-    updateWrCache(diskCache, data, offset, len, len, goff);
-  }
-  size_t appendWrCache(WrDiskCache* diskCache, int64_t goff,
-                       const unsigned char* data, size_t len);
+  // Copies len bytes of data to be put at goff into the cache.  The
+  // data is coalesced with the cached data ending at goff if
+  // possible.  reserve is the number of bytes expected to be written
+  // contiguously from goff, including len.
+  void copyWrCache(WrDiskCache* diskCache, int64_t goff,
+                   const unsigned char* data, size_t len, size_t reserve);
+  // Moves the buffer data of capacity bytes holding len bytes to be
+  // put at goff into the cache without copying.  data must be
+  // allocated by new[].  If the cached data ending at goff has room
+  // for len bytes, they are copied there instead, so that the blocks
+  // of a piece are written in large chunks.  In that case, or if the
+  // cache already has data at goff, data is released to diskCache.
+  void moveWrCache(WrDiskCache* diskCache, int64_t goff,
+                   std::unique_ptr<unsigned char[]> data, size_t len,
+                   size_t capacity);
   void releaseWrCache(WrDiskCache* diskCache);
   WrDiskCacheEntry* getWrDiskCacheEntry() const { return wrCache_.get(); }
 };
@@ -38,6 +38,10 @@
 #include "DownloadContext.h"
 #include "PieceStorage.h"
 #include "a2functional.h"
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#include "SingletonHolder.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -58,9 +62,13 @@ bool PieceHashCheckIntegrityEntry::isValidationReady()
 
 void PieceHashCheckIntegrityEntry::initValidator()
 {
+  HashWorkerPool* hashWorkerPool = nullptr;
+#ifdef HAVE_STD_THREAD
+  hashWorkerPool = SingletonHolder<HashWorkerPool>::instance().get();
+#endif // HAVE_STD_THREAD
   auto validator = make_unique<IteratableChunkChecksumValidator>(
       getRequestGroup()->getDownloadContext(),
-      getRequestGroup()->getPieceStorage());
+      getRequestGroup()->getPieceStorage(), hashWorkerPool);
   validator->init();
   setValidator(std::move(validator));
 }
@@ -43,7 +43,7 @@
 namespace aria2 {
 
 PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle)
-    : order_(pieceNum), counts_(pieceNum)
+    : order_(pieceNum), counts_(pieceNum), pos_(pieceNum), bucketStart_(1)
 {
   for (size_t i = 0; i < pieceNum; ++i) {
     order_[i] = i;
@@ -53,66 +53,76 @@ PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle)
     std::shuffle(order_.begin(), order_.end(),
                  *SimpleRandomizer::getInstance());
   }
+  for (size_t i = 0; i < pieceNum; ++i) {
+    pos_[order_[i]] = i;
+  }
 }
 
 PieceStatMan::~PieceStatMan() = default;
 
-namespace {
-void inc(int& x)
+void PieceStatMan::swapOrder(size_t i, size_t j)
+{
+  std::swap(order_[i], order_[j]);
+  pos_[order_[i]] = i;
+  pos_[order_[j]] = j;
+}
+
+// Moves the piece to the end of its bucket and then shrinks the
+// bucket by one, so that the piece becomes the first one of the next
+// bucket.
+void PieceStatMan::inc(size_t index)
 {
-  if (x < std::numeric_limits<int>::max()) {
-    ++x;
+  int c = counts_[index];
+  if (c == std::numeric_limits<int>::max()) {
+    return;
   }
+  if (bucketStart_.size() <= static_cast<size_t>(c) + 1) {
+    bucketStart_.resize(c + 2, order_.size());
+  }
+  size_t last = bucketStart_[c + 1] - 1;
+  swapOrder(pos_[index], last);
+  bucketStart_[c + 1] = last;
+  ++counts_[index];
 }
-} // namespace
 
-namespace {
-void sub(int& x)
+// Moves the piece to the start of its bucket and then shrinks the
+// bucket by one, so that the piece becomes the last one of the
+// previous bucket.
+void PieceStatMan::sub(size_t index)
 {
-  if (x > 0) {
-    --x;
+  int c = counts_[index];
+  if (c == 0) {
+    return;
   }
+  size_t first = bucketStart_[c];
+  swapOrder(pos_[index], first);
+  bucketStart_[c] = first + 1;
+  --counts_[index];
 }
-} // namespace
 
 void PieceStatMan::addPieceStats(const unsigned char* bitfield,
                                  size_t bitfieldLength)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      inc(counts_[i]);
-    }
-  }
+  bitfield::forEachSetBit(bitfield, counts_.size(),
+                          [this](size_t index) { inc(index); });
 }
 
 void PieceStatMan::subtractPieceStats(const unsigned char* bitfield,
                                       size_t bitfieldLength)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      sub(counts_[i]);
-    }
-  }
+  bitfield::forEachSetBit(bitfield, counts_.size(),
+                          [this](size_t index) { sub(index); });
 }
 
 void PieceStatMan::updatePieceStats(const unsigned char* newBitfield,
                                     size_t newBitfieldLength,
                                     const unsigned char* oldBitfield)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    bool inNew = bitfield::test(newBitfield, nbits, i);
-    bool inOld = bitfield::test(oldBitfield, nbits, i);
-    if (inNew) {
-      if (!inOld) {
-        inc(counts_[i]);
-      }
-    }
-    else if (inOld) {
-      sub(counts_[i]);
-    }
-  }
+  bitfield::forEachChangedBit(newBitfield, oldBitfield, counts_.size(),
+                              [this](size_t index) { inc(index); },
+                              [this](size_t index) { sub(index); });
 }
 
-void PieceStatMan::addPieceStats(size_t index) { inc(counts_[index]); }
+void PieceStatMan::addPieceStats(size_t index) { inc(index); }
 
 } // namespace aria2
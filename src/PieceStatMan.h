@@ -43,8 +43,23 @@ namespace aria2 {
 
 class PieceStatMan {
 private:
+  // Piece indexes sorted by their counts in ascending order.  Pieces
+  // with the same count form a bucket.  Pieces in a bucket are
+  // randomly ordered if randomShuffle is true in the constructor.
   std::vector<size_t> order_;
+  // The number of peers which have the piece, indexed by piece index.
   std::vector<int> counts_;
+  // The position of each piece in order_, indexed by piece index.
+  std::vector<size_t> pos_;
+  // bucketStart_[c] is the position of the first piece in order_
+  // whose count is greater than or equal to c.
+  std::vector<size_t> bucketStart_;
+
+  void inc(size_t index);
+
+  void sub(size_t index);
+
+  void swapOrder(size_t i, size_t j);
 
 public:
   PieceStatMan(size_t pieceNum, bool randomShuffle);
@@ -61,6 +76,7 @@ public:
                         size_t newBitfieldLength,
                         const unsigned char* oldBitfield);
 
+  // Returns piece indexes sorted by their counts in ascending order.
   const std::vector<size_t>& getOrder() const { return order_; }
 
   const std::vector<int>& getCounts() const { return counts_; }
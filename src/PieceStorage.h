@@ -43,6 +43,7 @@
 
 #include "TimerA2.h"
 #include "Command.h"
+#include "BufferPool.h"
 
 namespace aria2 {
 
@@ -124,6 +125,26 @@ public:
   virtual std::shared_ptr<Piece>
   getMissingPiece(const std::shared_ptr<Peer>& peer,
                   const std::vector<size_t>& excludedIndexes, cuid_t cuid) = 0;
+
+  /**
+   * Appends HAVE messages in wire format for the pieces advertised
+   * after lastHaveIndex to messages.  The consecutive messages are
+   * stored in one slice.  The slices are shared by all callers, so
+   * they must not be modified.  The number of HAVE messages is
+   * assigned to numHaves.  Returns the haveIndex of the last
+   * advertised piece, which should be passed as lastHaveIndex in the
+   * next call.
+   */
+  virtual uint64_t
+  getAdvertisedPieceMessages(std::vector<BufferSlice>& messages,
+                             size_t& numHaves, uint64_t lastHaveIndex) = 0;
+
+  /**
+   * Returns BITFIELD message in wire format for the current
+   * bitfield.  The returned slice is shared by all callers while the
+   * bitfield is unchanged, so it must not be modified.
+   */
+  virtual BufferSlice getBitfieldMessage() = 0;
 #endif // ENABLE_BITTORRENT
 
   // Returns true if there is at least one missing and unused piece.
@@ -238,14 +259,6 @@ public:
   virtual void advertisePiece(cuid_t cuid, size_t index,
                               Timer registerdTime) = 0;
 
-  /**
-   * indexes is filled with piece index which is not advertised by the
-   * caller command and newer than lastHaveIndex.
-   */
-  virtual uint64_t getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
-                                             cuid_t myCuid,
-                                             uint64_t lastHaveIndex) = 0;
-
   /**
    * Removes have entry if its registeredTime is at least as old as
    * expiry.
@@ -56,13 +56,18 @@ std::vector<unsigned char> RangeBtMessage::createMessage()
    * total: 17bytes
    */
   auto msg = std::vector<unsigned char>(MESSAGE_LENGTH);
-  bittorrent::createPeerMessageString(msg.data(), MESSAGE_LENGTH, 13, getId());
-  bittorrent::setIntParam(&msg[5], index_);
-  bittorrent::setIntParam(&msg[9], begin_);
-  bittorrent::setIntParam(&msg[13], length_);
+  writeMessage(msg.data());
   return msg;
 }
 
+void RangeBtMessage::writeMessage(unsigned char* data) const
+{
+  bittorrent::createPeerMessageString(data, MESSAGE_LENGTH, 13, getId());
+  bittorrent::setIntParam(&data[5], index_);
+  bittorrent::setIntParam(&data[9], begin_);
+  bittorrent::setIntParam(&data[13], length_);
+}
+
 std::string RangeBtMessage::toString() const
 {
   return fmt("%s index=%lu, begin=%d, length=%d", getName(),
@@ -53,14 +53,19 @@ RealtimeCommand::~RealtimeCommand() { requestGroup_->decreaseNumCommand(); }
 bool RealtimeCommand::execute()
 {
   setStatusRealtime();
-  e_->setNoWait(true);
+  bool r;
   try {
-    return executeInternal();
+    r = executeInternal();
   }
   catch (RecoverableException& e) {
-    bool r = handleException(e);
-    return r;
+    r = handleException(e);
   }
+  // Don't block the event loop unless this command went to sleep
+  // waiting for an event.
+  if (r || statusMatch(Command::STATUS_REALTIME)) {
+    e_->setNoWait(true);
+  }
+  return r;
 }
 
 } // namespace aria2
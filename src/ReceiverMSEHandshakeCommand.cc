@@ -102,8 +102,9 @@ bool ReceiverMSEHandshakeCommand::executeInternal()
               "The legacy BitTorrent handshake is not acceptable by the"
               " preference.");
         }
-        auto peerConnection =
-            make_unique<PeerConnection>(getCuid(), getPeer(), getSocket());
+        auto peerConnection = make_unique<PeerConnection>(
+            getCuid(), getPeer(), getSocket(),
+            getDownloadEngine()->getBufferPool());
         peerConnection->presetBuffer(mseHandshake_->getBuffer(),
                                      mseHandshake_->getBufferLength());
         getDownloadEngine()->addCommand(
@@ -214,7 +215,8 @@ bool ReceiverMSEHandshakeCommand::executeInternal()
 void ReceiverMSEHandshakeCommand::createCommand()
 {
   auto peerConnection =
-      make_unique<PeerConnection>(getCuid(), getPeer(), getSocket());
+      make_unique<PeerConnection>(getCuid(), getPeer(), getSocket(),
+                                  getDownloadEngine()->getBufferPool());
   if (mseHandshake_->getNegotiatedCryptoType() == MSEHandshake::CRYPTO_ARC4) {
     peerConnection->enableEncryption(mseHandshake_->popEncryptor(),
                                      mseHandshake_->popDecryptor());
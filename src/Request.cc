@@ -163,7 +163,7 @@ void Request::resetRedirectCount() { redirectCount_ = 0; }
 
 void Request::setMaxPipelinedRequest(int num) { maxPipelinedRequest_ = num; }
 
-const std::shared_ptr<PeerStat>& Request::initPeerStat()
+const std::shared_ptr<PeerStat>& Request::initPeerStat(cuid_t cuid)
 {
   // Use host and protocol in original URI, because URI selector
   // selects URI based on original URI, not redirected one.
@@ -172,7 +172,7 @@ const std::shared_ptr<PeerStat>& Request::initPeerStat()
   assert(v == 0);
   std::string host = uri::getFieldString(us, USR_HOST, uri_.c_str());
   std::string protocol = uri::getFieldString(us, USR_SCHEME, uri_.c_str());
-  peerStat_ = std::make_shared<PeerStat>(0, host, protocol);
+  peerStat_ = std::make_shared<PeerStat>(cuid, host, protocol);
   return peerStat_;
 }
 
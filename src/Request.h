@@ -41,6 +41,7 @@
 
 #include "TimerA2.h"
 #include "uri.h"
+#include "Command.h"
 
 namespace aria2 {
 
@@ -150,7 +151,8 @@ public:
 
   const std::shared_ptr<PeerStat>& getPeerStat() const { return peerStat_; }
 
-  const std::shared_ptr<PeerStat>& initPeerStat();
+  // Creates new PeerStat for the connection |cuid|.
+  const std::shared_ptr<PeerStat>& initPeerStat(cuid_t cuid);
 
   void requestRemoval() { removalRequested_ = true; }
 
@@ -142,6 +142,7 @@ RequestGroup::RequestGroup(const std::shared_ptr<GroupId>& gid,
       fileNotFoundCount_(0),
       maxDownloadSpeedLimit_(option->getAsInt(PREF_MAX_DOWNLOAD_LIMIT)),
       maxUploadSpeedLimit_(option->getAsInt(PREF_MAX_UPLOAD_LIMIT)),
+      downloadPriority_(option->getAsInt(PREF_DOWNLOAD_PRIORITY)),
       resumeFailureCount_(0),
       haltReason_(RequestGroup::NONE),
       lastErrorCode_(error_code::UNDEFINED),
@@ -1275,18 +1276,6 @@ void RequestGroup::setTimeout(std::chrono::seconds timeout)
   timeout_ = std::move(timeout);
 }
 
-bool RequestGroup::doesDownloadSpeedExceed()
-{
-  int spd = downloadContext_->getNetStat().calculateDownloadSpeed();
-  return maxDownloadSpeedLimit_ > 0 && maxDownloadSpeedLimit_ < spd;
-}
-
-bool RequestGroup::doesUploadSpeedExceed()
-{
-  int spd = downloadContext_->getNetStat().calculateUploadSpeed();
-  return maxUploadSpeedLimit_ > 0 && maxUploadSpeedLimit_ < spd;
-}
-
 void RequestGroup::saveControlFile() const
 {
   if (saveControlFile_) {
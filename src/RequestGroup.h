@@ -161,6 +161,8 @@ private:
 
   int maxUploadSpeedLimit_;
 
+  int downloadPriority_;
+
   int resumeFailureCount_;
 
   HaltReason haltReason_;
@@ -426,16 +428,6 @@ public:
 
   const std::chrono::seconds& getTimeout() const { return timeout_; }
 
-  // Returns true if current download speed exceeds
-  // maxDownloadSpeedLimit_.  Always returns false if
-  // maxDownloadSpeedLimit_ == 0.  Otherwise returns false.
-  bool doesDownloadSpeedExceed();
-
-  // Returns true if current upload speed exceeds
-  // maxUploadSpeedLimit_. Always returns false if
-  // maxUploadSpeedLimit_ == 0. Otherwise returns false.
-  bool doesUploadSpeedExceed();
-
   int getMaxDownloadSpeedLimit() const { return maxDownloadSpeedLimit_; }
 
   void setMaxDownloadSpeedLimit(int speed) { maxDownloadSpeedLimit_ = speed; }
@@ -444,6 +436,10 @@ public:
 
   void setMaxUploadSpeedLimit(int speed) { maxUploadSpeedLimit_ = speed; }
 
+  int getDownloadPriority() const { return downloadPriority_; }
+
+  void setDownloadPriority(int priority) { downloadPriority_ = priority; }
+
   void setLastErrorCode(error_code::Value code, const char* message = "")
   {
     lastErrorCode_ = code;
@@ -85,6 +85,12 @@
 #include "OpenedFileCounter.h"
 #include "wallclock.h"
 #include "RpcMethodImpl.h"
+#include "UploadScheduler.h"
+#include "DownloadShaper.h"
+#include "AbstractCommand.h"
+#ifdef ENABLE_ASYNC_DNS
+#include "DNSPrefetchCommand.h"
+#endif // ENABLE_ASYNC_DNS
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
@@ -122,6 +128,10 @@ RequestGroupMan::RequestGroupMan(
       removedErrorResult_(0),
       removedLastErrorResult_(error_code::FINISHED),
       maxDownloadResult_(option->getAsInt(PREF_MAX_DOWNLOAD_RESULT)),
+      uploadScheduler_(make_unique<UploadScheduler>(
+          option->getAsInt(PREF_MAX_OVERALL_UPLOAD_LIMIT))),
+      downloadShaper_(make_unique<DownloadShaper>(
+          option->getAsInt(PREF_MAX_OVERALL_DOWNLOAD_LIMIT))),
       openedFileCounter_(std::make_shared<OpenedFileCounter>(
           this, option->getAsInt(PREF_BT_MAX_OPEN_FILES))),
       numStoppedTotal_(0)
@@ -521,6 +531,7 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
                                    : maxConcurrentDownloads_;
 
   if (static_cast<size_t>(maxConcurrentDownloads) <= numActive_) {
+    prefetchHostnames(e);
     return;
   }
   int count = 0;
@@ -590,6 +601,59 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
     e->setRefreshInterval(std::chrono::milliseconds(0));
     A2_LOG_DEBUG(fmt("%d RequestGroup(s) added.", count));
   }
+  prefetchHostnames(e);
+}
+
+namespace {
+// The number of waiting downloads looked ahead for DNS prefetch.
+const size_t DNS_PREFETCH_GROUPS = 16;
+// The maximum number of DNSPrefetchCommands running at a time.
+const size_t MAX_DNS_PREFETCH = 8;
+} // namespace
+
+void RequestGroupMan::prefetchHostnames(DownloadEngine* e)
+{
+#ifdef ENABLE_ASYNC_DNS
+  size_t numGroups = 0;
+  for (auto i = std::begin(reservedGroups_), eoi = std::end(reservedGroups_);
+       i != eoi && numGroups < DNS_PREFETCH_GROUPS &&
+       prefetchingHosts_.size() < MAX_DNS_PREFETCH;
+       ++i, ++numGroups) {
+    const auto& option = (*i)->getOption();
+    if (!option->getAsBool(PREF_ASYNC_DNS)) {
+      continue;
+    }
+    // The connections use the first few URIs in parallel.
+    size_t numUris = option->getAsInt(PREF_SPLIT);
+    for (auto& fileEntry : (*i)->getDownloadContext()->getFileEntries()) {
+      const auto& uris = fileEntry->getRemainingUris();
+      for (size_t j = 0; j < std::min(numUris, uris.size()) &&
+                         prefetchingHosts_.size() < MAX_DNS_PREFETCH;
+           ++j) {
+        uri::UriStruct us;
+        // With a proxy server, aria2 resolves the address of the
+        // proxy server, not the hostname.
+        if (!uri::parse(us, uris[j]) ||
+            !getProxyUri(us.protocol, option.get()).empty() ||
+            util::isNumericHost(us.host) ||
+            e->getDNSCache()->contains(us.host, us.port)) {
+          continue;
+        }
+        if (prefetchingHosts_.insert(std::make_pair(us.host, us.port))
+                .second) {
+          e->addCommand(make_unique<DNSPrefetchCommand>(
+              e->newCUID(), e, std::move(us.host), us.port));
+        }
+      }
+    }
+  }
+#endif // ENABLE_ASYNC_DNS
+}
+
+void RequestGroupMan::onHostnamePrefetched(const std::string& hostname,
+                                           uint16_t port)
+{
+  prefetchingHosts_.erase(std::make_pair(hostname, port));
 }
 
 void RequestGroupMan::save()
@@ -983,16 +1047,16 @@ void RequestGroupMan::removeStaleServerStat(const std::chrono::seconds& timeout)
   serverStatMan_->removeStaleServerStat(timeout);
 }
 
-bool RequestGroupMan::doesOverallDownloadSpeedExceed()
+void RequestGroupMan::setMaxOverallDownloadSpeedLimit(int speed)
 {
-  return maxOverallDownloadSpeedLimit_ > 0 &&
-         maxOverallDownloadSpeedLimit_ < netStat_.calculateDownloadSpeed();
+  maxOverallDownloadSpeedLimit_ = speed;
+  downloadShaper_->setMaxOverallDownloadSpeedLimit(speed);
 }
 
-bool RequestGroupMan::doesOverallUploadSpeedExceed()
+void RequestGroupMan::setMaxOverallUploadSpeedLimit(int speed)
 {
-  return maxOverallUploadSpeedLimit_ > 0 &&
-         maxOverallUploadSpeedLimit_ < netStat_.calculateUploadSpeed();
+  maxOverallUploadSpeedLimit_ = speed;
+  uploadScheduler_->setMaxOverallUploadSpeedLimit(speed);
 }
 
 void RequestGroupMan::getUsedHosts(
@@ -41,6 +41,7 @@
 #include <deque>
 #include <vector>
 #include <map>
+#include <set>
 #include <memory>
 
 #include "DownloadResult.h"
@@ -61,6 +62,8 @@ class OutputFile;
 class UriListParser;
 class WrDiskCache;
 class OpenedFileCounter;
+class UploadScheduler;
+class DownloadShaper;
 
 typedef IndexedList<a2_gid_t, std::shared_ptr<RequestGroup>> RequestGroupList;
 typedef IndexedList<a2_gid_t, std::shared_ptr<DownloadResult>>
@@ -121,6 +124,10 @@ private:
 
   std::unique_ptr<WrDiskCache> wrDiskCache_;
 
+  std::unique_ptr<UploadScheduler> uploadScheduler_;
+
+  std::unique_ptr<DownloadShaper> downloadShaper_;
+
   std::shared_ptr<OpenedFileCounter> openedFileCounter_;
 
   // The number of stopped downloads so far in total, including
@@ -130,6 +137,10 @@ private:
   // SHA1 hash value of the content of last session serialization.
   std::string lastSessionHash_;
 
+  // The pairs of hostname and port whose addresses are being
+  // prefetched by DNSPrefetchCommand.
+  std::set<std::pair<std::string, uint16_t>> prefetchingHosts_;
+
   void formatDownloadResultFull(
       OutputFile& out, const char* status,
       const std::shared_ptr<DownloadResult>& downloadResult) const;
@@ -147,6 +158,11 @@ private:
 
   int optimizeConcurrentDownloads();
 
+  // Starts DNSPrefetchCommand for the hostnames of the waiting
+  // downloads which will start next, so that they do not wait for the
+  // name resolution.  This is only effective with asynchronous DNS.
+  void prefetchHostnames(DownloadEngine* e);
+
 public:
   RequestGroupMan(std::vector<std::shared_ptr<RequestGroup>> requestGroups,
                   int maxConcurrentDownloads, const Option* option);
@@ -167,6 +183,10 @@ public:
 
   void fillRequestGroupFromReserver(DownloadEngine* e);
 
+  // Called by DNSPrefetchCommand when the name resolution of hostname
+  // finished.
+  void onHostnamePrefetched(const std::string& hostname, uint16_t port);
+
   // Note that this method does not call addRequestGroupIndex(). This
   // method should be considered as private, but exposed for unit
   // testing purpose.
@@ -286,36 +306,27 @@ public:
 
   void removeStaleServerStat(const std::chrono::seconds& timeout);
 
-  // Returns true if current download speed exceeds
-  // maxOverallDownloadSpeedLimit_.  Always returns false if
-  // maxOverallDownloadSpeedLimit_ == 0.  Otherwise returns false.
-  bool doesOverallDownloadSpeedExceed();
-
-  void setMaxOverallDownloadSpeedLimit(int speed)
-  {
-    maxOverallDownloadSpeedLimit_ = speed;
-  }
+  void setMaxOverallDownloadSpeedLimit(int speed);
 
   int getMaxOverallDownloadSpeedLimit() const
   {
     return maxOverallDownloadSpeedLimit_;
   }
 
-  // Returns true if current upload speed exceeds
-  // maxOverallUploadSpeedLimit_. Always returns false if
-  // maxOverallUploadSpeedLimit_ == 0. Otherwise returns false.
-  bool doesOverallUploadSpeedExceed();
+  void setMaxOverallUploadSpeedLimit(int speed);
 
-  void setMaxOverallUploadSpeedLimit(int speed)
+  int getMaxOverallUploadSpeedLimit() const
   {
-    maxOverallUploadSpeedLimit_ = speed;
+    return maxOverallUploadSpeedLimit_;
   }
 
-  int getMaxOverallUploadSpeedLimit() const
+  UploadScheduler* getUploadScheduler() const
   {
-    return maxOverallUploadSpeedLimit_;
+    return uploadScheduler_.get();
   }
 
+  DownloadShaper* getDownloadShaper() const { return downloadShaper_.get(); }
+
   void setMaxConcurrentDownloads(int max) { maxConcurrentDownloads_ = max; }
 
   // Call this function if requestGroups_ queue should be maintained.
@@ -69,6 +69,13 @@
 #include "MessageDigest.h"
 #include "message_digest_helper.h"
 #include "OpenedFileCounter.h"
+#include "BufferPool.h"
+#include "DownloadShaper.h"
+#include "SocketCore.h"
+#include "SocketPool.h"
+#ifdef ENABLE_SSL
+#include "TLSContext.h"
+#endif // ENABLE_SSL
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #include "BtRegistry.h"
@@ -102,6 +109,8 @@ const char KEY_STATUS[] = "status";
 const char KEY_TOTAL_LENGTH[] = "totalLength";
 const char KEY_COMPLETED_LENGTH[] = "completedLength";
 const char KEY_DOWNLOAD_SPEED[] = "downloadSpeed";
+const char KEY_AVERAGE_DOWNLOAD_SPEED[] = "averageDownloadSpeed";
+const char KEY_DOWNLOAD_LENGTH[] = "downloadLength";
 const char KEY_UPLOAD_SPEED[] = "uploadSpeed";
 const char KEY_UPLOAD_LENGTH[] = "uploadLength";
 const char KEY_CONNECTIONS[] = "connections";
@@ -145,6 +154,24 @@ const char KEY_NUM_WAITING[] = "numWaiting";
 const char KEY_NUM_STOPPED[] = "numStopped";
 const char KEY_NUM_ACTIVE[] = "numActive";
 const char KEY_NUM_STOPPED_TOTAL[] = "numStoppedTotal";
+const char KEY_BUFFER_POOL_HITS[] = "bufferPoolHits";
+const char KEY_BUFFER_POOL_MISSES[] = "bufferPoolMisses";
+const char KEY_BUFFER_POOL_IN_USE[] = "bufferPoolInUse";
+const char KEY_BUFFER_POOL_FREE[] = "bufferPoolFree";
+const char KEY_SOCKET_POOL_HITS[] = "socketPoolHits";
+const char KEY_SOCKET_POOL_MISSES[] = "socketPoolMisses";
+const char KEY_SOCKET_POOL_IDLE[] = "socketPoolIdle";
+const char KEY_DNS_CACHE_HITS[] = "dnsCacheHits";
+const char KEY_DNS_CACHE_MISSES[] = "dnsCacheMisses";
+const char KEY_TLS_FULL_HANDSHAKES[] = "tlsFullHandshakes";
+const char KEY_TLS_RESUMED_HANDSHAKES[] = "tlsResumedHandshakes";
+const char KEY_DOWNLOAD_LIMIT[] = "downloadLimit";
+const char KEY_TOKENS[] = "tokens";
+const char KEY_CLASSES[] = "classes";
+const char KEY_PRIORITY[] = "priority";
+const char KEY_QUOTA[] = "quota";
+const char KEY_GRANTED_LENGTH[] = "grantedLength";
+const char KEY_BORROWED_LENGTH[] = "borrowedLength";
 const char KEY_VERIFIED_LENGTH[] = "verifiedLength";
 const char KEY_VERIFY_PENDING[] = "verifyIntegrityPending";
 } // namespace
@@ -797,14 +824,13 @@ void gatherProgress(Dict* entryDict, const std::shared_ptr<RequestGroup>& group,
   }
 #endif // ENABLE_BITTORRENT
   if (e->getCheckIntegrityMan()) {
-    if (e->getCheckIntegrityMan()->isPicked(
-            [&group](const CheckIntegrityEntry& ent) {
-              return ent.getRequestGroup() == group.get();
-            })) {
-      entryDict->put(
-          KEY_VERIFIED_LENGTH,
-          util::itos(
-              e->getCheckIntegrityMan()->getPickedEntry()->getCurrentLength()));
+    auto entry = e->getCheckIntegrityMan()->findPickedEntry(
+        [&group](const CheckIntegrityEntry& ent) {
+          return ent.getRequestGroup() == group.get();
+        });
+    if (entry) {
+      entryDict->put(KEY_VERIFIED_LENGTH,
+                     util::itos(entry->getCurrentLength()));
     }
     if (e->getCheckIntegrityMan()->isQueued(
             [&group](const CheckIntegrityEntry& ent) {
@@ -1283,6 +1309,10 @@ std::unique_ptr<ValueBase> GetServersRpcMethod::process(const RpcRequest& req,
         serverEntry->put(KEY_CURRENT_URI, req->getCurrentUri());
         serverEntry->put(KEY_DOWNLOAD_SPEED,
                          util::itos(ps->calculateDownloadSpeed()));
+        serverEntry->put(KEY_AVERAGE_DOWNLOAD_SPEED,
+                         util::itos(ps->calculateAvgDownloadSpeed()));
+        serverEntry->put(KEY_DOWNLOAD_LENGTH,
+                         util::itos(ps->getSessionDownloadLength()));
         servers->append(std::move(serverEntry));
       }
     }
@@ -1389,6 +1419,53 @@ GetGlobalStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   res->put(KEY_NUM_STOPPED, util::uitos(rgman->getDownloadResults().size()));
   res->put(KEY_NUM_STOPPED_TOTAL, util::uitos(rgman->getNumStoppedTotal()));
   res->put(KEY_NUM_ACTIVE, util::uitos(rgman->getRequestGroups().size()));
+  auto bufferPool = e->getBufferPool();
+  res->put(KEY_BUFFER_POOL_HITS, util::uitos(bufferPool->getNumHits()));
+  res->put(KEY_BUFFER_POOL_MISSES, util::uitos(bufferPool->getNumMisses()));
+  res->put(KEY_BUFFER_POOL_IN_USE, util::uitos(bufferPool->getInUseBytes()));
+  res->put(KEY_BUFFER_POOL_FREE, util::uitos(bufferPool->getFreeBytes()));
+  auto& socketPool = e->getSocketPool();
+  res->put(KEY_SOCKET_POOL_HITS, util::uitos(socketPool->getNumHits()));
+  res->put(KEY_SOCKET_POOL_MISSES, util::uitos(socketPool->getNumMisses()));
+  res->put(KEY_SOCKET_POOL_IDLE, util::uitos(socketPool->size()));
+  auto& dnsCache = e->getDNSCache();
+  res->put(KEY_DNS_CACHE_HITS, util::uitos(dnsCache->getNumHits()));
+  res->put(KEY_DNS_CACHE_MISSES, util::uitos(dnsCache->getNumMisses()));
+#ifdef ENABLE_SSL
+  auto& tlsContext = SocketCore::getClientTLSContext();
+  if (tlsContext) {
+    auto& sessionCache = tlsContext->getSessionCache();
+    res->put(KEY_TLS_FULL_HANDSHAKES,
+             util::uitos(sessionCache.getNumFullHandshakes()));
+    res->put(KEY_TLS_RESUMED_HANDSHAKES,
+             util::uitos(sessionCache.getNumResumedHandshakes()));
+  }
+#endif // ENABLE_SSL
+  return std::move(res);
+}
+
+std::unique_ptr<ValueBase>
+GetShaperStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
+{
+  auto shaper = e->getRequestGroupMan()->getDownloadShaper();
+  auto res = Dict::g();
+  res->put(KEY_DOWNLOAD_LIMIT,
+           util::itos(shaper->getMaxOverallDownloadSpeedLimit()));
+  res->put(KEY_TOKENS, util::itos(shaper->getOverallBucket().getTokens()));
+  auto classes = List::g();
+  for (auto& i : shaper->getClasses()) {
+    auto& cls = i.second;
+    auto entry = Dict::g();
+    entry->put(KEY_GID, GroupId::toHex(i.first));
+    entry->put(KEY_PRIORITY, util::itos(cls.priority));
+    entry->put(KEY_DOWNLOAD_LIMIT, util::itos(cls.ceil.getRate()));
+    entry->put(KEY_TOKENS, util::itos(cls.ceil.getTokens()));
+    entry->put(KEY_QUOTA, util::itos(cls.quota));
+    entry->put(KEY_GRANTED_LENGTH, util::itos(cls.grantedLength));
+    entry->put(KEY_BORROWED_LENGTH, util::itos(cls.borrowedLength));
+    classes->append(std::move(entry));
+  }
+  res->put(KEY_CLASSES, std::move(classes));
   return std::move(res);
 }
 
@@ -1634,6 +1711,9 @@ void changeOption(const std::shared_ptr<RequestGroup>& group,
   if (option.defined(PREF_MAX_UPLOAD_LIMIT)) {
     group->setMaxUploadSpeedLimit(grOption->getAsInt(PREF_MAX_UPLOAD_LIMIT));
   }
+  if (option.defined(PREF_DOWNLOAD_PRIORITY)) {
+    group->setDownloadPriority(grOption->getAsInt(PREF_DOWNLOAD_PRIORITY));
+  }
 #ifdef ENABLE_BITTORRENT
   auto btObject = e->getBtRegistry()->get(group->getGID());
   if (btObject) {
@@ -37,6 +37,7 @@
 #include <cassert>
 #include <algorithm>
 #include <numeric>
+#include <cmath>
 
 #include "util.h"
 #include "message.h"
@@ -206,9 +207,150 @@ std::shared_ptr<Segment> SegmentMan::getSegment(cuid_t cuid,
   std::shared_ptr<Piece> piece = pieceStorage_->getMissingPiece(
       minSplitSize, ignoreBitfield_.getFilterBitfield(),
       ignoreBitfield_.getBitfieldLength(), cuid);
+  if (!piece) {
+    return splitSlowestSegment(cuid);
+  }
   return checkoutSegment(cuid, piece);
 }
 
+namespace {
+// The connection must be this many times faster than the owner to
+// take over the in-flight segment.
+const int TAKE_OVER_SPEED_RATIO = 2;
+// Taking over the in-flight segment must save at least this many
+// seconds, which pays for the new request.
+const int TAKE_OVER_MIN_GAIN = 1;
+} // namespace
+
+std::shared_ptr<Segment> SegmentMan::splitSlowestSegment(cuid_t cuid)
+{
+  int64_t totalLength = downloadContext_->getTotalLength();
+  auto peerStat = getPeerStat(cuid);
+  if (totalLength == 0 || !peerStat) {
+    return nullptr;
+  }
+  int64_t speed = peerStat->calculateDownloadSpeed();
+  if (speed == 0) {
+    return nullptr;
+  }
+  int64_t pieceLength = downloadContext_->getPieceLength();
+  size_t numPieces = downloadContext_->getNumPieces();
+  std::shared_ptr<SegmentEntry> slowest;
+  int64_t slowestSpeed = 0;
+  // The bytes left in the segment of the slowest connection.
+  int64_t slowestRemaining = 0;
+  // The number and the length of the missing pieces following the
+  // segment of the slowest connection.
+  size_t slowestNumTail = 0;
+  int64_t slowestTailLength = 0;
+  double slowestTime = 0;
+  for (auto& entry : usedSegmentEntries_) {
+    if (entry->cuid == cuid) {
+      continue;
+    }
+    auto ownerStat = getPeerStat(entry->cuid);
+    if (!ownerStat) {
+      continue;
+    }
+    int64_t ownerSpeed = ownerStat->calculateDownloadSpeed();
+    if (ownerSpeed == 0) {
+      continue;
+    }
+    const auto& segment = entry->segment;
+    int64_t remaining = segment->getLength() - segment->getWrittenLength();
+    size_t numTail = 0;
+    int64_t tailLength = 0;
+    for (size_t i = segment->getIndex() + 1;
+         i < numPieces && !ignoreBitfield_.isFilterBitSet(i) &&
+         !pieceStorage_->hasPiece(i) && !pieceStorage_->isPieceUsed(i);
+         ++i) {
+      ++numTail;
+      tailLength +=
+          std::min<int64_t>(pieceLength, totalLength - i * pieceLength);
+    }
+    double time = static_cast<double>(remaining + tailLength) / ownerSpeed;
+    if (time > slowestTime) {
+      slowest = entry;
+      slowestSpeed = ownerSpeed;
+      slowestRemaining = remaining;
+      slowestNumTail = numTail;
+      slowestTailLength = tailLength;
+      slowestTime = time;
+    }
+  }
+  if (!slowest) {
+    return nullptr;
+  }
+  size_t index = slowest->segment->getIndex();
+  if (slowestNumTail > 0) {
+    // Leave the owner the bytes it is expected to download in the time
+    // this connection downloads the rest.
+    double ownerShare = static_cast<double>(slowestRemaining +
+                                            slowestTailLength) *
+                        slowestSpeed / (slowestSpeed + speed);
+    size_t skip = 0;
+    if (ownerShare > slowestRemaining) {
+      skip = std::ceil((ownerShare - slowestRemaining) / pieceLength);
+    }
+    if (skip >= slowestNumTail) {
+      return nullptr;
+    }
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Split the missing pieces after"
+                    " segment#%lu of CUID#%" PRId64 " at piece#%lu. speed=%"
+                    PRId64 ", owner's speed=%" PRId64,
+                    cuid, static_cast<unsigned long>(index), slowest->cuid,
+                    static_cast<unsigned long>(index + 1 + skip), speed,
+                    slowestSpeed));
+    return getSegmentWithIndex(cuid, index + 1 + skip);
+  }
+  // The owner which pipelines several segments may be receiving the
+  // data for this segment, so it must have no other segment.
+  auto owner = slowest->cuid;
+  if (std::count_if(std::begin(usedSegmentEntries_),
+                    std::end(usedSegmentEntries_),
+                    [owner](const std::shared_ptr<SegmentEntry>& entry) {
+                      return entry->cuid == owner;
+                    }) != 1 ||
+      speed < slowestSpeed * TAKE_OVER_SPEED_RATIO ||
+      static_cast<double>(slowestRemaining) / slowestSpeed -
+              static_cast<double>(slowestRemaining) / speed <
+          TAKE_OVER_MIN_GAIN) {
+    return nullptr;
+  }
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " - Take over segment#%lu from CUID#%" PRId64
+                  ". speed=%" PRId64 ", owner's speed=%" PRId64,
+                  cuid, static_cast<unsigned long>(index), owner, speed,
+                  slowestSpeed));
+  // The owner notices that its segment is canceled and restarts.
+  // This connection resumes the segment from the written length.
+  cancelSegment(owner, slowest->segment);
+  return getSegmentWithIndex(cuid, index);
+}
+
+std::shared_ptr<Segment>
+SegmentMan::checkoutNextSegment(cuid_t cuid,
+                                const std::shared_ptr<Segment>& segment,
+                                const BitfieldMan& ignoreBitfield)
+{
+  size_t index = segment->getIndex() + 1;
+  if (downloadContext_->getNumPieces() <= index ||
+      ignoreBitfield.isFilterBitSet(index)) {
+    return nullptr;
+  }
+  return checkoutSegment(cuid, pieceStorage_->getMissingPiece(index, cuid));
+}
+
+std::shared_ptr<Segment>
+SegmentMan::getNextSegment(cuid_t cuid, const std::shared_ptr<Segment>& segment,
+                           size_t minSplitSize)
+{
+  auto next = checkoutNextSegment(cuid, segment, ignoreBitfield_);
+  if (next) {
+    return next;
+  }
+  return getSegment(cuid, minSplitSize);
+}
+
 void SegmentMan::getSegment(std::vector<std::shared_ptr<Segment>>& segments,
                             cuid_t cuid, size_t minSplitSize,
                             const std::shared_ptr<FileEntry>& fileEntry,
@@ -219,10 +361,16 @@ void SegmentMan::getSegment(std::vector<std::shared_ptr<Segment>>& segments,
   filter.addNotFilter(fileEntry->getOffset(), fileEntry->getLength());
   std::vector<std::shared_ptr<Segment>> pending;
   while (segments.size() < maxSegments) {
-    std::shared_ptr<Segment> segment = checkoutSegment(
-        cuid,
-        pieceStorage_->getMissingPiece(minSplitSize, filter.getFilterBitfield(),
-                                       filter.getBitfieldLength(), cuid));
+    std::shared_ptr<Segment> segment;
+    if (!segments.empty()) {
+      segment = checkoutNextSegment(cuid, segments.back(), filter);
+    }
+    if (!segment) {
+      segment = checkoutSegment(
+          cuid, pieceStorage_->getMissingPiece(
+                    minSplitSize, filter.getFilterBitfield(),
+                    filter.getBitfieldLength(), cuid));
+    }
     if (!segment) {
       break;
     }
@@ -404,6 +552,14 @@ int64_t SegmentMan::getDownloadLength() const
 
 void SegmentMan::registerPeerStat(const std::shared_ptr<PeerStat>& peerStat)
 {
+  if (peerStat->getCuid() != 0) {
+    for (auto& e : peerStats_) {
+      if (e->getCuid() == peerStat->getCuid()) {
+        e = peerStat;
+        return;
+      }
+    }
+  }
   peerStats_.push_back(peerStat);
 }
 
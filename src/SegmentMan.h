@@ -96,9 +96,27 @@ private:
   std::shared_ptr<Segment> checkoutSegment(cuid_t cuid,
                                            const std::shared_ptr<Piece>& piece);
 
+  // Checkouts the segment which follows |segment| if it is neither
+  // used, downloaded nor filtered by |ignoreBitfield|.  Otherwise
+  // returns null.
+  std::shared_ptr<Segment>
+  checkoutNextSegment(cuid_t cuid, const std::shared_ptr<Segment>& segment,
+                      const BitfieldMan& ignoreBitfield);
+
   void cancelSegmentInternal(cuid_t cuid,
                              const std::shared_ptr<Segment>& segment);
 
+  // End-game of HTTP/FTP download: finds the in-flight segment of
+  // another connection which is expected to finish last, judging by
+  // the download speed of its owner, and splits the work left to it.
+  // The connection cuid takes the tail of the missing pieces
+  // following that segment, so that both connections are expected to
+  // finish at the same time.  If no such piece is left and cuid is
+  // much faster than the owner, cuid takes over the segment itself.
+  // Returns null if cuid has no download speed yet or splitting does
+  // not pay.
+  std::shared_ptr<Segment> splitSlowestSegment(cuid_t cuid);
+
 public:
   SegmentMan(const std::shared_ptr<DownloadContext>& downloadContext,
              const std::shared_ptr<PieceStorage>& pieceStorage);
@@ -130,10 +148,21 @@ public:
   void getInFlightSegment(std::vector<std::shared_ptr<Segment>>& segments,
                           cuid_t cuid);
 
+  // Checkouts a missing segment.  If no segment is available for
+  // minSplitSize, splits the work of the slowest connection.  See
+  // splitSlowestSegment().
   std::shared_ptr<Segment> getSegment(cuid_t cuid, size_t minSplitSize);
 
+  // Returns the segment which follows |segment| if it is available,
+  // so that the requests pipelined in one connection read the file
+  // sequentially.  Otherwise, same as getSegment(cuid, minSplitSize).
+  std::shared_ptr<Segment>
+  getNextSegment(cuid_t cuid, const std::shared_ptr<Segment>& segment,
+                 size_t minSplitSize);
+
   // Checkouts segments in the range of fileEntry and push back to
-  // segments until segments.size() < maxSegments holds false
+  // segments until segments.size() < maxSegments holds false.  The
+  // segment following the last one in segments is preferred.
   void getSegment(std::vector<std::shared_ptr<Segment>>& segments, cuid_t cuid,
                   size_t minSplitSize,
                   const std::shared_ptr<FileEntry>& fileEntry,
@@ -195,9 +224,9 @@ public:
    */
   int64_t getDownloadLength() const;
 
-  // If there is inactive PeerStat in peerStats_, it is replaced with
-  // given peerStat. If no such PeerStat exist, the given peerStat is
-  // inserted.
+  // If there is PeerStat for the same non-zero CUID in peerStats_, it
+  // is replaced with given peerStat. If no such PeerStat exist, the
+  // given peerStat is inserted.
   void registerPeerStat(const std::shared_ptr<PeerStat>& peerStat);
 
   const std::vector<std::shared_ptr<PeerStat>>& getPeerStats() const
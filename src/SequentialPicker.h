@@ -38,31 +38,65 @@
 #include "common.h"
 
 #include <deque>
+#include <vector>
 #include <memory>
 #include <functional>
 
 namespace aria2 {
 
+// Picks the entries in the order they are pushed.  At most
+// maxPicked entries are picked at the same time.  The default value
+// of maxPicked is 1.
 template <typename T> class SequentialPicker {
 private:
   std::deque<std::unique_ptr<T>> entries_;
-  std::unique_ptr<T> pickedEntry_;
+  std::vector<std::unique_ptr<T>> pickedEntries_;
+  size_t maxPicked_;
 
 public:
-  bool isPicked() const { return pickedEntry_.get(); }
+  SequentialPicker() : maxPicked_(1) {}
 
-  const std::unique_ptr<T>& getPickedEntry() const { return pickedEntry_; }
+  void setMaxPicked(size_t maxPicked) { maxPicked_ = maxPicked; }
 
-  void dropPickedEntry() { pickedEntry_.reset(); }
+  size_t getMaxPicked() const { return maxPicked_; }
+
+  bool isPicked() const { return !pickedEntries_.empty(); }
+
+  // Returns the entry picked first among the picked entries.
+  const std::unique_ptr<T>& getPickedEntry() const
+  {
+    static const std::unique_ptr<T> nullEntry;
+    return pickedEntries_.empty() ? nullEntry : pickedEntries_.front();
+  }
+
+  size_t countPickedEntry() const { return pickedEntries_.size(); }
+
+  void dropPickedEntry(const T* entry)
+  {
+    for (auto i = std::begin(pickedEntries_), eoi = std::end(pickedEntries_);
+         i != eoi; ++i) {
+      if ((*i).get() == entry) {
+        pickedEntries_.erase(i);
+        return;
+      }
+    }
+  }
 
   bool hasNext() const { return !entries_.empty(); }
 
+  // Returns true if there is a queued entry and fewer than maxPicked
+  // entries are picked.
+  bool canPickNext() const
+  {
+    return hasNext() && pickedEntries_.size() < maxPicked_;
+  }
+
   T* pickNext()
   {
     if (hasNext()) {
-      pickedEntry_ = std::move(entries_.front());
+      pickedEntries_.push_back(std::move(entries_.front()));
       entries_.pop_front();
-      return pickedEntry_.get();
+      return pickedEntries_.back().get();
     }
     return nullptr;
   }
@@ -76,7 +110,18 @@ public:
 
   bool isPicked(const std::function<bool(const T&)>& pred) const
   {
-    return pickedEntry_ && pred(*pickedEntry_);
+    return findPickedEntry(pred);
+  }
+
+  // Returns the picked entry which satisfies pred, or nullptr.
+  T* findPickedEntry(const std::function<bool(const T&)>& pred) const
+  {
+    for (auto& e : pickedEntries_) {
+      if (pred(*e)) {
+        return e.get();
+      }
+    }
+    return nullptr;
   }
 
   bool isQueued(const std::function<bool(const T&)>& pred) const
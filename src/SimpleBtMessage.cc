@@ -56,6 +56,15 @@ void SimpleBtMessage::send()
   A2_LOG_INFO(fmt(MSG_SEND_PEER_MESSAGE, getCuid(),
                   getPeer()->getIPAddress().c_str(), getPeer()->getPort(),
                   toString().c_str()));
+  auto length = getMessageLength();
+  if (length > 0) {
+    auto buf = getPeerConnection()->allocateBuffer(length);
+    writeMessage(buf.data());
+    A2_LOG_DEBUG(
+        fmt("msglength = %lu bytes", static_cast<unsigned long>(length)));
+    getPeerConnection()->pushBytes(std::move(buf), getProgressUpdate());
+    return;
+  }
   auto msg = createMessage();
   A2_LOG_DEBUG(
       fmt("msglength = %lu bytes", static_cast<unsigned long>(msg.size())));
@@ -51,6 +51,17 @@ public:
 
   virtual std::vector<unsigned char> createMessage() = 0;
 
+  // Returns the length of the message in wire format if it is known
+  // in advance, otherwise 0.  If nonzero is returned, send() writes
+  // the message using writeMessage() into the buffer allocated by
+  // PeerConnection, instead of calling createMessage().
+  virtual size_t getMessageLength() const { return 0; }
+
+  // Writes the message in wire format to data, which has
+  // getMessageLength() bytes.  The default implementation does
+  // nothing.
+  virtual void writeMessage(unsigned char* data) const {}
+
   virtual std::unique_ptr<ProgressUpdate> getProgressUpdate();
 
   virtual bool sendPredicate() const { return true; };
@@ -94,6 +94,11 @@ void SingleFileAllocationIterator::allocateChunk()
     stream_->truncate(totalLength_);
     offset_ = totalLength_;
   }
+  if (finished()) {
+    // The zero-filled chunks must reach the file before the
+    // downloaded data are written to the same range.
+    stream_->flush();
+  }
 }
 
 bool SingleFileAllocationIterator::finished()
@@ -71,19 +71,14 @@ ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
     if (piece->getWrDiskCacheEntry()) {
       assert(wrDiskCache_);
       // If we receive small data (e.g., 1 or 2 bytes), cache entry
-      // becomes a headache. To mitigate this problem, we allocate
-      // cache buffer at least 4KiB and append the data to the
-      // contagious cache data.
-      size_t alen = piece->appendWrCache(
-          wrDiskCache_, segment->getPositionToWrite(), inbuf, wlen);
-      if (alen < wlen) {
-        size_t len = wlen - alen;
-        size_t capacity = std::max(len, static_cast<size_t>(4_k));
-        auto dataCopy = new unsigned char[capacity];
-        memcpy(dataCopy, inbuf + alen, len);
-        piece->updateWrCache(wrDiskCache_, dataCopy, 0, len, capacity,
-                             segment->getPositionToWrite() + alen);
-      }
+      // becomes a headache. To mitigate this problem, the data is
+      // copied to the cache buffer sized for the rest of the segment,
+      // and the following data is appended to it.
+      size_t reserve = segment->getLength() > 0
+                           ? segment->getLength() - segment->getWrittenLength()
+                           : WrDiskCache::BUFFER_SIZE;
+      piece->copyWrCache(wrDiskCache_, segment->getPositionToWrite(), inbuf,
+                         wlen, reserve);
     }
     else {
       out->writeData(inbuf, wlen, segment->getPositionToWrite());
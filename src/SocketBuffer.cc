@@ -36,8 +36,10 @@
 
 #include <cassert>
 #include <algorithm>
+#include <array>
 
 #include "SocketCore.h"
+#include "DiskAdaptor.h"
 #include "DlAbortEx.h"
 #include "message.h"
 #include "fmt.h"
@@ -102,6 +104,77 @@ const unsigned char* SocketBuffer::StringBufEntry::getData() const
   return reinterpret_cast<const unsigned char*>(str_.c_str());
 }
 
+SocketBuffer::SliceBufEntry::SliceBufEntry(
+    BufferSlice slice, std::unique_ptr<ProgressUpdate> progressUpdate)
+    : BufEntry(std::move(progressUpdate)), slice_(std::move(slice))
+{
+}
+
+ssize_t
+SocketBuffer::SliceBufEntry::send(const std::shared_ptr<SocketCore>& socket,
+                                  size_t offset)
+{
+  return socket->writeData(slice_.data() + offset, slice_.size() - offset);
+}
+
+bool SocketBuffer::SliceBufEntry::final(size_t offset) const
+{
+  return slice_.size() <= offset;
+}
+
+size_t SocketBuffer::SliceBufEntry::getLength() const { return slice_.size(); }
+
+const unsigned char* SocketBuffer::SliceBufEntry::getData() const
+{
+  return slice_.data();
+}
+
+SocketBuffer::DiskDataBufEntry::DiskDataBufEntry(
+    std::shared_ptr<DiskAdaptor> diskAdaptor, int64_t offset, size_t length,
+    std::unique_ptr<ProgressUpdate> progressUpdate)
+    : BufEntry(std::move(progressUpdate)),
+      diskAdaptor_(std::move(diskAdaptor)),
+      offset_(offset),
+      length_(length)
+{
+}
+
+SocketBuffer::DiskDataBufEntry::~DiskDataBufEntry() = default;
+
+ssize_t
+SocketBuffer::DiskDataBufEntry::send(const std::shared_ptr<SocketCore>& socket,
+                                     size_t offset)
+{
+  size_t len = length_ - offset;
+  ssize_t rv = diskAdaptor_->sendFile(*socket, len, offset_ + offset);
+  if (rv == -1) {
+    std::array<unsigned char, 16_k> buf;
+    len = std::min(len, buf.size());
+    if (diskAdaptor_->readData(buf.data(), len, offset_ + offset) !=
+        static_cast<ssize_t>(len)) {
+      throw DL_ABORT_EX(EX_DATA_READ);
+    }
+    return socket->writeData(buf.data(), len);
+  }
+  if (rv == 0 && !socket->wantWrite()) {
+    // The file is shorter than expected.
+    throw DL_ABORT_EX(EX_DATA_READ);
+  }
+  return rv;
+}
+
+bool SocketBuffer::DiskDataBufEntry::final(size_t offset) const
+{
+  return length_ <= offset;
+}
+
+size_t SocketBuffer::DiskDataBufEntry::getLength() const { return length_; }
+
+const unsigned char* SocketBuffer::DiskDataBufEntry::getData() const
+{
+  return nullptr;
+}
+
 SocketBuffer::SocketBuffer(std::shared_ptr<SocketCore> socket)
     : socket_(std::move(socket)), offset_(0)
 {
@@ -127,36 +200,63 @@ void SocketBuffer::pushStr(std::string data,
   }
 }
 
+void SocketBuffer::pushSlice(BufferSlice slice,
+                             std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  if (!slice.empty()) {
+    bufq_.push_back(make_unique<SliceBufEntry>(std::move(slice),
+                                               std::move(progressUpdate)));
+  }
+}
+
+void SocketBuffer::pushDiskData(std::shared_ptr<DiskAdaptor> diskAdaptor,
+                                int64_t offset, size_t length,
+                                std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  if (length > 0) {
+    bufq_.push_back(make_unique<DiskDataBufEntry>(
+        std::move(diskAdaptor), offset, length, std::move(progressUpdate)));
+  }
+}
+
 ssize_t SocketBuffer::send()
 {
   a2iovec iov[A2_IOV_MAX];
   size_t totalslen = 0;
   while (!bufq_.empty()) {
     size_t num;
-    size_t bufqlen = bufq_.size();
-    ssize_t amount = 24_k;
+    ssize_t slen;
     ssize_t firstlen = bufq_.front()->getLength() - offset_;
-    amount -= firstlen;
-    iov[0].A2IOVEC_BASE = reinterpret_cast<char*>(
-        const_cast<unsigned char*>(bufq_.front()->getData() + offset_));
-    iov[0].A2IOVEC_LEN = firstlen;
-    num = 1;
-    for (auto i = std::begin(bufq_) + 1, eoi = std::end(bufq_);
-         i != eoi && num < A2_IOV_MAX && num < bufqlen && amount > 0;
-         ++i, ++num) {
-
-      ssize_t len = (*i)->getLength();
-
-      if (amount < len) {
-        break;
-      }
+    if (!bufq_.front()->getData()) {
+      // The data are not in memory.  Let the entry send them.
+      num = 1;
+      slen = bufq_.front()->send(socket_, offset_);
+    }
+    else {
+      size_t bufqlen = bufq_.size();
+      ssize_t amount = 24_k;
+      amount -= firstlen;
+      iov[0].A2IOVEC_BASE = reinterpret_cast<char*>(
+          const_cast<unsigned char*>(bufq_.front()->getData() + offset_));
+      iov[0].A2IOVEC_LEN = firstlen;
+      num = 1;
+      for (auto i = std::begin(bufq_) + 1, eoi = std::end(bufq_);
+           i != eoi && num < A2_IOV_MAX && num < bufqlen && amount > 0;
+           ++i, ++num) {
+
+        ssize_t len = (*i)->getLength();
 
-      amount -= len;
-      iov[num].A2IOVEC_BASE =
-          reinterpret_cast<char*>(const_cast<unsigned char*>((*i)->getData()));
-      iov[num].A2IOVEC_LEN = len;
+        if (amount < len || !(*i)->getData()) {
+          break;
+        }
+
+        amount -= len;
+        iov[num].A2IOVEC_BASE = reinterpret_cast<char*>(
+            const_cast<unsigned char*>((*i)->getData()));
+        iov[num].A2IOVEC_LEN = len;
+      }
+      slen = socket_->writeVector(iov, num);
     }
-    ssize_t slen = socket_->writeVector(iov, num);
     if (slen == 0 && !socket_->wantRead() && !socket_->wantWrite()) {
       throw DL_ABORT_EX(fmt(EX_SOCKET_SEND, "Connection closed."));
     }
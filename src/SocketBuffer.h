@@ -42,9 +42,12 @@
 #include <memory>
 #include <vector>
 
+#include "BufferPool.h"
+
 namespace aria2 {
 
 class SocketCore;
+class DiskAdaptor;
 
 struct ProgressUpdate {
   virtual ~ProgressUpdate() = default;
@@ -64,6 +67,8 @@ private:
                          size_t offset) = 0;
     virtual bool final(size_t offset) const = 0;
     virtual size_t getLength() const = 0;
+    // Returns the pointer to the data, or nullptr if the data are not
+    // in memory.  In the latter case, send() is used to send them.
     virtual const unsigned char* getData() const = 0;
     void progressUpdate(size_t length, bool complete)
     {
@@ -105,6 +110,41 @@ private:
     std::string str_;
   };
 
+  class SliceBufEntry : public BufEntry {
+  public:
+    SliceBufEntry(BufferSlice slice,
+                  std::unique_ptr<ProgressUpdate> progressUpdate);
+    virtual ssize_t send(const std::shared_ptr<SocketCore>& socket,
+                         size_t offset) CXX11_OVERRIDE;
+    virtual bool final(size_t offset) const CXX11_OVERRIDE;
+    virtual size_t getLength() const CXX11_OVERRIDE;
+    virtual const unsigned char* getData() const CXX11_OVERRIDE;
+
+  private:
+    BufferSlice slice_;
+  };
+
+  // Data in file, which are sent by DiskAdaptor::sendFile() if
+  // possible.  Otherwise, they are read into a temporary buffer and
+  // sent.
+  class DiskDataBufEntry : public BufEntry {
+  public:
+    DiskDataBufEntry(std::shared_ptr<DiskAdaptor> diskAdaptor, int64_t offset,
+                     size_t length,
+                     std::unique_ptr<ProgressUpdate> progressUpdate);
+    virtual ~DiskDataBufEntry();
+    virtual ssize_t send(const std::shared_ptr<SocketCore>& socket,
+                         size_t offset) CXX11_OVERRIDE;
+    virtual bool final(size_t offset) const CXX11_OVERRIDE;
+    virtual size_t getLength() const CXX11_OVERRIDE;
+    virtual const unsigned char* getData() const CXX11_OVERRIDE;
+
+  private:
+    std::shared_ptr<DiskAdaptor> diskAdaptor_;
+    int64_t offset_;
+    size_t length_;
+  };
+
   std::shared_ptr<SocketCore> socket_;
 
   std::deque<std::unique_ptr<BufEntry>> bufq_;
@@ -137,6 +177,24 @@ public:
   void pushStr(std::string data,
                std::unique_ptr<ProgressUpdate> progressUpdate = nullptr);
 
+  // Feeds data referred by slice into queue. This function doesn't
+  // send data.  The data must not be altered until they are sent.  If
+  // progressUpdate is not null, its update() function will be called
+  // each time the data is sent. It will be deleted by this object. It
+  // can be null.
+  void pushSlice(BufferSlice slice,
+                 std::unique_ptr<ProgressUpdate> progressUpdate = nullptr);
+
+  // Feeds length bytes of data at offset in diskAdaptor into
+  // queue. This function doesn't send data.  The data are read when
+  // they are sent, so they must not be changed until then.  If
+  // progressUpdate is not null, its update() function will be called
+  // each time the data is sent. It will be deleted by this object. It
+  // can be null.
+  void pushDiskData(std::shared_ptr<DiskAdaptor> diskAdaptor, int64_t offset,
+                    size_t length,
+                    std::unique_ptr<ProgressUpdate> progressUpdate = nullptr);
+
   // Sends data in queue.  Returns the number of bytes sent.
   ssize_t send();
 
@@ -39,6 +39,9 @@
 #endif // HAVE_IPHLPAPI_H
 
 #include <unistd.h>
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif // HAVE_SENDFILE
 #ifdef HAVE_IFADDRS_H
 #include <ifaddrs.h>
 #endif // HAVE_IFADDRS_H
@@ -146,6 +149,11 @@ void SocketCore::setClientTLSContext(
   clTlsContext_ = tlsContext;
 }
 
+const std::shared_ptr<TLSContext>& SocketCore::getClientTLSContext()
+{
+  return clTlsContext_;
+}
+
 void SocketCore::setServerTLSContext(
     const std::shared_ptr<TLSContext>& tlsContext)
 {
@@ -796,6 +804,35 @@ ssize_t SocketCore::writeVector(a2iovec* iov, size_t iovcnt)
   return ret;
 }
 
+#ifdef HAVE_SENDFILE
+ssize_t SocketCore::sendFile(int fd, int64_t offset, size_t len)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+  if (secure_) {
+    return -1;
+  }
+  off_t off = offset;
+  ssize_t ret;
+  while ((ret = sendfile(sockfd_, fd, &off, len)) == -1 && errno == EINTR)
+    ;
+  if (ret == -1) {
+    int errNum = errno;
+    if (A2_WOULDBLOCK(errNum)) {
+      wantWrite_ = true;
+      return 0;
+    }
+    if (errNum == EINVAL || errNum == ENOSYS) {
+      // The file does not support mmap-like operation, or sendfile
+      // is not implemented.
+      return -1;
+    }
+    throw DL_RETRY_EX(fmt(EX_SOCKET_SEND, errorMsg(errNum).c_str()));
+  }
+  return ret;
+}
+#endif // HAVE_SENDFILE
+
 ssize_t SocketCore::writeData(const void* data, size_t len)
 {
   ssize_t ret = 0;
@@ -941,6 +978,16 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
                               tlsSession_->getLastErrorString().c_str()));
       }
     }
+    if (tlsctx->getSide() == TLS_CLIENT) {
+      // Resume the session previously negotiated with the same host,
+      // which saves the full handshake for the subsequent
+      // connections.
+      auto peerEndpoint = getPeerInfo();
+      tlsSession_->setSessionCacheKey(
+          fmt("%s:%u", hostname.empty() ? peerEndpoint.addr.c_str()
+                                        : hostname.c_str(),
+              peerEndpoint.port));
+    }
     // Done with the setup, now let handshaking begin immediately.
     secure_ = A2_TLS_HANDSHAKING;
     A2_LOG_DEBUG("TLS Handshaking");
@@ -987,7 +1034,16 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
         break;
       }
 
-      // 3. We're connected now!
+      // 3. Record the handshake
+      if (tlsctx->getSide() == TLS_CLIENT) {
+        auto resumed = tlsSession_->isSessionResumed();
+        tlsctx->getSessionCache().countHandshake(resumed);
+        if (resumed) {
+          A2_LOG_DEBUG(fmt("Resumed TLS session with %s", peerInfo.c_str()));
+        }
+      }
+
+      // 4. We're connected now!
       secure_ = A2_TLS_CONNECTED;
       return true;
     }
@@ -1267,6 +1323,16 @@ bool SocketCore::wantRead() const { return wantRead_; }
 
 bool SocketCore::wantWrite() const { return wantWrite_; }
 
+bool SocketCore::isSecure() const
+{
+#ifdef HAVE_LIBSSH2
+  if (sshSession_) {
+    return true;
+  }
+#endif // HAVE_LIBSSH2
+  return secure_ != A2_TLS_NONE;
+}
+
 void SocketCore::bindAddress(const std::string& iface)
 {
   auto bindAddrs = getInterfaceAddress(iface, protocolFamily_);
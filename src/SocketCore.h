@@ -264,6 +264,16 @@ public:
 
   ssize_t writeVector(a2iovec* iov, size_t iovcnt);
 
+#ifdef HAVE_SENDFILE
+  // Sends up to len bytes of file fd starting at offset using
+  // sendfile(2), without copying the data to user space.  Returns the
+  // number of bytes sent.  If the underlying socket gets EAGAIN,
+  // wantWrite_ is set and 0 is returned.  Returns -1 if sendfile
+  // cannot be used for this socket or file, which is the case for
+  // TLS socket, so that the caller can fall back to writeData().
+  ssize_t sendFile(int fd, int64_t offset, size_t len);
+#endif // HAVE_SENDFILE
+
   /**
    * Reads up to len bytes from this socket.
    * data is a pointer pointing the first
@@ -337,6 +347,13 @@ public:
    */
   bool wantWrite() const;
 
+  /**
+   * Returns true if data are read through TLS or SSH session.  Such a
+   * session may return less data than requested even if the
+   * underlying socket has more.
+   */
+  bool isSecure() const;
+
   // Returns buffered data which are already received.  This data was
   // already read from socket, and ready to read without reading
   // socket.
@@ -345,6 +362,7 @@ public:
 #ifdef ENABLE_SSL
   static void
   setClientTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
+  static const std::shared_ptr<TLSContext>& getClientTLSContext();
   static void
   setServerTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
 #endif // ENABLE_SSL
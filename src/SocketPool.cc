@@ -0,0 +1,253 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SocketPool.h"
+
+#include <cassert>
+#include <algorithm>
+#include <functional>
+
+#include "SocketCore.h"
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "util.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+const size_t SocketPool::DEFAULT_MAX_SOCKETS;
+const size_t SocketPool::DEFAULT_MAX_SOCKETS_PER_HOST;
+
+namespace {
+void hashCombine(size_t& seed, size_t v)
+{
+  seed ^= v + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+} // namespace
+
+SocketPoolKey::SocketPoolKey(std::string host, uint16_t port,
+                             std::string username, std::string proxyhost,
+                             uint16_t proxyport, bool tls)
+    : host_(std::move(host)),
+      username_(std::move(username)),
+      proxyhost_(std::move(proxyhost)),
+      port_(port),
+      proxyport_(proxyport),
+      tls_(tls),
+      hash_(std::hash<std::string>()(host_))
+{
+  std::hash<std::string> strHash;
+  hashCombine(hash_, port_);
+  hashCombine(hash_, strHash(username_));
+  hashCombine(hash_, strHash(proxyhost_));
+  hashCombine(hash_, proxyport_);
+  hashCombine(hash_, tls_);
+}
+
+bool SocketPoolKey::operator==(const SocketPoolKey& other) const
+{
+  return hash_ == other.hash_ && port_ == other.port_ &&
+         proxyport_ == other.proxyport_ && tls_ == other.tls_ &&
+         host_ == other.host_ && username_ == other.username_ &&
+         proxyhost_ == other.proxyhost_;
+}
+
+std::string SocketPoolKey::toString() const
+{
+  std::string s;
+  if (!username_.empty()) {
+    s += util::percentEncode(username_);
+    s += "@";
+  }
+  s += fmt("%s(%u)", host_.c_str(), port_);
+  if (!proxyhost_.empty()) {
+    s += fmt("/%s(%u)", proxyhost_.c_str(), proxyport_);
+  }
+  if (tls_) {
+    s += " TLS";
+  }
+  return s;
+}
+
+bool SocketPool::Entry::isTimeout() const
+{
+  return registeredTime.difference(global::wallclock()) >= timeout;
+}
+
+bool SocketPool::Entry::isReusable() const
+{
+  if (isTimeout()) {
+    return false;
+  }
+  try {
+    // We assume that if socket is readable it means peer shutdowns
+    // connection and the socket will receive EOF.
+    return !socket->isReadable(0);
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX("Checking pooled socket failed.", e);
+    return false;
+  }
+}
+
+SocketPool::SocketPool(size_t maxSockets, size_t maxSocketsPerHost)
+    : maxSockets_(std::max(maxSockets, static_cast<size_t>(1))),
+      maxSocketsPerHost_(std::max(maxSocketsPerHost, static_cast<size_t>(1))),
+      numHits_(0),
+      numMisses_(0),
+      numEvicted_(0)
+{
+}
+
+SocketPool::~SocketPool() = default;
+
+void SocketPool::put(const SocketPoolKey& key,
+                     const std::shared_ptr<SocketCore>& socket,
+                     const std::string& options, std::chrono::seconds timeout)
+{
+  A2_LOG_INFO(fmt("Pool socket for %s", key.toString().c_str()));
+  auto i = index_.find(key);
+  if (i == std::end(index_)) {
+    i = index_.insert(std::make_pair(key, std::deque<EntryList::iterator>()))
+            .first;
+  }
+  auto& sockets = (*i).second;
+  entries_.push_back(Entry{&(*i).first, socket, options, std::move(timeout),
+                           global::wallclock()});
+  sockets.push_back(std::prev(std::end(entries_)));
+  if (sockets.size() > maxSocketsPerHost_) {
+    A2_LOG_DEBUG(fmt("Too many pooled sockets for %s. Closing the oldest one.",
+                     key.toString().c_str()));
+    erase(sockets.front());
+    ++numEvicted_;
+  }
+  if (entries_.size() > maxSockets_) {
+    A2_LOG_DEBUG(fmt("Too many pooled sockets. Closing the one for %s.",
+                     entries_.front().key->toString().c_str()));
+    erase(std::begin(entries_));
+    ++numEvicted_;
+  }
+}
+
+std::shared_ptr<SocketCore> SocketPool::take(std::string& options,
+                                             const SocketPoolKey& key)
+{
+  for (;;) {
+    auto i = index_.find(key);
+    if (i == std::end(index_)) {
+      return nullptr;
+    }
+    auto j = (*i).second.back();
+    auto& entry = *j;
+    if (entry.isReusable()) {
+      A2_LOG_INFO(fmt("Found socket for %s", key.toString().c_str()));
+      auto socket = entry.socket;
+      options = entry.options;
+      erase(j);
+      return socket;
+    }
+    A2_LOG_DEBUG(fmt("Dropped stale socket for %s", key.toString().c_str()));
+    erase(j);
+    ++numEvicted_;
+  }
+}
+
+std::shared_ptr<SocketCore> SocketPool::pop(std::string& options,
+                                            const SocketPoolKey& key)
+{
+  auto socket = take(options, key);
+  if (socket) {
+    ++numHits_;
+  }
+  else {
+    ++numMisses_;
+  }
+  return socket;
+}
+
+std::shared_ptr<SocketCore>
+SocketPool::pop(std::string& options, const std::vector<SocketPoolKey>& keys)
+{
+  std::shared_ptr<SocketCore> socket;
+  for (const auto& key : keys) {
+    socket = take(options, key);
+    if (socket) {
+      break;
+    }
+  }
+  if (socket) {
+    ++numHits_;
+  }
+  else {
+    ++numMisses_;
+  }
+  return socket;
+}
+
+void SocketPool::evict()
+{
+  if (entries_.empty()) {
+    return;
+  }
+  A2_LOG_DEBUG("Scanning SocketPool and erasing stale entry.");
+  size_t numRemoved = 0;
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    if ((*i).isReusable()) {
+      ++i;
+    }
+    else {
+      erase(i++);
+      ++numRemoved;
+    }
+  }
+  numEvicted_ += numRemoved;
+  A2_LOG_DEBUG(
+      fmt("%lu entries removed.", static_cast<unsigned long>(numRemoved)));
+}
+
+void SocketPool::erase(EntryList::iterator i)
+{
+  auto j = index_.find(*(*i).key);
+  assert(j != std::end(index_));
+  auto& sockets = (*j).second;
+  sockets.erase(std::find(std::begin(sockets), std::end(sockets), i));
+  entries_.erase(i);
+  if (sockets.empty()) {
+    index_.erase(j);
+  }
+}
+
+} // namespace aria2
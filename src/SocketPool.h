@@ -0,0 +1,175 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SOCKET_POOL_H
+#define D_SOCKET_POOL_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+#include <list>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+// Key of SocketPool: the tuple of the host, port, user name, proxy
+// and whether the connection is secured by TLS.  The hash of the tuple
+// is computed once on construction.
+class SocketPoolKey {
+public:
+  SocketPoolKey(std::string host, uint16_t port, std::string username,
+                std::string proxyhost, uint16_t proxyport, bool tls);
+
+  bool operator==(const SocketPoolKey& other) const;
+
+  size_t hash() const { return hash_; }
+
+  // Returns the string representation of this key for logging.
+  std::string toString() const;
+
+private:
+  std::string host_;
+  std::string username_;
+  std::string proxyhost_;
+  uint16_t port_;
+  uint16_t proxyport_;
+  bool tls_;
+  size_t hash_;
+};
+
+struct SocketPoolKeyHash {
+  size_t operator()(const SocketPoolKey& key) const { return key.hash(); }
+};
+
+// Pool of the idle connections which may be reused for subsequent
+// requests to the same server.  At most maxSocketsPerHost sockets are
+// kept for each key and maxSockets in total.  When the limit is
+// exceeded, the least recently pooled socket is closed.
+class SocketPool {
+public:
+  SocketPool(size_t maxSockets = DEFAULT_MAX_SOCKETS,
+             size_t maxSocketsPerHost = DEFAULT_MAX_SOCKETS_PER_HOST);
+
+  ~SocketPool();
+
+  // Don't allow copying
+  SocketPool(const SocketPool&) = delete;
+  SocketPool& operator=(const SocketPool&) = delete;
+
+  // Pools socket under key.  The socket is closed when it is not
+  // reused within timeout.  options is the protocol specific option
+  // string, which is returned by pop() with the socket.
+  void put(const SocketPoolKey& key, const std::shared_ptr<SocketCore>& socket,
+           const std::string& options, std::chrono::seconds timeout);
+
+  // Removes the most recently pooled socket for key from the pool and
+  // returns it, storing its option string in options.  The sockets
+  // which are timed out or closed by the peer are dropped on the way.
+  // Returns nullptr if no socket can be reused.
+  std::shared_ptr<SocketCore> pop(std::string& options,
+                                  const SocketPoolKey& key);
+
+  // Same as above, but tries keys in order.  The lookup counts as one
+  // hit or miss.
+  std::shared_ptr<SocketCore> pop(std::string& options,
+                                  const std::vector<SocketPoolKey>& keys);
+
+  // Drops the sockets which are timed out or readable.  The idle
+  // connection becomes readable when the peer closes it, and such
+  // connection must not be reused.
+  void evict();
+
+  // Returns the number of pooled sockets.
+  size_t size() const { return entries_.size(); }
+
+  bool empty() const { return entries_.empty(); }
+
+  // Returns the number of pop() calls which returned a socket.
+  uint64_t getNumHits() const { return numHits_; }
+
+  // Returns the number of pop() calls which returned nullptr.
+  uint64_t getNumMisses() const { return numMisses_; }
+
+  // Returns the number of sockets dropped without being reused.
+  uint64_t getNumEvicted() const { return numEvicted_; }
+
+  static const size_t DEFAULT_MAX_SOCKETS = 128;
+  static const size_t DEFAULT_MAX_SOCKETS_PER_HOST = 16;
+
+private:
+  struct Entry {
+    // Points to the key in index_.
+    const SocketPoolKey* key;
+    std::shared_ptr<SocketCore> socket;
+    std::string options;
+    std::chrono::seconds timeout;
+    Timer registeredTime;
+
+    bool isTimeout() const;
+
+    // Returns true if the socket can be reused.
+    bool isReusable() const;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  std::shared_ptr<SocketCore> take(std::string& options,
+                                   const SocketPoolKey& key);
+
+  void erase(EntryList::iterator i);
+
+  // Pooled sockets, the least recently pooled first.
+  EntryList entries_;
+  // Pooled sockets for each key, the least recently pooled first.
+  std::unordered_map<SocketPoolKey, std::deque<EntryList::iterator>,
+                     SocketPoolKeyHash>
+      index_;
+  size_t maxSockets_;
+  size_t maxSocketsPerHost_;
+  uint64_t numHits_;
+  uint64_t numMisses_;
+  uint64_t numEvicted_;
+};
+
+} // namespace aria2
+
+#endif // D_SOCKET_POOL_H
@@ -35,30 +35,114 @@
 #include "SocketRecvBuffer.h"
 
 #include <cstring>
+#include <algorithm>
 #include <cassert>
 
 #include "SocketCore.h"
 #include "LogFactory.h"
+#include "fmt.h"
+#include "RecoverableException.h"
 
 namespace aria2 {
 
+constexpr size_t SocketRecvBuffer::MIN_CAPACITY;
+constexpr size_t SocketRecvBuffer::MAX_CAPACITY;
+constexpr int SocketRecvBuffer::SHRINK_THRESHOLD;
+
 SocketRecvBuffer::SocketRecvBuffer(std::shared_ptr<SocketCore> socket)
-    : socket_(std::move(socket)), pos_(buf_.data()), last_(pos_)
+    : buf_(make_unique<unsigned char[]>(MIN_CAPACITY)),
+      capacity_(MIN_CAPACITY),
+      nextCapacity_(MIN_CAPACITY),
+      numSmallReads_(0),
+      socket_(std::move(socket)),
+      pos_(buf_.get()),
+      last_(pos_)
 {
 }
 
 SocketRecvBuffer::~SocketRecvBuffer() = default;
 
-ssize_t SocketRecvBuffer::recv()
+ssize_t SocketRecvBuffer::recv() { return recv(MAX_CAPACITY); }
+
+ssize_t SocketRecvBuffer::recv(size_t maxLength)
 {
-  size_t n = std::end(buf_) - last_;
-  if (n == 0) {
+  if (error_) {
+    // The error hit after the data returned by the last call.
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  if (bufferEmpty()) {
+    resize();
+  }
+  auto end = buf_.get() + capacity_;
+  maxLength = std::min(static_cast<size_t>(end - last_), maxLength);
+  if (maxLength == 0) {
     A2_LOG_DEBUG("Buffer full");
     return 0;
   }
-  socket_->readData(last_, n);
-  last_ += n;
-  return n;
+  size_t nread = 0;
+  while (nread < maxLength) {
+    size_t len = maxLength - nread;
+    size_t n = len;
+    try {
+      socket_->readData(last_, n);
+    }
+    catch (RecoverableException& e) {
+      if (nread == 0) {
+        throw;
+      }
+      // Return the data read so far, and report the error by the
+      // next recv().  The socket may not report it again: a consumed
+      // connection reset would look like EOF.
+      A2_LOG_DEBUG_EX("Stopped reading on error", e);
+      error_ = std::current_exception();
+      break;
+    }
+    last_ += n;
+    nread += n;
+    // A short read from a plain socket means that the kernel buffer
+    // was drained.  TLS and SSH sessions return one record at a time,
+    // so keep reading until they have no more data.
+    if (n == 0 || (n < len && !socket_->isSecure())) {
+      break;
+    }
+  }
+  if (nread > 0) {
+    adjustCapacity(nread);
+  }
+  return nread;
+}
+
+void SocketRecvBuffer::adjustCapacity(size_t nread)
+{
+  if (last_ == buf_.get() + capacity_) {
+    numSmallReads_ = 0;
+    nextCapacity_ = std::min(capacity_ * 2, MAX_CAPACITY);
+  }
+  else if (nread < capacity_ / 4) {
+    if (++numSmallReads_ >= SHRINK_THRESHOLD) {
+      numSmallReads_ = 0;
+      nextCapacity_ = std::max(capacity_ / 2, MIN_CAPACITY);
+    }
+  }
+  else {
+    numSmallReads_ = 0;
+  }
+}
+
+void SocketRecvBuffer::resize()
+{
+  assert(bufferEmpty());
+  if (nextCapacity_ == capacity_) {
+    return;
+  }
+  A2_LOG_DEBUG(fmt("Resize receive buffer %lu -> %lu",
+                   static_cast<unsigned long>(capacity_),
+                   static_cast<unsigned long>(nextCapacity_)));
+  capacity_ = nextCapacity_;
+  buf_ = make_unique<unsigned char[]>(capacity_);
+  pos_ = last_ = buf_.get();
 }
 
 void SocketRecvBuffer::drain(size_t n)
@@ -70,6 +154,10 @@ void SocketRecvBuffer::drain(size_t n)
   }
 }
 
-void SocketRecvBuffer::truncateBuffer() { pos_ = last_ = buf_.data(); }
+void SocketRecvBuffer::truncateBuffer()
+{
+  pos_ = last_ = buf_.get();
+  resize();
+}
 
 } // namespace aria2
@@ -38,7 +38,7 @@
 #include "common.h"
 
 #include <memory>
-#include <array>
+#include <exception>
 
 #include "a2functional.h"
 
@@ -46,6 +46,12 @@ namespace aria2 {
 
 class SocketCore;
 
+// Buffers the data received from a socket.  The capacity of the
+// buffer adapts to the connection: it starts small, so that idle and
+// control connections hold little memory, doubles each time a recv()
+// fills the whole buffer, and halves after a run of recv() calls
+// which used less than a quarter of it.  The capacity only changes
+// while the buffer is empty, so buffered data is never moved.
 class SocketRecvBuffer {
 public:
   SocketRecvBuffer(std::shared_ptr<SocketCore> socket);
@@ -53,6 +59,12 @@ public:
   // Reads data from socket as much as capacity allows. Returns the
   // number of bytes read.
   ssize_t recv();
+  // Same as recv(), but reads at most maxLength bytes.  The socket is
+  // read repeatedly until it has no more data, maxLength bytes are
+  // read or the buffer is full.  If reading fails after some data
+  // were read, the data are returned and the exception is thrown by
+  // the next call.
+  ssize_t recv(size_t maxLength);
   // Truncates the contents of buffer to 0.
   void truncateBuffer();
   // Drains first n bytes of data from buffer.  It is an programmer's
@@ -68,11 +80,31 @@ public:
 
   bool bufferEmpty() const { return pos_ == last_; }
 
+  size_t getCapacity() const { return capacity_; }
+
+  static constexpr size_t MIN_CAPACITY = 4_k;
+  static constexpr size_t MAX_CAPACITY = 256_k;
+  // The number of consecutive recv() calls reading less than a
+  // quarter of the capacity after which the capacity is halved.
+  static constexpr int SHRINK_THRESHOLD = 16;
+
 private:
-  std::array<unsigned char, 16_k> buf_;
+  // Updates nextCapacity_ based on the number of bytes read by the
+  // last recv().
+  void adjustCapacity(size_t nread);
+  // Reallocates the buffer if nextCapacity_ differs from capacity_.
+  // The buffer must be empty.
+  void resize();
+
+  std::unique_ptr<unsigned char[]> buf_;
+  size_t capacity_;
+  size_t nextCapacity_;
+  int numSmallReads_;
   std::shared_ptr<SocketCore> socket_;
   unsigned char* pos_;
   unsigned char* last_;
+  // The error which stopped the last recv() after it read some data.
+  std::exception_ptr error_;
 };
 
 } // namespace aria2
@@ -35,7 +35,6 @@
 #include "SpeedCalc.h"
 
 #include <algorithm>
-#include <functional>
 
 #include "wallclock.h"
 
@@ -45,42 +44,56 @@ namespace {
 constexpr auto WINDOW_TIME = 10_s;
 } // namespace
 
-SpeedCalc::SpeedCalc() : accumulatedLength_(0), bytesWindow_(0), maxSpeed_(0) {}
+SpeedCalc::SpeedCalc()
+    : first_(0),
+      numSlots_(0),
+      accumulatedLength_(0),
+      bytesWindow_(0),
+      maxSpeed_(0)
+{
+}
 
 void SpeedCalc::reset()
 {
-  timeSlots_.clear();
+  first_ = 0;
+  numSlots_ = 0;
   start_ = global::wallclock();
   accumulatedLength_ = 0;
   bytesWindow_ = 0;
   maxSpeed_ = 0;
 }
 
-void SpeedCalc::removeStaleTimeSlot(const Timer& now)
+void SpeedCalc::removeStaleSlots(const Timer& now)
 {
-  while (!timeSlots_.empty()) {
-    if (timeSlots_[0].first.difference(now) <= WINDOW_TIME) {
+  while (numSlots_ > 0) {
+    auto& slot = slotAt(0);
+    if (slot.time.difference(now) <= WINDOW_TIME) {
       break;
     }
-    bytesWindow_ -= timeSlots_[0].second;
-    timeSlots_.pop_front();
+    bytesWindow_ -= slot.bytes;
+    first_ = (first_ + 1) % NUM_SLOTS;
+    --numSlots_;
   }
 }
 
+int64_t SpeedCalc::elapsedSince(const Slot& slot, const Timer& now)
+{
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     slot.time.difference(now))
+                     .count();
+  return std::max<int64_t>(elapsed, 1);
+}
+
 int SpeedCalc::calculateSpeed()
 {
   const auto& now = global::wallclock();
-  removeStaleTimeSlot(now);
-  if (timeSlots_.empty()) {
+  removeStaleSlots(now);
+  if (numSlots_ == 0) {
     return 0;
   }
-  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     timeSlots_[0].first.difference(now))
-                     .count();
-  if (elapsed <= 0) {
-    elapsed = 1;
-  }
-  int speed = bytesWindow_ * 1000 / elapsed;
+  // The window begins at the oldest slot, so that the idle period
+  // before it does not lower the speed.
+  int speed = bytesWindow_ * 1000 / elapsedSince(slotAt(0), now);
   maxSpeed_ = std::max(speed, maxSpeed_);
   return speed;
 }
@@ -88,40 +101,42 @@ int SpeedCalc::calculateSpeed()
 int SpeedCalc::calculateNewestSpeed(int seconds)
 {
   const auto& now = global::wallclock();
-  removeStaleTimeSlot(now);
-
-  int64_t bytesCount(0);
-  auto it = timeSlots_.rbegin();
-  while (it != timeSlots_.rend()) {
-    if (it->first.difference(now) > seconds * 1_s) {
+  removeStaleSlots(now);
+  int64_t bytesCount = 0;
+  size_t i = numSlots_;
+  for (; i > 0; --i) {
+    auto& slot = slotAt(i - 1);
+    if (slot.time.difference(now) > seconds * 1_s) {
       break;
     }
-    bytesCount += (*it++).second;
+    bytesCount += slot.bytes;
   }
-  if (it == timeSlots_.rbegin()) {
+  if (i == numSlots_) {
     return 0;
   }
-
-  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     (*--it).first.difference(now))
-                     .count();
-  if (elapsed <= 0) {
-    elapsed = 1;
-  }
-  return bytesCount * (1000. / elapsed);
+  return bytesCount * (1000. / elapsedSince(slotAt(i), now));
 }
 
 void SpeedCalc::update(size_t bytes)
 {
   const auto& now = global::wallclock();
-  removeStaleTimeSlot(now);
-  if (timeSlots_.empty() ||
+  removeStaleSlots(now);
+  if (numSlots_ == 0 ||
       std::chrono::duration_cast<std::chrono::seconds>(
-          timeSlots_.back().first.difference(now)) >= 1_s) {
-    timeSlots_.push_back(std::make_pair(now, bytes));
+          slotAt(numSlots_ - 1).time.difference(now)) >= 1_s) {
+    if (numSlots_ == NUM_SLOTS) {
+      // The ring is full only if the clock went backwards.  Drop
+      // the oldest slot.
+      bytesWindow_ -= slotAt(0).bytes;
+      first_ = (first_ + 1) % NUM_SLOTS;
+      --numSlots_;
+    }
+    auto& slot = slotAt(numSlots_++);
+    slot.time = now;
+    slot.bytes = bytes;
   }
   else {
-    timeSlots_.back().second += bytes;
+    slotAt(numSlots_ - 1).bytes += bytes;
   }
   bytesWindow_ += bytes;
   accumulatedLength_ += bytes;
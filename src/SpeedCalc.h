@@ -37,21 +37,51 @@
 
 #include "common.h"
 
-#include <deque>
+#include <array>
 
 #include "TimerA2.h"
 
 namespace aria2 {
 
+// Calculates the transfer speed over the last 10 seconds.  The
+// transferred bytes are accumulated into time slots of at least 1
+// second, which are kept in a fixed ring, and the sum of the slots
+// is maintained incrementally, so that update() and calculateSpeed()
+// take constant time and never allocate memory.
 class SpeedCalc {
 private:
-  std::deque<std::pair<Timer, size_t>> timeSlots_;
+  // A new slot begins at the first update() 1 second or more after
+  // the previous slot began, so that at most 11 slots begin within 10
+  // seconds.
+  static constexpr size_t NUM_SLOTS = 11;
+
+  struct Slot {
+    // The time of the first update() in this slot
+    Timer time;
+    int64_t bytes;
+
+    Slot() : time(Timer::zero()), bytes(0) {}
+  };
+
+  // The slots within the window, oldest first.  The i-th slot is
+  // stored in slots_[(first_ + i) % NUM_SLOTS].
+  std::array<Slot, NUM_SLOTS> slots_;
+  size_t first_;
+  size_t numSlots_;
   Timer start_;
   int64_t accumulatedLength_;
+  // The sum of the bytes of the slots within the window.
   int64_t bytesWindow_;
   int maxSpeed_;
 
-  void removeStaleTimeSlot(const Timer& now);
+  Slot& slotAt(size_t i) { return slots_[(first_ + i) % NUM_SLOTS]; }
+
+  // Removes the slots which began more than 10 seconds before now.
+  void removeStaleSlots(const Timer& now);
+
+  // Returns the elapsed time in milliseconds from the beginning of
+  // slot to now.  The returned value is at least 1.
+  static int64_t elapsedSince(const Slot& slot, const Timer& now);
 
 public:
   SpeedCalc();
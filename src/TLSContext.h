@@ -39,6 +39,8 @@
 
 #include "common.h"
 
+#include "TLSSessionCache.h"
+
 namespace aria2 {
 
 enum TLSSessionSide { TLS_CLIENT, TLS_SERVER };
@@ -70,6 +72,14 @@ public:
   virtual TLSSessionSide getSide() const = 0;
   virtual bool getVerifyPeer() const = 0;
   virtual void setVerifyPeer(bool) = 0;
+
+  // Returns the cache of the sessions for client side session
+  // resumption.  The backends which do not support session
+  // resumption only use it to count handshakes.
+  TLSSessionCache& getSessionCache() { return sessionCache_; }
+
+private:
+  TLSSessionCache sessionCache_;
 };
 
 } // namespace aria2
@@ -111,6 +111,18 @@ public:
   // contacting network.
   virtual size_t getRecvBufferedLength() = 0;
 
+  // Enables client side session resumption with the session cache of
+  // TLSContext.  The session stored under |key| is offered in the
+  // handshake, and the sessions the server issues are stored under
+  // |key|.  This function must be called before tlsConnect().  The
+  // backend which does not support session resumption may leave this
+  // function as is.
+  virtual void setSessionCacheKey(const std::string& key) {}
+
+  // Returns true if the completed handshake resumed the session
+  // offered by setSessionCacheKey().
+  virtual bool isSessionResumed() { return false; }
+
 protected:
   TLSSession() = default;
 
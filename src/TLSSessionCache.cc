@@ -0,0 +1,117 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TLSSessionCache.h"
+
+#include <algorithm>
+
+namespace aria2 {
+
+const size_t TLSSessionCache::DEFAULT_MAX_HOSTS;
+const size_t TLSSessionCache::DEFAULT_MAX_SESSIONS_PER_HOST;
+
+TLSSessionCache::TLSSessionCache(size_t maxHosts, size_t maxSessionsPerHost)
+    : maxHosts_(std::max(maxHosts, static_cast<size_t>(1))),
+      maxSessionsPerHost_(std::max(maxSessionsPerHost, static_cast<size_t>(1))),
+      clock_(0),
+      numFullHandshakes_(0),
+      numResumedHandshakes_(0)
+{
+}
+
+void TLSSessionCache::put(const std::string& key, std::string data)
+{
+  if (data.empty()) {
+    return;
+  }
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    if (entries_.size() >= maxHosts_) {
+      entries_.erase(std::min_element(
+          std::begin(entries_), std::end(entries_),
+          [](const std::pair<const std::string, Entry>& lhs,
+             const std::pair<const std::string, Entry>& rhs) {
+            return lhs.second.lastUsed < rhs.second.lastUsed;
+          }));
+    }
+    i = entries_.insert(std::make_pair(key, Entry())).first;
+  }
+  auto& entry = (*i).second;
+  if (entry.sessions.size() >= maxSessionsPerHost_) {
+    entry.sessions.pop_front();
+  }
+  entry.sessions.push_back(std::move(data));
+  entry.lastUsed = ++clock_;
+}
+
+std::string TLSSessionCache::take(const std::string& key)
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return "";
+  }
+  auto& entry = (*i).second;
+  auto data = std::move(entry.sessions.back());
+  entry.sessions.pop_back();
+  if (entry.sessions.empty()) {
+    entries_.erase(i);
+  }
+  else {
+    entry.lastUsed = ++clock_;
+  }
+  return data;
+}
+
+size_t TLSSessionCache::countSessions(const std::string& key) const
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return 0;
+  }
+  return (*i).second.sessions.size();
+}
+
+void TLSSessionCache::clear() { entries_.clear(); }
+
+void TLSSessionCache::countHandshake(bool resumed)
+{
+  if (resumed) {
+    ++numResumedHandshakes_;
+  }
+  else {
+    ++numFullHandshakes_;
+  }
+}
+
+} // namespace aria2
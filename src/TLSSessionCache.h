@@ -0,0 +1,104 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TLS_SESSION_CACHE_H
+#define D_TLS_SESSION_CACHE_H
+
+#include "common.h"
+
+#include <string>
+#include <deque>
+#include <map>
+
+namespace aria2 {
+
+// Client side cache of TLS sessions used for session resumption.
+// The sessions are stored in the serialized form the TLS backend
+// produces, keyed by the host and port they were negotiated with.
+// Several sessions are kept per host, because TLS 1.3 session tickets
+// should be used only once and parallel connections to the same host
+// each want one.  This class is not thread-safe.
+class TLSSessionCache {
+public:
+  TLSSessionCache(size_t maxHosts = DEFAULT_MAX_HOSTS,
+                  size_t maxSessionsPerHost = DEFAULT_MAX_SESSIONS_PER_HOST);
+
+  // Stores the serialized session data for key.  If key already has
+  // maxSessionsPerHost sessions, the oldest one is dropped.  If the
+  // cache already has maxHosts keys, the least recently used key is
+  // evicted.
+  void put(const std::string& key, std::string data);
+
+  // Removes the most recently stored session for key from the cache
+  // and returns it.  Returns empty string if key has no session.
+  std::string take(const std::string& key);
+
+  // Returns the number of sessions stored for key.
+  size_t countSessions(const std::string& key) const;
+
+  // Returns the number of keys in the cache.
+  size_t size() const { return entries_.size(); }
+
+  void clear();
+
+  // Records the completed handshake.  resumed is true if the
+  // handshake resumed a cached session.
+  void countHandshake(bool resumed);
+
+  uint64_t getNumFullHandshakes() const { return numFullHandshakes_; }
+
+  uint64_t getNumResumedHandshakes() const { return numResumedHandshakes_; }
+
+  static const size_t DEFAULT_MAX_HOSTS = 256;
+  static const size_t DEFAULT_MAX_SESSIONS_PER_HOST = 8;
+
+private:
+  struct Entry {
+    std::deque<std::string> sessions;
+    // Value of clock_ when this entry was last used.
+    uint64_t lastUsed;
+  };
+
+  std::map<std::string, Entry> entries_;
+  size_t maxHosts_;
+  size_t maxSessionsPerHost_;
+  // Incremented on each put() and take() to order the entries by use.
+  uint64_t clock_;
+  uint64_t numFullHandshakes_;
+  uint64_t numResumedHandshakes_;
+};
+
+} // namespace aria2
+
+#endif // D_TLS_SESSION_CACHE_H
@@ -0,0 +1,187 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TimerWheel.h"
+
+#include <cassert>
+#include <limits>
+#include <algorithm>
+
+namespace aria2 {
+
+TimerWheel::Entry::Entry(Command* command)
+    : command_(command),
+      prev_(nullptr),
+      next_(nullptr),
+      expiry_(Timer::zero()),
+      tick_(0)
+{
+}
+
+TimerWheel::TimerWheel(std::chrono::milliseconds resolution, size_t numSlots)
+    : resolution_(std::chrono::duration_cast<Timer::Clock::duration>(
+                      resolution)
+                      .count()),
+      slots_(numSlots),
+      current_(std::numeric_limits<int64_t>::min()),
+      size_(0)
+{
+  assert(resolution_ > 0 && numSlots > 0);
+  for (auto& head : slots_) {
+    head.prev_ = head.next_ = &head;
+  }
+}
+
+TimerWheel::~TimerWheel()
+{
+  // Leave the remaining entries unlinked, so that their owners can
+  // outlive this object.
+  for (auto& head : slots_) {
+    for (auto e = head.next_; e != &head;) {
+      auto next = e->next_;
+      e->prev_ = e->next_ = nullptr;
+      e = next;
+    }
+  }
+}
+
+int64_t TimerWheel::toTick(const Timer& t) const
+{
+  return t.getTime().time_since_epoch().count() / resolution_;
+}
+
+void TimerWheel::link(Entry* head, Entry* entry)
+{
+  entry->prev_ = head->prev_;
+  entry->next_ = head;
+  head->prev_->next_ = entry;
+  head->prev_ = entry;
+}
+
+void TimerWheel::unlink(Entry* entry)
+{
+  entry->prev_->next_ = entry->next_;
+  entry->next_->prev_ = entry->prev_;
+  entry->prev_ = entry->next_ = nullptr;
+}
+
+void TimerWheel::add(Entry* entry, const Timer& expiry)
+{
+  assert(!entry->isLinked());
+  auto count = expiry.getTime().time_since_epoch().count();
+  // Round up, so that the entry does not expire early.
+  auto tick = count / resolution_ + (count % resolution_ != 0);
+  if (current_ != std::numeric_limits<int64_t>::min()) {
+    tick = std::max(tick, current_ + 1);
+  }
+  entry->expiry_ = expiry;
+  entry->tick_ = tick;
+  link(&slots_[tick % slots_.size()], entry);
+  ++size_;
+}
+
+void TimerWheel::remove(Entry* entry)
+{
+  if (!entry->isLinked()) {
+    return;
+  }
+  unlink(entry);
+  --size_;
+}
+
+void TimerWheel::expire(const Timer& now, std::vector<Entry*>& expired)
+{
+  auto tick = toTick(now);
+  if (current_ != std::numeric_limits<int64_t>::min() && tick <= current_) {
+    return;
+  }
+  auto first = expired.size();
+  // If more than a round has passed, every slot is visited once.
+  auto begin = current_ == std::numeric_limits<int64_t>::min() ||
+                       tick - current_ > static_cast<int64_t>(slots_.size())
+                   ? tick - static_cast<int64_t>(slots_.size()) + 1
+                   : current_ + 1;
+  current_ = tick;
+  for (auto t = begin; t <= tick && size_ > 0; ++t) {
+    auto& head = slots_[t % slots_.size()];
+    for (auto e = head.next_; e != &head;) {
+      auto next = e->next_;
+      if (e->tick_ <= tick) {
+        unlink(e);
+        --size_;
+        expired.push_back(e);
+      }
+      e = next;
+    }
+  }
+  std::stable_sort(std::begin(expired) + first, std::end(expired),
+                   [](const Entry* lhs, const Entry* rhs) {
+                     return lhs->tick_ < rhs->tick_;
+                   });
+}
+
+std::chrono::milliseconds
+TimerWheel::getTimeout(const Timer& now, std::chrono::milliseconds max) const
+{
+  if (size_ == 0) {
+    return max;
+  }
+  auto nowTick = toTick(now);
+  // The entries expire after current_.  The slots up to nowTick may
+  // have the entries which expire now.
+  auto first = current_ == std::numeric_limits<int64_t>::min()
+                   ? nowTick
+                   : current_ + 1;
+  auto last = std::min(
+      first + static_cast<int64_t>(slots_.size()) - 1,
+      nowTick + std::chrono::duration_cast<Timer::Clock::duration>(max)
+                        .count() /
+                    resolution_);
+  for (auto t = first; t <= last; ++t) {
+    auto& head = slots_[t % slots_.size()];
+    if (head.next_ != &head) {
+      auto d = Timer::Clock::duration(t * resolution_) -
+               now.getTime().time_since_epoch();
+      if (d <= Timer::Clock::duration::zero()) {
+        return std::chrono::milliseconds(0);
+      }
+      // Round up, so that the slot has come after the timeout.
+      return std::chrono::duration_cast<std::chrono::milliseconds>(
+          d + std::chrono::milliseconds(1) - Timer::Clock::duration(1));
+    }
+  }
+  return max;
+}
+
+} // namespace aria2
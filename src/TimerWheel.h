@@ -0,0 +1,131 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TIMER_WHEEL_H
+#define D_TIMER_WHEEL_H
+
+#include "common.h"
+
+#include <vector>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class Command;
+
+// Hashed timing wheel.  The time is divided into ticks of the given
+// resolution, and an entry which expires at tick t is linked to the
+// slot t % numSlots.  Adding and removing an entry is O(1) and does
+// not allocate memory, because the entries are embedded in their
+// owners.  The entries which expire more than numSlots ticks later
+// stay in their slot until the wheel comes round to them again.
+class TimerWheel {
+public:
+  class Entry {
+  public:
+    Entry(Command* command = nullptr);
+
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    Command* getCommand() const { return command_; }
+
+    // Returns true if this entry is linked to the wheel.
+    bool isLinked() const { return prev_ != nullptr; }
+
+    // The time given to TimerWheel::add().  Valid only if isLinked()
+    // is true.
+    const Timer& getExpiry() const { return expiry_; }
+
+  private:
+    Command* command_;
+    Entry* prev_;
+    Entry* next_;
+    Timer expiry_;
+    int64_t tick_;
+
+    friend class TimerWheel;
+  };
+
+  TimerWheel(std::chrono::milliseconds resolution, size_t numSlots);
+
+  ~TimerWheel();
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Links entry, which must not be linked, so that it expires at
+  // expiry.  The expiry is rounded up to the tick.  If it has passed,
+  // entry expires in the next call of expire().
+  void add(Entry* entry, const Timer& expiry);
+
+  // Unlinks entry if it is linked.
+  void remove(Entry* entry);
+
+  // Unlinks the entries which have expired by now, and appends them
+  // to expired in the order of expiry.
+  void expire(const Timer& now, std::vector<Entry*>& expired);
+
+  // Returns the time until the first non-empty slot comes, which is
+  // never later than the earliest expiry.  Returns max if it is
+  // later than max or the wheel is empty.
+  std::chrono::milliseconds getTimeout(const Timer& now,
+                                       std::chrono::milliseconds max) const;
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  int64_t toTick(const Timer& t) const;
+
+  static void link(Entry* head, Entry* entry);
+
+  static void unlink(Entry* entry);
+
+  int64_t resolution_;
+  // Each slot is a circular doubly linked list whose head is a dummy
+  // entry.
+  std::vector<Entry> slots_;
+  // The last tick processed by expire().  The entries added later
+  // expire after it.
+  int64_t current_;
+  size_t size_;
+};
+
+} // namespace aria2
+
+#endif // D_TIMER_WHEEL_H
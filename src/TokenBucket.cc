@@ -0,0 +1,109 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TokenBucket.h"
+
+#include <algorithm>
+
+namespace aria2 {
+
+const std::chrono::milliseconds TokenBucket::BURST_DURATION(200);
+
+namespace {
+int64_t computeBurst(int rate)
+{
+  return std::max(static_cast<int64_t>(1),
+                  static_cast<int64_t>(rate) *
+                      TokenBucket::BURST_DURATION.count() / 1000);
+}
+} // namespace
+
+TokenBucket::TokenBucket(int rate)
+    : rate_(rate),
+      burst_(computeBurst(rate)),
+      tokens_(burst_),
+      lastRefill_(Timer::zero())
+{
+}
+
+void TokenBucket::setRate(int rate)
+{
+  if (rate_ == rate) {
+    return;
+  }
+  auto wasLimited = isLimited();
+  rate_ = rate;
+  burst_ = computeBurst(rate);
+  // Unlimited bucket is regarded as full.
+  tokens_ = wasLimited ? std::min(tokens_, burst_) : burst_;
+}
+
+void TokenBucket::refill(const Timer& now)
+{
+  if (rate_ == 0 || tokens_ == burst_) {
+    lastRefill_ = now;
+    return;
+  }
+  // Elapsed time longer than 1 second fills the bucket anyway.
+  // Capping it avoids overflow.
+  auto elapsed = std::min(
+      static_cast<int64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              lastRefill_.difference(now))
+              .count()),
+      static_cast<int64_t>(1000000));
+  auto delta = static_cast<int64_t>(rate_) * elapsed / 1000000;
+  // If delta is 0, keep lastRefill_ so that the elapsed time is not
+  // lost.
+  if (delta > 0) {
+    tokens_ = std::min(tokens_ + delta, burst_);
+    lastRefill_ = now;
+  }
+}
+
+void TokenBucket::consume(size_t length)
+{
+  if (rate_ > 0) {
+    tokens_ -= length;
+  }
+}
+
+void TokenBucket::refund(size_t length)
+{
+  if (rate_ > 0) {
+    tokens_ = std::min(tokens_ + static_cast<int64_t>(length), burst_);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,98 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TOKEN_BUCKET_H
+#define D_TOKEN_BUCKET_H
+
+#include "common.h"
+
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+// Token bucket to limit transfer rate.  A token represents a byte.
+// Tokens are added at the rate, and at most the burst size, which is
+// the amount of tokens added in BURST_DURATION, are kept.  The number
+// of tokens can go negative: data larger than the available tokens
+// can be transferred at once, and then the debt must be paid before
+// the next transfer.  This keeps the average rate without splitting
+// data.
+class TokenBucket {
+public:
+  // rate is in bytes per second.  0 means unlimited.
+  TokenBucket(int rate = 0);
+
+  // Changes the rate.  The tokens exceeding the new burst size are
+  // discarded.  If the bucket was unlimited, it becomes full.
+  void setRate(int rate);
+
+  int getRate() const { return rate_; }
+
+  bool isLimited() const { return rate_ > 0; }
+
+  // Adds the tokens accumulated since the last call.
+  void refill(const Timer& now);
+
+  // Returns true if data can be transferred.
+  bool available() const { return rate_ == 0 || tokens_ > 0; }
+
+  // Returns true if the bucket has the maximum number of tokens.
+  // Unlimited bucket is always full.
+  bool isFull() const { return rate_ == 0 || tokens_ == burst_; }
+
+  // Takes length tokens.  Does nothing if the bucket is unlimited.
+  void consume(size_t length);
+
+  // Gives back length tokens taken but not used.
+  void refund(size_t length);
+
+  int64_t getTokens() const { return tokens_; }
+
+  int64_t getBurst() const { return burst_; }
+
+  // The duration the burst size covers.
+  static const std::chrono::milliseconds BURST_DURATION;
+
+private:
+  int rate_;
+  int64_t burst_;
+  int64_t tokens_;
+  Timer lastRefill_;
+};
+
+} // namespace aria2
+
+#endif // D_TOKEN_BUCKET_H
@@ -109,6 +109,19 @@ public:
   getMissingPiece(const std::shared_ptr<Peer>& peer,
                   const std::vector<size_t>& excludedIndexes,
                   cuid_t cuid) CXX11_OVERRIDE;
+
+  virtual uint64_t
+  getAdvertisedPieceMessages(std::vector<BufferSlice>& messages,
+                             size_t& numHaves,
+                             uint64_t lastHaveIndex) CXX11_OVERRIDE
+  {
+    throw FATAL_EXCEPTION("Not Implemented!");
+  }
+
+  virtual BufferSlice getBitfieldMessage() CXX11_OVERRIDE
+  {
+    throw FATAL_EXCEPTION("Not Implemented!");
+  }
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece() CXX11_OVERRIDE;
@@ -229,17 +242,6 @@ public:
   {
   }
 
-  /**
-   * indexes is filled with piece index which is not advertised by the
-   * caller command and newer than lastHaveIndex.
-   */
-  virtual uint64_t
-  getAdvertisedPieceIndexes(std::vector<size_t>& indexes, cuid_t myCuid,
-                            uint64_t lastHaveIndex) CXX11_OVERRIDE
-  {
-    throw FATAL_EXCEPTION("Not Implemented!");
-  }
-
   virtual void removeAdvertisedPiece(const Timer& expiry) CXX11_OVERRIDE {}
 
   /**
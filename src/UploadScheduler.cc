@@ -0,0 +1,276 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "RequestGroup.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+const std::chrono::milliseconds UploadScheduler::TICK(100);
+
+UploadScheduler::UploadScheduler(int maxOverallUploadSpeedLimit)
+    : overall_(maxOverallUploadSpeedLimit),
+      nextGid_(0),
+      lastTick_(Timer::zero())
+{
+}
+
+void UploadScheduler::setMaxOverallUploadSpeedLimit(int speed)
+{
+  overall_.setRate(speed);
+}
+
+void UploadScheduler::removeIdlePeers(Entry& ent)
+{
+  for (auto i = std::begin(ent.peers); i != std::end(ent.peers);) {
+    auto& peer = (*i).second;
+    if (!peer.active && peer.deficit >= 0) {
+      // The peer has had nothing to upload.  Its unused budget is
+      // given back, so that it is handed out to the others.
+      overall_.refund(peer.deficit);
+      ent.bucket.refund(peer.deficit);
+      i = ent.peers.erase(i);
+      continue;
+    }
+    ++i;
+  }
+}
+
+void UploadScheduler::tick(const Timer& now)
+{
+  if (lastTick_.difference(now) < TICK) {
+    return;
+  }
+  lastTick_ = now;
+  size_t numActive = 0;
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    auto& ent = (*i).second;
+    if (!overall_.isLimited() && !ent.bucket.isLimited()) {
+      // The limits were removed.  There is nothing to enforce.
+      i = entries_.erase(i);
+      continue;
+    }
+    ent.bucket.refill(now);
+    removeIdlePeers(ent);
+    // The remaining peers are either the ones which have data to
+    // upload or the ones which have a debt.
+    if (!ent.peers.empty()) {
+      ++numActive;
+    }
+    else if (ent.bucket.isFull()) {
+      i = entries_.erase(i);
+      continue;
+    }
+    ++i;
+  }
+  if (overall_.isLimited()) {
+    if (numActive > 0) {
+      overall_.refill(now);
+      distribute(numActive);
+    }
+  }
+  else {
+    for (auto& e : entries_) {
+      giveToPeers(e.second, std::numeric_limits<int64_t>::max());
+    }
+  }
+  for (auto& e : entries_) {
+    for (auto& p : e.second.peers) {
+      p.second.active = false;
+    }
+  }
+}
+
+int64_t UploadScheduler::getPeerCap(const Entry& ent) const
+{
+  // Don't let the budget grow beyond the burst size.
+  auto cap = std::numeric_limits<int64_t>::max();
+  if (overall_.isLimited()) {
+    cap = overall_.getBurst();
+  }
+  if (ent.bucket.isLimited()) {
+    cap = std::min(cap, ent.bucket.getBurst());
+  }
+  return cap;
+}
+
+int64_t UploadScheduler::giveToPeers(Entry& ent, int64_t budget)
+{
+  if (ent.bucket.isLimited()) {
+    budget = std::min(budget, ent.bucket.getTokens());
+  }
+  if (budget <= 0 || ent.peers.empty()) {
+    return 0;
+  }
+  // Each peer gets the same share.  The peer which gets the share
+  // first rotates every tick, so that the remainder is shared fairly
+  // over time.  The share of the peer which has nothing to upload
+  // only pays its debt: the bytes it sent beyond its budget are
+  // charged to the limits this way.
+  auto quantum = std::max(static_cast<int64_t>(1),
+                          budget / static_cast<int64_t>(ent.peers.size()));
+  auto cap = getPeerCap(ent);
+  int64_t given = 0;
+  auto start = ent.peers.lower_bound(ent.nextCuid);
+  if (start == std::end(ent.peers)) {
+    start = std::begin(ent.peers);
+  }
+  ent.nextCuid = (*start).first + 1;
+  auto i = start;
+  do {
+    auto& peer = (*i).second;
+    auto share = std::min(std::min(quantum, budget - given),
+                          (peer.active ? cap : 0) - peer.deficit);
+    if (share > 0) {
+      peer.deficit += share;
+      given += share;
+      if (given == budget) {
+        break;
+      }
+    }
+    if (++i == std::end(ent.peers)) {
+      i = std::begin(ent.peers);
+    }
+  } while (i != start);
+  ent.bucket.consume(given);
+  return given;
+}
+
+void UploadScheduler::distribute(size_t numActive)
+{
+  if (overall_.getTokens() <= 0) {
+    return;
+  }
+  // Each RequestGroup gets the same share.  The RequestGroup
+  // which gets the share first rotates every tick, so that the
+  // remainder is shared fairly over time.
+  auto quantum =
+      std::max(static_cast<int64_t>(1),
+               overall_.getTokens() / static_cast<int64_t>(numActive));
+  auto start = entries_.lower_bound(nextGid_);
+  if (start == std::end(entries_)) {
+    start = std::begin(entries_);
+  }
+  nextGid_ = (*start).first + 1;
+  auto i = start;
+  do {
+    auto& ent = (*i).second;
+    // The share the RequestGroup cannot use now, because of its own
+    // limit, is left to the following ticks.
+    if (!ent.peers.empty()) {
+      overall_.consume(
+          giveToPeers(ent, std::min(quantum, overall_.getTokens())));
+      if (overall_.getTokens() <= 0) {
+        break;
+      }
+    }
+    if (++i == std::end(entries_)) {
+      i = std::begin(entries_);
+    }
+  } while (i != start);
+}
+
+UploadScheduler::Entry& UploadScheduler::getEntry(RequestGroup* group,
+                                                  const Timer& now)
+{
+  auto i = entries_.find(group->getGID());
+  if (i == std::end(entries_)) {
+    i = entries_
+            .insert(std::make_pair(
+                group->getGID(),
+                Entry{TokenBucket(group->getMaxUploadSpeedLimit()),
+                      std::map<cuid_t, Peer>(), 0}))
+            .first;
+    // Starts counting the elapsed time from now.
+    (*i).second.bucket.refill(now);
+  }
+  else {
+    (*i).second.bucket.setRate(group->getMaxUploadSpeedLimit());
+  }
+  return (*i).second;
+}
+
+bool UploadScheduler::acquire(RequestGroup* group, cuid_t cuid,
+                              size_t length)
+{
+  if (!isLimited(group)) {
+    return true;
+  }
+  tick(global::wallclock());
+  auto& ent = getEntry(group, global::wallclock());
+  auto& peer =
+      (*ent.peers.insert(std::make_pair(cuid, Peer{0, false})).first).second;
+  peer.active = true;
+  if (peer.deficit <= 0) {
+    return false;
+  }
+  peer.deficit -= length;
+  return true;
+}
+
+bool UploadScheduler::canUpload(RequestGroup* group, cuid_t cuid)
+{
+  if (!isLimited(group)) {
+    return true;
+  }
+  tick(global::wallclock());
+  auto i = entries_.find(group->getGID());
+  if (i == std::end(entries_)) {
+    return true;
+  }
+  const auto& peers = (*i).second.peers;
+  auto j = peers.find(cuid);
+  return j == std::end(peers) || (*j).second.deficit > 0;
+}
+
+bool UploadScheduler::isLimited(RequestGroup* group) const
+{
+  return overall_.isLimited() || group->getMaxUploadSpeedLimit() > 0;
+}
+
+size_t UploadScheduler::getNumPeers(RequestGroup* group) const
+{
+  auto i = entries_.find(group->getGID());
+  if (i == std::end(entries_)) {
+    return 0;
+  }
+  return (*i).second.peers.size();
+}
+
+} // namespace aria2
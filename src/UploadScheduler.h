@@ -0,0 +1,141 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_UPLOAD_SCHEDULER_H
+#define D_UPLOAD_SCHEDULER_H
+
+#include "common.h"
+
+#include <map>
+#include <chrono>
+
+#include "TokenBucket.h"
+#include "TimerA2.h"
+#include "GroupId.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class RequestGroup;
+
+// Hands out upload budgets to the peers, identified by the cuid of
+// their PeerInteractionCommand.  Every TICK, the tokens of the
+// overall upload limit are distributed among the RequestGroups which
+// have data to upload in deficit round robin order, and the share of
+// each RequestGroup, further capped by the token bucket of its own
+// upload limit, is split among its peers which have data to upload
+// in the same way.  A peer can upload while its deficit is positive.
+// The deficit can go negative by a message larger than it, and the
+// debt is carried over, even while the peer has nothing to upload,
+// until the following shares pay it.
+class UploadScheduler {
+public:
+  UploadScheduler(int maxOverallUploadSpeedLimit = 0);
+
+  // 0 means unlimited.
+  void setMaxOverallUploadSpeedLimit(int speed);
+
+  // Returns true if the peer cuid of group can upload length bytes
+  // now, and charges them to its budget.  Otherwise returns false
+  // and the peer is given the budget in the following ticks.
+  bool acquire(RequestGroup* group, cuid_t cuid, size_t length);
+
+  // Returns true if the peer cuid of group has budget to upload.
+  // This function does not charge anything.
+  bool canUpload(RequestGroup* group, cuid_t cuid);
+
+  // Returns true if the upload of group is limited by either the
+  // overall limit or its own limit.
+  bool isLimited(RequestGroup* group) const;
+
+  // Distributes the budgets if TICK has passed since the last
+  // distribution.  acquire() and canUpload() call this function.
+  void tick(const Timer& now);
+
+  size_t getNumEntries() const { return entries_.size(); }
+
+  // Returns the number of the peers of group which have a budget or
+  // a debt.
+  size_t getNumPeers(RequestGroup* group) const;
+
+  // The interval the budgets are handed out.
+  static const std::chrono::milliseconds TICK;
+
+private:
+  struct Peer {
+    // The budget of the peer.  Negative value is the debt.
+    int64_t deficit;
+    // true if the peer asked for budget in the current tick.
+    bool active;
+  };
+
+  struct Entry {
+    // The limit of the RequestGroup
+    TokenBucket bucket;
+    // Keyed by cuid.
+    std::map<cuid_t, Peer> peers;
+    // The cuid of the peer which gets the share first in the next
+    // tick.
+    cuid_t nextCuid;
+  };
+
+  Entry& getEntry(RequestGroup* group, const Timer& now);
+
+  // Returns the largest budget a peer can have.
+  int64_t getPeerCap(const Entry& ent) const;
+
+  // Gives back the budget of the idle peers of ent and removes the
+  // ones without a debt.
+  void removeIdlePeers(Entry& ent);
+
+  // Splits at most budget bytes among the peers of ent, and charges
+  // them to the bucket of ent.  Returns the number of bytes given.
+  int64_t giveToPeers(Entry& ent, int64_t budget);
+
+  // Distributes the tokens of overall_ among numActive entries which
+  // have peers.
+  void distribute(size_t numActive);
+
+  TokenBucket overall_;
+  // Keyed by GID, so that no entry refers to a deleted RequestGroup.
+  std::map<a2_gid_t, Entry> entries_;
+  // The GID of the RequestGroup which gets the share first in the
+  // next tick.
+  a2_gid_t nextGid_;
+  Timer lastTick_;
+};
+
+} // namespace aria2
+
+#endif // D_UPLOAD_SCHEDULER_H
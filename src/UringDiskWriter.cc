@@ -0,0 +1,206 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "UringDiskWriter.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "a2io.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+UringDiskWriter::UringDiskWriter(const std::string& filename, IOUring* ring)
+    : DefaultDiskWriter(filename), ring_(ring)
+{
+}
+
+UringDiskWriter::~UringDiskWriter()
+{
+  try {
+    ring_->wait(status_);
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_ERROR_EX("Waiting for queued writes failed", e);
+  }
+}
+
+void UringDiskWriter::checkError()
+{
+  if (status_.errNum != 0) {
+    int errNum = status_.errNum;
+    status_.errNum = 0;
+    throwWriteError(errNum);
+  }
+}
+
+void UringDiskWriter::waitWrites()
+{
+  ring_->wait(status_);
+  checkError();
+}
+
+void UringDiskWriter::waitWrites(int64_t offset, size_t len)
+{
+  if (getFd() != A2_BAD_FD) {
+    ring_->waitRange(getFd(), offset, len);
+  }
+  checkError();
+}
+
+void UringDiskWriter::closeFile()
+{
+  try {
+    ring_->wait(status_);
+  }
+  catch (RecoverableException& e) {
+    // The kernel holds the reference to the file while the write is
+    // in flight, so it is safe to close it here.
+    DefaultDiskWriter::closeFile();
+    throw;
+  }
+  DefaultDiskWriter::closeFile();
+  checkError();
+}
+
+void UringDiskWriter::writeData(const unsigned char* data, size_t len,
+                                int64_t offset)
+{
+  checkError();
+  if (getFd() == A2_BAD_FD) {
+    DefaultDiskWriter::writeData(data, len, offset);
+    return;
+  }
+  auto buf = make_unique<unsigned char[]>(len);
+  memcpy(buf.get(), data, len);
+  ring_->write(status_, getFd(), std::move(buf), 0, len, offset);
+}
+
+void UringDiskWriter::writeDataOwned(std::unique_ptr<unsigned char[]> data,
+                                     size_t begin, size_t len, int64_t offset)
+{
+  checkError();
+  if (getFd() == A2_BAD_FD) {
+    DefaultDiskWriter::writeData(data.get() + begin, len, offset);
+    return;
+  }
+  ring_->write(status_, getFd(), std::move(data), begin, len, offset);
+}
+
+void UringDiskWriter::writeDataVector(const a2iovec* iov, size_t iovcnt,
+                                      int64_t offset)
+{
+  checkError();
+  if (getFd() == A2_BAD_FD) {
+    DefaultDiskWriter::writeDataVector(iov, iovcnt, offset);
+    return;
+  }
+  size_t len = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    len += iov[i].A2IOVEC_LEN;
+  }
+  auto buf = make_unique<unsigned char[]>(len);
+  auto p = buf.get();
+  for (size_t i = 0; i < iovcnt; ++i) {
+    memcpy(p, iov[i].A2IOVEC_BASE, iov[i].A2IOVEC_LEN);
+    p += iov[i].A2IOVEC_LEN;
+  }
+  ring_->write(status_, getFd(), std::move(buf), 0, len, offset);
+}
+
+ssize_t UringDiskWriter::readData(unsigned char* data, size_t len,
+                                  int64_t offset)
+{
+  if (getFd() == A2_BAD_FD) {
+    checkError();
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+  // read() waits for the overlapping writes, but their errors must be
+  // reported before the data is returned.
+  waitWrites(offset, len);
+  ssize_t ret;
+  while ((ret = ring_->read(getFd(), data, len, offset)) == -1 &&
+         errno == EINTR)
+    ;
+  if (ret == -1) {
+    throwReadError(errno);
+  }
+  return ret;
+}
+
+ssize_t UringDiskWriter::sendFile(SocketCore& socket, size_t len,
+                                  int64_t offset)
+{
+  waitWrites(offset, len);
+  return DefaultDiskWriter::sendFile(socket, len, offset);
+}
+
+void UringDiskWriter::truncate(int64_t length)
+{
+  waitWrites();
+  DefaultDiskWriter::truncate(length);
+}
+
+void UringDiskWriter::allocate(int64_t offset, int64_t length, bool sparse)
+{
+  waitWrites(offset, length);
+  DefaultDiskWriter::allocate(offset, length, sparse);
+}
+
+void UringDiskWriter::flush() { waitWrites(); }
+
+int64_t UringDiskWriter::size()
+{
+  waitWrites();
+  return DefaultDiskWriter::size();
+}
+
+void UringDiskWriter::enableMmap() {}
+
+void UringDiskWriter::dropCache(int64_t len, int64_t offset)
+{
+  waitWrites(offset, len);
+  DefaultDiskWriter::dropCache(len, offset);
+}
+
+int UringDiskWriter::dupForRead(int64_t offset, size_t len)
+{
+  waitWrites(offset, len);
+  return DefaultDiskWriter::dupForRead(offset, len);
+}
+
+} // namespace aria2
@@ -0,0 +1,115 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_URING_DISK_WRITER_H
+#define D_URING_DISK_WRITER_H
+
+#include "DefaultDiskWriter.h"
+#include "IOUring.h"
+
+namespace aria2 {
+
+// DiskWriter which queues writes to io_uring instead of writing them
+// synchronously.  The buffers given to writeDataOwned() are written
+// in place; the data given to writeData() and writeDataVector() are
+// copied, so that the caller can release its buffer immediately.
+// readData() also goes through io_uring.  The operations which depend
+// on the file content wait for the queued writes overlapping the
+// range first; only truncate() and size() wait for all of them.  A
+// failed write is reported by the exception thrown from the next
+// operation.
+class UringDiskWriter : public DefaultDiskWriter {
+public:
+  UringDiskWriter(const std::string& filename, IOUring* ring);
+
+  virtual ~UringDiskWriter();
+
+  virtual void closeFile() CXX11_OVERRIDE;
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE;
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  virtual ssize_t sendFile(SocketCore& socket, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  virtual void writeDataVector(const a2iovec* iov, size_t iovcnt,
+                               int64_t offset) CXX11_OVERRIDE;
+
+  virtual bool acceptsDataOwnership() const CXX11_OVERRIDE { return true; }
+
+  virtual void writeDataOwned(std::unique_ptr<unsigned char[]> data,
+                              size_t begin, size_t len,
+                              int64_t offset) CXX11_OVERRIDE;
+
+  virtual void truncate(int64_t length) CXX11_OVERRIDE;
+
+  virtual void allocate(int64_t offset, int64_t length,
+                        bool sparse) CXX11_OVERRIDE;
+
+  virtual void flush() CXX11_OVERRIDE;
+
+  virtual int64_t size() CXX11_OVERRIDE;
+
+  // mmap is not used together with io_uring.  This function does
+  // nothing.
+  virtual void enableMmap() CXX11_OVERRIDE;
+
+  virtual void dropCache(int64_t len, int64_t offset) CXX11_OVERRIDE;
+
+  virtual int dupForRead(int64_t offset, size_t len) CXX11_OVERRIDE;
+
+  // Returns the number of writes not completed yet.
+  size_t getNumPendingWrites() const { return status_.pending; }
+
+private:
+  // Throws the exception if the preceding write failed.
+  void checkError();
+
+  // Waits for all queued writes and calls checkError().
+  void waitWrites();
+
+  // Waits for the queued writes overlapping [offset, offset+len) and
+  // calls checkError().
+  void waitWrites(int64_t offset, size_t len);
+
+  IOUring* ring_;
+  IOUring::Status status_;
+};
+
+} // namespace aria2
+
+#endif // D_URING_DISK_WRITER_H
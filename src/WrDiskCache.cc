@@ -39,9 +39,12 @@
 #include "WrDiskCacheEntry.h"
 #include "LogFactory.h"
 #include "fmt.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
+const size_t WrDiskCache::BUFFER_SIZE = 64_k;
+
 WrDiskCache::WrDiskCache(size_t limit) : limit_(limit), total_(0), clock_(0) {}
 
 WrDiskCache::~WrDiskCache()
@@ -50,46 +53,114 @@ WrDiskCache::~WrDiskCache()
     A2_LOG_WARN(fmt("Write disk cache is not empty size=%lu",
                     static_cast<unsigned long>(total_)));
   }
+  // The entries may outlive this object.
+  for (auto ent : heap_) {
+    ent->setHeapIndex(WrDiskCacheEntry::NO_HEAP_INDEX);
+    ent->setDiskCache(nullptr);
+  }
+  for (auto buf : freeBuffers_) {
+    delete[] buf;
+  }
 }
 
-bool WrDiskCache::add(WrDiskCacheEntry* ent)
+bool WrDiskCache::contains(WrDiskCacheEntry* ent) const
 {
-  ent->setSizeKey(ent->getSize());
-  ent->setLastUpdate(++clock_);
-  std::pair<EntrySet::iterator, bool> rv = set_.insert(ent);
-  if (rv.second) {
-    total_ += ent->getSize();
-    ensureLimit();
-    return true;
+  return ent->getHeapIndex() < heap_.size() &&
+         heap_[ent->getHeapIndex()] == ent;
+}
+
+void WrDiskCache::setHeapEntry(size_t i, WrDiskCacheEntry* ent)
+{
+  heap_[i] = ent;
+  ent->setHeapIndex(i);
+}
+
+void WrDiskCache::siftUp(size_t i)
+{
+  auto ent = heap_[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!(*ent < *heap_[parent])) {
+      break;
+    }
+    setHeapEntry(i, heap_[parent]);
+    i = parent;
+  }
+  setHeapEntry(i, ent);
+}
+
+void WrDiskCache::siftDown(size_t i)
+{
+  auto ent = heap_[i];
+  for (;;) {
+    size_t child = i * 2 + 1;
+    if (child >= heap_.size()) {
+      break;
+    }
+    if (child + 1 < heap_.size() && *heap_[child + 1] < *heap_[child]) {
+      ++child;
+    }
+    if (!(*heap_[child] < *ent)) {
+      break;
+    }
+    setHeapEntry(i, heap_[child]);
+    i = child;
+  }
+  setHeapEntry(i, ent);
+}
+
+void WrDiskCache::fix(size_t i)
+{
+  if (i > 0 && *heap_[i] < *heap_[(i - 1) / 2]) {
+    siftUp(i);
   }
   else {
-    A2_LOG_WARN(fmt("Found duplicate cache entry a.{size=%lu,clock=%" PRId64
-                    "} b{size=%lu,clock=%" PRId64 "}",
-                    static_cast<unsigned long>((*rv.first)->getSize()),
-                    (*rv.first)->getLastUpdate(),
+    siftDown(i);
+  }
+}
+
+bool WrDiskCache::add(WrDiskCacheEntry* ent)
+{
+  if (contains(ent)) {
+    A2_LOG_WARN(fmt("Found duplicate cache entry size=%lu,clock=%" PRId64,
                     static_cast<unsigned long>(ent->getSize()),
                     ent->getLastUpdate()));
     return false;
   }
+  ent->setSizeKey(ent->getSize());
+  ent->setLastUpdate(++clock_);
+  ent->setDiskCache(this);
+  heap_.push_back(ent);
+  siftUp(heap_.size() - 1);
+  total_ += ent->getSize();
+  ensureLimit();
+  return true;
 }
 
 bool WrDiskCache::remove(WrDiskCacheEntry* ent)
 {
-  if (set_.erase(ent)) {
-    A2_LOG_DEBUG(fmt("Removed cache entry size=%lu, clock=%" PRId64,
-                     static_cast<unsigned long>(ent->getSize()),
-                     ent->getLastUpdate()));
-    total_ -= ent->getSize();
-    return true;
-  }
-  else {
+  if (!contains(ent)) {
     return false;
   }
+  A2_LOG_DEBUG(fmt("Removed cache entry size=%lu, clock=%" PRId64,
+                   static_cast<unsigned long>(ent->getSize()),
+                   ent->getLastUpdate()));
+  size_t i = ent->getHeapIndex();
+  auto last = heap_.back();
+  heap_.pop_back();
+  if (last != ent) {
+    setHeapEntry(i, last);
+    fix(i);
+  }
+  ent->setHeapIndex(WrDiskCacheEntry::NO_HEAP_INDEX);
+  ent->setDiskCache(nullptr);
+  total_ -= ent->getSize();
+  return true;
 }
 
 bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
 {
-  if (!set_.erase(ent)) {
+  if (!contains(ent)) {
     return false;
   }
   A2_LOG_DEBUG(fmt("Update cache entry size=%lu, delta=%ld, clock=%" PRId64,
@@ -98,7 +169,7 @@ bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
 
   ent->setSizeKey(ent->getSize());
   ent->setLastUpdate(++clock_);
-  set_.insert(ent);
+  fix(ent->getHeapIndex());
 
   if (delta < 0) {
     assert(total_ >= static_cast<size_t>(-delta));
@@ -111,18 +182,38 @@ bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
 void WrDiskCache::ensureLimit()
 {
   while (total_ > limit_) {
-    auto i = set_.begin();
-    WrDiskCacheEntry* ent = *i;
+    WrDiskCacheEntry* ent = heap_[0];
     A2_LOG_DEBUG(fmt("Force flush cache entry size=%lu, clock=%" PRId64,
                      static_cast<unsigned long>(ent->getSizeKey()),
                      ent->getLastUpdate()));
     total_ -= ent->getSize();
     ent->writeToDisk();
-    set_.erase(i);
 
     ent->setSizeKey(ent->getSize());
     ent->setLastUpdate(++clock_);
-    set_.insert(ent);
+    siftDown(0);
+  }
+}
+
+unsigned char* WrDiskCache::allocateBuffer()
+{
+  if (freeBuffers_.empty()) {
+    return new unsigned char[BUFFER_SIZE];
+  }
+  auto buf = freeBuffers_.back();
+  freeBuffers_.pop_back();
+  return buf;
+}
+
+void WrDiskCache::releaseBuffer(unsigned char* buf, size_t size)
+{
+  // Keep free buffers up to the cache size, which is roughly the
+  // number of buffers in use when the cache is full.
+  if (size == BUFFER_SIZE && freeBuffers_.size() < limit_ / BUFFER_SIZE) {
+    freeBuffers_.push_back(buf);
+  }
+  else {
+    delete[] buf;
   }
 }
 
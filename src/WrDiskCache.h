@@ -37,9 +37,7 @@
 
 #include "common.h"
 
-#include <set>
-
-#include "a2functional.h"
+#include <vector>
 
 namespace aria2 {
 
@@ -64,14 +62,38 @@ public:
   void ensureLimit();
   size_t getSize() const { return total_; }
 
+  // The size of the buffers returned by allocateBuffer().
+  static const size_t BUFFER_SIZE;
+
+  // Returns a buffer of BUFFER_SIZE bytes allocated by new[].  The
+  // buffer released by releaseBuffer() is reused if available.
+  unsigned char* allocateBuffer();
+  // Releases buf allocated by new[].  The size of buf is given in
+  // size.  If size is BUFFER_SIZE, buf is kept for reuse while the
+  // number of free buffers is small enough.  Otherwise, buf is
+  // deleted.
+  void releaseBuffer(unsigned char* buf, size_t size);
+  size_t getNumFreeBuffers() const { return freeBuffers_.size(); }
+
 private:
-  typedef std::set<WrDiskCacheEntry*, DerefLess<WrDiskCacheEntry*>> EntrySet;
+  bool contains(WrDiskCacheEntry* ent) const;
+  // Moves the entry at index i to the correct position in heap_ after
+  // its key was changed.
+  void fix(size_t i);
+  void siftUp(size_t i);
+  void siftDown(size_t i);
+  void setHeapEntry(size_t i, WrDiskCacheEntry* ent);
+
   // Maximum number of bytes the storage can cache.
   size_t limit_;
   // Current number of bytes cached.
   size_t total_;
-  EntrySet set_;
+  // Binary heap of entries, the one to be flushed first at the top.
+  // Each entry remembers its position in the heap, so that update()
+  // costs O(log N) and allocates no memory.
+  std::vector<WrDiskCacheEntry*> heap_;
   int64_t clock_;
+  std::vector<unsigned char*> freeBuffers_;
 };
 
 } // namespace aria2
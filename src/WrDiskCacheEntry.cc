@@ -35,8 +35,11 @@
 #include "WrDiskCacheEntry.h"
 
 #include <cstring>
+#include <limits>
+#include <algorithm>
 
 #include "DiskAdaptor.h"
+#include "WrDiskCache.h"
 #include "RecoverableException.h"
 #include "DownloadFailureException.h"
 #include "LogFactory.h"
@@ -44,10 +47,15 @@
 
 namespace aria2 {
 
+const size_t WrDiskCacheEntry::NO_HEAP_INDEX =
+    std::numeric_limits<size_t>::max();
+
 WrDiskCacheEntry::WrDiskCacheEntry(
     const std::shared_ptr<DiskAdaptor>& diskAdaptor)
     : sizeKey_(0),
       lastUpdate_(0),
+      heapIndex_(NO_HEAP_INDEX),
+      diskCache_(nullptr),
       size_(0),
       error_(CACHE_ERR_SUCCESS),
       errorCode_(error_code::UNDEFINED),
@@ -67,7 +75,15 @@ WrDiskCacheEntry::~WrDiskCacheEntry()
 void WrDiskCacheEntry::deleteDataCells()
 {
   for (auto& e : set_) {
-    delete[] e->data;
+    // data is nullptr if the buffer was handed to DiskWriter.
+    if (e->data) {
+      if (diskCache_) {
+        diskCache_->releaseBuffer(e->data, e->offset + e->capacity);
+      }
+      else {
+        delete[] e->data;
+      }
+    }
     delete e;
   }
   set_.clear();
@@ -94,7 +110,7 @@ bool WrDiskCacheEntry::cacheData(DataCell* dataCell)
   A2_LOG_DEBUG(fmt("WrDiskCacheEntry cache goff=%" PRId64 ", len=%lu",
                    dataCell->goff, static_cast<unsigned long>(dataCell->len)));
   if (set_.insert(dataCell).second) {
-    size_ += dataCell->len;
+    size_ += dataCell->capacity;
     return true;
   }
   else {
@@ -102,24 +118,91 @@ bool WrDiskCacheEntry::cacheData(DataCell* dataCell)
   }
 }
 
-size_t WrDiskCacheEntry::append(int64_t goff, const unsigned char* data,
-                                size_t len)
+size_t WrDiskCacheEntry::cacheData(int64_t goff, const unsigned char* data,
+                                   size_t len, size_t reserve)
 {
-  if (set_.empty()) {
-    return 0;
+  size_t wlen = 0;
+  auto i = findCellEndingAt(goff);
+  if (i != std::end(set_)) {
+    wlen = appendTo(i, data, len);
+    goff += wlen;
+    data += wlen;
+    len -= wlen;
+    reserve -= std::min(reserve, wlen);
   }
-  auto i = set_.end();
-  --i;
-  if (static_cast<int64_t>((*i)->goff + (*i)->len) == goff) {
-    size_t wlen = std::min((*i)->capacity - (*i)->len, len);
-    memcpy((*i)->data + (*i)->offset + (*i)->len, data, wlen);
-    (*i)->len += wlen;
-    size_ += wlen;
+  if (len == 0) {
     return wlen;
   }
+  auto cell = new DataCell();
+  cell->goff = goff;
+  cell->offset = 0;
+  cell->len = len;
+  cell->capacity = std::max(len, std::min(reserve, WrDiskCache::BUFFER_SIZE));
+  if (diskCache_ && cell->capacity == WrDiskCache::BUFFER_SIZE) {
+    cell->data = diskCache_->allocateBuffer();
+  }
   else {
-    return 0;
+    cell->data = new unsigned char[cell->capacity];
+  }
+  memcpy(cell->data, data, len);
+  if (!cacheData(cell)) {
+    A2_LOG_WARN(fmt("WrDiskCacheEntry already has data at goff=%" PRId64,
+                    goff));
+    if (diskCache_) {
+      diskCache_->releaseBuffer(cell->data, cell->capacity);
+    }
+    else {
+      delete[] cell->data;
+    }
+    delete cell;
+    return wlen;
+  }
+  return wlen + len;
+}
+
+bool WrDiskCacheEntry::coalesce(int64_t goff, const unsigned char* data,
+                                size_t len)
+{
+  auto i = findCellEndingAt(goff);
+  if (i == std::end(set_) || (*i)->capacity - (*i)->len < len) {
+    return false;
+  }
+  auto next = i;
+  if (++next != std::end(set_) &&
+      (*next)->goff < goff + static_cast<int64_t>(len)) {
+    return false;
+  }
+  appendTo(i, data, len);
+  return true;
+}
+
+WrDiskCacheEntry::DataCellSet::iterator
+WrDiskCacheEntry::findCellEndingAt(int64_t goff)
+{
+  DataCell key;
+  key.goff = goff;
+  auto i = set_.upper_bound(&key);
+  if (i == std::begin(set_)) {
+    return std::end(set_);
+  }
+  --i;
+  if ((*i)->goff + static_cast<int64_t>((*i)->len) != goff) {
+    return std::end(set_);
+  }
+  return i;
+}
+
+size_t WrDiskCacheEntry::appendTo(DataCellSet::iterator i,
+                                  const unsigned char* data, size_t len)
+{
+  auto d = *i;
+  size_t wlen = std::min(d->capacity - d->len, len);
+  if (++i != std::end(set_)) {
+    wlen = std::min(wlen, static_cast<size_t>((*i)->goff - d->goff - d->len));
   }
+  memcpy(d->data + d->offset + d->len, data, wlen);
+  d->len += wlen;
+  return wlen;
 }
 
 } // namespace aria2
@@ -73,18 +73,40 @@ public:
   // Deletes cached data without flushing to the disk.
   void clear();
 
-  // Caches |dataCell|
+  // Caches |dataCell|.  The capacity of its buffer is added to the
+  // size of this entry.
   bool cacheData(DataCell* dataCell);
 
-  // Appends into last dataCell in set_ if the region is
-  // contagious. Returns the number of copied bytes.
-  size_t append(int64_t goff, const unsigned char* data, size_t len);
-
+  // Copies |len| bytes of |data| to be put at |goff| into the cache.
+  // The data is appended to the data cell ending at |goff| as much as
+  // possible, and the rest is copied to a new data cell.  |reserve|
+  // is the number of bytes expected to be cached contiguously from
+  // |goff| including |len|, which is used to size the buffer of the
+  // new data cell, so that the following data are coalesced into it.
+  // Returns the number of bytes cached, which is less than |len| only
+  // if the data overlaps the data already cached.
+  size_t cacheData(int64_t goff, const unsigned char* data, size_t len,
+                   size_t reserve);
+
+  // Copies |len| bytes of |data| to be put at |goff| to the end of
+  // the data cell ending at |goff| if its buffer has room for all of
+  // them.  Returns true if copied.
+  bool coalesce(int64_t goff, const unsigned char* data, size_t len);
+
+  // Returns the number of bytes of the buffers of the data cells,
+  // which is not less than the number of bytes cached.
   size_t getSize() const { return size_; }
   void setSizeKey(size_t sizeKey) { sizeKey_ = sizeKey; }
   size_t getSizeKey() const { return sizeKey_; }
   void setLastUpdate(int64_t clock) { lastUpdate_ = clock; }
   int64_t getLastUpdate() const { return lastUpdate_; }
+  // Position in the heap of WrDiskCache.
+  void setHeapIndex(size_t heapIndex) { heapIndex_ = heapIndex; }
+  size_t getHeapIndex() const { return heapIndex_; }
+  static const size_t NO_HEAP_INDEX;
+  // Sets WrDiskCache this entry is added to.  The buffers of the data
+  // cells are released to it.
+  void setDiskCache(WrDiskCache* diskCache) { diskCache_ = diskCache; }
   bool operator<(const WrDiskCacheEntry& rhs) const
   {
     return sizeKey_ > rhs.sizeKey_ ||
@@ -101,8 +123,20 @@ public:
 private:
   void deleteDataCells();
 
+  // Returns the data cell ending at goff, or set_.end().
+  DataCellSet::iterator findCellEndingAt(int64_t goff);
+
+  // Appends data to the data cell pointed by i as much as possible
+  // without overlapping the next data cell.  Returns the number of
+  // copied bytes.
+  size_t appendTo(DataCellSet::iterator i, const unsigned char* data,
+                  size_t len);
+
   size_t sizeKey_;
   int64_t lastUpdate_;
+  size_t heapIndex_;
+
+  WrDiskCache* diskCache_;
 
   size_t size_;
 
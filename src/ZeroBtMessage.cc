@@ -50,10 +50,15 @@ std::vector<unsigned char> ZeroBtMessage::createMessage()
    * total: 5bytes
    */
   auto msg = std::vector<unsigned char>(MESSAGE_LENGTH);
-  bittorrent::createPeerMessageString(msg.data(), MESSAGE_LENGTH, 1, getId());
+  writeMessage(msg.data());
   return msg;
 }
 
+void ZeroBtMessage::writeMessage(unsigned char* data) const
+{
+  bittorrent::createPeerMessageString(data, MESSAGE_LENGTH, 1, getId());
+}
+
 std::string ZeroBtMessage::toString() const { return getName(); }
 
 } // namespace aria2
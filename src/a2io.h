@@ -141,6 +141,7 @@
 #define a2open(path, flags, mode) _wsopen(path, flags, _SH_DENYNO, mode)
 #define a2fopen(path, mode) _wfsopen(path, mode, _SH_DENYNO)
 // # define a2ftruncate(fd, length): We don't use ftruncate in Mingw build
+// # define a2pread, a2pwrite, a2pwritev: Not available in Mingw build
 #define a2_off_t off_t
 #elif defined(__ANDROID__) || defined(ANDROID)
 #define a2lseek(fd, offset, origin) lseek64(fd, offset, origin)
@@ -166,6 +167,10 @@ extern int ftruncate64(int fd, off64_t length);
 }
 #endif
 #define a2ftruncate(fd, length) ftruncate64(fd, length)
+#define a2pread(fd, buf, count, offset) pread64(fd, buf, count, offset)
+#define a2pwrite(fd, buf, count, offset) pwrite64(fd, buf, count, offset)
+// # define a2pwritev(fd, iov, iovcnt, offset): pwritev64 is not
+// available in older NDK.
 // Use off64_t directly since android does not offer transparent
 // switching between off_t and off64_t.
 #define a2_off_t off64_t
@@ -184,6 +189,9 @@ extern int ftruncate64(int fd, off64_t length);
 #define a2open(path, flags, mode) open(path, flags, mode)
 #define a2fopen(path, mode) fopen(path, mode)
 #define a2ftruncate(fd, length) ftruncate(fd, length)
+#define a2pread(fd, buf, count, offset) pread(fd, buf, count, offset)
+#define a2pwrite(fd, buf, count, offset) pwrite(fd, buf, count, offset)
+#define a2pwritev(fd, iov, iovcnt, offset) pwritev(fd, iov, iovcnt, offset)
 #define a2_off_t off_t
 #endif
 
@@ -46,6 +46,36 @@ void flipBit(unsigned char* data, size_t length, size_t bitIndex)
   data[byteIndex] ^= mask;
 }
 
+void andBits(unsigned char* dst, const unsigned char* src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t d, s;
+    memcpy(&d, &dst[i], sizeof(d));
+    memcpy(&s, &src[i], sizeof(s));
+    d &= s;
+    memcpy(&dst[i], &d, sizeof(d));
+  }
+  for (; i < len; ++i) {
+    dst[i] &= src[i];
+  }
+}
+
+void andNotBits(unsigned char* dst, const unsigned char* src, size_t len)
+{
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t d, s;
+    memcpy(&d, &dst[i], sizeof(d));
+    memcpy(&s, &src[i], sizeof(s));
+    d &= ~s;
+    memcpy(&dst[i], &d, sizeof(d));
+  }
+  for (; i < len; ++i) {
+    dst[i] &= ~src[i];
+  }
+}
+
 } // namespace bitfield
 
 } // namespace aria2
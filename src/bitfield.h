@@ -94,6 +94,56 @@ inline size_t countBit32(uint32_t n)
          cntbits[(n >> 16) & 0xffu] + cntbits[(n >> 24) & 0xffu];
 }
 
+inline size_t countBit64(uint64_t n)
+{
+#ifdef __GNUG__
+  return __builtin_popcountll(n);
+#else  // !__GNUG__
+  n = n - ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  n = (n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (n * 0x0101010101010101ULL) >> 56;
+#endif // !__GNUG__
+}
+
+// Returns the number of leading zero bits in n.  n must not be 0.
+inline int countLeadingZero64(uint64_t n)
+{
+  assert(n);
+#ifdef __GNUG__
+  return __builtin_clzll(n);
+#else  // !__GNUG__
+  int c = 0;
+  for (; (n & 0x8000000000000000ULL) == 0; n <<= 1, ++c)
+    ;
+  return c;
+#endif // !__GNUG__
+}
+
+// Loads 8 bytes from p as big endian integer, so that the most
+// significant bit of the returned value corresponds to the first bit
+// of p.
+inline uint64_t loadWord(const unsigned char* p)
+{
+  return (static_cast<uint64_t>(p[0]) << 56) |
+         (static_cast<uint64_t>(p[1]) << 48) |
+         (static_cast<uint64_t>(p[2]) << 40) |
+         (static_cast<uint64_t>(p[3]) << 32) |
+         (static_cast<uint64_t>(p[4]) << 24) |
+         (static_cast<uint64_t>(p[5]) << 16) |
+         (static_cast<uint64_t>(p[6]) << 8) | static_cast<uint64_t>(p[7]);
+}
+
+// Loads last len bytes of bitfield, which is less than 8 bytes, as
+// big endian integer.  Missing bytes are treated as 0.
+inline uint64_t loadPartialWord(const unsigned char* p, size_t len)
+{
+  assert(len < 8);
+  unsigned char buf[8] = {};
+  memcpy(buf, p, len);
+  return loadWord(buf);
+}
+
 // Counts set bit in bitfield.
 inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
 {
@@ -101,25 +151,111 @@ inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
     return 0;
   }
   size_t count = 0;
-  size_t size = sizeof(uint32_t);
   size_t len = (nbits + 7) / 8;
-  if (nbits % 32 != 0) {
-    --len;
-    count +=
-        countBit32(static_cast<uint32_t>(bitfield[len] & lastByteMask(nbits)));
+  // Count the last byte separately to mask out unused bits.
+  --len;
+  count += countBit32(static_cast<uint32_t>(bitfield[len] &
+                                            lastByteMask(nbits)));
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t v;
+    memcpy(&v, &bitfield[i], sizeof(v));
+    count += countBit64(v);
+  }
+  for (; i < len; ++i) {
+    count += cntbits[bitfield[i]];
   }
-  size_t to = len / size;
-  for (size_t i = 0; i < to; ++i) {
-    uint32_t v;
-    memcpy(&v, &bitfield[i * size], sizeof(v));
-    count += countBit32(v);
+  return count;
+}
+
+// Counts set bit in a[i] & b[i].  Both a and b contain nbits bits.
+inline size_t countSetBitAnd(const unsigned char* a, const unsigned char* b,
+                             size_t nbits)
+{
+  if (nbits == 0) {
+    return 0;
+  }
+  size_t count = 0;
+  size_t len = (nbits + 7) / 8;
+  --len;
+  count += cntbits[a[len] & b[len] & lastByteMask(nbits)];
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t va, vb;
+    memcpy(&va, &a[i], sizeof(va));
+    memcpy(&vb, &b[i], sizeof(vb));
+    count += countBit64(va & vb);
   }
-  for (size_t i = len - len % size; i < len; ++i) {
-    count += countBit32(static_cast<uint32_t>(bitfield[i]));
+  for (; i < len; ++i) {
+    count += cntbits[a[i] & b[i]];
   }
   return count;
 }
 
+// Performs dst[i] &= src[i] for i in [0, len).
+void andBits(unsigned char* dst, const unsigned char* src, size_t len);
+
+// Performs dst[i] &= ~src[i] for i in [0, len).
+void andNotBits(unsigned char* dst, const unsigned char* src, size_t len);
+
+// Calls fn(index) for each set bit in word.  The most significant bit
+// of word is offset-th bit of the bitfield which contains nbits bits.
+// Bits whose index is nbits or larger are ignored.
+template <typename F>
+void forEachSetBitInWord(uint64_t word, size_t offset, size_t nbits, F& fn)
+{
+  while (word) {
+    int n = countLeadingZero64(word);
+    size_t index = offset + n;
+    if (index >= nbits) {
+      return;
+    }
+    fn(index);
+    word ^= 0x8000000000000000ULL >> n;
+  }
+}
+
+// Calls fn(index) for each set bit in bitfield.  bitfield contains
+// nbits bits.  Runs of zero bits are skipped 64 bits at a time.
+template <typename F>
+void forEachSetBit(const unsigned char* bitfield, size_t nbits, F fn)
+{
+  size_t len = (nbits + 7) / 8;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    forEachSetBitInWord(loadWord(bitfield + i), i * 8, nbits, fn);
+  }
+  if (i < len) {
+    forEachSetBitInWord(loadPartialWord(bitfield + i, len - i), i * 8, nbits,
+                        fn);
+  }
+}
+
+// Calls setFn(index) for each bit which is set in newBitfield but not
+// in oldBitfield, and calls unsetFn(index) for each bit which is set
+// in oldBitfield but not in newBitfield.  Both bitfields contain
+// nbits bits.
+template <typename F, typename G>
+void forEachChangedBit(const unsigned char* newBitfield,
+                       const unsigned char* oldBitfield, size_t nbits,
+                       F setFn, G unsetFn)
+{
+  size_t len = (nbits + 7) / 8;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t n = loadWord(newBitfield + i);
+    uint64_t o = loadWord(oldBitfield + i);
+    forEachSetBitInWord(n & ~o, i * 8, nbits, setFn);
+    forEachSetBitInWord(o & ~n, i * 8, nbits, unsetFn);
+  }
+  if (i < len) {
+    uint64_t n = loadPartialWord(newBitfield + i, len - i);
+    uint64_t o = loadPartialWord(oldBitfield + i, len - i);
+    forEachSetBitInWord(n & ~o, i * 8, nbits, setFn);
+    forEachSetBitInWord(o & ~n, i * 8, nbits, unsetFn);
+  }
+}
+
 // Counts set bit in bitfield. This is a bit slower than countSetBit
 // but can accept array template expression as bitfield.
 template <typename Array>
@@ -144,13 +280,23 @@ void flipBit(unsigned char* data, size_t length, size_t bitIndex);
 
 // Stores first set bit index of bitfield to index.  bitfield contains
 // nbits. Returns true if set bit is found. Otherwise returns false.
+// Bytes which have no set bit are skipped at once.
 template <typename Array>
 bool getFirstSetBitIndex(size_t& index, const Array& bitfield, size_t nbits)
 {
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      index = i;
-      return true;
+  for (size_t i = 0, len = (nbits + 7) / 8; i < len; ++i) {
+    unsigned char c = bitfield[i];
+    if (c == 0) {
+      continue;
+    }
+    for (size_t j = i * 8; c; c <<= 1, ++j) {
+      if (c & 0x80u) {
+        if (j >= nbits) {
+          return false;
+        }
+        index = j;
+        return true;
+      }
     }
   }
   return false;
@@ -158,6 +304,7 @@ bool getFirstSetBitIndex(size_t& index, const Array& bitfield, size_t nbits)
 
 // Appends first at most n set bit index in bitfield to out.  bitfield
 // contains nbits bits.  Returns the number of appended bit indexes.
+// Bytes which have no set bit are skipped at once.
 template <typename Array, typename OutputIterator>
 size_t getFirstNSetBitIndex(OutputIterator out, size_t n, const Array& bitfield,
                             size_t nbits)
@@ -166,11 +313,17 @@ size_t getFirstNSetBitIndex(OutputIterator out, size_t n, const Array& bitfield,
     return 0;
   }
   const size_t origN = n;
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      *out++ = i;
-      if (--n == 0) {
-        break;
+  for (size_t i = 0, len = (nbits + 7) / 8; i < len; ++i) {
+    unsigned char c = bitfield[i];
+    for (size_t j = i * 8; c; c <<= 1, ++j) {
+      if (c & 0x80u) {
+        if (j >= nbits) {
+          return origN - n;
+        }
+        *out++ = j;
+        if (--n == 0) {
+          return origN;
+        }
       }
     }
   }
@@ -69,6 +69,386 @@ template <typename T> static forceinline T par(T b, T c, T d)
   w03 = endian(buffer[3]), w02 = endian(buffer[2]);                            \
   w01 = endian(buffer[1]), w00 = endian(buffer[0])
 
+// Hardware accelerated SHA-1/SHA-256 transforms.
+// These are compiled with function level target attributes, so that the
+// rest of the binary does not require the instructions, and are only used
+// after the CPU was checked to support them.  Defining
+// CRYPTO_HASH_NO_ACCEL leaves them out, which test/ShaBench uses to
+// measure the portable code.
+#if !defined(CRYPTO_HASH_NO_ACCEL) &&                                          \
+    (defined(__x86_64__) || defined(__i386__)) &&                              \
+    ((defined(__clang__) && __clang_major__ >= 6) ||                           \
+     (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 5))
+#define __hash_x86_sha 1
+#include <cpuid.h>
+#include <immintrin.h>
+#define __hash_x86_sha_target __attribute__((target("sha,sse4.1,ssse3")))
+#endif // x86 && (clang >= 6 || gcc >= 5)
+
+#if !defined(CRYPTO_HASH_NO_ACCEL) && defined(__aarch64__) &&                  \
+    ((defined(__linux__) && !defined(__clang__) && defined(__GNUC__) &&        \
+      __GNUC__ >= 8) ||                                                        \
+     ((defined(__linux__) || defined(__APPLE__)) &&                            \
+      (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))))
+#define __hash_arm_sha 1
+#include <arm_neon.h>
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#define __hash_arm_sha_target
+#else // !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2)
+#define __hash_arm_sha_target __attribute__((target("+crypto")))
+#endif // !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2)
+#ifdef __linux__
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif // HWCAP_SHA1
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif // HWCAP_SHA2
+#endif // __linux__
+#endif // __aarch64__ && ...
+
+// Processes |blocks| consecutive 64 byte blocks of |data|, updating |state|
+// (in native word order) in place.
+typedef void (*sha_transform_t)(uint32_t* state, const uint8_t* data,
+                                size_t blocks);
+
+#if defined(__hash_x86_sha) || defined(__hash_arm_sha)
+static const uint32_t sha256_k[] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+#endif // defined(__hash_x86_sha) || defined(__hash_arm_sha)
+
+#ifdef __hash_x86_sha
+static bool __hash_x86_have_sha()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSSE3) ||
+      !(ecx & bit_SSE4_1) || __get_cpuid_max(0, nullptr) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  // bit_SHA, which older cpuid.h lack.
+  return ebx & (1 << 29);
+}
+
+__hash_x86_sha_target static void sha1_x86(uint32_t* state,
+                                           const uint8_t* data, size_t blocks)
+{
+  const __m128i mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd =
+      _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  __m128i e1;
+
+  for (; blocks; --blocks, data += 64) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save = e0;
+
+    __m128i m0 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 0)), mask);
+    __m128i m1 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 16)), mask);
+    __m128i m2 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 32)), mask);
+    __m128i m3 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 48)), mask);
+
+// 4 rounds, with |e| the current and |en| the next e.
+#define r4(e, en, m, f)                                                        \
+  e = _mm_sha1nexte_epu32(e, m);                                               \
+  en = abcd;                                                                   \
+  abcd = _mm_sha1rnds4_epu32(abcd, e, f);
+
+// Message schedule.
+#define s1(mp, m) mp = _mm_sha1msg1_epu32(mp, m);
+#define s2(mn, m) mn = _mm_sha1msg2_epu32(mn, m);
+#define sx(mx, m) mx = _mm_xor_si128(mx, m);
+
+    e0 = _mm_add_epi32(e0, m0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+    r4(e1, e0, m1, 0) s1(m0, m1);
+    r4(e0, e1, m2, 0) s1(m1, m2) sx(m0, m2);
+    r4(e1, e0, m3, 0) s2(m0, m3) s1(m2, m3) sx(m1, m3);
+    r4(e0, e1, m0, 0) s2(m1, m0) s1(m3, m0) sx(m2, m0);
+    r4(e1, e0, m1, 1) s2(m2, m1) s1(m0, m1) sx(m3, m1);
+    r4(e0, e1, m2, 1) s2(m3, m2) s1(m1, m2) sx(m0, m2);
+    r4(e1, e0, m3, 1) s2(m0, m3) s1(m2, m3) sx(m1, m3);
+    r4(e0, e1, m0, 1) s2(m1, m0) s1(m3, m0) sx(m2, m0);
+    r4(e1, e0, m1, 1) s2(m2, m1) s1(m0, m1) sx(m3, m1);
+    r4(e0, e1, m2, 2) s2(m3, m2) s1(m1, m2) sx(m0, m2);
+    r4(e1, e0, m3, 2) s2(m0, m3) s1(m2, m3) sx(m1, m3);
+    r4(e0, e1, m0, 2) s2(m1, m0) s1(m3, m0) sx(m2, m0);
+    r4(e1, e0, m1, 2) s2(m2, m1) s1(m0, m1) sx(m3, m1);
+    r4(e0, e1, m2, 2) s2(m3, m2) s1(m1, m2) sx(m0, m2);
+    r4(e1, e0, m3, 3) s2(m0, m3) s1(m2, m3) sx(m1, m3);
+    r4(e0, e1, m0, 3) s2(m1, m0) s1(m3, m0) sx(m2, m0);
+    r4(e1, e0, m1, 3) s2(m2, m1) sx(m3, m1);
+    r4(e0, e1, m2, 3) s2(m3, m2);
+    r4(e1, e0, m3, 3);
+
+#undef sx
+#undef s2
+#undef s1
+#undef r4
+
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+  _mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+__hash_x86_sha_target static void sha256_x86(uint32_t* state,
+                                             const uint8_t* data,
+                                             size_t blocks)
+{
+  const __m128i mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  // The instructions want the state as ABEF and CDGH.
+  __m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]),
+                                0xb1);
+  __m128i state1 =
+      _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1b);
+  __m128i state0 = _mm_alignr_epi8(t, state1, 8);
+  state1 = _mm_blend_epi16(state1, t, 0xf0);
+
+  for (; blocks; --blocks, data += 64) {
+    const __m128i abef_save = state0;
+    const __m128i cdgh_save = state1;
+    __m128i w;
+
+    __m128i m0 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 0)), mask);
+    __m128i m1 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 16)), mask);
+    __m128i m2 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 32)), mask);
+    __m128i m3 = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(data + 48)), mask);
+
+// 4 rounds using the |i|th 4 words of the message schedule.
+#define r4(m, i)                                                               \
+  w = _mm_add_epi32(m, _mm_loadu_si128((const __m128i*)&sha256_k[(i) * 4]));   \
+  state1 = _mm_sha256rnds2_epu32(state1, state0, w);                           \
+  state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(w, 0x0e));
+
+// Message schedule.
+#define s1(mp, m) mp = _mm_sha256msg1_epu32(mp, m);
+#define s2(mn, m, mp)                                                          \
+  mn = _mm_sha256msg2_epu32(_mm_add_epi32(mn, _mm_alignr_epi8(m, mp, 4)), m);
+
+    r4(m0, 0);
+    r4(m1, 1) s1(m0, m1);
+    r4(m2, 2) s1(m1, m2);
+    r4(m3, 3) s2(m0, m3, m2) s1(m2, m3);
+    r4(m0, 4) s2(m1, m0, m3) s1(m3, m0);
+    r4(m1, 5) s2(m2, m1, m0) s1(m0, m1);
+    r4(m2, 6) s2(m3, m2, m1) s1(m1, m2);
+    r4(m3, 7) s2(m0, m3, m2) s1(m2, m3);
+    r4(m0, 8) s2(m1, m0, m3) s1(m3, m0);
+    r4(m1, 9) s2(m2, m1, m0) s1(m0, m1);
+    r4(m2, 10) s2(m3, m2, m1) s1(m1, m2);
+    r4(m3, 11) s2(m0, m3, m2) s1(m2, m3);
+    r4(m0, 12) s2(m1, m0, m3) s1(m3, m0);
+    r4(m1, 13) s2(m2, m1, m0);
+    r4(m2, 14) s2(m3, m2, m1);
+    r4(m3, 15);
+
+#undef s2
+#undef s1
+#undef r4
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+  }
+
+  t = _mm_shuffle_epi32(state0, 0x1b);
+  state1 = _mm_shuffle_epi32(state1, 0xb1);
+  _mm_storeu_si128((__m128i*)&state[0], _mm_blend_epi16(t, state1, 0xf0));
+  _mm_storeu_si128((__m128i*)&state[4], _mm_alignr_epi8(state1, t, 8));
+}
+#endif // __hash_x86_sha
+
+#ifdef __hash_arm_sha
+#ifdef __linux__
+static bool __hash_arm_have_sha1()
+{
+  return getauxval(AT_HWCAP) & HWCAP_SHA1;
+}
+
+static bool __hash_arm_have_sha2()
+{
+  return getauxval(AT_HWCAP) & HWCAP_SHA2;
+}
+#else // !__linux__
+// All Apple ARMv8 CPUs have the crypto extensions.
+static bool __hash_arm_have_sha1() { return true; }
+
+static bool __hash_arm_have_sha2() { return true; }
+#endif // !__linux__
+
+#define __hash_arm_load(p) vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)))
+
+__hash_arm_sha_target static void sha1_arm(uint32_t* state,
+                                           const uint8_t* data, size_t blocks)
+{
+  uint32x4_t abcd = vld1q_u32(state);
+  uint32_t e0 = state[4];
+  uint32_t e1;
+
+  for (; blocks; --blocks, data += 64) {
+    const uint32x4_t abcd_save = abcd;
+    const uint32_t e0_save = e0;
+    uint32x4_t w;
+
+    uint32x4_t m0 = __hash_arm_load(data + 0);
+    uint32x4_t m1 = __hash_arm_load(data + 16);
+    uint32x4_t m2 = __hash_arm_load(data + 32);
+    uint32x4_t m3 = __hash_arm_load(data + 48);
+
+// 4 rounds, with |e| the current and |en| the next e.
+#define r4(f, e, en, m, k)                                                     \
+  w = vaddq_u32(m, vdupq_n_u32(k));                                            \
+  en = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                    \
+  abcd = f(abcd, e, w);
+
+// Message schedule.
+#define ms(a, b, c, d) a = vsha1su1q_u32(vsha1su0q_u32(a, b, c), d);
+
+    r4(vsha1cq_u32, e0, e1, m0, 0x5a827999) ms(m0, m1, m2, m3);
+    r4(vsha1cq_u32, e1, e0, m1, 0x5a827999) ms(m1, m2, m3, m0);
+    r4(vsha1cq_u32, e0, e1, m2, 0x5a827999) ms(m2, m3, m0, m1);
+    r4(vsha1cq_u32, e1, e0, m3, 0x5a827999) ms(m3, m0, m1, m2);
+    r4(vsha1cq_u32, e0, e1, m0, 0x5a827999) ms(m0, m1, m2, m3);
+    r4(vsha1pq_u32, e1, e0, m1, 0x6ed9eba1) ms(m1, m2, m3, m0);
+    r4(vsha1pq_u32, e0, e1, m2, 0x6ed9eba1) ms(m2, m3, m0, m1);
+    r4(vsha1pq_u32, e1, e0, m3, 0x6ed9eba1) ms(m3, m0, m1, m2);
+    r4(vsha1pq_u32, e0, e1, m0, 0x6ed9eba1) ms(m0, m1, m2, m3);
+    r4(vsha1pq_u32, e1, e0, m1, 0x6ed9eba1) ms(m1, m2, m3, m0);
+    r4(vsha1mq_u32, e0, e1, m2, 0x8f1bbcdc) ms(m2, m3, m0, m1);
+    r4(vsha1mq_u32, e1, e0, m3, 0x8f1bbcdc) ms(m3, m0, m1, m2);
+    r4(vsha1mq_u32, e0, e1, m0, 0x8f1bbcdc) ms(m0, m1, m2, m3);
+    r4(vsha1mq_u32, e1, e0, m1, 0x8f1bbcdc) ms(m1, m2, m3, m0);
+    r4(vsha1mq_u32, e0, e1, m2, 0x8f1bbcdc) ms(m2, m3, m0, m1);
+    r4(vsha1pq_u32, e1, e0, m3, 0xca62c1d6) ms(m3, m0, m1, m2);
+    r4(vsha1pq_u32, e0, e1, m0, 0xca62c1d6);
+    r4(vsha1pq_u32, e1, e0, m1, 0xca62c1d6);
+    r4(vsha1pq_u32, e0, e1, m2, 0xca62c1d6);
+    r4(vsha1pq_u32, e1, e0, m3, 0xca62c1d6);
+
+#undef ms
+#undef r4
+
+    abcd = vaddq_u32(abcd, abcd_save);
+    e0 += e0_save;
+  }
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+__hash_arm_sha_target static void sha256_arm(uint32_t* state,
+                                             const uint8_t* data,
+                                             size_t blocks)
+{
+  uint32x4_t state0 = vld1q_u32(&state[0]);
+  uint32x4_t state1 = vld1q_u32(&state[4]);
+
+  for (; blocks; --blocks, data += 64) {
+    const uint32x4_t abcd_save = state0;
+    const uint32x4_t efgh_save = state1;
+    uint32x4_t w, t;
+
+    uint32x4_t m0 = __hash_arm_load(data + 0);
+    uint32x4_t m1 = __hash_arm_load(data + 16);
+    uint32x4_t m2 = __hash_arm_load(data + 32);
+    uint32x4_t m3 = __hash_arm_load(data + 48);
+
+// 4 rounds using the |i|th 4 words of the message schedule.
+#define r4(m, i)                                                               \
+  w = vaddq_u32(m, vld1q_u32(&sha256_k[(i) * 4]));                             \
+  t = state0;                                                                  \
+  state0 = vsha256hq_u32(state0, state1, w);                                   \
+  state1 = vsha256h2q_u32(state1, t, w);
+
+// Message schedule.
+#define ms(a, b, c, d) a = vsha256su1q_u32(vsha256su0q_u32(a, b), c, d);
+
+    r4(m0, 0) ms(m0, m1, m2, m3);
+    r4(m1, 1) ms(m1, m2, m3, m0);
+    r4(m2, 2) ms(m2, m3, m0, m1);
+    r4(m3, 3) ms(m3, m0, m1, m2);
+    r4(m0, 4) ms(m0, m1, m2, m3);
+    r4(m1, 5) ms(m1, m2, m3, m0);
+    r4(m2, 6) ms(m2, m3, m0, m1);
+    r4(m3, 7) ms(m3, m0, m1, m2);
+    r4(m0, 8) ms(m0, m1, m2, m3);
+    r4(m1, 9) ms(m1, m2, m3, m0);
+    r4(m2, 10) ms(m2, m3, m0, m1);
+    r4(m3, 11) ms(m3, m0, m1, m2);
+    r4(m0, 12);
+    r4(m1, 13);
+    r4(m2, 14);
+    r4(m3, 15);
+
+#undef ms
+#undef r4
+
+    state0 = vaddq_u32(state0, abcd_save);
+    state1 = vaddq_u32(state1, efgh_save);
+  }
+
+  vst1q_u32(&state[0], state0);
+  vst1q_u32(&state[4], state1);
+}
+
+#undef __hash_arm_load
+#endif // __hash_arm_sha
+
+// Runtime dispatch.  Returns nullptr if the portable implementation
+// should be used.
+static sha_transform_t __hash_select_sha1()
+{
+#if defined(__hash_x86_sha)
+  if (__hash_x86_have_sha()) {
+    return sha1_x86;
+  }
+#elif defined(__hash_arm_sha)
+  if (__hash_arm_have_sha1()) {
+    return sha1_arm;
+  }
+#endif
+  return nullptr;
+}
+
+static sha_transform_t __hash_select_sha256()
+{
+#if defined(__hash_x86_sha)
+  if (__hash_x86_have_sha()) {
+    return sha256_x86;
+  }
+#elif defined(__hash_arm_sha)
+  if (__hash_arm_have_sha2()) {
+    return sha256_arm;
+  }
+#endif
+  return nullptr;
+}
+
 using namespace crypto;
 using namespace crypto::hash;
 
@@ -92,6 +472,15 @@ protected:
 
   virtual void transform(const word_t* buffer) = 0;
 
+  // |transform| |blocks| consecutive blocks.  Implementations having a
+  // faster way to process multiple blocks may override this.
+  virtual void transformBlocks(const word_t* buffer, size_t blocks)
+  {
+    for (; blocks; --blocks, buffer += bsize) {
+      transform(buffer);
+    }
+  }
+
   virtual std::string digest()
   {
     return std::string((const char*)state_.bytes, sizeof(state_.bytes));
@@ -118,19 +507,20 @@ public:
       bytes += turn;
       offset_ += turn;
       if (likely(offset_ == sizeof(buffer_))) {
-        transform(buffer_.words);
+        transformBlocks(buffer_.words, 1);
         offset_ = 0;
       }
     }
 
     // |transform| as many blocks as possible.
-    while (len >= sizeof(buffer_)) {
+    if (len >= sizeof(buffer_)) {
       // |offset_| has to be 0 at this point!
       // Which is guaranteed by the block above.
 
-      transform(reinterpret_cast<const word_t*>(bytes));
-      bytes += sizeof(buffer_);
-      len -= sizeof(buffer_);
+      const auto blocks = len / sizeof(buffer_);
+      transformBlocks(reinterpret_cast<const word_t*>(bytes), blocks);
+      bytes += blocks * sizeof(buffer_);
+      len -= blocks * sizeof(buffer_);
     }
 
     // Buffer remaining bytes, if any.
@@ -148,12 +538,12 @@ public:
     const uint_fast16_t cutoff = sizeof(buffer_) - sizeof(word_t) * 2;
     buffer_.bytes[offset_] = 0x80;
     if (unlikely(++offset_ == sizeof(buffer_))) {
-      transform(buffer_.words);
+      transformBlocks(buffer_.words, 1);
       memset(buffer_.bytes, 0x00, cutoff);
     }
     else if (offset_ > cutoff) {
       memset(buffer_.bytes + offset_, 0x00, sizeof(buffer_) - offset_);
-      transform(buffer_.words);
+      transformBlocks(buffer_.words, 1);
       memset(buffer_.bytes, 0x00, cutoff);
     }
     else if (likely(offset_ != cutoff)) {
@@ -177,7 +567,7 @@ public:
     }
 
     // Last transform:
-    transform(buffer_.words);
+    transformBlocks(buffer_.words, 1);
 
 #if LITTLE_ENDIAN == BYTE_ORDER
     // On little endian, we still need to swap the bytes.
@@ -512,6 +902,17 @@ protected:
     state_.words[4] += e;
   }
 
+  virtual void transformBlocks(const word_t* buffer, size_t blocks)
+  {
+    static const sha_transform_t accelerated = __hash_select_sha1();
+    if (accelerated) {
+      accelerated(state_.words, reinterpret_cast<const uint8_t*>(buffer),
+                  blocks);
+      return;
+    }
+    AlgorithmImpl::transformBlocks(buffer, blocks);
+  }
+
 public:
   SHA1() { reset(); }
 
@@ -708,6 +1109,17 @@ protected:
     state_.words[7] += h;
   }
 
+  virtual void transformBlocks(const word_t* buffer, size_t blocks)
+  {
+    static const sha_transform_t accelerated = __hash_select_sha256();
+    if (accelerated) {
+      accelerated(state_.words, reinterpret_cast<const uint8_t*>(buffer),
+                  blocks);
+      return;
+    }
+    AlgorithmImpl::transformBlocks(buffer, blocks);
+  }
+
 public:
   SHA256() { reset(); }
 
@@ -192,6 +192,8 @@ PrefPtr PREF_MAX_OVERALL_DOWNLOAD_LIMIT =
     makePref("max-overall-download-limit");
 // value: 1*digit
 PrefPtr PREF_MAX_DOWNLOAD_LIMIT = makePref("max-download-limit");
+// value: 0 ... 100
+PrefPtr PREF_DOWNLOAD_PRIORITY = makePref("download-priority");
 // value: 1*digit
 PrefPtr PREF_STARTUP_IDLE_TIME = makePref("startup-idle-time");
 // value: prealloc | fallc | none
@@ -348,6 +350,10 @@ PrefPtr PREF_STOP_WITH_PROCESS = makePref("stop-with-process");
 // value: true | false
 PrefPtr PREF_ENABLE_MMAP = makePref("enable-mmap");
 // value: true | false
+PrefPtr PREF_ENABLE_IO_URING = makePref("enable-io-uring");
+// value: 0 ... 64
+PrefPtr PREF_PIECE_HASH_THREADS = makePref("piece-hash-threads");
+// value: true | false
 PrefPtr PREF_FORCE_SAVE = makePref("force-save");
 // value: true | false
 PrefPtr PREF_SAVE_NOT_FOUND = makePref("save-not-found");
@@ -541,6 +547,8 @@ PrefPtr PREF_BT_SAVE_METADATA = makePref("bt-save-metadata");
 PrefPtr PREF_BT_METADATA_ONLY = makePref("bt-metadata-only");
 // values: true | false
 PrefPtr PREF_BT_ENABLE_LPD = makePref("bt-enable-lpd");
+// values: true | false
+PrefPtr PREF_BT_ENABLE_SENDFILE = makePref("bt-enable-sendfile");
 // values: string
 PrefPtr PREF_BT_LPD_INTERFACE = makePref("bt-lpd-interface");
 // values: 1*digit
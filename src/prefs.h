@@ -146,6 +146,8 @@ extern PrefPtr PREF_LOWEST_SPEED_LIMIT;
 extern PrefPtr PREF_PIECE_LENGTH;
 // value: 1*digit
 extern PrefPtr PREF_MAX_DOWNLOAD_LIMIT;
+// value: 0 ... 100
+extern PrefPtr PREF_DOWNLOAD_PRIORITY;
 // value: 1*digit
 extern PrefPtr PREF_STARTUP_IDLE_TIME;
 // value: prealloc | falloc | none
@@ -301,6 +303,10 @@ extern PrefPtr PREF_STOP_WITH_PROCESS;
 // value: true | false
 extern PrefPtr PREF_ENABLE_MMAP;
 // value: true | false
+extern PrefPtr PREF_ENABLE_IO_URING;
+// value: 0 ... 64
+extern PrefPtr PREF_PIECE_HASH_THREADS;
+// value: true | false
 extern PrefPtr PREF_FORCE_SAVE;
 // value: true | false
 extern PrefPtr PREF_SAVE_NOT_FOUND;
@@ -492,6 +498,8 @@ extern PrefPtr PREF_BT_SAVE_METADATA;
 extern PrefPtr PREF_BT_METADATA_ONLY;
 // values: true | false
 extern PrefPtr PREF_BT_ENABLE_LPD;
+// values: true | false
+extern PrefPtr PREF_BT_ENABLE_SENDFILE;
 // values: string
 extern PrefPtr PREF_BT_LPD_INTERFACE;
 // values: 1*digit
@@ -130,6 +130,12 @@
     "                              You can append K or M(1K = 1024, 1M = 1024K).\n" \
     "                              To limit the overall download speed, use\n" \
     "                              --max-overall-download-limit option.")
+#define TEXT_DOWNLOAD_PRIORITY                                          \
+  _(" --download-priority=<N>      Set the priority of the download when it shares\n" \
+    "                              the bandwidth under --max-overall-download-limit.\n" \
+    "                              Each download is assured an equal share, and the\n" \
+    "                              share left unused by the others goes to the\n" \
+    "                              downloads with higher priority first.")
 #define TEXT_FILE_ALLOCATION                                            \
   _(" --file-allocation=METHOD     Specify file allocation method.\n"   \
     "                              'none' doesn't pre-allocate file space. 'prealloc'\n" \
@@ -192,6 +198,10 @@
   _(" --enable-http-keep-alive[=true|false] Enable HTTP/1.1 persistent connection.")
 #define TEXT_ENABLE_HTTP_PIPELINING                                     \
   _(" --enable-http-pipelining[=true|false] Enable HTTP/1.1 pipelining.")
+#define TEXT_MAX_HTTP_PIPELINING                                        \
+  _(" --max-http-pipelining=<NUM> Set the maximum number of requests pipelined\n" \
+    "                              in one connection when\n" \
+    "                              --enable-http-pipelining is used.")
 #define TEXT_CHECK_INTEGRITY                                            \
   _(" -V, --check-integrity[=true|false] Check file integrity by validating piece\n" \
     "                              hashes or a hash of entire file. This option has\n" \
@@ -664,6 +674,11 @@
     "                              (e.g., 1.2Ki, 3.4Mi) in the console readout.")
 #define TEXT_BT_ENABLE_LPD                      \
   _(" --bt-enable-lpd[=true|false] Enable Local Peer Discovery.")
+#define TEXT_BT_ENABLE_SENDFILE                                         \
+  _(" --bt-enable-sendfile[=true|false] Send piece data to peers directly from\n" \
+    "                              files using sendfile(2), without copying them\n" \
+    "                              to memory. The data sent to the peers using\n" \
+    "                              encryption are copied as usual.")
 #define TEXT_BT_LPD_INTERFACE                                           \
   _(" --bt-lpd-interface=INTERFACE Use given interface for Local Peer Discovery. If\n" \
     "                              this option is not specified, the default\n" \
@@ -943,6 +958,19 @@
     "                              your disk.")
 #define TEXT_ENABLE_MMAP                        \
   _(" --enable-mmap[=true|false]   Map files into memory.")
+#define TEXT_PIECE_HASH_THREADS                                         \
+  _(" --piece-hash-threads=<N>     Verify piece hashes on N worker threads when\n" \
+    "                              checking file integrity. Up to N downloads are\n" \
+    "                              verified at the same time. The BitTorrent pieces\n" \
+    "                              whose hash cannot be computed while receiving\n" \
+    "                              the data are also verified by them. If 0 is\n" \
+    "                              given, the hashes are computed in the main\n" \
+    "                              thread one piece at a time.")
+#define TEXT_ENABLE_IO_URING                                            \
+  _(" --enable-io-uring[=true|false] Write files using io_uring, so that slow\n" \
+    "                              disk writes do not block network I/O. If\n" \
+    "                              io_uring is not available at runtime, aria2\n" \
+    "                              writes files synchronously.")
 #define TEXT_RPC_CERTIFICATE                                            \
   _(" --rpc-certificate=FILE       Use the certificate in FILE for RPC server.\n" \
     "                              The certificate must be in PEM format.\n" \
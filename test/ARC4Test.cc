@@ -12,6 +12,8 @@ class ARC4Test : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(ARC4Test);
   CPPUNIT_TEST(testEncrypt);
+  CPPUNIT_TEST(testEncrypt_knownAnswer);
+  CPPUNIT_TEST(testEncrypt_split);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -20,6 +22,8 @@ public:
   void tearDown() {}
 
   void testEncrypt();
+  void testEncrypt_knownAnswer();
+  void testEncrypt_split();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ARC4Test);
@@ -50,4 +54,46 @@ void ARC4Test::testEncrypt()
   CPPUNIT_ASSERT(memcmp(key, decrypted, LEN) == 0);
 }
 
+void ARC4Test::testEncrypt_knownAnswer()
+{
+  ARC4Encryptor enc;
+  enc.init(reinterpret_cast<const unsigned char*>("Key"), 3);
+  unsigned char out[14];
+  enc.encrypt(9, out, reinterpret_cast<const unsigned char*>("Plaintext"));
+  CPPUNIT_ASSERT_EQUAL(std::string("bbf316e8d940af0ad3"), util::toHex(out, 9));
+
+  enc.init(reinterpret_cast<const unsigned char*>("Secret"), 6);
+  enc.encrypt(14, out,
+              reinterpret_cast<const unsigned char*>("Attack at dawn"));
+  CPPUNIT_ASSERT_EQUAL(std::string("45a01f645fc35b383552544b9bf5"),
+                       util::toHex(out, 14));
+}
+
+void ARC4Test::testEncrypt_split()
+{
+  const size_t LEN = 2000;
+  unsigned char key[20];
+  util::generateRandomData(key, sizeof(key));
+  unsigned char data[LEN];
+  util::generateRandomData(data, sizeof(data));
+
+  ARC4Encryptor enc;
+  enc.init(key, sizeof(key));
+  unsigned char expected[LEN];
+  enc.encrypt(LEN, expected, data);
+
+  // Encrypting in pieces must produce the same output regardless of
+  // how they are split.
+  enc.init(key, sizeof(key));
+  unsigned char out[LEN];
+  memcpy(out, data, LEN);
+  size_t offset = 0;
+  for (auto n : {1, 255, 256, 300, 1, 700}) {
+    enc.encrypt(n, out + offset, out + offset);
+    offset += n;
+  }
+  enc.encrypt(LEN - offset, out + offset, out + offset);
+  CPPUNIT_ASSERT(memcmp(expected, out, LEN) == 0);
+}
+
 } // namespace aria2
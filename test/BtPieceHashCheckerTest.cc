@@ -0,0 +1,154 @@
+#include "BtPieceHashChecker.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include "HashWorkerPool.h"
+#include "MockPieceStorage.h"
+#include "DefaultPeerStorage.h"
+#include "DownloadContext.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "Piece.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class BtPieceHashCheckerTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BtPieceHashCheckerTest);
+  CPPUNIT_TEST(testCheckFinished);
+  CPPUNIT_TEST(testCanSubmit);
+  CPPUNIT_TEST(testCancel);
+  CPPUNIT_TEST_SUITE_END();
+
+  class MockPieceStorage2 : public MockPieceStorage {
+  public:
+    std::vector<size_t> completedIndexes;
+    std::vector<size_t> advertisedIndexes;
+    std::vector<size_t> cancelledIndexes;
+
+    virtual void
+    completePiece(const std::shared_ptr<Piece>& piece) CXX11_OVERRIDE
+    {
+      completedIndexes.push_back(piece->getIndex());
+    }
+
+    virtual void cancelPiece(const std::shared_ptr<Piece>& piece,
+                             cuid_t cuid) CXX11_OVERRIDE
+    {
+      cancelledIndexes.push_back(piece->getIndex());
+    }
+
+    virtual void advertisePiece(cuid_t cuid, size_t index,
+                                Timer registeredTime) CXX11_OVERRIDE
+    {
+      advertisedIndexes.push_back(index);
+    }
+  };
+
+  std::unique_ptr<HashWorkerPool> pool_;
+  std::unique_ptr<DownloadContext> dctx_;
+  std::shared_ptr<MockPieceStorage2> pieceStorage_;
+  std::shared_ptr<DefaultPeerStorage> peerStorage_;
+
+public:
+  void setUp()
+  {
+    pool_ = make_unique<HashWorkerPool>(2);
+    dctx_ = make_unique<DownloadContext>(8, 16);
+    std::vector<std::string> hashes{
+        // sha-1("abcdefgh")
+        fromHex("425af12a0743502b322e93a015bcf868e324d56a"),
+        // Not sha-1("ijklmnop")
+        fromHex("0000000000000000000000000000000000000000")};
+    dctx_->setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+    auto adaptor = std::make_shared<DirectDiskAdaptor>();
+    auto dw = make_unique<ByteArrayDiskWriter>();
+    dw->setString("abcdefghijklmnop");
+    adaptor->setDiskWriter(std::move(dw));
+    adaptor->setTotalLength(16);
+    pieceStorage_ = std::make_shared<MockPieceStorage2>();
+    pieceStorage_->setDiskAdaptor(adaptor);
+    peerStorage_ = std::make_shared<DefaultPeerStorage>();
+  }
+
+  void testCheckFinished();
+  void testCanSubmit();
+  void testCancel();
+
+  std::shared_ptr<Piece> createCompletedPiece(size_t index)
+  {
+    auto piece = std::make_shared<Piece>(index, 8);
+    piece->completeBlock(0);
+    return piece;
+  }
+
+  void waitFinished(BtPieceHashChecker& checker)
+  {
+    while (checker.countPending() > 0) {
+      checker.checkFinished();
+    }
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BtPieceHashCheckerTest);
+
+void BtPieceHashCheckerTest::testCheckFinished()
+{
+  BtPieceHashChecker checker(pool_.get(), dctx_.get(), pieceStorage_,
+                             peerStorage_);
+  auto good = createCompletedPiece(0);
+  // The hash of piece#1 does not match.
+  auto bad = createCompletedPiece(1);
+  checker.submit(good, 1, "192.168.0.1");
+  checker.submit(bad, 2, "192.168.0.2");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, checker.countPending());
+  waitFinished(checker);
+
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->completedIndexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pieceStorage_->completedIndexes[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->advertisedIndexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pieceStorage_->advertisedIndexes[0]);
+  CPPUNIT_ASSERT(good->pieceComplete());
+  CPPUNIT_ASSERT(!peerStorage_->isBadPeer("192.168.0.1"));
+
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->cancelledIndexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->cancelledIndexes[0]);
+  CPPUNIT_ASSERT(!bad->hasBlock(0));
+  CPPUNIT_ASSERT(peerStorage_->isBadPeer("192.168.0.2"));
+}
+
+void BtPieceHashCheckerTest::testCanSubmit()
+{
+  HashWorkerPool pool(1);
+  BtPieceHashChecker checker(&pool, dctx_.get(), pieceStorage_,
+                             peerStorage_);
+  // 1 thread accepts up to 2 pieces.
+  for (size_t i = 0; i < 2; ++i) {
+    CPPUNIT_ASSERT(checker.canSubmit());
+    checker.submit(createCompletedPiece(i), 1, "192.168.0.1");
+  }
+  CPPUNIT_ASSERT(!checker.canSubmit());
+  waitFinished(checker);
+  CPPUNIT_ASSERT(checker.canSubmit());
+}
+
+void BtPieceHashCheckerTest::testCancel()
+{
+  BtPieceHashChecker checker(pool_.get(), dctx_.get(), pieceStorage_,
+                             peerStorage_);
+  auto piece = createCompletedPiece(0);
+  checker.submit(piece, 1, "192.168.0.1");
+  checker.cancel();
+
+  CPPUNIT_ASSERT_EQUAL((size_t)0, checker.countPending());
+  CPPUNIT_ASSERT(!checker.canSubmit());
+  CPPUNIT_ASSERT(!piece->hasBlock(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStorage_->cancelledIndexes.size());
+  CPPUNIT_ASSERT(pieceStorage_->completedIndexes.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, checker.checkFinished());
+}
+
+} // namespace aria2
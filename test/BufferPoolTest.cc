@@ -0,0 +1,148 @@
+#include "BufferPool.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "a2functional.h"
+
+namespace aria2 {
+
+class BufferPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BufferPoolTest);
+  CPPUNIT_TEST(testAllocate);
+  CPPUNIT_TEST(testAllocate_large);
+  CPPUNIT_TEST(testMaxFreeBytes);
+  CPPUNIT_TEST(testSlice);
+  CPPUNIT_TEST(testOutlivePool);
+  CPPUNIT_TEST(testCopyAndMove);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testAllocate();
+  void testAllocate_large();
+  void testMaxFreeBytes();
+  void testSlice();
+  void testOutlivePool();
+  void testCopyAndMove();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BufferPoolTest);
+
+void BufferPoolTest::testAllocate()
+{
+  BufferPool pool;
+  {
+    auto buf = pool.allocate(17);
+    CPPUNIT_ASSERT_EQUAL((size_t)17, buf.size());
+    memset(buf.data(), 0, buf.size());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)0, pool.getNumHits());
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumMisses());
+    CPPUNIT_ASSERT_EQUAL(BufferPool::getCapacity(17), pool.getInUseBytes());
+    CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getFreeBytes());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getInUseBytes());
+  CPPUNIT_ASSERT_EQUAL(BufferPool::getCapacity(17), pool.getFreeBytes());
+
+  // Same size class
+  auto buf = pool.allocate(9);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumMisses());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getFreeBytes());
+
+  // Different size class
+  auto buf2 = pool.allocate(16_k + 13);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getNumMisses());
+  CPPUNIT_ASSERT(BufferPool::getCapacity(16_k + 13) >= 16_k + 13);
+  CPPUNIT_ASSERT_EQUAL(BufferPool::getCapacity(9) +
+                           BufferPool::getCapacity(16_k + 13),
+                       pool.getInUseBytes());
+}
+
+void BufferPoolTest::testAllocate_large()
+{
+  BufferPool pool;
+  {
+    auto buf = pool.allocate(1_m);
+    CPPUNIT_ASSERT_EQUAL((size_t)1_m, buf.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)1_m, BufferPool::getCapacity(1_m));
+    CPPUNIT_ASSERT_EQUAL((size_t)1_m, pool.getInUseBytes());
+  }
+  // The large buffer is not pooled.
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getInUseBytes());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getFreeBytes());
+  pool.allocate(1_m);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, pool.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getNumMisses());
+}
+
+void BufferPoolTest::testMaxFreeBytes()
+{
+  size_t capacity = BufferPool::getCapacity(4_k);
+  BufferPool pool(capacity);
+  {
+    auto buf1 = pool.allocate(4_k);
+    auto buf2 = pool.allocate(4_k);
+  }
+  CPPUNIT_ASSERT_EQUAL(capacity, pool.getFreeBytes());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getInUseBytes());
+}
+
+void BufferPoolTest::testSlice()
+{
+  BufferPool pool;
+  auto buf = pool.allocate(10);
+  memcpy(buf.data(), "0123456789", 10);
+  CPPUNIT_ASSERT(buf.unique());
+  {
+    auto s = buf.slice(3, 4);
+    CPPUNIT_ASSERT(!buf.unique());
+    CPPUNIT_ASSERT_EQUAL((size_t)4, s.size());
+    CPPUNIT_ASSERT(memcmp("3456", s.data(), 4) == 0);
+    auto t = s.slice(1, 2);
+    CPPUNIT_ASSERT(memcmp("45", t.data(), 2) == 0);
+  }
+  CPPUNIT_ASSERT(buf.unique());
+  buf = BufferSlice();
+  CPPUNIT_ASSERT(buf.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getInUseBytes());
+  CPPUNIT_ASSERT_EQUAL(BufferPool::getCapacity(10), pool.getFreeBytes());
+}
+
+void BufferPoolTest::testOutlivePool()
+{
+  BufferSlice buf;
+  {
+    BufferPool pool;
+    buf = pool.allocate(100);
+  }
+  memset(buf.data(), 0, buf.size());
+  // buf is released after pool is destroyed.
+}
+
+void BufferPoolTest::testCopyAndMove()
+{
+  BufferPool pool;
+  auto buf = pool.allocate(10);
+  auto copy = buf;
+  CPPUNIT_ASSERT_EQUAL(buf.data(), copy.data());
+  CPPUNIT_ASSERT(!buf.unique());
+  auto moved = std::move(copy);
+  CPPUNIT_ASSERT(copy.empty());
+  CPPUNIT_ASSERT(!buf.unique());
+  moved = BufferSlice::allocate(5);
+  CPPUNIT_ASSERT(buf.unique());
+  CPPUNIT_ASSERT(moved.unique());
+  CPPUNIT_ASSERT_EQUAL((size_t)5, moved.size());
+  buf = buf;
+  CPPUNIT_ASSERT(buf.unique());
+  buf = std::move(moved);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, buf.size());
+  // Nothing was allocated from the pool except the first buffer.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumMisses());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getInUseBytes());
+  CPPUNIT_ASSERT_EQUAL(BufferPool::getCapacity(10), pool.getFreeBytes());
+}
+
+} // namespace aria2
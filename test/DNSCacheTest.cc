@@ -2,6 +2,8 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+
 namespace aria2 {
 
 class DNSCacheTest : public CppUnit::TestFixture {
@@ -11,6 +13,9 @@ class DNSCacheTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testMarkBad);
   CPPUNIT_TEST(testPutBadAddr);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testExpire);
+  CPPUNIT_TEST(testPutFailure);
+  CPPUNIT_TEST(testCountLookup);
   CPPUNIT_TEST_SUITE_END();
 
   DNSCache cache_;
@@ -18,6 +23,7 @@ class DNSCacheTest : public CppUnit::TestFixture {
 public:
   void setUp()
   {
+    global::wallclock().reset(1_s);
     cache_ = DNSCache();
     cache_.put("www", "192.168.0.1", 80);
     cache_.put("www", "::1", 80);
@@ -25,10 +31,15 @@ public:
     cache_.put("proxy", "192.168.1.2", 8080);
   }
 
+  void tearDown() { global::wallclock().reset(); }
+
   void testFind();
   void testMarkBad();
   void testPutBadAddr();
   void testRemove();
+  void testExpire();
+  void testPutFailure();
+  void testCountLookup();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DNSCacheTest);
@@ -61,4 +72,61 @@ void DNSCacheTest::testRemove()
   CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
 }
 
+void DNSCacheTest::testExpire()
+{
+  DNSCache cache(std::chrono::seconds(60), std::chrono::seconds(10));
+  cache.put("www", "192.168.0.1", 80);
+  global::wallclock().advance(59_s);
+  CPPUNIT_ASSERT(cache.contains("www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache.find("www", 80));
+
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT(!cache.contains("www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("www", 80));
+  std::vector<std::string> addrs;
+  cache.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT(addrs.empty());
+
+  // The expired addresses are replaced with new ones.
+  cache.put("www", "192.168.0.2", 80);
+  cache.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), addrs[0]);
+}
+
+void DNSCacheTest::testPutFailure()
+{
+  DNSCache cache(std::chrono::seconds(60), std::chrono::seconds(10));
+  cache.put("www", "192.168.0.1", 80);
+  cache.putFailure("www", 80);
+  CPPUNIT_ASSERT(cache.isFailed("www", 80));
+  CPPUNIT_ASSERT(cache.contains("www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("www", 80));
+  CPPUNIT_ASSERT(!cache.isFailed("www", 8080));
+  Timer expiry(global::wallclock());
+  expiry.advance(10_s);
+  CPPUNIT_ASSERT(expiry.getTime() ==
+                 cache.getFailureExpiry("www", 80).getTime());
+  CPPUNIT_ASSERT(global::wallclock().getTime() ==
+                 cache.getFailureExpiry("www", 8080).getTime());
+
+  global::wallclock().advance(10_s);
+  CPPUNIT_ASSERT(!cache.isFailed("www", 80));
+  CPPUNIT_ASSERT(!cache.contains("www", 80));
+
+  cache.putFailure("www", 80);
+  cache.put("www", "192.168.0.2", 80);
+  CPPUNIT_ASSERT(!cache.isFailed("www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache.find("www", 80));
+}
+
+void DNSCacheTest::testCountLookup()
+{
+  cache_.countLookup(true);
+  cache_.countLookup(true);
+  cache_.countLookup(false);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache_.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache_.getNumMisses());
+}
+
 } // namespace aria2
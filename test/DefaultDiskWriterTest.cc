@@ -2,6 +2,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "a2functional.h"
+#include "TestUtil.h"
 
 namespace aria2 {
 
@@ -9,6 +10,8 @@ class DefaultDiskWriterTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DefaultDiskWriterTest);
   CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testWriteData);
+  CPPUNIT_TEST(testWriteDataVector);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -16,6 +19,8 @@ public:
   void setUp() {}
 
   void testSize();
+  void testWriteData();
+  void testWriteDataVector();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultDiskWriterTest);
@@ -28,4 +33,40 @@ void DefaultDiskWriterTest::testSize()
   CPPUNIT_ASSERT_EQUAL((int64_t)4_k, dw.size());
 }
 
+void DefaultDiskWriterTest::testWriteData()
+{
+  std::string filename = A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_write";
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 6);
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello "), 6, 0);
+  unsigned char buf[11];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, dw.readData(buf, 6, 5));
+  CPPUNIT_ASSERT_EQUAL(std::string(" world"), std::string(&buf[0], &buf[6]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 11));
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"), readFile(filename));
+}
+
+void DefaultDiskWriterTest::testWriteDataVector()
+{
+  std::string filename = A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest_vector";
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  char s1[] = "hello";
+  char s2[] = " ";
+  char s3[] = "world";
+  a2iovec iov[3];
+  iov[0].A2IOVEC_BASE = s1;
+  iov[0].A2IOVEC_LEN = 5;
+  iov[1].A2IOVEC_BASE = s2;
+  iov[1].A2IOVEC_LEN = 1;
+  iov[2].A2IOVEC_BASE = s3;
+  iov[2].A2IOVEC_LEN = 5;
+  dw.writeDataVector(iov, 3, 2);
+  dw.writeData(reinterpret_cast<const unsigned char*>(">>"), 2, 0);
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string(">>hello world"), readFile(filename));
+}
+
 } // namespace aria2
@@ -16,6 +16,8 @@
 #include "DiskWriterFactory.h"
 #include "PieceStatMan.h"
 #include "prefs.h"
+#include "BtHaveMessage.h"
+#include "BtBitfieldMessage.h"
 
 namespace aria2 {
 
@@ -40,6 +42,8 @@ class DefaultPieceStorageTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetFilteredCompletedLength);
   CPPUNIT_TEST(testGetNextUsedIndex);
   CPPUNIT_TEST(testAdvertisePiece);
+  CPPUNIT_TEST(testGetAdvertisedPieceMessages);
+  CPPUNIT_TEST(testGetBitfieldMessage);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -79,6 +83,8 @@ public:
   void testGetFilteredCompletedLength();
   void testGetNextUsedIndex();
   void testAdvertisePiece();
+  void testGetAdvertisedPieceMessages();
+  void testGetBitfieldMessage();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultPieceStorageTest);
@@ -403,6 +409,24 @@ void DefaultPieceStorageTest::testGetNextUsedIndex()
   CPPUNIT_ASSERT_EQUAL((size_t)2, pss.getNextUsedIndex(0));
 }
 
+namespace {
+std::vector<size_t>
+toHaveIndexes(const std::vector<BufferSlice>& messages)
+{
+  std::vector<size_t> res;
+  for (const auto& data : messages) {
+    CPPUNIT_ASSERT_EQUAL((size_t)0, data.size() % 9);
+    for (size_t i = 0; i < data.size(); i += 9) {
+      CPPUNIT_ASSERT_EQUAL((uint32_t)5,
+                           bittorrent::getIntParam(data.data(), i));
+      CPPUNIT_ASSERT_EQUAL((uint8_t)BtHaveMessage::ID, data.data()[i + 4]);
+      res.push_back(bittorrent::getIntParam(data.data(), i + 5));
+    }
+  }
+  return res;
+}
+} // namespace
+
 void DefaultPieceStorageTest::testAdvertisePiece()
 {
   DefaultPieceStorage ps(dctx_, option_.get());
@@ -413,48 +437,153 @@ void DefaultPieceStorageTest::testAdvertisePiece()
   ps.advertisePiece(1, 103, Timer(12_s));
   ps.advertisePiece(2, 104, Timer(100_s));
 
-  std::vector<size_t> res, ans;
+  std::vector<BufferSlice> res;
+  std::vector<size_t> ans;
+  size_t numHaves;
   uint64_t lastHaveIndex;
 
-  lastHaveIndex = ps.getAdvertisedPieceIndexes(res, 1, 0);
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
   ans = std::vector<size_t>{100, 101, 102, 103, 104};
 
   CPPUNIT_ASSERT_EQUAL((uint64_t)5, lastHaveIndex);
-  CPPUNIT_ASSERT(ans == res);
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
 
   res.clear();
-  lastHaveIndex = ps.getAdvertisedPieceIndexes(res, 1, 3);
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 3);
   ans = std::vector<size_t>{103, 104};
 
   CPPUNIT_ASSERT_EQUAL((uint64_t)5, lastHaveIndex);
-  CPPUNIT_ASSERT_EQUAL((size_t)2, res.size());
-  CPPUNIT_ASSERT(ans == res);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, numHaves);
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
 
   res.clear();
-  lastHaveIndex = ps.getAdvertisedPieceIndexes(res, 1, 5);
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 5);
 
   CPPUNIT_ASSERT_EQUAL((uint64_t)5, lastHaveIndex);
-  CPPUNIT_ASSERT_EQUAL((size_t)0, res.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, numHaves);
 
   // remove haves
 
   ps.removeAdvertisedPiece(Timer(11_s));
 
   res.clear();
-  lastHaveIndex = ps.getAdvertisedPieceIndexes(res, 1, 0);
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
   ans = std::vector<size_t>{103, 104};
 
   CPPUNIT_ASSERT_EQUAL((uint64_t)5, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, numHaves);
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
+
+  ps.removeAdvertisedPiece(Timer(300_s));
+
+  res.clear();
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, numHaves);
+}
+
+void DefaultPieceStorageTest::testGetAdvertisedPieceMessages()
+{
+  DefaultPieceStorage ps(dctx_, option_.get());
+
+  for (size_t i = 0; i < 200; ++i) {
+    ps.advertisePiece(1, i, Timer(std::chrono::seconds(i < 150 ? 10 : 20)));
+  }
+
+  std::vector<BufferSlice> res, res2;
+  std::vector<size_t> ans;
+  size_t numHaves;
+  uint64_t lastHaveIndex;
+
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)200, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)200, numHaves);
+  // 200 haves are stored in 2 chunks.
   CPPUNIT_ASSERT_EQUAL((size_t)2, res.size());
-  CPPUNIT_ASSERT(ans == res);
+  for (size_t i = 0; i < 200; ++i) {
+    ans.push_back(i);
+  }
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
+
+  // Other peers share the same storage.
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res2, numHaves, 0);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)200, lastHaveIndex);
+  CPPUNIT_ASSERT(res[0].data() == res2[0].data());
+  CPPUNIT_ASSERT(res[1].data() == res2[1].data());
+
+  res.clear();
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 197);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)200, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, numHaves);
+  ans = std::vector<size_t>{197, 198, 199};
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
+
+  res.clear();
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 200);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)200, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, numHaves);
+  CPPUNIT_ASSERT(res.empty());
+
+  // Appending more haves does not change the slices returned before.
+  ps.advertisePiece(1, 200, Timer(20_s));
+  CPPUNIT_ASSERT_EQUAL((size_t)72 * 9, res2[1].size());
+
+  ps.removeAdvertisedPiece(Timer(10_s));
+
+  res.clear();
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)201, lastHaveIndex);
+  CPPUNIT_ASSERT_EQUAL((size_t)51, numHaves);
+  ans.clear();
+  for (size_t i = 150; i < 201; ++i) {
+    ans.push_back(i);
+  }
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
 
   ps.removeAdvertisedPiece(Timer(300_s));
 
   res.clear();
-  lastHaveIndex = ps.getAdvertisedPieceIndexes(res, 1, 0);
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 0);
 
   CPPUNIT_ASSERT_EQUAL((uint64_t)0, lastHaveIndex);
-  CPPUNIT_ASSERT_EQUAL((size_t)0, res.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, numHaves);
+
+  ps.advertisePiece(1, 1, Timer(400_s));
+
+  res.clear();
+  lastHaveIndex = ps.getAdvertisedPieceMessages(res, numHaves, 201);
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)202, lastHaveIndex);
+  ans = std::vector<size_t>{1};
+  CPPUNIT_ASSERT(ans == toHaveIndexes(res));
+}
+
+void DefaultPieceStorageTest::testGetBitfieldMessage()
+{
+  DefaultPieceStorage ps(dctx_, option_.get());
+
+  auto data = ps.getBitfieldMessage();
+
+  CPPUNIT_ASSERT_EQUAL((size_t)6, data.size());
+  CPPUNIT_ASSERT_EQUAL((uint32_t)2, bittorrent::getIntParam(data.data(), 0));
+  CPPUNIT_ASSERT_EQUAL((uint8_t)BtBitfieldMessage::ID, data.data()[4]);
+  CPPUNIT_ASSERT_EQUAL((uint8_t)0x00, data.data()[5]);
+
+  // Reused while bitfield is unchanged.
+  CPPUNIT_ASSERT(data.data() == ps.getBitfieldMessage().data());
+
+  ps.markPiecesDone(128);
+
+  auto data2 = ps.getBitfieldMessage();
+
+  CPPUNIT_ASSERT(data.data() != data2.data());
+  CPPUNIT_ASSERT_EQUAL((uint8_t)0x00, data.data()[5]);
+  CPPUNIT_ASSERT_EQUAL((uint8_t)0x80, data2.data()[5]);
 }
 
 } // namespace aria2
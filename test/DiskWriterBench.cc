@@ -0,0 +1,130 @@
+// Measures the write cache flush on a DirectDiskAdaptor backed by a
+// DefaultDiskWriter.  256MiB is written as 16KiB blocks, 16 adjacent
+// blocks per piece, each piece cached in a WrDiskCacheEntry.  The
+// "cell" path writes each data cell with its own
+// DiskAdaptor::writeData() call, which is what a flush did before
+// adjacent data cells were coalesced.  The "flush" path calls
+// WrDiskCacheEntry::writeToDisk(), which issues one writeDataVector()
+// per run of adjacent cells.  The write syscalls are read from
+// /proc/self/io.
+#include "WrDiskCacheEntry.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "DirectDiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "File.h"
+#include "console.h"
+#include "a2functional.h"
+
+using namespace aria2;
+
+namespace {
+constexpr size_t BLOCK_LENGTH = 16_k;
+constexpr size_t BLOCKS_PER_PIECE = 16;
+constexpr int64_t TOTAL_LENGTH = 256_m;
+constexpr int NUM_ROUNDS = 3;
+const char OUT_FILE[] = "/tmp/aria2_DiskWriterBench.bin";
+} // namespace
+
+namespace {
+// Returns the number of write syscalls made so far, or -1 if
+// /proc/self/io is not available.
+long long countWriteSyscalls()
+{
+  std::ifstream in("/proc/self/io");
+  std::string key;
+  long long value;
+  while (in >> key >> value) {
+    if (key == "syscw:") {
+      return value;
+    }
+  }
+  return -1;
+}
+} // namespace
+
+namespace {
+void fillEntry(WrDiskCacheEntry& entry, int64_t goff,
+               const std::vector<unsigned char>& buf)
+{
+  for (size_t i = 0; i < BLOCKS_PER_PIECE; ++i) {
+    auto cell = new WrDiskCacheEntry::DataCell();
+    cell->goff = goff + i * BLOCK_LENGTH;
+    cell->data = new unsigned char[BLOCK_LENGTH];
+    memcpy(cell->data, buf.data() + i * BLOCK_LENGTH, BLOCK_LENGTH);
+    cell->offset = 0;
+    cell->len = cell->capacity = BLOCK_LENGTH;
+    entry.cacheData(cell);
+  }
+}
+} // namespace
+
+namespace {
+void writeCells(const std::shared_ptr<DiskAdaptor>& adaptor,
+                const std::vector<unsigned char>& buf)
+{
+  for (int64_t goff = 0; goff < TOTAL_LENGTH;
+       goff += BLOCK_LENGTH * BLOCKS_PER_PIECE) {
+    WrDiskCacheEntry entry(adaptor);
+    fillEntry(entry, goff, buf);
+    for (auto& d : entry.getDataSet()) {
+      adaptor->writeData(d->data + d->offset, d->len, d->goff);
+    }
+    entry.clear();
+  }
+}
+} // namespace
+
+namespace {
+void flushCache(const std::shared_ptr<DiskAdaptor>& adaptor,
+                const std::vector<unsigned char>& buf)
+{
+  for (int64_t goff = 0; goff < TOTAL_LENGTH;
+       goff += BLOCK_LENGTH * BLOCKS_PER_PIECE) {
+    WrDiskCacheEntry entry(adaptor);
+    fillEntry(entry, goff, buf);
+    entry.writeToDisk();
+  }
+}
+} // namespace
+
+namespace {
+template <typename F> void bench(const char* name, F f)
+{
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    auto syscw = countWriteSyscalls();
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    auto ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    printf("%-6s %8.1f ms %8.1f MiB/s %8.1f write syscalls/MiB\n", name, ms,
+           TOTAL_LENGTH / 1_m * 1000.0 / ms,
+           syscw == -1
+               ? -1.0
+               : static_cast<double>(countWriteSyscalls() - syscw) /
+                     (TOTAL_LENGTH / 1_m));
+  }
+}
+} // namespace
+
+int main()
+{
+  // WrDiskCacheEntry logs, and the Logger writes to the console.
+  global::initConsole(true);
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<DefaultDiskWriter>(OUT_FILE);
+  dw->openFile();
+  adaptor->setDiskWriter(std::move(dw));
+  std::vector<unsigned char> buf(BLOCK_LENGTH * BLOCKS_PER_PIECE, 'a');
+  bench("cell", [&] { writeCells(adaptor, buf); });
+  bench("flush", [&] { flushCache(adaptor, buf); });
+  adaptor->closeFile();
+  File(OUT_FILE).remove();
+}
@@ -0,0 +1,113 @@
+// Measures the cost of one iteration of DownloadEngine::run() against
+// the number of commands waiting in it.  The commands are mostly
+// idle, as BitTorrent peer commands waiting for their sockets are:
+// random commands are made active as if an event occurred for them,
+// each once in 5 seconds on average, and the others are only executed
+// when DownloadEngine refreshes them.  The engine does not wait for
+// events, so that the iterations are run back to back for 5 seconds
+// for each number of commands.  The mean, 99th percentile and maximum
+// time of an iteration, and the number of commands executed in an
+// iteration are printed.
+#include "DownloadEngine.h"
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+
+#include "Command.h"
+#include "SelectEventPoll.h"
+#include "Option.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+
+using namespace aria2;
+
+namespace {
+class IdleCommand : public Command {
+public:
+  IdleCommand(cuid_t cuid, DownloadEngine* e, size_t* count)
+      : Command(cuid), e_(e), count_(count)
+  {
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    ++*count_;
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+
+private:
+  DownloadEngine* e_;
+  size_t* count_;
+};
+} // namespace
+
+namespace {
+constexpr auto EVENT_INTERVAL = std::chrono::seconds(5);
+constexpr auto DURATION = std::chrono::seconds(5);
+} // namespace
+
+namespace {
+void bench(size_t numCommands)
+{
+  Option option;
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setOption(&option);
+  e.setRequestGroupMan(make_unique<RequestGroupMan>(
+      std::vector<std::shared_ptr<RequestGroup>>{}, 1, &option));
+  size_t numExecuted = 0;
+  std::vector<Command*> commands;
+  for (size_t i = 0; i < numCommands; ++i) {
+    auto c = make_unique<IdleCommand>(i, &e, &numExecuted);
+    commands.push_back(c.get());
+    e.addCommand(std::move(c));
+  }
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist(0, numCommands - 1);
+  // The first iteration executes all commands.
+  e.setNoWait(true);
+  e.run(true);
+  numExecuted = 0;
+  std::vector<std::chrono::steady_clock::duration> times;
+  size_t numEvents = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (;;) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (elapsed >= DURATION) {
+      break;
+    }
+    for (auto n = numCommands * elapsed / EVENT_INTERVAL; numEvents < n;
+         ++numEvents) {
+      commands[dist(gen)]->setStatusActive();
+    }
+    e.setNoWait(true);
+    auto t0 = std::chrono::steady_clock::now();
+    e.run(true);
+    times.push_back(std::chrono::steady_clock::now() - t0);
+  }
+  auto total = std::accumulate(std::begin(times), std::end(times),
+                               std::chrono::steady_clock::duration{});
+  auto mean = std::chrono::duration<double, std::micro>(total).count() /
+              times.size();
+  std::sort(std::begin(times), std::end(times));
+  printf("commands=%zu iterations=%zu mean=%.2fus p99=%.2fus max=%.2fus "
+         "executed/iteration=%.2f\n",
+         numCommands, times.size(), mean,
+         std::chrono::duration<double, std::micro>(
+             times[times.size() * 99 / 100])
+             .count(),
+         std::chrono::duration<double, std::micro>(times.back()).count(),
+         static_cast<double>(numExecuted) / times.size());
+}
+} // namespace
+
+int main()
+{
+  for (auto n : {100, 1000, 10000, 100000}) {
+    bench(n);
+  }
+}
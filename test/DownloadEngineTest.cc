@@ -0,0 +1,209 @@
+#include "DownloadEngine.h"
+
+#include <thread>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+#include "SelectEventPoll.h"
+#include "Option.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class DownloadEngineTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DownloadEngineTest);
+  CPPUNIT_TEST(testRun_readyCommands);
+  CPPUNIT_TEST(testRun_realtimeCommand);
+  CPPUNIT_TEST(testRun_setStatusWhileExecuting);
+  CPPUNIT_TEST(testRun_wakeup);
+  CPPUNIT_TEST(testRun_refresh);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::unique_ptr<DownloadEngine> e_;
+  std::unique_ptr<Option> option_;
+
+public:
+  void setUp()
+  {
+    option_ = make_unique<Option>();
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e_->setOption(option_.get());
+    e_->setRequestGroupMan(make_unique<RequestGroupMan>(
+        std::vector<std::shared_ptr<RequestGroup>>{}, 1, option_.get()));
+  }
+
+  void tearDown() { e_.reset(); }
+
+  void testRun_readyCommands();
+  void testRun_realtimeCommand();
+  void testRun_setStatusWhileExecuting();
+  void testRun_wakeup();
+  void testRun_refresh();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadEngineTest);
+
+namespace {
+class CountCommand : public Command {
+public:
+  CountCommand(cuid_t cuid, DownloadEngine* e)
+      : Command(cuid), e_(e), count_(0), next_(nullptr), wakeup_(false)
+  {
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    ++count_;
+    if (next_) {
+      next_->setStatusActive();
+    }
+    if (wakeup_) {
+      e_->addWakeup(this, std::chrono::milliseconds(10));
+    }
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+
+  DownloadEngine* e_;
+  int count_;
+  Command* next_;
+  bool wakeup_;
+};
+} // namespace
+
+namespace {
+std::vector<CountCommand*> addCommands(DownloadEngine* e, size_t n)
+{
+  std::vector<CountCommand*> commands;
+  for (size_t i = 0; i < n; ++i) {
+    auto c = make_unique<CountCommand>(i, e);
+    commands.push_back(c.get());
+    e->addCommand(std::move(c));
+  }
+  return commands;
+}
+} // namespace
+
+void DownloadEngineTest::testRun_readyCommands()
+{
+  auto commands = addCommands(e_.get(), 10);
+  // First iteration executes all commands.
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  for (auto c : commands) {
+    CPPUNIT_ASSERT_EQUAL(1, c->count_);
+  }
+  commands[3]->setStatusActive();
+  commands[7]->setStatus(Command::STATUS_ONESHOT_REALTIME);
+  commands[5]->setStatusActive();
+  commands[5]->setStatusInactive();
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  for (size_t i = 0; i < commands.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL((i == 3 || i == 7) ? 2 : 1, commands[i]->count_);
+  }
+  // Status is reset after execution.
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(2, commands[3]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[7]->count_);
+}
+
+void DownloadEngineTest::testRun_realtimeCommand()
+{
+  auto commands = addCommands(e_.get(), 3);
+  commands[1]->setStatusRealtime();
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  for (int i = 0; i < 3; ++i) {
+    e_->setNoWait(true);
+    CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  }
+  CPPUNIT_ASSERT_EQUAL(1, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(4, commands[1]->count_);
+  CPPUNIT_ASSERT_EQUAL(1, commands[2]->count_);
+}
+
+void DownloadEngineTest::testRun_setStatusWhileExecuting()
+{
+  auto commands = addCommands(e_.get(), 3);
+  // commands[2] is activated while it is waiting for its turn in the
+  // first iteration.  It must be executed only once there.
+  commands[0]->next_ = commands[2];
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(1, commands[2]->count_);
+  commands[0]->next_ = nullptr;
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  for (auto c : commands) {
+    CPPUNIT_ASSERT_EQUAL(1, c->count_);
+  }
+  // commands[1] activates commands[0] which was already executed in
+  // this iteration.  commands[0] is executed in the next iteration.
+  commands[1]->next_ = commands[0];
+  commands[1]->setStatusActive();
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(1, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+  commands[1]->next_ = nullptr;
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(2, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+}
+
+void DownloadEngineTest::testRun_wakeup()
+{
+  auto commands = addCommands(e_.get(), 3);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  e_->addWakeup(commands[1], std::chrono::milliseconds(10));
+  // The earlier wakeup is kept.
+  e_->addWakeup(commands[1], 10_s);
+  Timer timer;
+  // The engine waits for the wakeup instead of the refresh interval.
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT(timer.difference() < std::chrono::milliseconds(500));
+  CPPUNIT_ASSERT_EQUAL(1, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+  CPPUNIT_ASSERT_EQUAL(1, commands[2]->count_);
+  // The command schedules the wakeup while it is executed.
+  commands[2]->wakeup_ = true;
+  commands[2]->setStatusActive();
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(2, commands[2]->count_);
+  commands[2]->wakeup_ = false;
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(1, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+  CPPUNIT_ASSERT_EQUAL(3, commands[2]->count_);
+}
+
+void DownloadEngineTest::testRun_refresh()
+{
+  auto commands = addCommands(e_.get(), 3);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  Timer timer;
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  commands[0]->setStatusActive();
+  e_->setNoWait(true);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(2, commands[0]->count_);
+  // The commands which have not been executed for the refresh
+  // interval are executed, without a pass over all commands.
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT(timer.difference() >= std::chrono::milliseconds(900));
+  CPPUNIT_ASSERT_EQUAL(2, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[2]->count_);
+  CPPUNIT_ASSERT_EQUAL(1, e_->run(true));
+  CPPUNIT_ASSERT_EQUAL(3, commands[0]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[1]->count_);
+  CPPUNIT_ASSERT_EQUAL(2, commands[2]->count_);
+}
+
+} // namespace aria2
@@ -0,0 +1,149 @@
+#include "DownloadShaper.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "RequestGroup.h"
+#include "Option.h"
+#include "GroupId.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+class DownloadShaperTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DownloadShaperTest);
+  CPPUNIT_TEST(testAcquire_unlimited);
+  CPPUNIT_TEST(testAcquire_ceil);
+  CPPUNIT_TEST(testAcquire_overallLimit);
+  CPPUNIT_TEST(testAcquire_borrow);
+  CPPUNIT_TEST(testAcquire_priority);
+  CPPUNIT_TEST(testRelease);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<Option> option_;
+  std::unique_ptr<RequestGroup> rg1_;
+  std::unique_ptr<RequestGroup> rg2_;
+  std::unique_ptr<RequestGroup> rg3_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    rg1_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    rg2_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    rg3_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    global::wallclock().reset(1_s);
+  }
+
+  void tearDown() { global::wallclock().reset(); }
+
+  void testAcquire_unlimited();
+  void testAcquire_ceil();
+  void testAcquire_overallLimit();
+  void testAcquire_borrow();
+  void testAcquire_priority();
+  void testRelease();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadShaperTest);
+
+void DownloadShaperTest::testAcquire_unlimited()
+{
+  DownloadShaper shaper;
+  CPPUNIT_ASSERT(!shaper.isLimited(rg1_.get()));
+  CPPUNIT_ASSERT(shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)16_k, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT(shaper.getClasses().empty());
+}
+
+void DownloadShaperTest::testAcquire_ceil()
+{
+  DownloadShaper shaper;
+  rg1_->setMaxDownloadSpeedLimit(10000);
+  CPPUNIT_ASSERT(shaper.isLimited(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)2000, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT(!shaper.canDownload(rg1_.get()));
+  // The other group is not affected.
+  CPPUNIT_ASSERT_EQUAL((size_t)16_k, shaper.acquire(rg2_.get(), 16_k));
+
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT(shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)1000, shaper.acquire(rg1_.get(), 16_k));
+}
+
+void DownloadShaperTest::testAcquire_overallLimit()
+{
+  DownloadShaper shaper(20000);
+  // No quota is given until the next tick.
+  CPPUNIT_ASSERT(!shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, shaper.acquire(rg2_.get(), 16_k));
+
+  // 4000 tokens are shared by the 2 active groups.
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)2000, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)2000, shaper.acquire(rg2_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((int64_t)2000,
+                       shaper.getClasses().at(rg1_->getGID()).grantedLength);
+
+  // 2000 tokens are added in a tick.  If rg1_ becomes idle, rg2_
+  // gets all of them and the quota rg1_ left unused.
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)1000, shaper.acquire(rg2_.get(), 16_k));
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)3000, shaper.acquire(rg2_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, shaper.getClasses().size());
+  // The quota is not returned twice.
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)2000, shaper.acquire(rg2_.get(), 16_k));
+}
+
+void DownloadShaperTest::testAcquire_borrow()
+{
+  DownloadShaper shaper(15000);
+  // rg1_ can use only 200 bytes of its share of 1000.
+  rg1_->setMaxDownloadSpeedLimit(1000);
+  CPPUNIT_ASSERT(!shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT(!shaper.canDownload(rg2_.get()));
+  CPPUNIT_ASSERT(!shaper.canDownload(rg3_.get()));
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)200, shaper.acquire(rg1_.get(), 16_k));
+  // The remaining 800 bytes are lent to rg2_ and rg3_.
+  CPPUNIT_ASSERT_EQUAL((size_t)1400, shaper.acquire(rg2_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)1400, shaper.acquire(rg3_.get(), 16_k));
+  auto& classes = shaper.getClasses();
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, classes.at(rg1_->getGID()).borrowedLength);
+  CPPUNIT_ASSERT_EQUAL((int64_t)400,
+                       classes.at(rg2_->getGID()).borrowedLength);
+}
+
+void DownloadShaperTest::testAcquire_priority()
+{
+  DownloadShaper shaper(15000);
+  rg1_->setMaxDownloadSpeedLimit(1000);
+  rg3_->setDownloadPriority(1);
+  CPPUNIT_ASSERT(!shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT(!shaper.canDownload(rg2_.get()));
+  CPPUNIT_ASSERT(!shaper.canDownload(rg3_.get()));
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)200, shaper.acquire(rg1_.get(), 16_k));
+  // rg3_ borrows first.
+  CPPUNIT_ASSERT_EQUAL((size_t)1000, shaper.acquire(rg2_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)1800, shaper.acquire(rg3_.get(), 16_k));
+}
+
+void DownloadShaperTest::testRelease()
+{
+  DownloadShaper shaper(20000);
+  CPPUNIT_ASSERT(!shaper.canDownload(rg1_.get()));
+  global::wallclock().advance(DownloadShaper::TICK);
+  CPPUNIT_ASSERT_EQUAL((size_t)4000, shaper.acquire(rg1_.get(), 16_k));
+  shaper.release(rg1_.get(), 500);
+  CPPUNIT_ASSERT(shaper.canDownload(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)500, shaper.acquire(rg1_.get(), 16_k));
+  CPPUNIT_ASSERT_EQUAL((int64_t)4000,
+                       shaper.getClasses().at(rg1_->getGID()).grantedLength);
+}
+
+} // namespace aria2
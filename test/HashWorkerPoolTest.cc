@@ -0,0 +1,195 @@
+#include "HashWorkerPool.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+
+#include "MessageDigest.h"
+#include "DlAbortEx.h"
+#include "FileRegion.h"
+#include "util.h"
+#include "a2functional.h"
+#include "a2io.h"
+
+namespace aria2 {
+
+class HashWorkerPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HashWorkerPoolTest);
+  CPPUNIT_TEST(testSubmit);
+  CPPUNIT_TEST(testCancel);
+  CPPUNIT_TEST(testReadRegions);
+  CPPUNIT_TEST(testCompletionFd);
+  CPPUNIT_TEST(testHashJobGroup_unsupported);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testSubmit();
+  void testCancel();
+  void testReadRegions();
+  void testCompletionFd();
+  void testHashJobGroup_unsupported();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HashWorkerPoolTest);
+
+namespace {
+std::unique_ptr<HashJob> createJob(size_t index, const std::string& s)
+{
+  auto job = make_unique<HashJob>();
+  job->index = index;
+  job->length = s.size();
+  job->data = make_unique<unsigned char[]>(s.size());
+  memcpy(job->data.get(), s.data(), s.size());
+  return job;
+}
+} // namespace
+
+void HashWorkerPoolTest::testSubmit()
+{
+  HashWorkerPool pool(3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.getNumThreads());
+  auto sha1 = std::make_shared<HashJobGroup>("sha-1");
+  auto md5 = std::make_shared<HashJobGroup>("md5");
+  for (size_t i = 0; i < 10; ++i) {
+    pool.submit(sha1, createJob(i, std::string(i * 1000, 'a')));
+  }
+  pool.submit(md5, createJob(100, "aria2"));
+
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  while (jobs.size() < 10) {
+    pool.collect(*sha1, jobs, std::chrono::milliseconds(100));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countPending(*sha1));
+  std::sort(std::begin(jobs), std::end(jobs),
+            [](const std::unique_ptr<HashJob>& lhs,
+               const std::unique_ptr<HashJob>& rhs) {
+              return lhs->index < rhs->index;
+            });
+  auto ctx = MessageDigest::sha1();
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL(i, jobs[i]->index);
+    ctx->reset();
+    ctx->update(std::string(i * 1000, 'a').data(), i * 1000);
+    CPPUNIT_ASSERT_EQUAL(util::toHex(ctx->digest()),
+                         util::toHex(jobs[i]->digest));
+  }
+
+  jobs.clear();
+  while (jobs.empty()) {
+    pool.collect(*md5, jobs, std::chrono::milliseconds(100));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)100, jobs[0]->index);
+  CPPUNIT_ASSERT_EQUAL(std::string("2c90cadbef42945f0dcff2b959977ff8"),
+                       util::toHex(jobs[0]->digest));
+}
+
+void HashWorkerPoolTest::testCancel()
+{
+  HashWorkerPool pool(1);
+  auto group = std::make_shared<HashJobGroup>("sha-1");
+  for (size_t i = 0; i < 100; ++i) {
+    pool.submit(group, createJob(i, std::string(1_m, 'a')));
+  }
+  pool.cancel(*group);
+  // Only the job being hashed remains.
+  CPPUNIT_ASSERT(pool.countPending(*group) <= 1);
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  pool.collect(*group, jobs, std::chrono::milliseconds(100));
+  CPPUNIT_ASSERT(jobs.empty());
+}
+
+void HashWorkerPoolTest::testReadRegions()
+{
+#ifdef HAVE_PREAD
+  std::string path =
+      A2_TEST_OUT_DIR "/aria2_HashWorkerPoolTest_testReadRegions";
+  {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << "aria2";
+  }
+  HashWorkerPool pool(1);
+  auto group = std::make_shared<HashJobGroup>("sha-1");
+  // The first half is given, and the second half is read from the
+  // file by the worker thread.
+  auto job = createJob(0, "aria2aria2");
+  memset(job->data.get() + 5, 0, 5);
+  job->reads.emplace_back(open(path.c_str(), O_RDONLY), 0, 5, 5);
+  job->dropCache = true;
+  pool.submit(group, std::move(job));
+  // The region is beyond the end of the file.
+  job = createJob(1, "aria2");
+  job->reads.emplace_back(open(path.c_str(), O_RDONLY), 3, 5, 0);
+  pool.submit(group, std::move(job));
+
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  while (jobs.size() < 2) {
+    pool.collect(*group, jobs, std::chrono::milliseconds(100));
+  }
+  std::sort(std::begin(jobs), std::end(jobs),
+            [](const std::unique_ptr<HashJob>& lhs,
+               const std::unique_ptr<HashJob>& rhs) {
+              return lhs->index < rhs->index;
+            });
+  CPPUNIT_ASSERT_EQUAL(0, jobs[0]->readError);
+  CPPUNIT_ASSERT(jobs[0]->reads.empty());
+  auto ctx = MessageDigest::sha1();
+  ctx->update("aria2aria2", 10);
+  CPPUNIT_ASSERT_EQUAL(util::toHex(ctx->digest()),
+                       util::toHex(jobs[0]->digest));
+  CPPUNIT_ASSERT_EQUAL(-1, jobs[1]->readError);
+  CPPUNIT_ASSERT_EQUAL(std::string("data is too short"),
+                       jobs[1]->getReadErrorString());
+  CPPUNIT_ASSERT(jobs[1]->digest.empty());
+#endif // HAVE_PREAD
+}
+
+#ifndef __MINGW32__
+namespace {
+bool readable(int fd, int timeout)
+{
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  return poll(&pfd, 1, timeout) == 1;
+}
+} // namespace
+#endif // !__MINGW32__
+
+void HashWorkerPoolTest::testCompletionFd()
+{
+#ifndef __MINGW32__
+  HashWorkerPool pool(2);
+  auto group = std::make_shared<HashJobGroup>("sha-1");
+  int fd = group->getCompletionFd();
+  CPPUNIT_ASSERT(fd != -1);
+  CPPUNIT_ASSERT(!readable(fd, 0));
+  pool.submit(group, createJob(0, "aria2"));
+  pool.submit(group, createJob(1, "aria2"));
+  std::vector<std::unique_ptr<HashJob>> jobs;
+  while (jobs.size() < 2) {
+    CPPUNIT_ASSERT(readable(fd, 10000));
+    pool.collect(*group, jobs);
+    // Collecting the jobs makes the fd unreadable until the next job
+    // finishes.
+    if (jobs.size() == 2) {
+      CPPUNIT_ASSERT(!readable(fd, 0));
+    }
+  }
+#endif // !__MINGW32__
+}
+
+void HashWorkerPoolTest::testHashJobGroup_unsupported()
+{
+  try {
+    HashJobGroup group("no-such-hash");
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+    // success
+  }
+}
+
+} // namespace aria2
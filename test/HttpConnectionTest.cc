@@ -0,0 +1,157 @@
+#include "HttpConnection.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpHeader.h"
+#include "Request.h"
+#include "FileEntry.h"
+#include "Piece.h"
+#include "PiecedSegment.h"
+#include "Option.h"
+#include "AuthConfigFactory.h"
+#include "SocketCore.h"
+#include "SocketRecvBuffer.h"
+#include "Range.h"
+#include "prefs.h"
+
+namespace aria2 {
+
+class HttpConnectionTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HttpConnectionTest);
+  CPPUNIT_TEST(testReceiveResponse_pipelining);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<SocketCore> clientSock_;
+  std::shared_ptr<SocketCore> serverSock_;
+  std::unique_ptr<Option> option_;
+  std::unique_ptr<AuthConfigFactory> authConfigFactory_;
+
+public:
+  void setUp()
+  {
+    SocketCore listenSock;
+    listenSock.bind(0);
+    listenSock.beginListen();
+    listenSock.setBlockingMode();
+
+    auto endpoint = listenSock.getAddrInfo();
+    clientSock_ = std::make_shared<SocketCore>();
+    clientSock_->establishConnection("localhost", endpoint.port);
+    clientSock_->setBlockingMode();
+
+    serverSock_ = listenSock.acceptConnection();
+    serverSock_->setBlockingMode();
+    clientSock_->setNonBlockingMode();
+
+    option_ = make_unique<Option>();
+    authConfigFactory_ = make_unique<AuthConfigFactory>();
+  }
+
+  std::unique_ptr<HttpRequest>
+  createHttpRequest(const std::shared_ptr<Request>& req,
+                    const std::shared_ptr<FileEntry>& fileEntry, size_t index)
+  {
+    auto httpRequest = make_unique<HttpRequest>();
+    httpRequest->setRequest(req);
+    httpRequest->setFileEntry(fileEntry);
+    httpRequest->setSegment(
+        std::make_shared<PiecedSegment>(4, std::make_shared<Piece>(index, 4)));
+    httpRequest->setAuthConfigFactory(authConfigFactory_.get());
+    httpRequest->setOption(option_.get());
+    httpRequest->setNoWantDigest(true);
+    return httpRequest;
+  }
+
+  // Reads from serverSock_ until n requests are received.
+  std::string receiveRequests(size_t n)
+  {
+    std::string data;
+    while (true) {
+      size_t count = 0;
+      for (auto i = data.find("\r\n\r\n"); i != std::string::npos;
+           i = data.find("\r\n\r\n", i + 4)) {
+        ++count;
+      }
+      if (count >= n) {
+        return data;
+      }
+      char buf[4096];
+      size_t len = sizeof(buf);
+      serverSock_->readData(buf, len);
+      CPPUNIT_ASSERT(len > 0);
+      data.append(buf, len);
+    }
+  }
+
+  void testReceiveResponse_pipelining();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HttpConnectionTest);
+
+void HttpConnectionTest::testReceiveResponse_pipelining()
+{
+  auto req = std::make_shared<Request>();
+  req->setUri("http://localhost/file");
+  req->supportsPersistentConnection(true);
+  req->setPipeliningHint(true);
+  auto fileEntry = std::make_shared<FileEntry>("file", 8, 0);
+
+  auto socketRecvBuffer = std::make_shared<SocketRecvBuffer>(clientSock_);
+  HttpConnection con(1, clientSock_, socketRecvBuffer);
+  auto first = createHttpRequest(req, fileEntry, 0);
+  auto second = createHttpRequest(req, fileEntry, 1);
+  auto firstSegment = first->getSegment();
+  auto secondSegment = second->getSegment();
+  con.sendRequest(std::move(first));
+  con.sendRequest(std::move(second));
+  CPPUNIT_ASSERT(con.sendBufferIsEmpty());
+  CPPUNIT_ASSERT(con.isIssued(firstSegment));
+  CPPUNIT_ASSERT(con.isIssued(secondSegment));
+
+  // Both requests are sent before any response is received.
+  auto requests = receiveRequests(2);
+  auto firstRange = requests.find("Range: bytes=0-3\r\n");
+  auto secondRange = requests.find("Range: bytes=4-7\r\n");
+  CPPUNIT_ASSERT(firstRange != std::string::npos);
+  CPPUNIT_ASSERT(secondRange != std::string::npos);
+  CPPUNIT_ASSERT(firstRange < secondRange);
+
+  // The server sends both responses at once.
+  std::string responses = "HTTP/1.1 206 Partial Content\r\n"
+                          "Content-Range: bytes 0-3/8\r\n"
+                          "Content-Length: 4\r\n"
+                          "\r\n"
+                          "abcd"
+                          "HTTP/1.1 206 Partial Content\r\n"
+                          "Content-Range: bytes 4-7/8\r\n"
+                          "Content-Length: 4\r\n"
+                          "\r\n"
+                          "efgh";
+  serverSock_->writeData(responses);
+
+  std::unique_ptr<HttpResponse> res;
+  while (!(res = con.receiveResponse())) {
+    CPPUNIT_ASSERT(clientSock_->wantRead());
+  }
+  CPPUNIT_ASSERT_EQUAL(firstSegment, res->getHttpRequest()->getSegment());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, res->getHttpHeader()->getRange().startByte);
+  CPPUNIT_ASSERT(!con.isIssued(firstSegment));
+  CPPUNIT_ASSERT_EQUAL(std::string("abcd"),
+                       std::string(socketRecvBuffer->getBuffer(),
+                                   socketRecvBuffer->getBuffer() + 4));
+  socketRecvBuffer->drain(4);
+
+  // The second response was already buffered.
+  res = con.receiveResponse();
+  CPPUNIT_ASSERT(res);
+  CPPUNIT_ASSERT_EQUAL(secondSegment, res->getHttpRequest()->getSegment());
+  CPPUNIT_ASSERT_EQUAL((int64_t)4, res->getHttpHeader()->getRange().startByte);
+  CPPUNIT_ASSERT_EQUAL(std::string("efgh"),
+                       std::string(socketRecvBuffer->getBuffer(),
+                                   socketRecvBuffer->getBuffer() + 4));
+}
+
+} // namespace aria2
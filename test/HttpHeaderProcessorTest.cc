@@ -1,12 +1,15 @@
 #include "HttpHeaderProcessor.h"
 
 #include <iostream>
+#include <random>
 
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "HttpHeader.h"
 #include "DlRetryEx.h"
 #include "DlAbortEx.h"
+#include "LegacyHttpHeaderProcessor.h"
+#include "util.h"
 
 namespace aria2 {
 
@@ -26,6 +29,8 @@ class HttpHeaderProcessorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testBeyondLimit);
   CPPUNIT_TEST(testGetHeaderString);
   CPPUNIT_TEST(testGetHttpRequestHeader);
+  CPPUNIT_TEST(testParse_split);
+  CPPUNIT_TEST(testParse_legacy);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -42,6 +47,8 @@ public:
   void testBeyondLimit();
   void testGetHeaderString();
   void testGetHttpRequestHeader();
+  void testParse_split();
+  void testParse_legacy();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HttpHeaderProcessorTest);
@@ -295,4 +302,207 @@ void HttpHeaderProcessorTest::testGetHttpRequestHeader()
   CPPUNIT_ASSERT(!httpHeader->defined(HttpHeader::CONTENT_ENCODING));
 }
 
+namespace {
+void assertSameHeader(const HttpHeader& expected, const HttpHeader& actual)
+{
+  CPPUNIT_ASSERT_EQUAL(expected.getStatusCode(), actual.getStatusCode());
+  CPPUNIT_ASSERT_EQUAL(expected.getReasonPhrase(), actual.getReasonPhrase());
+  CPPUNIT_ASSERT_EQUAL(expected.getVersion(), actual.getVersion());
+  CPPUNIT_ASSERT_EQUAL(expected.getMethod(), actual.getMethod());
+  CPPUNIT_ASSERT_EQUAL(expected.getRequestPath(), actual.getRequestPath());
+  for (int i = 0; i < HttpHeader::MAX_INTERESTING_HEADER; ++i) {
+    CPPUNIT_ASSERT(expected.findAll(i) == actual.findAll(i));
+  }
+}
+} // namespace
+
+void HttpHeaderProcessorTest::testParse_split()
+{
+  std::string hd = "HTTP/1.1 206 Partial Content\r\n"
+                   "Date: Mon, 25 Jun 2007 16:04:59 GMT\r\n"
+                   "CONTENT-length: 9187 \r\n"
+                   "Content-Range: bytes 0-9186/9187\r\n"
+                   "X-Unknown:\r\n"
+                   "Link: <http://example.org/1>;\r\n"
+                   "  rel=duplicate\r\n"
+                   "set-cookie: a=b\n"
+                   "Set-Cookie: c=d\r\n"
+                   "\r\nputbackme";
+  HttpHeaderProcessor whole(HttpHeaderProcessor::CLIENT_PARSER);
+  CPPUNIT_ASSERT(whole.parse(hd));
+  size_t headerLength = whole.getLastBytesProcessed();
+  auto expected = whole.getResult();
+  CPPUNIT_ASSERT_EQUAL(std::string("9187"),
+                       expected->find(HttpHeader::CONTENT_LENGTH));
+  CPPUNIT_ASSERT_EQUAL(std::string("<http://example.org/1>; rel=duplicate"),
+                       expected->find(HttpHeader::LINK));
+  CPPUNIT_ASSERT_EQUAL((size_t)2,
+                       expected->findAll(HttpHeader::SET_COOKIE).size());
+
+  // Field names and values split at any position are parsed into the
+  // same result.
+  for (size_t i = 1; i < headerLength; ++i) {
+    HttpHeaderProcessor proc(HttpHeaderProcessor::CLIENT_PARSER);
+    CPPUNIT_ASSERT(!proc.parse(hd.substr(0, i)));
+    CPPUNIT_ASSERT_EQUAL(i, proc.getLastBytesProcessed());
+    CPPUNIT_ASSERT(proc.parse(hd.substr(i)));
+    CPPUNIT_ASSERT_EQUAL(headerLength - i, proc.getLastBytesProcessed());
+    CPPUNIT_ASSERT_EQUAL(hd.substr(0, headerLength), proc.getHeaderString());
+    assertSameHeader(*expected, *proc.getResult());
+  }
+
+  HttpHeaderProcessor proc(HttpHeaderProcessor::CLIENT_PARSER);
+  for (size_t i = 0; i < headerLength - 1; ++i) {
+    CPPUNIT_ASSERT(!proc.parse(hd.substr(i, 1)));
+  }
+  CPPUNIT_ASSERT(proc.parse(hd.substr(headerLength - 1)));
+  assertSameHeader(*expected, *proc.getResult());
+}
+
+namespace {
+const char* LEGACY_SEEDS[] = {
+    "HTTP/1.1 206 Partial Content\r\n"
+    "Date: Mon, 25 Jun 2007 16:04:59 GMT\r\n"
+    "content-LENGTH: 9187 \r\n"
+    "Content-Range: bytes 0-9186/9187\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "X-Unknown:\r\n"
+    "Link: <http://example.org/1>;\r\n"
+    "\t rel=duplicate\r\n"
+    "Set-Cookie: a=b; path=/\r\n"
+    "Location: http://example.org/a b\r\n"
+    "\r\nputbackme",
+    "HTTP/1.0 302 Found\n"
+    "location:   /redirect  \n"
+    "Content-Type: text/html; charset=UTF-8\n"
+    "Retry-After: 120\n"
+    "\n",
+    "HTTP/1.1 200\r\n\r\n",
+    "GET /index.html?q=1 HTTP/1.1\r\n"
+    "Host: example.org:8080\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Authorization: Basic Zm9vOmJhcg==\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n",
+};
+} // namespace
+
+namespace {
+// Returns hd with a few random bytes replaced, inserted or erased,
+// the case of letters flipped and segments duplicated.  The result is
+// shorter than 1024 bytes, so that the legacy limit of field names
+// does not apply.
+std::string mutateHeader(std::string hd, std::mt19937& gen)
+{
+  static const char alphabet[] = ":; \t\r\naZ09-";
+  std::uniform_int_distribution<int> opDist(0, 4);
+  std::uniform_int_distribution<size_t> charDist(0, sizeof(alphabet) - 2);
+  std::bernoulli_distribution randomChar(0.5);
+  std::uniform_int_distribution<int> countDist(0, 3);
+  for (int n = countDist(gen); n > 0 && !hd.empty(); --n) {
+    std::uniform_int_distribution<size_t> posDist(0, hd.size() - 1);
+    size_t pos = posDist(gen);
+    // Half of the new bytes are random, the rest are the delimiters
+    // the parser looks for.
+    char c = randomChar(gen) ? gen() : alphabet[charDist(gen)];
+    switch (opDist(gen)) {
+    case 0:
+      hd[pos] = c;
+      break;
+    case 1:
+      hd.insert(pos, 1, c);
+      break;
+    case 2:
+      hd.erase(pos, countDist(gen) + 1);
+      break;
+    case 3:
+      hd[pos] ^= util::isAlpha(hd[pos]) ? 0x20 : 0;
+      break;
+    case 4:
+      hd.insert(posDist(gen), hd.substr(pos, countDist(gen) * 16 + 1));
+      break;
+    }
+  }
+  return hd.substr(0, 1000);
+}
+} // namespace
+
+namespace {
+struct LegacyParseResult {
+  bool done;
+  std::string error;
+  std::vector<size_t> bytesProcessed;
+  std::string headerString;
+  std::unique_ptr<HttpHeader> header;
+};
+} // namespace
+
+namespace {
+template <typename Processor>
+LegacyParseResult parseInChunks(bool server, const std::string& hd,
+                                const std::vector<size_t>& chunks)
+{
+  Processor proc(server ? Processor::SERVER_PARSER : Processor::CLIENT_PARSER);
+  LegacyParseResult res{false};
+  auto data = reinterpret_cast<const unsigned char*>(hd.data());
+  for (auto len : chunks) {
+    try {
+      res.done = proc.parse(data, len);
+    }
+    catch (Exception& e) {
+      res.error = e.what();
+      break;
+    }
+    res.bytesProcessed.push_back(proc.getLastBytesProcessed());
+    if (res.done) {
+      break;
+    }
+    data += len;
+  }
+  res.headerString = proc.getHeaderString();
+  res.header = proc.getResult();
+  return res;
+}
+} // namespace
+
+void HttpHeaderProcessorTest::testParse_legacy()
+{
+  // Differential test against the parser before field names were
+  // looked up in place.  Both get the same random chunks of mutated
+  // headers and must agree on everything they return.
+  std::mt19937 gen(2014);
+  std::uniform_int_distribution<size_t> seedDist(
+      0, sizeof(LEGACY_SEEDS) / sizeof(LEGACY_SEEDS[0]) - 1);
+  std::uniform_int_distribution<size_t> chunkDist(1, 64);
+  for (int n = 0; n < 20000; ++n) {
+    std::string seed = LEGACY_SEEDS[seedDist(gen)];
+    bool server = seed[0] != 'H';
+    auto hd = mutateHeader(seed, gen);
+    // The legacy parser drops the HTTP-version bytes which arrive in
+    // a later call, so the first chunk holds the whole first line.
+    std::vector<size_t> chunks;
+    size_t first = hd.find('\n');
+    size_t rest = hd.size();
+    if (first != std::string::npos) {
+      chunks.push_back(first + 1);
+      rest -= first + 1;
+    }
+    while (rest > 0) {
+      chunks.push_back(std::min(rest, chunkDist(gen)));
+      rest -= chunks.back();
+    }
+    auto expected =
+        parseInChunks<LegacyHttpHeaderProcessor>(server, hd, chunks);
+    auto actual = parseInChunks<HttpHeaderProcessor>(server, hd, chunks);
+    CPPUNIT_ASSERT_MESSAGE(hd + actual.error, expected.error == actual.error);
+    CPPUNIT_ASSERT_MESSAGE(hd, expected.done == actual.done);
+    CPPUNIT_ASSERT_MESSAGE(hd,
+                           expected.bytesProcessed == actual.bytesProcessed);
+    CPPUNIT_ASSERT_MESSAGE(hd, expected.headerString == actual.headerString);
+    if (expected.done) {
+      assertSameHeader(*expected.header, *actual.header);
+    }
+  }
+}
+
 } // namespace aria2
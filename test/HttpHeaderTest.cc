@@ -15,6 +15,7 @@ class HttpHeaderTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testClearField);
   CPPUNIT_TEST(testFieldContains);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testIdInterestingHeader);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -23,6 +24,7 @@ public:
   void testClearField();
   void testFieldContains();
   void testRemove();
+  void testIdInterestingHeader();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(HttpHeaderTest);
@@ -197,4 +199,25 @@ void HttpHeaderTest::testRemove()
   CPPUNIT_ASSERT(h.defined(HttpHeader::CONNECTION));
 }
 
+void HttpHeaderTest::testIdInterestingHeader()
+{
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::CONTENT_LENGTH,
+                       idInterestingHeader("content-length"));
+  std::string name = "Content-LENGTH";
+  CPPUNIT_ASSERT_EQUAL(
+      (int)HttpHeader::CONTENT_LENGTH,
+      idInterestingHeader(name.data(), name.data() + name.size()));
+  name = "Access-Control-Request-Headers";
+  CPPUNIT_ASSERT_EQUAL(
+      (int)HttpHeader::ACCESS_CONTROL_REQUEST_HEADERS,
+      idInterestingHeader(name.data(), name.data() + name.size()));
+  // Prefix of an interesting header name.
+  CPPUNIT_ASSERT_EQUAL((int)HttpHeader::MAX_INTERESTING_HEADER,
+                       idInterestingHeader(name.data(), name.data() + 6));
+  name.append(64, 'x');
+  CPPUNIT_ASSERT_EQUAL(
+      (int)HttpHeader::MAX_INTERESTING_HEADER,
+      idInterestingHeader(name.data(), name.data() + name.size()));
+}
+
 } // namespace aria2
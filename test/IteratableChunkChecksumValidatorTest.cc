@@ -9,6 +9,10 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "PieceSelector.h"
+#include "a2io.h"
+#ifdef HAVE_STD_THREAD
+#include "HashWorkerPool.h"
+#endif // HAVE_STD_THREAD
 
 namespace aria2 {
 
@@ -17,6 +21,9 @@ class IteratableChunkChecksumValidatorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+#ifdef HAVE_STD_THREAD
+  CPPUNIT_TEST(testValidate_hashWorkerPool);
+#endif // HAVE_STD_THREAD
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -27,6 +34,9 @@ public:
 
   void testValidate();
   void testValidate_readError();
+#ifdef HAVE_STD_THREAD
+  void testValidate_hashWorkerPool();
+#endif // HAVE_STD_THREAD
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IteratableChunkChecksumValidatorTest);
@@ -106,4 +116,65 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError()
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+#ifdef HAVE_STD_THREAD
+void IteratableChunkChecksumValidatorTest::testValidate_hashWorkerPool()
+{
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(
+      100, 500, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  std::deque<std::string> hashes(&csArray[0], &csArray[3]);
+  hashes[1] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+  hashes.push_back(fromHex("ffffffffffffffffffffffffffffffffffffffff"));
+  hashes.push_back(fromHex("ffffffffffffffffffffffffffffffffffffffff"));
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+
+  HashWorkerPool pool(2);
+  IteratableChunkChecksumValidator validator(dctx, ps, &pool);
+  validator.init();
+
+  while (!validator.finished()) {
+    validator.validateChunk();
+    CPPUNIT_ASSERT(validator.getCurrentOffset() <= 500);
+#ifndef __MINGW32__
+    // Wait for the worker threads as DownloadEngine does.
+    int fd = validator.getWaitFd();
+    if (fd != -1) {
+      struct pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = POLLIN;
+      CPPUNIT_ASSERT_EQUAL(1, poll(&pfd, 1, 10000));
+    }
+#endif // !__MINGW32__
+  }
+  CPPUNIT_ASSERT_EQUAL((int64_t)500, validator.getCurrentOffset());
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(!ps->hasPiece(3));
+  CPPUNIT_ASSERT(!ps->hasPiece(4));
+
+  // Validation can be restarted while pieces are being hashed.
+  std::shared_ptr<DownloadContext> dctx2(new DownloadContext(
+      100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  dctx2->setPieceHashes("sha-1", &csArray[0], &csArray[3]);
+  ps = std::make_shared<DefaultPieceStorage>(dctx2, &option);
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+  IteratableChunkChecksumValidator validator2(dctx2, ps, &pool);
+  validator2.init();
+  validator2.validateChunk();
+  validator2.init();
+  while (!validator2.finished()) {
+    validator2.validateChunk();
+  }
+  CPPUNIT_ASSERT(ps->downloadFinished());
+}
+#endif // HAVE_STD_THREAD
+
 } // namespace aria2
@@ -10,6 +10,7 @@ class MessageDigestTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(MessageDigestTest);
   CPPUNIT_TEST(testDigest);
+  CPPUNIT_TEST(testDigest_multipleBlocks);
   CPPUNIT_TEST(testSupports);
   CPPUNIT_TEST(testGetDigestLength);
   CPPUNIT_TEST(testIsStronger);
@@ -32,6 +33,7 @@ public:
   }
 
   void testDigest();
+  void testDigest_multipleBlocks();
   void testSupports();
   void testGetDigestLength();
   void testIsStronger();
@@ -72,6 +74,37 @@ void MessageDigestTest::testDigest()
 #endif // HAVE_ZLIB
 }
 
+void MessageDigestTest::testDigest_multipleBlocks()
+{
+  const std::string msg =
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  sha1_->update(msg.data(), msg.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("84983e441c3bd26ebaae4aa1f95129e5e54670f1"),
+                       util::toHex(sha1_->digest()));
+  auto sha256 = MessageDigest::create("sha-256");
+  sha256->update(msg.data(), msg.size());
+  CPPUNIT_ASSERT_EQUAL(
+      std::string(
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+      util::toHex(sha256->digest()));
+
+  // 1,000,000 'a', given in pieces which are not multiple of the
+  // block size.
+  const std::string a(1000, 'a');
+  sha1_->reset();
+  sha256->reset();
+  for (int i = 0; i < 1000; ++i) {
+    sha1_->update(a.data(), a.size());
+    sha256->update(a.data(), a.size());
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+                       util::toHex(sha1_->digest()));
+  CPPUNIT_ASSERT_EQUAL(
+      std::string(
+          "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"),
+      util::toHex(sha256->digest()));
+}
+
 void MessageDigestTest::testSupports()
 {
   CPPUNIT_ASSERT(MessageDigest::supports("md5"));
@@ -57,6 +57,8 @@ public:
 
   virtual bool isUploading() CXX11_OVERRIDE { return uploading; }
 
+  virtual size_t getUploadLength() CXX11_OVERRIDE { return 0; }
+
   void setUploading(bool flag) { this->uploading = flag; }
 
   virtual void doReceivedAction() CXX11_OVERRIDE {}
@@ -4,6 +4,7 @@
 #include "BtMessageDispatcher.h"
 
 #include <algorithm>
+#include <deque>
 
 #include "BtMessage.h"
 #include "Piece.h"
@@ -16,6 +16,7 @@
 #include "BtKeepAliveMessage.h"
 #include "BtHaveAllMessage.h"
 #include "BtHaveNoneMessage.h"
+#include "BtPreparedMessage.h"
 #include "BtRejectMessage.h"
 #include "BtAllowedFastMessage.h"
 #include "BtPortMessage.h"
@@ -125,6 +126,13 @@ public:
     return nullptr;
   }
 
+  virtual std::unique_ptr<BtPreparedMessage>
+  createPreparedMessage(uint8_t id, const char* name,
+                        BufferSlice data) CXX11_OVERRIDE
+  {
+    return nullptr;
+  }
+
   virtual std::unique_ptr<BtRejectMessage>
   createRejectMessage(size_t index, int32_t begin,
                       int32_t length) CXX11_OVERRIDE
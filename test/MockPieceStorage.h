@@ -4,6 +4,7 @@
 #include "PieceStorage.h"
 
 #include <algorithm>
+#include <deque>
 
 #include "BitfieldMan.h"
 #include "FatalException.h"
@@ -94,6 +95,19 @@ public:
     return std::shared_ptr<Piece>(new Piece());
   }
 
+  virtual uint64_t
+  getAdvertisedPieceMessages(std::vector<BufferSlice>& messages,
+                             size_t& numHaves,
+                             uint64_t lastHaveIndex) CXX11_OVERRIDE
+  {
+    throw FATAL_EXCEPTION("Not Implemented!");
+  }
+
+  virtual BufferSlice getBitfieldMessage() CXX11_OVERRIDE
+  {
+    throw FATAL_EXCEPTION("Not Implemented!");
+  }
+
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece() CXX11_OVERRIDE { return false; }
@@ -247,13 +261,6 @@ public:
   {
   }
 
-  virtual uint64_t
-  getAdvertisedPieceIndexes(std::vector<size_t>& indexes, cuid_t myCuid,
-                            uint64_t lastHaveIndex) CXX11_OVERRIDE
-  {
-    throw FATAL_EXCEPTION("Not Implemented!");
-  }
-
   virtual void removeAdvertisedPiece(const Timer& expiry) CXX11_OVERRIDE {}
 
   virtual void markAllPiecesDone() CXX11_OVERRIDE {}
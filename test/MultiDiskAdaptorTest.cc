@@ -13,6 +13,7 @@
 #include "TestUtil.h"
 #include "DiskWriter.h"
 #include "WrDiskCacheEntry.h"
+#include "FileRegion.h"
 
 namespace aria2 {
 
@@ -21,6 +22,7 @@ class MultiDiskAdaptorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(MultiDiskAdaptorTest);
   CPPUNIT_TEST(testWriteData);
   CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testGetFileRegions);
   CPPUNIT_TEST(testCutTrailingGarbage);
   CPPUNIT_TEST(testSize);
   CPPUNIT_TEST(testUtime);
@@ -40,6 +42,7 @@ public:
 
   void testWriteData();
   void testReadData();
+  void testGetFileRegions();
   void testCutTrailingGarbage();
   void testSize();
   void testUtime();
@@ -360,6 +363,40 @@ void MultiDiskAdaptorTest::testReadData()
                        std::string((char*)buf));
 }
 
+void MultiDiskAdaptorTest::testGetFileRegions()
+{
+#ifdef HAVE_PREAD
+  auto entries = std::vector<std::shared_ptr<FileEntry>>{
+      std::make_shared<FileEntry>(A2_TEST_DIR "/file1r.txt", 15, 0),
+      std::make_shared<FileEntry>(A2_TEST_DIR "/file2r.txt", 7, 15),
+      std::make_shared<FileEntry>(A2_TEST_DIR "/file3r.txt", 3, 22)};
+
+  adaptor->setFileEntries(std::begin(entries), std::end(entries));
+  adaptor->enableReadOnly();
+  adaptor->openFile();
+  std::vector<FileRegion> regions;
+  CPPUNIT_ASSERT(adaptor->getFileRegions(regions, 1, 6, 19));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, regions.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)6, regions[0].getOffset());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, regions[0].getLength());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, regions[0].getDataOffset());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, regions[2].getOffset());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, regions[2].getLength());
+  CPPUNIT_ASSERT_EQUAL((size_t)17, regions[2].getDataOffset());
+  unsigned char buf[21] = {'_'};
+  for (auto& r : regions) {
+    CPPUNIT_ASSERT_EQUAL((ssize_t)r.getLength(), r.read(buf, false));
+  }
+  buf[20] = '\0';
+  CPPUNIT_ASSERT_EQUAL(std::string("_7890ABCDEFGHIJKLMNO"),
+                       std::string((char*)buf));
+  // The regions added so far are kept if the range is out of the
+  // files.
+  CPPUNIT_ASSERT(!adaptor->getFileRegions(regions, 0, 20, 10));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, regions.size());
+#endif // HAVE_PREAD
+}
+
 void MultiDiskAdaptorTest::testCutTrailingGarbage()
 {
   std::string dir = A2_TEST_OUT_DIR;
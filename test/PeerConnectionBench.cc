@@ -0,0 +1,161 @@
+// Measures the throughput of one peer connection with and without MSE
+// encryption.  A sending PeerConnection pushes bursts of 16 REQUEST,
+// 8 HAVE and 16 PIECE messages with 16KiB blocks, 256MiB of blocks in
+// total, over a loopback TCP connection, and a receiving
+// PeerConnection reads them back with receiveMessage().  With
+// encryption, both ends run ARC4, so the figure includes one
+// encryption and one decryption of every byte.  The ARC4Encryptor of
+// the configured backend is also timed on its own, encrypting a 1MiB
+// buffer in place.
+#include "PeerConnection.h"
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <memory>
+
+#include "SocketCore.h"
+#include "ARC4Encryptor.h"
+#include "bittorrent_helper.h"
+#include "a2functional.h"
+#include "console.h"
+
+using namespace aria2;
+
+namespace {
+constexpr size_t BLOCK_LENGTH = 16_k;
+constexpr size_t BLOCKS_PER_BURST = 16;
+constexpr size_t HAVES_PER_BURST = 8;
+constexpr int64_t TOTAL_LENGTH = 256_m;
+constexpr size_t ARC4_BUFFER_LENGTH = 1_m;
+constexpr int NUM_ROUNDS = 3;
+} // namespace
+
+namespace {
+std::pair<std::shared_ptr<SocketCore>, std::shared_ptr<SocketCore>>
+createSocketPair()
+{
+  auto sendSock = std::make_shared<SocketCore>();
+  SocketCore serverSock;
+  serverSock.bind(0);
+  serverSock.beginListen();
+  serverSock.setBlockingMode();
+  auto endpoint = serverSock.getAddrInfo();
+  sendSock->establishConnection("localhost", endpoint.port);
+  sendSock->setBlockingMode();
+  std::shared_ptr<SocketCore> recvSock(serverSock.acceptConnection());
+  // Both ends are driven from this thread, so neither may block.
+  sendSock->setNonBlockingMode();
+  recvSock->setNonBlockingMode();
+  return std::make_pair(sendSock, recvSock);
+}
+} // namespace
+
+namespace {
+std::unique_ptr<ARC4Encryptor> createEncryptor()
+{
+  const unsigned char key[] = "0123456789abcdef0123";
+  auto enc = make_unique<ARC4Encryptor>();
+  enc->init(key, sizeof(key) - 1);
+  return enc;
+}
+} // namespace
+
+namespace {
+std::vector<unsigned char> createMessage(size_t payloadLength, uint8_t id)
+{
+  std::vector<unsigned char> msg(4 + payloadLength);
+  bittorrent::createPeerMessageString(msg.data(), msg.size(), payloadLength,
+                                      id);
+  return msg;
+}
+} // namespace
+
+namespace {
+void pushBurst(PeerConnection& con, size_t index)
+{
+  for (size_t i = 0; i < BLOCKS_PER_BURST; ++i) {
+    auto msg = createMessage(13, 6);
+    bittorrent::setIntParam(&msg[5], index);
+    bittorrent::setIntParam(&msg[9], i * BLOCK_LENGTH);
+    bittorrent::setIntParam(&msg[13], BLOCK_LENGTH);
+    con.pushBytes(std::move(msg));
+  }
+  for (size_t i = 0; i < HAVES_PER_BURST; ++i) {
+    auto msg = createMessage(5, 4);
+    bittorrent::setIntParam(&msg[5], index + i);
+    con.pushBytes(std::move(msg));
+  }
+  for (size_t i = 0; i < BLOCKS_PER_BURST; ++i) {
+    auto msg = con.allocateBuffer(13 + BLOCK_LENGTH);
+    bittorrent::createPeerMessageString(msg.data(), 13, 9 + BLOCK_LENGTH, 7);
+    bittorrent::setIntParam(msg.data() + 5, index);
+    bittorrent::setIntParam(msg.data() + 9, i * BLOCK_LENGTH);
+    memset(msg.data() + 13, 'a', BLOCK_LENGTH);
+    con.pushBytes(std::move(msg));
+  }
+}
+} // namespace
+
+namespace {
+// Returns the block throughput in MB/s.
+double benchPeer(bool encryption)
+{
+  auto sockPair = createSocketPair();
+  PeerConnection sender(1, nullptr, sockPair.first);
+  PeerConnection receiver(2, nullptr, sockPair.second);
+  if (encryption) {
+    sender.enableEncryption(createEncryptor(), createEncryptor());
+    receiver.enableEncryption(createEncryptor(), createEncryptor());
+  }
+  constexpr size_t numBursts = TOTAL_LENGTH / BLOCK_LENGTH / BLOCKS_PER_BURST;
+  constexpr size_t messagesPerBurst = 2 * BLOCKS_PER_BURST + HAVES_PER_BURST;
+  size_t received = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < numBursts; ++i) {
+    pushBurst(sender, i);
+    size_t expected = (i + 1) * messagesPerBurst;
+    while (received < expected) {
+      if (!sender.sendBufferIsEmpty()) {
+        sender.sendPendingData();
+      }
+      size_t len;
+      while (receiver.receiveMessage(nullptr, len)) {
+        ++received;
+      }
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return TOTAL_LENGTH / std::chrono::duration<double>(t1 - t0).count() / 1e6;
+}
+} // namespace
+
+namespace {
+// Returns the throughput of ARC4Encryptor::encrypt() in MB/s.
+double benchArc4()
+{
+  std::vector<unsigned char> buf(ARC4_BUFFER_LENGTH);
+  auto enc = createEncryptor();
+  constexpr size_t numBuffers = TOTAL_LENGTH / ARC4_BUFFER_LENGTH;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < numBuffers; ++i) {
+    enc->encrypt(buf.size(), buf.data(), buf.data());
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  return TOTAL_LENGTH / std::chrono::duration<double>(t1 - t0).count() / 1e6;
+}
+} // namespace
+
+int main()
+{
+  // PeerConnection logs, and the Logger writes to the console.
+  global::initConsole(true);
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    auto plaintext = benchPeer(false);
+    auto encrypted = benchPeer(true);
+    auto arc4 = benchArc4();
+    printf("plaintext %7.0f MB/s  encrypted %7.0f MB/s  arc4 %7.0f MB/s\n",
+           plaintext, encrypted, arc4);
+  }
+}
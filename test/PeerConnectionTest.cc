@@ -6,6 +6,12 @@
 
 #include "Peer.h"
 #include "SocketCore.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "DefaultDiskWriter.h"
+#include "ARC4Encryptor.h"
+#include "bittorrent_helper.h"
+#include "WrDiskCache.h"
 
 namespace aria2 {
 
@@ -13,10 +19,23 @@ class PeerConnectionTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(PeerConnectionTest);
   CPPUNIT_TEST(testReserveBuffer);
+  CPPUNIT_TEST(testPushDiskData);
+  CPPUNIT_TEST(testPushDiskData_file);
+  CPPUNIT_TEST(testPushBytes_encryption);
+  CPPUNIT_TEST(testReceiveMessage_pieceBlock);
+  CPPUNIT_TEST(testReceiveMessage_readQuota);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testReserveBuffer();
+  void testPushDiskData();
+  void testPushDiskData_file();
+  void testPushBytes_encryption();
+  void testReceiveMessage_pieceBlock();
+  void testReceiveMessage_readQuota();
+
+  void checkPushDiskData(const std::shared_ptr<DiskAdaptor>& adaptor,
+                         const std::string& data);
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PeerConnectionTest);
@@ -36,4 +55,274 @@ void PeerConnectionTest::testReserveBuffer()
   CPPUNIT_ASSERT(memcmp("foo", con.getBuffer(), 3) == 0);
 }
 
+namespace {
+std::pair<std::shared_ptr<SocketCore>, std::shared_ptr<SocketCore>>
+createSocketPair()
+{
+  auto sendSock = std::make_shared<SocketCore>();
+
+  SocketCore serverSock;
+  serverSock.bind(0);
+  serverSock.beginListen();
+  serverSock.setBlockingMode();
+
+  auto endpoint = serverSock.getAddrInfo();
+  sendSock->establishConnection("localhost", endpoint.port);
+  sendSock->setBlockingMode();
+
+  std::shared_ptr<SocketCore> recvSock(serverSock.acceptConnection());
+  recvSock->setBlockingMode();
+
+  return std::make_pair(sendSock, recvSock);
+}
+} // namespace
+
+namespace {
+struct CountingProgressUpdate : public ProgressUpdate {
+  CountingProgressUpdate(size_t* length, bool* complete)
+      : length(length), complete(complete)
+  {
+  }
+  virtual void update(size_t len, bool comp) CXX11_OVERRIDE
+  {
+    *length += len;
+    *complete = comp;
+  }
+  size_t* length;
+  bool* complete;
+};
+} // namespace
+
+namespace {
+std::string createData(size_t length)
+{
+  std::string data;
+  for (size_t i = 0; i < length; ++i) {
+    data += 'a' + i % 26;
+  }
+  return data;
+}
+} // namespace
+
+void PeerConnectionTest::checkPushDiskData(
+    const std::shared_ptr<DiskAdaptor>& adaptor, const std::string& data)
+{
+  auto sockPair = createSocketPair();
+  PeerConnection con(1, std::shared_ptr<Peer>(), sockPair.first);
+  CPPUNIT_ASSERT(!con.canPushDiskData());
+  con.enableSendFile();
+  CPPUNIT_ASSERT(con.canPushDiskData());
+
+  size_t sentLength = 0;
+  bool complete = false;
+  con.pushBytes(std::vector<unsigned char>{'<', '<'});
+  // Skip the first 7 bytes.
+  con.pushDiskData(adaptor, 7, data.size() - 7,
+                   make_unique<CountingProgressUpdate>(&sentLength, &complete));
+  con.pushBytes(std::vector<unsigned char>{'>', '>'});
+  while (!con.sendBufferIsEmpty()) {
+    con.sendPendingData();
+  }
+  CPPUNIT_ASSERT_EQUAL(data.size() - 7, sentLength);
+  CPPUNIT_ASSERT(complete);
+
+  std::string expected = "<<" + data.substr(7) + ">>";
+  std::string received;
+  while (received.size() < expected.size()) {
+    unsigned char buf[4_k];
+    size_t len = sizeof(buf);
+    sockPair.second->readData(buf, len);
+    CPPUNIT_ASSERT(len > 0);
+    received.append(&buf[0], &buf[len]);
+  }
+  CPPUNIT_ASSERT(expected == received);
+}
+
+void PeerConnectionTest::testPushDiskData()
+{
+  // ByteArrayDiskWriter does not support sendFile(), so the data are
+  // sent via temporary buffer.
+  auto data = createData(40000);
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<ByteArrayDiskWriter>();
+  dw->setString(data);
+  adaptor->setDiskWriter(std::move(dw));
+  adaptor->setTotalLength(data.size());
+  checkPushDiskData(adaptor, data);
+}
+
+void PeerConnectionTest::testPushDiskData_file()
+{
+  auto data = createData(40000);
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<DefaultDiskWriter>(
+      A2_TEST_OUT_DIR "/aria2_PeerConnectionTest_pushDiskData");
+  dw->initAndOpenFile();
+  dw->writeData(reinterpret_cast<const unsigned char*>(data.data()),
+                data.size(), 0);
+  adaptor->setDiskWriter(std::move(dw));
+  adaptor->setTotalLength(data.size());
+  checkPushDiskData(adaptor, data);
+}
+
+void PeerConnectionTest::testPushBytes_encryption()
+{
+  const unsigned char key[] = "secret";
+  auto enc = make_unique<ARC4Encryptor>();
+  enc->init(key, sizeof(key));
+  auto dec = make_unique<ARC4Encryptor>();
+  dec->init(key, sizeof(key));
+  ARC4Encryptor peerDec;
+  peerDec.init(key, sizeof(key));
+
+  auto sockPair = createSocketPair();
+  PeerConnection con(1, std::shared_ptr<Peer>(), sockPair.first);
+  con.enableEncryption(std::move(enc), std::move(dec));
+
+  std::string expected;
+  // Small messages are coalesced into a few batches.
+  for (size_t i = 0; i < 500; ++i) {
+    auto data = createData(17);
+    con.pushBytes(std::vector<unsigned char>(std::begin(data), std::end(data)));
+    expected += data;
+  }
+  CPPUNIT_ASSERT(!con.sendBufferIsEmpty());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, con.getBufferEntrySize());
+
+  // Shared data must not be altered.
+  auto data = createData(100);
+  auto shared = BufferSlice::allocate(data.size());
+  memcpy(shared.data(), data.data(), data.size());
+  con.pushBytes(shared);
+  con.pushBytes(shared);
+  expected += data;
+  expected += data;
+  CPPUNIT_ASSERT(memcmp(data.data(), shared.data(), data.size()) == 0);
+
+  size_t sentLength = 0;
+  bool complete = false;
+  data = createData(20000);
+  auto large = BufferSlice::allocate(data.size());
+  memcpy(large.data(), data.data(), data.size());
+  con.pushBytes(std::move(large),
+                make_unique<CountingProgressUpdate>(&sentLength, &complete));
+  expected += data;
+
+  con.pushBytes(std::vector<unsigned char>{'>', '>'});
+  expected += ">>";
+
+  while (!con.sendBufferIsEmpty()) {
+    con.sendPendingData();
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)20000, sentLength);
+  CPPUNIT_ASSERT(complete);
+
+  std::string received;
+  while (received.size() < expected.size()) {
+    unsigned char buf[4_k];
+    size_t len = sizeof(buf);
+    sockPair.second->readData(buf, len);
+    CPPUNIT_ASSERT(len > 0);
+    peerDec.encrypt(len, buf, buf);
+    received.append(&buf[0], &buf[len]);
+  }
+  CPPUNIT_ASSERT(expected == received);
+}
+
+namespace {
+std::string createPieceMessage(size_t index, const std::string& block)
+{
+  unsigned char header[13];
+  bittorrent::createPeerMessageString(header, sizeof(header),
+                                      9 + block.size(), 7);
+  bittorrent::setIntParam(&header[5], index);
+  bittorrent::setIntParam(&header[9], 0);
+  return std::string(&header[0], &header[13]) + block;
+}
+} // namespace
+
+void PeerConnectionTest::testReceiveMessage_pieceBlock()
+{
+  auto sockPair = createSocketPair();
+  PeerConnection con(1, std::shared_ptr<Peer>(), sockPair.second);
+  WrDiskCache dc(1_m);
+  con.enablePieceBlockBuffer(&dc);
+
+  std::string have("\x00\x00\x00\x05\x04\x00\x00\x00\x01", 9);
+  std::vector<std::string> blocks;
+  std::string stream = have;
+  for (size_t i = 0; i < 3; ++i) {
+    blocks.push_back(createData(30000 + i));
+    stream += createPieceMessage(i, blocks.back());
+  }
+  stream += have;
+  sockPair.first->writeData(stream.data(), stream.size());
+
+  size_t dataLength;
+  CPPUNIT_ASSERT(con.receiveMessage(nullptr, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dataLength);
+  CPPUNIT_ASSERT(!con.popPieceBlock());
+
+  for (size_t i = 0; i < 3; ++i) {
+    while (!con.receiveMessage(nullptr, dataLength))
+      ;
+    CPPUNIT_ASSERT_EQUAL(9 + blocks[i].size(), dataLength);
+    auto payload = con.getMsgPayloadBuffer();
+    CPPUNIT_ASSERT_EQUAL((uint8_t)7, payload[0]);
+    CPPUNIT_ASSERT_EQUAL((uint32_t)i, bittorrent::getIntParam(payload, 1));
+    auto block = con.popPieceBlock();
+    // After a PIECE message, only the header of the next PIECE
+    // message is read into the payload buffer.
+    if (i == 2) {
+      CPPUNIT_ASSERT(block);
+      // The buffer is allocated from the write disk cache.
+      CPPUNIT_ASSERT_EQUAL(WrDiskCache::BUFFER_SIZE,
+                           con.getPieceBlockCapacity());
+    }
+    const unsigned char* data = block ? block.get() : payload + 9;
+    CPPUNIT_ASSERT(memcmp(blocks[i].data(), data, blocks[i].size()) == 0);
+  }
+
+  while (!con.receiveMessage(nullptr, dataLength))
+    ;
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dataLength);
+  CPPUNIT_ASSERT(memcmp(have.data() + 4, con.getMsgPayloadBuffer(), 5) == 0);
+}
+
+void PeerConnectionTest::testReceiveMessage_readQuota()
+{
+  auto sockPair = createSocketPair();
+  PeerConnection con(1, std::shared_ptr<Peer>(), sockPair.second);
+  con.enablePieceBlockBuffer(nullptr);
+
+  std::string have("\x00\x00\x00\x05\x04\x00\x00\x00\x01", 9);
+  auto block = createData(30000);
+  auto piece = createPieceMessage(0, block);
+  std::string stream = have + piece;
+  sockPair.first->writeData(stream.data(), stream.size());
+
+  size_t dataLength;
+  con.setReadQuota(have.size());
+  CPPUNIT_ASSERT(con.receiveMessage(nullptr, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dataLength);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, con.getReadQuota());
+  // No more bytes are read without quota.
+  CPPUNIT_ASSERT(!con.receiveMessage(nullptr, dataLength));
+
+  con.setReadQuota(10000);
+  CPPUNIT_ASSERT(!con.receiveMessage(nullptr, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, con.getReadQuota());
+
+  con.setReadQuota(1_m);
+  while (!con.receiveMessage(nullptr, dataLength))
+    ;
+  CPPUNIT_ASSERT_EQUAL(9 + block.size(), dataLength);
+  CPPUNIT_ASSERT_EQUAL((size_t)(1_m - (piece.size() - 10000)),
+                       con.getReadQuota());
+  CPPUNIT_ASSERT_EQUAL(block.size(), con.getPieceBlockCapacity());
+  auto pieceBlock = con.popPieceBlock();
+  CPPUNIT_ASSERT(pieceBlock);
+  CPPUNIT_ASSERT(memcmp(block.data(), pieceBlock.get(), block.size()) == 0);
+}
+
 } // namespace aria2
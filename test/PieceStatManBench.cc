@@ -0,0 +1,109 @@
+// Measures PieceStatMan and RarestPieceSelector with 1M pieces and
+// 500 peers, each of which has a random half of the pieces.  It
+// times the HAVE messages, which update the count of one piece, a
+// peer joining and leaving, which add and subtract a whole bitfield,
+// and RarestPieceSelector::select() for the pieces a random peer has
+// and we miss.  The selection is timed while we miss half of the
+// pieces and while we miss 1% of them.
+#include "PieceStatMan.h"
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <random>
+#include <memory>
+
+#include "RarestPieceSelector.h"
+#include "bitfield.h"
+
+using namespace aria2;
+
+namespace {
+constexpr size_t NUM_PIECES = 1000000;
+constexpr size_t NUM_PEERS = 500;
+constexpr size_t BITFIELD_LENGTH = (NUM_PIECES + 7) / 8;
+constexpr size_t NUM_SELECTS = 20000;
+constexpr size_t NUM_JOINS = 100;
+} // namespace
+
+namespace {
+double micros(std::chrono::steady_clock::duration d, size_t n)
+{
+  return std::chrono::duration<double, std::micro>(d).count() / n;
+}
+} // namespace
+
+namespace {
+void benchSelect(PieceStatMan& psm,
+                 const std::vector<std::vector<unsigned char>>& peers,
+                 double missRatio, std::mt19937& gen)
+{
+  std::bernoulli_distribution miss(missRatio);
+  std::vector<unsigned char> missing(BITFIELD_LENGTH);
+  for (size_t i = 0; i < NUM_PIECES; ++i) {
+    if (miss(gen)) {
+      bitfield::flipBit(missing.data(), BITFIELD_LENGTH, i);
+    }
+  }
+  std::uniform_int_distribution<size_t> peerDist(0, NUM_PEERS - 1);
+  std::uniform_int_distribution<size_t> pieceDist(0, NUM_PIECES - 1);
+  RarestPieceSelector selector(
+      std::shared_ptr<PieceStatMan>(&psm, [](PieceStatMan*) {}));
+  std::vector<unsigned char> candidates(BITFIELD_LENGTH);
+  std::chrono::steady_clock::duration haveTime{}, selectTime{};
+  size_t sink = 0;
+  for (size_t i = 0; i < NUM_SELECTS; ++i) {
+    const auto& peer = peers[peerDist(gen)];
+    for (size_t j = 0; j < BITFIELD_LENGTH; ++j) {
+      candidates[j] = peer[j] & missing[j];
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    psm.addPieceStats(pieceDist(gen));
+    auto t1 = std::chrono::steady_clock::now();
+    size_t index;
+    if (selector.select(index, candidates.data(), NUM_PIECES)) {
+      sink += index;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    haveTime += t1 - t0;
+    selectTime += t2 - t1;
+  }
+  printf("missing=%.0f%% have=%.3fus select=%.3fus (sink=%zu)\n",
+         missRatio * 100, micros(haveTime, NUM_SELECTS),
+         micros(selectTime, NUM_SELECTS), sink);
+}
+} // namespace
+
+int main()
+{
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> byteDist(0, 255);
+  std::vector<std::vector<unsigned char>> peers(NUM_PEERS);
+  for (auto& peer : peers) {
+    peer.resize(BITFIELD_LENGTH);
+    for (auto& c : peer) {
+      c = byteDist(gen);
+    }
+  }
+  PieceStatMan psm(NUM_PIECES, true);
+  auto t0 = std::chrono::steady_clock::now();
+  for (const auto& peer : peers) {
+    psm.addPieceStats(peer.data(), peer.size());
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  printf("pieces=%zu peers=%zu addPieceStats(bitfield)=%.1fms\n",
+         NUM_PIECES, NUM_PEERS, micros(t1 - t0, NUM_PEERS) / 1000);
+
+  // Peers leave and join again.
+  t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < NUM_JOINS; ++i) {
+    const auto& peer = peers[i % NUM_PEERS];
+    psm.subtractPieceStats(peer.data(), peer.size());
+    psm.addPieceStats(peer.data(), peer.size());
+  }
+  t1 = std::chrono::steady_clock::now();
+  printf("leave+join=%.1fms\n", micros(t1 - t0, NUM_JOINS) / 1000);
+
+  benchSelect(psm, peers, 0.5, gen);
+  benchSelect(psm, peers, 0.01, gen);
+}
@@ -11,6 +11,7 @@ class PieceStatManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddPieceStats_bitfield);
   CPPUNIT_TEST(testUpdatePieceStats);
   CPPUNIT_TEST(testSubtractPieceStats);
+  CPPUNIT_TEST(testGetOrder);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -22,6 +23,7 @@ public:
   void testAddPieceStats_bitfield();
   void testUpdatePieceStats();
   void testSubtractPieceStats();
+  void testGetOrder();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PieceStatManTest);
@@ -35,9 +37,10 @@ void PieceStatManTest::testAddPieceStats_index()
     const std::vector<size_t>& order(pieceStatMan.getOrder());
     const std::vector<int>& counts(pieceStatMan.getCounts());
     for (size_t i = 0; i < 10; ++i) {
-      CPPUNIT_ASSERT_EQUAL(i, order[i]);
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    // The piece with the highest count comes last.
+    CPPUNIT_ASSERT_EQUAL((size_t)1, order[9]);
   }
   pieceStatMan.addPieceStats(1);
   {
@@ -126,4 +129,55 @@ void PieceStatManTest::testSubtractPieceStats()
   }
 }
 
+namespace {
+void checkOrder(const PieceStatMan& pieceStatMan)
+{
+  const std::vector<size_t>& order(pieceStatMan.getOrder());
+  const std::vector<int>& counts(pieceStatMan.getCounts());
+  std::vector<bool> seen(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    CPPUNIT_ASSERT(!seen[order[i]]);
+    seen[order[i]] = true;
+    if (i > 0) {
+      CPPUNIT_ASSERT(counts[order[i - 1]] <= counts[order[i]]);
+    }
+  }
+}
+} // namespace
+
+void PieceStatManTest::testGetOrder()
+{
+  PieceStatMan pieceStatMan(10, true);
+  checkOrder(pieceStatMan);
+  const unsigned char bitfield1[] = {0xff, 0xc0};
+  const unsigned char bitfield2[] = {0x0f, 0x40};
+  const unsigned char bitfield3[] = {0x81, 0x80};
+  pieceStatMan.addPieceStats(bitfield1, sizeof(bitfield1));
+  checkOrder(pieceStatMan);
+  pieceStatMan.addPieceStats(bitfield2, sizeof(bitfield2));
+  checkOrder(pieceStatMan);
+  pieceStatMan.addPieceStats(5);
+  pieceStatMan.addPieceStats(5);
+  checkOrder(pieceStatMan);
+  pieceStatMan.updatePieceStats(bitfield3, sizeof(bitfield3), bitfield2);
+  checkOrder(pieceStatMan);
+  pieceStatMan.subtractPieceStats(bitfield1, sizeof(bitfield1));
+  checkOrder(pieceStatMan);
+  // idx: 0, 1, 2, 3, 4, 5, 6, 7, 8, 9
+  // bf1: 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 (subtracted)
+  // bf2: 0, 0, 0, 0, 1, 1, 1, 1, 0, 1 (replaced with bf3)
+  // bf3: 1, 0, 0, 0, 0, 0, 0, 1, 1, 0
+  // idx:                5, 5
+  // ---------------------------------
+  // res: 1, 0, 0, 0, 0, 2, 0, 1, 1, 0
+  const std::vector<size_t>& order(pieceStatMan.getOrder());
+  CPPUNIT_ASSERT_EQUAL((size_t)5, order[9]);
+  CPPUNIT_ASSERT_EQUAL(0, pieceStatMan.getCounts()[order[5]]);
+  CPPUNIT_ASSERT_EQUAL(1, pieceStatMan.getCounts()[order[6]]);
+  pieceStatMan.subtractPieceStats(bitfield3, sizeof(bitfield3));
+  checkOrder(pieceStatMan);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, order[9]);
+  CPPUNIT_ASSERT_EQUAL(0, pieceStatMan.getCounts()[order[8]]);
+}
+
 } // namespace aria2
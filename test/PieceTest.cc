@@ -8,6 +8,8 @@
 #include "DirectDiskAdaptor.h"
 #include "ByteArrayDiskWriter.h"
 #include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "DlAbortEx.h"
 
 namespace aria2 {
 
@@ -17,9 +19,11 @@ class PieceTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCompleteBlock);
   CPPUNIT_TEST(testGetCompletedLength);
   CPPUNIT_TEST(testFlushWrCache);
-  CPPUNIT_TEST(testAppendWrCache);
+  CPPUNIT_TEST(testCopyWrCache);
+  CPPUNIT_TEST(testMoveWrCache);
 
   CPPUNIT_TEST(testGetDigestWithWrCache);
+  CPPUNIT_TEST(testGetDataWithWrCache);
   CPPUNIT_TEST(testUpdateHash);
 
   CPPUNIT_TEST_SUITE_END();
@@ -40,9 +44,11 @@ public:
   void testCompleteBlock();
   void testGetCompletedLength();
   void testFlushWrCache();
-  void testAppendWrCache();
+  void testCopyWrCache();
+  void testMoveWrCache();
 
   void testGetDigestWithWrCache();
+  void testGetDataWithWrCache();
   void testUpdateHash();
 };
 
@@ -74,23 +80,16 @@ void PieceTest::testGetCompletedLength()
 
 void PieceTest::testFlushWrCache()
 {
-  unsigned char* data;
   Piece p(0, 1_k);
   WrDiskCache dc(64);
   p.initWrCache(&dc, adaptor_);
-  data = new unsigned char[3];
-  memcpy(data, "foo", 3);
-  p.updateWrCache(&dc, data, 0, 3, 0);
-  data = new unsigned char[4];
-  memcpy(data, " bar", 4);
-  p.updateWrCache(&dc, data, 0, 4, 3);
+  p.copyWrCache(&dc, 0, reinterpret_cast<const unsigned char*>("foo"), 3, 3);
+  p.copyWrCache(&dc, 3, reinterpret_cast<const unsigned char*>(" bar"), 4, 4);
   p.flushWrCache(&dc);
 
   CPPUNIT_ASSERT_EQUAL(std::string("foo bar"), writer_->getString());
 
-  data = new unsigned char[3];
-  memcpy(data, "foo", 3);
-  p.updateWrCache(&dc, data, 0, 3, 0);
+  p.copyWrCache(&dc, 0, reinterpret_cast<const unsigned char*>("foo"), 3, 3);
   CPPUNIT_ASSERT_EQUAL((size_t)3, dc.getSize());
   p.clearWrCache(&dc);
   CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getSize());
@@ -98,47 +97,116 @@ void PieceTest::testFlushWrCache()
   CPPUNIT_ASSERT(!p.getWrDiskCacheEntry());
 }
 
-void PieceTest::testAppendWrCache()
+void PieceTest::testCopyWrCache()
 {
-  unsigned char* data;
   Piece p(0, 1_k);
   WrDiskCache dc(1_k);
   p.initWrCache(&dc, adaptor_);
-  size_t capacity = 6;
-  data = new unsigned char[capacity];
-  memcpy(data, "foo", 3);
-  p.updateWrCache(&dc, data, 0, 3, capacity, 0);
-  size_t alen = p.appendWrCache(
-      &dc, 3, reinterpret_cast<const unsigned char*>("barbaz"), 6);
-  CPPUNIT_ASSERT_EQUAL((size_t)3, alen);
+  // The buffer of 6 bytes is counted even though only 3 bytes are
+  // cached.
+  p.copyWrCache(&dc, 0, reinterpret_cast<const unsigned char*>("foo"), 3, 6);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, dc.getSize());
+  // Coalesced into the buffer.  The rest is put into a new buffer.
+  p.copyWrCache(&dc, 3, reinterpret_cast<const unsigned char*>("barbaz"), 6,
+                6);
+  CPPUNIT_ASSERT_EQUAL((size_t)2,
+                       p.getWrDiskCacheEntry()->getDataSet().size());
+  CPPUNIT_ASSERT_EQUAL((size_t)9, dc.getSize());
+  p.flushWrCache(&dc);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("foobarbaz"), writer_->getString());
+}
+
+void PieceTest::testMoveWrCache()
+{
+  Piece p(0, 1_k);
+  WrDiskCache dc(1_k);
+  p.initWrCache(&dc, adaptor_);
+  std::unique_ptr<unsigned char[]> data(new unsigned char[3]);
+  memcpy(data.get(), "bar", 3);
+  auto ptr = data.get();
+  p.moveWrCache(&dc, 3, std::move(data), 3, 3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, dc.getSize());
+  CPPUNIT_ASSERT(ptr == (*p.getWrDiskCacheEntry()->getDataSet().begin())->data);
+
+  // Already cached at the same offset.  Just ignored.
+  data.reset(new unsigned char[3]);
+  memcpy(data.get(), "baz", 3);
+  p.moveWrCache(&dc, 3, std::move(data), 3, 3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, dc.getSize());
+
+  data.reset(new unsigned char[3]);
+  memcpy(data.get(), "foo", 3);
+  p.moveWrCache(&dc, 0, std::move(data), 3, 3);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, dc.getSize());
   p.flushWrCache(&dc);
   CPPUNIT_ASSERT_EQUAL(std::string("foobar"), writer_->getString());
+
+  // The buffer has room for the following data, which is copied into
+  // it.
+  data.reset(new unsigned char[8]);
+  memcpy(data.get(), "FOO", 3);
+  p.moveWrCache(&dc, 0, std::move(data), 3, 8);
+  CPPUNIT_ASSERT_EQUAL((size_t)8, dc.getSize());
+  data.reset(new unsigned char[8]);
+  memcpy(data.get(), "BAR", 3);
+  p.moveWrCache(&dc, 3, std::move(data), 3, 8);
+  CPPUNIT_ASSERT_EQUAL((size_t)1,
+                       p.getWrDiskCacheEntry()->getDataSet().size());
+  CPPUNIT_ASSERT_EQUAL((size_t)8, dc.getSize());
+  // Only 2 bytes left in the buffer.
+  data.reset(new unsigned char[8]);
+  memcpy(data.get(), "BAZ", 3);
+  p.moveWrCache(&dc, 6, std::move(data), 3, 8);
+  CPPUNIT_ASSERT_EQUAL((size_t)2,
+                       p.getWrDiskCacheEntry()->getDataSet().size());
+  CPPUNIT_ASSERT_EQUAL((size_t)16, dc.getSize());
+  p.flushWrCache(&dc);
+  CPPUNIT_ASSERT_EQUAL(std::string("FOOBARBAZ"), writer_->getString());
 }
 
 void PieceTest::testGetDigestWithWrCache()
 {
-  unsigned char* data;
   Piece p(0, 26);
   p.setHashType("sha-1");
   WrDiskCache dc(64);
   //                  012345678901234567890123456
   writer_->setString("abcde...ijklmnopq...uvwx.z");
   p.initWrCache(&dc, adaptor_);
-  data = new unsigned char[3];
-  memcpy(data, "fgh", 3);
-  p.updateWrCache(&dc, data, 0, 3, 5);
-  data = new unsigned char[3];
-  memcpy(data, "rst", 3);
-  p.updateWrCache(&dc, data, 0, 3, 17);
-  data = new unsigned char[1];
-  memcpy(data, "y", 1);
-  p.updateWrCache(&dc, data, 0, 1, 24);
+  p.copyWrCache(&dc, 5, reinterpret_cast<const unsigned char*>("fgh"), 3, 3);
+  p.copyWrCache(&dc, 17, reinterpret_cast<const unsigned char*>("rst"), 3, 3);
+  p.copyWrCache(&dc, 24, reinterpret_cast<const unsigned char*>("y"), 1, 1);
 
   CPPUNIT_ASSERT_EQUAL(
       std::string("32d10c7b8cf96570ca04ce37f2a19d84240d3a89"),
       util::toHex(p.getDigestWithWrCache(p.getLength(), adaptor_)));
 }
 
+void PieceTest::testGetDataWithWrCache()
+{
+  Piece p(0, 26);
+  WrDiskCache dc(64);
+  //                  012345678901234567890123456
+  writer_->setString("abcde...ijklmnopq...uvwx.z");
+  p.initWrCache(&dc, adaptor_);
+  p.copyWrCache(&dc, 5, reinterpret_cast<const unsigned char*>("fgh"), 3, 3);
+  p.copyWrCache(&dc, 17, reinterpret_cast<const unsigned char*>("rst"), 3, 3);
+  p.copyWrCache(&dc, 24, reinterpret_cast<const unsigned char*>("y"), 1, 1);
+
+  unsigned char buf[26];
+  p.getDataWithWrCache(buf, p.getLength(), adaptor_);
+  CPPUNIT_ASSERT_EQUAL(std::string("abcdefghijklmnopqrstuvwxyz"),
+                       std::string(&buf[0], &buf[sizeof(buf)]));
+
+  writer_->setString("abcde");
+  try {
+    p.getDataWithWrCache(buf, p.getLength(), adaptor_);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (RecoverableException& e) {
+  }
+}
+
 void PieceTest::testUpdateHash()
 {
   Piece p(0, 16, 2_m);
@@ -77,6 +77,7 @@ class RpcMethodTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testChangePosition);
   CPPUNIT_TEST(testChangePosition_fail);
   CPPUNIT_TEST(testGetSessionInfo);
+  CPPUNIT_TEST(testGetShaperStat);
   CPPUNIT_TEST(testChangeUri);
   CPPUNIT_TEST(testChangeUri_fail);
   CPPUNIT_TEST(testPause);
@@ -147,6 +148,7 @@ public:
   void testChangePosition();
   void testChangePosition_fail();
   void testGetSessionInfo();
+  void testGetShaperStat();
   void testChangeUri();
   void testChangeUri_fail();
   void testPause();
@@ -1284,6 +1286,21 @@ void RpcMethodTest::testGetSessionInfo()
                        getString(downcast<Dict>(res.param), "sessionId"));
 }
 
+void RpcMethodTest::testGetShaperStat()
+{
+  e_->getRequestGroupMan()->setMaxOverallDownloadSpeedLimit(100_k);
+  GetShaperStatRpcMethod m;
+  auto res =
+      m.execute(createReq(GetShaperStatRpcMethod::getMethodName()), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const Dict* resParams = downcast<Dict>(res.param);
+  CPPUNIT_ASSERT_EQUAL(std::string("102400"),
+                       getString(resParams, "downloadLimit"));
+  CPPUNIT_ASSERT_EQUAL(std::string("20480"), getString(resParams, "tokens"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0,
+                       downcast<List>(resParams->get("classes"))->size());
+}
+
 void RpcMethodTest::testPause()
 {
   std::vector<std::string> uris{
@@ -10,6 +10,7 @@
 #include "PieceSelector.h"
 #include "FileEntry.h"
 #include "PeerStat.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -19,10 +20,14 @@ class SegmentManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testNullBitfield);
   CPPUNIT_TEST(testCompleteSegment);
   CPPUNIT_TEST(testGetSegment_sameFileEntry);
+  CPPUNIT_TEST(testGetSegment_consecutive);
+  CPPUNIT_TEST(testGetNextSegment);
   CPPUNIT_TEST(testRegisterPeerStat);
   CPPUNIT_TEST(testCancelAllSegments);
   CPPUNIT_TEST(testGetPeerStat);
   CPPUNIT_TEST(testGetCleanSegmentIfOwnerIsIdle);
+  CPPUNIT_TEST(testGetSegment_splitSlowestSegment);
+  CPPUNIT_TEST(testGetSegment_takeOverSlowestSegment);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -40,15 +45,33 @@ public:
     dctx_.reset(new DownloadContext(pieceLength, totalLength, "aria2.tar.bz2"));
     pieceStorage_.reset(new DefaultPieceStorage(dctx_, option_.get()));
     segmentMan_.reset(new SegmentMan(dctx_, pieceStorage_));
+    global::wallclock().reset(1_s);
+  }
+
+  void tearDown() { global::wallclock().reset(); }
+
+  // Registers PeerStat for |cuid| which downloaded |bytes| in the last
+  // second.  Call global::wallclock().advance(1_s) after registering
+  // all PeerStats.
+  void registerPeerStat(cuid_t cuid, size_t bytes)
+  {
+    auto peerStat = std::make_shared<PeerStat>(cuid);
+    peerStat->downloadStart();
+    peerStat->updateDownload(bytes);
+    segmentMan_->registerPeerStat(peerStat);
   }
 
   void testNullBitfield();
   void testCompleteSegment();
   void testGetSegment_sameFileEntry();
+  void testGetSegment_consecutive();
+  void testGetNextSegment();
   void testRegisterPeerStat();
   void testCancelAllSegments();
   void testGetPeerStat();
   void testGetCleanSegmentIfOwnerIsIdle();
+  void testGetSegment_splitSlowestSegment();
+  void testGetSegment_takeOverSlowestSegment();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SegmentManTest);
@@ -144,6 +167,40 @@ void SegmentManTest::testGetSegment_sameFileEntry()
   CPPUNIT_ASSERT_EQUAL((size_t)3, segments.size());
 }
 
+void SegmentManTest::testGetSegment_consecutive()
+{
+  std::vector<std::shared_ptr<Segment>> segments;
+  segments.push_back(segmentMan_->getSegmentWithIndex(1, 5));
+  segmentMan_->getSegment(segments, 1, dctx_->getPieceLength(),
+                          dctx_->getFirstFileEntry(), 3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, segments.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)6, segments[1]->getIndex());
+  CPPUNIT_ASSERT_EQUAL((size_t)7, segments[2]->getIndex());
+}
+
+void SegmentManTest::testGetNextSegment()
+{
+  size_t minSplitSize = dctx_->getPieceLength();
+  auto segment = segmentMan_->getSegmentWithIndex(1, 10);
+  auto next = segmentMan_->getNextSegment(1, segment, minSplitSize);
+  CPPUNIT_ASSERT(next);
+  CPPUNIT_ASSERT_EQUAL((size_t)11, next->getIndex());
+
+  // The following segment is used by another command.
+  CPPUNIT_ASSERT(segmentMan_->getSegmentWithIndex(2, 12));
+  next = segmentMan_->getNextSegment(1, next, minSplitSize);
+  CPPUNIT_ASSERT(next);
+  CPPUNIT_ASSERT(next->getIndex() != 12);
+  CPPUNIT_ASSERT(next->getIndex() != 10);
+  CPPUNIT_ASSERT(next->getIndex() != 11);
+
+  // The last segment has no following segment.
+  segment = segmentMan_->getSegmentWithIndex(3, 63);
+  next = segmentMan_->getNextSegment(3, segment, minSplitSize);
+  CPPUNIT_ASSERT(next);
+  CPPUNIT_ASSERT(next->getIndex() < 63);
+}
+
 void SegmentManTest::testRegisterPeerStat()
 {
   Option op;
@@ -195,4 +252,46 @@ void SegmentManTest::testGetCleanSegmentIfOwnerIsIdle()
   CPPUNIT_ASSERT(!segmentMan_->getCleanSegmentIfOwnerIsIdle(5, 1));
 }
 
+void SegmentManTest::testGetSegment_splitSlowestSegment()
+{
+  size_t minSplitSize = 64_m;
+  CPPUNIT_ASSERT(segmentMan_->getSegmentWithIndex(1, 0));
+  registerPeerStat(1, 1_m);
+  registerPeerStat(2, 3_m);
+  global::wallclock().advance(1_s);
+
+  // No PeerStat, no speed to compare.
+  CPPUNIT_ASSERT(!segmentMan_->getSegment(3, minSplitSize));
+
+  // CUID#1 downloads 64MiB at 1MiB/s.  CUID#2, 3 times faster, leaves
+  // 16MiB to CUID#1.
+  auto segment = segmentMan_->getSegment(2, minSplitSize);
+  CPPUNIT_ASSERT(segment);
+  CPPUNIT_ASSERT_EQUAL((size_t)16, segment->getIndex());
+}
+
+void SegmentManTest::testGetSegment_takeOverSlowestSegment()
+{
+  size_t minSplitSize = 1_m;
+  pieceStorage_->markPiecesDone(63_m);
+  auto segment = segmentMan_->getSegmentWithIndex(1, 63);
+  CPPUNIT_ASSERT(segment);
+  segment->updateWrittenLength(512_k);
+  registerPeerStat(1, 64_k);
+  registerPeerStat(2, 1_m);
+  registerPeerStat(3, 100_k);
+  global::wallclock().advance(1_s);
+
+  // CUID#3 is not fast enough to take over the segment.
+  CPPUNIT_ASSERT(!segmentMan_->getSegment(3, minSplitSize));
+
+  auto next = segmentMan_->getSegment(2, minSplitSize);
+  CPPUNIT_ASSERT(next);
+  CPPUNIT_ASSERT_EQUAL((size_t)63, next->getIndex());
+  CPPUNIT_ASSERT_EQUAL((int64_t)512_k, next->getWrittenLength());
+  std::vector<std::shared_ptr<Segment>> segments;
+  segmentMan_->getInFlightSegment(segments, 1);
+  CPPUNIT_ASSERT(segments.empty());
+}
+
 } // namespace aria2
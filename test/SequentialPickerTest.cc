@@ -10,10 +10,12 @@ class SequentialPickerTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SequentialPickerTest);
   CPPUNIT_TEST(testPick);
+  CPPUNIT_TEST(testPick_maxPicked);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testPick();
+  void testPick_maxPicked();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SequentialPickerTest);
@@ -32,12 +34,13 @@ void SequentialPickerTest::testPick()
   CPPUNIT_ASSERT(picker.hasNext());
   CPPUNIT_ASSERT_EQUAL((size_t)2, picker.countEntryInQueue());
 
-  picker.pickNext();
+  auto picked = picker.pickNext();
 
   CPPUNIT_ASSERT(picker.isPicked());
   CPPUNIT_ASSERT_EQUAL(1, *picker.getPickedEntry());
+  CPPUNIT_ASSERT(!picker.canPickNext());
 
-  picker.dropPickedEntry();
+  picker.dropPickedEntry(picked);
 
   CPPUNIT_ASSERT(!picker.isPicked());
   CPPUNIT_ASSERT(picker.hasNext());
@@ -48,4 +51,32 @@ void SequentialPickerTest::testPick()
   CPPUNIT_ASSERT(!picker.hasNext());
 }
 
+void SequentialPickerTest::testPick_maxPicked()
+{
+  SequentialPicker<int> picker;
+  picker.setMaxPicked(2);
+  for (int i = 1; i <= 3; ++i) {
+    picker.pushEntry(make_unique<int>(i));
+  }
+
+  auto first = picker.pickNext();
+  CPPUNIT_ASSERT(picker.canPickNext());
+  auto second = picker.pickNext();
+  CPPUNIT_ASSERT_EQUAL(2, *second);
+  CPPUNIT_ASSERT(!picker.canPickNext());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, picker.countPickedEntry());
+  CPPUNIT_ASSERT_EQUAL(second, picker.findPickedEntry(
+                                   [](const int& ent) { return ent == 2; }));
+  CPPUNIT_ASSERT(!picker.isPicked([](const int& ent) { return ent == 3; }));
+
+  picker.dropPickedEntry(second);
+  CPPUNIT_ASSERT_EQUAL(first, picker.getPickedEntry().get());
+  CPPUNIT_ASSERT(picker.canPickNext());
+  CPPUNIT_ASSERT_EQUAL(3, *picker.pickNext());
+
+  picker.dropPickedEntry(first);
+  CPPUNIT_ASSERT_EQUAL(3, *picker.getPickedEntry());
+  CPPUNIT_ASSERT(!picker.canPickNext());
+}
+
 } // namespace aria2
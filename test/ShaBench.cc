@@ -0,0 +1,79 @@
+// Measures the hashing throughput of each digest algorithm.  A 64MiB
+// buffer is hashed in 16KiB updates, once through crypto::hash (the
+// internal implementation in src/crypto_hash.cc, which this program
+// compiles in) and once through MessageDigest (the configured
+// backend, e.g. OpenSSL).  ShaBench uses the SHA extensions of the
+// CPU when they are available, and ShaBenchPortable is built with
+// CRYPTO_HASH_NO_ACCEL to measure the portable transforms.
+#include "crypto_hash.h"
+
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "MessageDigest.h"
+#include "util.h"
+
+using namespace aria2;
+
+namespace {
+constexpr size_t BUFFER_LENGTH = 64 * 1024 * 1024;
+constexpr size_t UPDATE_LENGTH = 16 * 1024;
+constexpr int NUM_ROUNDS = 3;
+} // namespace
+
+namespace {
+// Returns the best throughput of NUM_ROUNDS runs of f in MB/s.
+template <typename F> double bench(F f)
+{
+  double best = 0;
+  for (int round = 0; round < NUM_ROUNDS; ++round) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    auto secs = std::chrono::duration<double>(t1 - t0).count();
+    best = std::max(best, BUFFER_LENGTH / secs / 1e6);
+  }
+  return best;
+}
+} // namespace
+
+int main()
+{
+  std::vector<unsigned char> buf(BUFFER_LENGTH);
+  std::mt19937 gen(0);
+  for (auto& c : buf) {
+    c = gen();
+  }
+#ifdef CRYPTO_HASH_NO_ACCEL
+  printf("internal: portable transforms\n");
+#else  // !CRYPTO_HASH_NO_ACCEL
+  printf("internal: hardware transforms where the CPU has them\n");
+#endif // !CRYPTO_HASH_NO_ACCEL
+  printf("%-8s %12s %12s\n", "algo", "internal", "MessageDigest");
+  for (auto name : {"md5", "sha-1", "sha-224", "sha-256", "sha-384",
+                    "sha-512"}) {
+    std::string internalDigest, backendDigest;
+    auto internal = bench([&] {
+      auto ctx = crypto::hash::create(name);
+      for (size_t i = 0; i < BUFFER_LENGTH; i += UPDATE_LENGTH) {
+        ctx->update(buf.data() + i, UPDATE_LENGTH);
+      }
+      internalDigest = ctx->finalize();
+    });
+    double backend = 0;
+    if (MessageDigest::supports(name)) {
+      backend = bench([&] {
+        auto ctx = MessageDigest::create(name);
+        for (size_t i = 0; i < BUFFER_LENGTH; i += UPDATE_LENGTH) {
+          ctx->update(buf.data() + i, UPDATE_LENGTH);
+        }
+        backendDigest = ctx->digest();
+      });
+    }
+    printf("%-8s %7.0f MB/s %7.0f MB/s%s\n", name, internal, backend,
+           backend > 0 && internalDigest != backendDigest ? " MISMATCH" : "");
+  }
+}
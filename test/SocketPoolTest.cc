@@ -0,0 +1,209 @@
+#include "SocketPool.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+class SocketPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketPoolTest);
+  CPPUNIT_TEST(testKey);
+  CPPUNIT_TEST(testPutPop);
+  CPPUNIT_TEST(testPop_keys);
+  CPPUNIT_TEST(testPop_closedByPeer);
+  CPPUNIT_TEST(testPut_maxSocketsPerHost);
+  CPPUNIT_TEST(testPut_maxSockets);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<SocketCore> listenSock_;
+  // Server side of the connections created by connect().
+  std::vector<std::shared_ptr<SocketCore>> peers_;
+
+public:
+  void setUp()
+  {
+    listenSock_ = make_unique<SocketCore>();
+    listenSock_->bind(0);
+    listenSock_->beginListen();
+    listenSock_->setBlockingMode();
+    global::wallclock().reset(1_s);
+  }
+
+  void tearDown() { global::wallclock().reset(); }
+
+  // Returns the client side of the new connection.  The server side
+  // is stored in peers_.
+  std::shared_ptr<SocketCore> connect()
+  {
+    auto sock = std::make_shared<SocketCore>();
+    sock->establishConnection("localhost", listenSock_->getAddrInfo().port);
+    sock->setBlockingMode();
+    peers_.push_back(listenSock_->acceptConnection());
+    return sock;
+  }
+
+  void testKey();
+  void testPutPop();
+  void testPop_keys();
+  void testPop_closedByPeer();
+  void testPut_maxSocketsPerHost();
+  void testPut_maxSockets();
+  void testEvict();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketPoolTest);
+
+void SocketPoolTest::testKey()
+{
+  SocketPoolKey key("192.168.0.1", 443, "", "", 0, true);
+  CPPUNIT_ASSERT(key == SocketPoolKey("192.168.0.1", 443, "", "", 0, true));
+  CPPUNIT_ASSERT_EQUAL(
+      key.hash(), SocketPoolKey("192.168.0.1", 443, "", "", 0, true).hash());
+  CPPUNIT_ASSERT(!(key == SocketPoolKey("192.168.0.1", 443, "", "", 0, false)));
+  CPPUNIT_ASSERT(!(key == SocketPoolKey("192.168.0.1", 80, "", "", 0, true)));
+  CPPUNIT_ASSERT(
+      !(key == SocketPoolKey("192.168.0.1", 443, "alice", "", 0, true)));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1(443) TLS"), key.toString());
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("alice%40example@example.org(21)/proxy(8080)"),
+      SocketPoolKey("example.org", 21, "alice@example", "proxy", 8080, false)
+          .toString());
+}
+
+void SocketPoolTest::testPutPop()
+{
+  SocketPool pool;
+  SocketPoolKey key("localhost", 80, "", "", 0, false);
+  auto s1 = connect();
+  auto s2 = connect();
+  pool.put(key, s1, "opt1", 15_s);
+  pool.put(key, s2, "opt2", 15_s);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.size());
+
+  std::string options;
+  // TLS connection is not interchangeable with plain one.
+  CPPUNIT_ASSERT(!pool.pop(options,
+                           SocketPoolKey("localhost", 80, "", "", 0, true)));
+  // The most recently pooled socket is returned first.
+  CPPUNIT_ASSERT_EQUAL(s2, pool.pop(options, key));
+  CPPUNIT_ASSERT_EQUAL(std::string("opt2"), options);
+  CPPUNIT_ASSERT_EQUAL(s1, pool.pop(options, key));
+  CPPUNIT_ASSERT_EQUAL(std::string("opt1"), options);
+  CPPUNIT_ASSERT(!pool.pop(options, key));
+  CPPUNIT_ASSERT(pool.empty());
+
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getNumMisses());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, pool.getNumEvicted());
+}
+
+void SocketPoolTest::testPop_keys()
+{
+  SocketPool pool;
+  auto s = connect();
+  pool.put(SocketPoolKey("192.168.0.2", 80, "", "", 0, false), s, "", 15_s);
+
+  std::vector<SocketPoolKey> keys{
+      SocketPoolKey("192.168.0.1", 80, "", "", 0, false),
+      SocketPoolKey("192.168.0.2", 80, "", "", 0, false)};
+  std::string options;
+  CPPUNIT_ASSERT_EQUAL(s, pool.pop(options, keys));
+  CPPUNIT_ASSERT(!pool.pop(options, keys));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumMisses());
+}
+
+void SocketPoolTest::testPop_closedByPeer()
+{
+  SocketPool pool;
+  SocketPoolKey key("localhost", 80, "", "", 0, false);
+  auto s1 = connect();
+  auto s2 = connect();
+  pool.put(key, s1, "", 15_s);
+  pool.put(key, s2, "", 15_s);
+  peers_[1]->closeConnection();
+
+  std::string options;
+  // s2 is dropped because the peer closed it.
+  CPPUNIT_ASSERT_EQUAL(s1, pool.pop(options, key));
+  CPPUNIT_ASSERT(pool.empty());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumEvicted());
+}
+
+void SocketPoolTest::testPut_maxSocketsPerHost()
+{
+  SocketPool pool(128, 2);
+  SocketPoolKey key1("192.168.0.1", 80, "", "", 0, false);
+  SocketPoolKey key2("192.168.0.2", 80, "", "", 0, false);
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  auto s4 = connect();
+  pool.put(key1, s1, "", 15_s);
+  pool.put(key1, s2, "", 15_s);
+  pool.put(key2, s3, "", 15_s);
+  pool.put(key1, s4, "", 15_s);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.size());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumEvicted());
+
+  std::string options;
+  CPPUNIT_ASSERT_EQUAL(s4, pool.pop(options, key1));
+  CPPUNIT_ASSERT_EQUAL(s2, pool.pop(options, key1));
+  CPPUNIT_ASSERT(!pool.pop(options, key1));
+  CPPUNIT_ASSERT_EQUAL(s3, pool.pop(options, key2));
+}
+
+void SocketPoolTest::testPut_maxSockets()
+{
+  SocketPool pool(2, 16);
+  SocketPoolKey key1("192.168.0.1", 80, "", "", 0, false);
+  SocketPoolKey key2("192.168.0.2", 80, "", "", 0, false);
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  pool.put(key1, s1, "", 15_s);
+  pool.put(key2, s2, "", 15_s);
+  pool.put(key2, s3, "", 15_s);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.size());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, pool.getNumEvicted());
+
+  std::string options;
+  // s1 was the least recently pooled.
+  CPPUNIT_ASSERT(!pool.pop(options, key1));
+  CPPUNIT_ASSERT_EQUAL(s3, pool.pop(options, key2));
+  CPPUNIT_ASSERT_EQUAL(s2, pool.pop(options, key2));
+}
+
+void SocketPoolTest::testEvict()
+{
+  SocketPool pool;
+  SocketPoolKey key1("192.168.0.1", 80, "", "", 0, false);
+  SocketPoolKey key2("192.168.0.2", 80, "", "", 0, false);
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  pool.put(key1, s1, "", 10_s);
+  pool.put(key1, s2, "", 30_s);
+  pool.put(key2, s3, "", 30_s);
+
+  pool.evict();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.size());
+
+  global::wallclock().advance(10_s);
+  peers_[2]->closeConnection();
+  pool.evict();
+  // s1 is timed out and s3 is closed by the peer.
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.size());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, pool.getNumEvicted());
+
+  std::string options;
+  CPPUNIT_ASSERT_EQUAL(s2, pool.pop(options, key1));
+  CPPUNIT_ASSERT(!pool.pop(options, key2));
+}
+
+} // namespace aria2
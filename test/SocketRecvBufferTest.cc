@@ -0,0 +1,129 @@
+#include "SocketRecvBuffer.h"
+
+#include <cstring>
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+
+namespace aria2 {
+
+class SocketRecvBufferTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketRecvBufferTest);
+  CPPUNIT_TEST(testRecv);
+  CPPUNIT_TEST(testRecv_maxLength);
+  CPPUNIT_TEST(testRecv_grow);
+  CPPUNIT_TEST(testRecv_shrink);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<SocketCore> sendSock_;
+  std::shared_ptr<SocketCore> recvSock_;
+
+public:
+  void setUp()
+  {
+    SocketCore serverSock;
+    serverSock.bind(0);
+    serverSock.beginListen();
+    serverSock.setBlockingMode();
+
+    auto endpoint = serverSock.getAddrInfo();
+    sendSock_ = std::make_shared<SocketCore>();
+    sendSock_->establishConnection("localhost", endpoint.port);
+    sendSock_->setBlockingMode();
+
+    recvSock_ = serverSock.acceptConnection();
+    recvSock_->setNonBlockingMode();
+  }
+
+  void testRecv();
+  void testRecv_maxLength();
+  void testRecv_grow();
+  void testRecv_shrink();
+
+  void send(size_t length)
+  {
+    std::string data(length, 'a');
+    CPPUNIT_ASSERT_EQUAL((ssize_t)length,
+                         sendSock_->writeData(data.data(), data.size()));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketRecvBufferTest);
+
+void SocketRecvBufferTest::testRecv()
+{
+  SocketRecvBuffer buf(recvSock_);
+  CPPUNIT_ASSERT(buf.bufferEmpty());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, buf.recv());
+  CPPUNIT_ASSERT(recvSock_->wantRead());
+
+  sendSock_->writeData("hello", 5);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, buf.recv());
+  CPPUNIT_ASSERT_EQUAL((size_t)5, buf.getBufferLength());
+  CPPUNIT_ASSERT(memcmp("hello", buf.getBuffer(), 5) == 0);
+
+  buf.drain(2);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, buf.getBufferLength());
+  CPPUNIT_ASSERT(memcmp("llo", buf.getBuffer(), 3) == 0);
+  buf.drain(3);
+  CPPUNIT_ASSERT(buf.bufferEmpty());
+}
+
+void SocketRecvBufferTest::testRecv_maxLength()
+{
+  SocketRecvBuffer buf(recvSock_);
+  send(100);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, buf.recv(10));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, buf.getBufferLength());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)90, buf.recv());
+  CPPUNIT_ASSERT_EQUAL((size_t)100, buf.getBufferLength());
+}
+
+void SocketRecvBufferTest::testRecv_grow()
+{
+  SocketRecvBuffer buf(recvSock_);
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY, buf.getCapacity());
+  send(SocketRecvBuffer::MIN_CAPACITY * 4);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)SocketRecvBuffer::MIN_CAPACITY, buf.recv());
+  // The buffer is full.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, buf.recv());
+  // The capacity changes only after the buffer becomes empty.
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY, buf.getCapacity());
+  buf.drain(SocketRecvBuffer::MIN_CAPACITY);
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY * 2, buf.getCapacity());
+
+  CPPUNIT_ASSERT_EQUAL((ssize_t)SocketRecvBuffer::MIN_CAPACITY * 2,
+                       buf.recv());
+  buf.truncateBuffer();
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY * 4, buf.getCapacity());
+
+  // Only the remaining data is read, and the capacity is kept.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)SocketRecvBuffer::MIN_CAPACITY, buf.recv());
+  buf.truncateBuffer();
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY * 4, buf.getCapacity());
+}
+
+void SocketRecvBufferTest::testRecv_shrink()
+{
+  SocketRecvBuffer buf(recvSock_);
+  send(SocketRecvBuffer::MIN_CAPACITY);
+  buf.recv();
+  buf.truncateBuffer();
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY * 2, buf.getCapacity());
+
+  for (int i = 0; i < SocketRecvBuffer::SHRINK_THRESHOLD - 1; ++i) {
+    send(100);
+    CPPUNIT_ASSERT_EQUAL((ssize_t)100, buf.recv());
+    buf.truncateBuffer();
+  }
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY * 2, buf.getCapacity());
+  send(100);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)100, buf.recv());
+  buf.truncateBuffer();
+  CPPUNIT_ASSERT_EQUAL(SocketRecvBuffer::MIN_CAPACITY, buf.getCapacity());
+}
+
+} // namespace aria2
@@ -0,0 +1,57 @@
+// Measures the cost of SpeedCalc::update() and
+// SpeedCalc::calculateSpeed() with 10000 peers, each of which owns a
+// SpeedCalc as Peer and PeerStat do.  In every round, each peer
+// receives a 16KiB block, and the wallclock advances 100 milliseconds,
+// so that the slots keep rolling over.  The speed of every peer is
+// calculated once a second, as the choking algorithm and the console
+// readout do.
+#include "SpeedCalc.h"
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+#include "wallclock.h"
+
+using namespace aria2;
+
+namespace {
+constexpr size_t NUM_PEERS = 10000;
+constexpr size_t NUM_ROUNDS = 600;
+} // namespace
+
+int main()
+{
+  global::wallclock().reset(1_s);
+  std::vector<SpeedCalc> calcs(NUM_PEERS);
+  for (auto& calc : calcs) {
+    calc.reset();
+  }
+  std::chrono::steady_clock::duration updateTime{}, readTime{};
+  size_t numUpdates = 0, numReads = 0;
+  int64_t sink = 0;
+  for (size_t round = 0; round < NUM_ROUNDS; ++round) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (auto& calc : calcs) {
+      calc.update(16_k);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    updateTime += t1 - t0;
+    numUpdates += calcs.size();
+    if (round % 10 == 9) {
+      for (auto& calc : calcs) {
+        sink += calc.calculateSpeed();
+      }
+      readTime += std::chrono::steady_clock::now() - t1;
+      numReads += calcs.size();
+    }
+    global::wallclock().advance(100_ms);
+  }
+  printf("peers=%zu update=%.1fns calculateSpeed=%.1fns (sink=%lld)\n",
+         NUM_PEERS,
+         std::chrono::duration<double, std::nano>(updateTime).count() /
+             numUpdates,
+         std::chrono::duration<double, std::nano>(readTime).count() /
+             numReads,
+         static_cast<long long>(sink));
+}
@@ -2,19 +2,33 @@
 #include <string>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+
 namespace aria2 {
 
 class SpeedCalcTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SpeedCalcTest);
   CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testCalculateSpeed);
+  CPPUNIT_TEST(testCalculateSpeed_window);
+  CPPUNIT_TEST(testCalculateSpeed_idle);
+  CPPUNIT_TEST(testCalculateSpeed_partialIdle);
+  CPPUNIT_TEST(testCalculateNewestSpeed);
   CPPUNIT_TEST_SUITE_END();
 
 private:
 public:
-  void setUp() {}
+  void setUp() { global::wallclock().reset(1_s); }
+
+  void tearDown() { global::wallclock().reset(); }
 
   void testUpdate();
+  void testCalculateSpeed();
+  void testCalculateSpeed_window();
+  void testCalculateSpeed_idle();
+  void testCalculateSpeed_partialIdle();
+  void testCalculateNewestSpeed();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SpeedCalcTest);
@@ -25,4 +39,82 @@ void SpeedCalcTest::testUpdate()
   calc.update(1000);
 }
 
+void SpeedCalcTest::testCalculateSpeed()
+{
+  SpeedCalc calc;
+  calc.reset();
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+
+  calc.update(1000);
+  global::wallclock().advance(500_ms);
+  calc.update(1000);
+  CPPUNIT_ASSERT_EQUAL(4000, calc.calculateSpeed());
+
+  global::wallclock().advance(1_s);
+  calc.update(3000);
+  CPPUNIT_ASSERT_EQUAL(3333, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(4000, calc.getMaxSpeed());
+  CPPUNIT_ASSERT_EQUAL(3333, calc.calculateAvgSpeed());
+}
+
+void SpeedCalcTest::testCalculateSpeed_window()
+{
+  SpeedCalc calc;
+  calc.reset();
+  for (int i = 0; i < 12; ++i) {
+    calc.update(1000);
+    global::wallclock().advance(1_s);
+  }
+  global::wallclock().sub(500_ms);
+  // The slots of the first 2 seconds fell out of the window, and the
+  // rest 10000 bytes are transferred in 9.5 seconds.
+  CPPUNIT_ASSERT_EQUAL(1052, calc.calculateSpeed());
+}
+
+void SpeedCalcTest::testCalculateSpeed_idle()
+{
+  SpeedCalc calc;
+  calc.reset();
+  calc.update(1000);
+  global::wallclock().advance(10_s);
+  // The slot is still within the window.
+  CPPUNIT_ASSERT_EQUAL(100, calc.calculateSpeed());
+  global::wallclock().advance(500_ms);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+
+  // The idle period does not count.
+  calc.update(2000);
+  global::wallclock().advance(500_ms);
+  CPPUNIT_ASSERT_EQUAL(4000, calc.calculateSpeed());
+}
+
+void SpeedCalcTest::testCalculateSpeed_partialIdle()
+{
+  SpeedCalc calc;
+  calc.reset();
+  calc.update(1000);
+  global::wallclock().advance(9500_ms);
+  calc.update(1000);
+  global::wallclock().advance(2500_ms);
+  // The first slot fell out of the window.  The speed is measured
+  // from the beginning of the second slot, not from 10 seconds ago.
+  CPPUNIT_ASSERT_EQUAL(400, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(400, calc.calculateNewestSpeed(5));
+}
+
+void SpeedCalcTest::testCalculateNewestSpeed()
+{
+  SpeedCalc calc;
+  calc.reset();
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateNewestSpeed(2));
+  for (int i = 0; i < 12; ++i) {
+    calc.update(1000);
+    global::wallclock().advance(1_s);
+  }
+  global::wallclock().sub(500_ms);
+  CPPUNIT_ASSERT_EQUAL(1333, calc.calculateNewestSpeed(2));
+  CPPUNIT_ASSERT_EQUAL(1052, calc.calculateNewestSpeed(20));
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateNewestSpeed(0));
+}
+
 } // namespace aria2
@@ -0,0 +1,92 @@
+#include "TLSSessionCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TLSSessionCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TLSSessionCacheTest);
+  CPPUNIT_TEST(testPutTake);
+  CPPUNIT_TEST(testPut_maxSessionsPerHost);
+  CPPUNIT_TEST(testPut_maxHosts);
+  CPPUNIT_TEST(testCountHandshake);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testPutTake();
+  void testPut_maxSessionsPerHost();
+  void testPut_maxHosts();
+  void testCountHandshake();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TLSSessionCacheTest);
+
+void TLSSessionCacheTest::testPutTake()
+{
+  TLSSessionCache cache;
+  CPPUNIT_ASSERT_EQUAL(std::string(), cache.take("localhost:443"));
+
+  cache.put("localhost:443", "alpha");
+  cache.put("localhost:443", "bravo");
+  cache.put("localhost:8443", "charlie");
+  // Empty session is ignored.
+  cache.put("localhost:443", "");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countSessions("localhost:443"));
+
+  // The most recent session is taken first.
+  CPPUNIT_ASSERT_EQUAL(std::string("bravo"), cache.take("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("alpha"), cache.take("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string(), cache.take("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("charlie"), cache.take("localhost:8443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.size());
+}
+
+void TLSSessionCacheTest::testPut_maxSessionsPerHost()
+{
+  TLSSessionCache cache(256, 2);
+  cache.put("localhost:443", "alpha");
+  cache.put("localhost:443", "bravo");
+  cache.put("localhost:443", "charlie");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countSessions("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("charlie"), cache.take("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("bravo"), cache.take("localhost:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string(), cache.take("localhost:443"));
+}
+
+void TLSSessionCacheTest::testPut_maxHosts()
+{
+  TLSSessionCache cache(2, 8);
+  cache.put("alpha:443", "a1");
+  cache.put("bravo:443", "b1");
+  cache.put("alpha:443", "a2");
+  // bravo:443 is the least recently used.
+  cache.put("charlie:443", "c1");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countSessions("bravo:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countSessions("alpha:443"));
+
+  // take() also marks the key used.
+  CPPUNIT_ASSERT_EQUAL(std::string("a2"), cache.take("alpha:443"));
+  cache.put("delta:443", "d1");
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countSessions("charlie:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countSessions("alpha:443"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countSessions("delta:443"));
+
+  cache.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.size());
+}
+
+void TLSSessionCacheTest::testCountHandshake()
+{
+  TLSSessionCache cache;
+  cache.countHandshake(false);
+  cache.countHandshake(true);
+  cache.countHandshake(true);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getNumFullHandshakes());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache.getNumResumedHandshakes());
+}
+
+} // namespace aria2
@@ -0,0 +1,133 @@
+#include "TimerWheel.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TimerWheelTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TimerWheelTest);
+  CPPUNIT_TEST(testExpire);
+  CPPUNIT_TEST(testExpire_rounds);
+  CPPUNIT_TEST(testExpire_passed);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testGetTimeout);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testExpire();
+  void testExpire_rounds();
+  void testExpire_passed();
+  void testRemove();
+  void testGetTimeout();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimerWheelTest);
+
+namespace {
+Timer at(int64_t ms) { return Timer(std::chrono::milliseconds(ms)); }
+} // namespace
+
+void TimerWheelTest::testExpire()
+{
+  TimerWheel wheel(std::chrono::milliseconds(10), 8);
+  TimerWheel::Entry e1, e2, e3;
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.expire(at(1000), expired);
+  wheel.add(&e1, at(1025));
+  wheel.add(&e2, at(1010));
+  wheel.add(&e3, at(1020));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, wheel.size());
+  CPPUNIT_ASSERT(e1.isLinked());
+  wheel.expire(at(1019), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e2);
+  CPPUNIT_ASSERT(!e2.isLinked());
+  // The expiry is rounded up to the tick.
+  expired.clear();
+  wheel.expire(at(1029), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e3);
+  expired.clear();
+  wheel.expire(at(1030), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e1);
+  CPPUNIT_ASSERT(wheel.empty());
+}
+
+void TimerWheelTest::testExpire_rounds()
+{
+  TimerWheel wheel(std::chrono::milliseconds(10), 8);
+  TimerWheel::Entry e1, e2;
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.expire(at(1000), expired);
+  // e1 is 2 rounds ahead of e2 in the same slot.
+  wheel.add(&e1, at(1180));
+  wheel.add(&e2, at(1020));
+  wheel.expire(at(1100), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e2);
+  CPPUNIT_ASSERT(e1.isLinked());
+  // More than a round has passed.  Every slot is visited once, and
+  // the entries are returned in the order of expiry.
+  expired.clear();
+  wheel.add(&e2, at(1110));
+  wheel.expire(at(5000), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e2);
+  CPPUNIT_ASSERT(expired[1] == &e1);
+}
+
+void TimerWheelTest::testExpire_passed()
+{
+  TimerWheel wheel(std::chrono::milliseconds(10), 8);
+  TimerWheel::Entry e1;
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.expire(at(1000), expired);
+  // The expiry has passed.  The entry expires in the next call.
+  wheel.add(&e1, at(900));
+  wheel.expire(at(1000), expired);
+  CPPUNIT_ASSERT(expired.empty());
+  wheel.expire(at(1010), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+}
+
+void TimerWheelTest::testRemove()
+{
+  TimerWheel wheel(std::chrono::milliseconds(10), 8);
+  TimerWheel::Entry e1, e2;
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.expire(at(1000), expired);
+  wheel.add(&e1, at(1010));
+  wheel.add(&e2, at(1010));
+  wheel.remove(&e1);
+  CPPUNIT_ASSERT(!e1.isLinked());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.size());
+  // Removing the unlinked entry does nothing.
+  wheel.remove(&e1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.size());
+  wheel.expire(at(1010), expired);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, expired.size());
+  CPPUNIT_ASSERT(expired[0] == &e2);
+}
+
+void TimerWheelTest::testGetTimeout()
+{
+  TimerWheel wheel(std::chrono::milliseconds(10), 8);
+  TimerWheel::Entry e1, e2;
+  std::vector<TimerWheel::Entry*> expired;
+  wheel.expire(at(1000), expired);
+  CPPUNIT_ASSERT_EQUAL(1000, (int)wheel.getTimeout(at(1000), 1_s).count());
+  wheel.add(&e1, at(1035));
+  CPPUNIT_ASSERT_EQUAL(38, (int)wheel.getTimeout(at(1002), 1_s).count());
+  CPPUNIT_ASSERT_EQUAL(20, (int)wheel.getTimeout(at(1002), 20_ms).count());
+  // The slot has come, but expire() has not been called yet.
+  CPPUNIT_ASSERT_EQUAL(0, (int)wheel.getTimeout(at(1045), 1_s).count());
+  // The slot of the entry in the next round comes first at 1040.
+  wheel.remove(&e1);
+  wheel.add(&e2, at(1200));
+  CPPUNIT_ASSERT_EQUAL(40, (int)wheel.getTimeout(at(1000), 1_s).count());
+  CPPUNIT_ASSERT_EQUAL(30, (int)wheel.getTimeout(at(1000), 30_ms).count());
+}
+
+} // namespace aria2
@@ -0,0 +1,88 @@
+#include "TokenBucket.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TokenBucketTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TokenBucketTest);
+  CPPUNIT_TEST(testConsume);
+  CPPUNIT_TEST(testConsume_unlimited);
+  CPPUNIT_TEST(testRefill_lowRate);
+  CPPUNIT_TEST(testSetRate);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testConsume();
+  void testConsume_unlimited();
+  void testRefill_lowRate();
+  void testSetRate();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TokenBucketTest);
+
+void TokenBucketTest::testConsume()
+{
+  TokenBucket bucket(10000);
+  CPPUNIT_ASSERT(bucket.isLimited());
+  CPPUNIT_ASSERT_EQUAL((int64_t)2000, bucket.getBurst());
+  CPPUNIT_ASSERT_EQUAL((int64_t)2000, bucket.getTokens());
+  CPPUNIT_ASSERT(bucket.isFull());
+
+  auto now = Timer::zero();
+  bucket.refill(now);
+  // Data larger than the tokens can be transferred at once.
+  bucket.consume(2500);
+  CPPUNIT_ASSERT_EQUAL((int64_t)-500, bucket.getTokens());
+  CPPUNIT_ASSERT(!bucket.available());
+
+  now.advance(100_ms);
+  bucket.refill(now);
+  CPPUNIT_ASSERT_EQUAL((int64_t)500, bucket.getTokens());
+  CPPUNIT_ASSERT(bucket.available());
+
+  now.advance(10_s);
+  bucket.refill(now);
+  CPPUNIT_ASSERT_EQUAL((int64_t)2000, bucket.getTokens());
+  CPPUNIT_ASSERT(bucket.isFull());
+}
+
+void TokenBucketTest::testConsume_unlimited()
+{
+  TokenBucket bucket;
+  CPPUNIT_ASSERT(!bucket.isLimited());
+  bucket.consume(1_m);
+  CPPUNIT_ASSERT(bucket.available());
+  CPPUNIT_ASSERT(bucket.isFull());
+}
+
+void TokenBucketTest::testRefill_lowRate()
+{
+  TokenBucket bucket(5);
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, bucket.getBurst());
+  auto now = Timer::zero();
+  bucket.refill(now);
+  bucket.consume(1);
+  CPPUNIT_ASSERT(!bucket.available());
+  now.advance(100_ms);
+  bucket.refill(now);
+  CPPUNIT_ASSERT(!bucket.available());
+  // The elapsed time which did not produce a token is not lost.
+  now.advance(100_ms);
+  bucket.refill(now);
+  CPPUNIT_ASSERT(bucket.available());
+}
+
+void TokenBucketTest::testSetRate()
+{
+  TokenBucket bucket(10000);
+  bucket.setRate(1000);
+  CPPUNIT_ASSERT_EQUAL((int64_t)200, bucket.getBurst());
+  CPPUNIT_ASSERT_EQUAL((int64_t)200, bucket.getTokens());
+  bucket.setRate(0);
+  CPPUNIT_ASSERT(!bucket.isLimited());
+  CPPUNIT_ASSERT(bucket.available());
+}
+
+} // namespace aria2
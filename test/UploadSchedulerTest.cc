@@ -0,0 +1,189 @@
+#include "UploadScheduler.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "RequestGroup.h"
+#include "Option.h"
+#include "GroupId.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+class UploadSchedulerTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(UploadSchedulerTest);
+  CPPUNIT_TEST(testAcquire_unlimited);
+  CPPUNIT_TEST(testAcquire_groupLimit);
+  CPPUNIT_TEST(testAcquire_overallLimit);
+  CPPUNIT_TEST(testAcquire_peers);
+  CPPUNIT_TEST(testTick_carryDebt);
+  CPPUNIT_TEST(testTick_removeIdleEntry);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<Option> option_;
+  std::unique_ptr<RequestGroup> rg1_;
+  std::unique_ptr<RequestGroup> rg2_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    rg1_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    rg2_ = make_unique<RequestGroup>(GroupId::create(), option_);
+    global::wallclock().reset(1_s);
+  }
+
+  void tearDown() { global::wallclock().reset(); }
+
+  void testAcquire_unlimited();
+  void testAcquire_groupLimit();
+  void testAcquire_overallLimit();
+  void testAcquire_peers();
+  void testTick_carryDebt();
+  void testTick_removeIdleEntry();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(UploadSchedulerTest);
+
+void UploadSchedulerTest::testAcquire_unlimited()
+{
+  UploadScheduler scheduler;
+  CPPUNIT_ASSERT(!scheduler.isLimited(rg1_.get()));
+  CPPUNIT_ASSERT(scheduler.canUpload(rg1_.get(), 1));
+  for (int i = 0; i < 100; ++i) {
+    CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 16_k));
+  }
+  CPPUNIT_ASSERT(scheduler.canUpload(rg1_.get(), 1));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.getNumEntries());
+}
+
+void UploadSchedulerTest::testAcquire_groupLimit()
+{
+  UploadScheduler scheduler;
+  rg1_->setMaxUploadSpeedLimit(10000);
+  CPPUNIT_ASSERT(scheduler.isLimited(rg1_.get()));
+  // No budget is given until the next tick.
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 2500));
+  CPPUNIT_ASSERT(!scheduler.canUpload(rg1_.get(), 1));
+  // The other group is not affected.
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 2, 16_k));
+
+  // The peer gets the full bucket, and can upload beyond it once.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.canUpload(rg1_.get(), 1));
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 2500));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+
+  // 1000 tokens are added in a tick.  The peer pays the debt of 500
+  // and is left with 500.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 500));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+}
+
+void UploadSchedulerTest::testAcquire_overallLimit()
+{
+  UploadScheduler scheduler(20000);
+  // No budget is given until the next tick.
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1500));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 2, 1500));
+
+  // 4000 tokens are shared by the 2 active groups.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 2500));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 2, 2000));
+  CPPUNIT_ASSERT(!scheduler.canUpload(rg2_.get(), 2));
+
+  // 2000 tokens are added in a tick.  rg1_ pays the debt of 500 and
+  // is left with 500.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 500));
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 2, 1000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 2, 1));
+
+  // rg1_ still gets its share, since it asked for budget in the last
+  // tick.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 2, 1000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 2, 1));
+  // rg1_ becomes idle.  rg2_ gets all tokens and the budget rg1_ left
+  // unused.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 2, 3000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 2, 1));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.getNumEntries());
+}
+
+void UploadSchedulerTest::testAcquire_peers()
+{
+  UploadScheduler scheduler(30000);
+  rg1_->setMaxUploadSpeedLimit(10000);
+  // The 2 peers of rg1_ share its own limit, and the peer of rg2_
+  // gets the rest of the overall limit.
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 2, 1));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 3, 1));
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 1000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 2, 1000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 2, 1));
+  CPPUNIT_ASSERT(scheduler.acquire(rg2_.get(), 3, 3000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg2_.get(), 3, 1));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, scheduler.getNumPeers(rg1_.get()));
+}
+
+void UploadSchedulerTest::testTick_carryDebt()
+{
+  UploadScheduler scheduler(20000);
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 2, 1));
+  global::wallclock().advance(UploadScheduler::TICK);
+  // The peer 1 gets 2000, and owes 14384 after sending 16KiB.
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 16_k));
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 2, 2000));
+  // The peer 1 has nothing to upload in the following ticks, but its
+  // debt is not forgiven: it takes its share of 1000 every tick.
+  for (int i = 0; i < 14; ++i) {
+    global::wallclock().advance(UploadScheduler::TICK);
+    CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 2, 1000));
+    CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 2, 1));
+    CPPUNIT_ASSERT_EQUAL((size_t)2, scheduler.getNumPeers(rg1_.get()));
+  }
+  CPPUNIT_ASSERT(!scheduler.canUpload(rg1_.get(), 1));
+  // The rest of the debt, 384, is paid.
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 2, 1000));
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 2, 1));
+  // The debt is paid, and the idle peer 1 is removed.
+  global::wallclock().advance(UploadScheduler::TICK);
+  scheduler.tick(global::wallclock());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.getNumPeers(rg1_.get()));
+}
+
+void UploadSchedulerTest::testTick_removeIdleEntry()
+{
+  UploadScheduler scheduler;
+  rg1_->setMaxUploadSpeedLimit(10000);
+  CPPUNIT_ASSERT(!scheduler.acquire(rg1_.get(), 1, 1));
+  global::wallclock().advance(UploadScheduler::TICK);
+  CPPUNIT_ASSERT(scheduler.acquire(rg1_.get(), 1, 2500));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.getNumEntries());
+  // Active in the previous tick.  The debt of 500 is paid, and the
+  // peer is given 500.
+  global::wallclock().advance(UploadScheduler::TICK);
+  scheduler.tick(global::wallclock());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.getNumPeers(rg1_.get()));
+  // The idle peer is removed, and its budget is given back to the
+  // bucket, which is not full yet.
+  global::wallclock().advance(UploadScheduler::TICK);
+  scheduler.tick(global::wallclock());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.getNumPeers(rg1_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, scheduler.getNumEntries());
+  global::wallclock().advance(UploadScheduler::TICK);
+  scheduler.tick(global::wallclock());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, scheduler.getNumEntries());
+}
+
+} // namespace aria2
@@ -0,0 +1,226 @@
+#include "UringDiskWriter.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "WrDiskCacheEntry.h"
+#include "DlAbortEx.h"
+#include "a2functional.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class UringDiskWriterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(UringDiskWriterTest);
+  CPPUNIT_TEST(testWriteData);
+  CPPUNIT_TEST(testWriteDataVector);
+  CPPUNIT_TEST(testWriteData_manyWrites);
+  CPPUNIT_TEST(testWriteData_sameRange);
+  CPPUNIT_TEST(testWriteData_error);
+  CPPUNIT_TEST(testWriteDataOwned);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testWriteCache);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::unique_ptr<IOUring> ring_;
+
+public:
+  void setUp() { ring_ = IOUring::create(); }
+
+  void tearDown() { ring_.reset(); }
+
+  void testWriteData();
+  void testWriteDataVector();
+  void testWriteData_manyWrites();
+  void testWriteData_sameRange();
+  void testWriteData_error();
+  void testWriteDataOwned();
+  void testReadData();
+  void testWriteCache();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(UringDiskWriterTest);
+
+void UringDiskWriterTest::testWriteData()
+{
+  if (!ring_) {
+    // io_uring is not available in this environment.
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_write";
+  UringDiskWriter dw(filename, ring_.get());
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 6);
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello "), 6, 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, dw.getNumPendingWrites());
+  ring_->submit();
+  unsigned char buf[11];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, dw.readData(buf, 6, 5));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, dw.getNumPendingWrites());
+  CPPUNIT_ASSERT_EQUAL(std::string(" world"), std::string(&buf[0], &buf[6]));
+  dw.writeData(reinterpret_cast<const unsigned char*>("W"), 1, 6);
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string("hello World"), readFile(filename));
+}
+
+void UringDiskWriterTest::testWriteDataVector()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_vector";
+  UringDiskWriter dw(filename, ring_.get());
+  dw.initAndOpenFile();
+  char s1[] = "hello";
+  char s2[] = " ";
+  char s3[] = "world";
+  a2iovec iov[3];
+  iov[0].A2IOVEC_BASE = s1;
+  iov[0].A2IOVEC_LEN = 5;
+  iov[1].A2IOVEC_BASE = s2;
+  iov[1].A2IOVEC_LEN = 1;
+  iov[2].A2IOVEC_BASE = s3;
+  iov[2].A2IOVEC_LEN = 5;
+  dw.writeDataVector(iov, 3, 2);
+  // The data is copied.  Modifying it does not affect the file.
+  s1[0] = 'j';
+  dw.writeData(reinterpret_cast<const unsigned char*>("ab"), 2, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)13, dw.size());
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string("abhello world"), readFile(filename));
+}
+
+void UringDiskWriterTest::testWriteData_manyWrites()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_many";
+  UringDiskWriter dw(filename, ring_.get());
+  dw.initAndOpenFile();
+  // More writes than the number of io_uring entries.
+  std::string ans;
+  for (int i = 0; i < 1000; ++i) {
+    unsigned char c = 'a' + i % 26;
+    dw.writeData(&c, 1, i);
+    ans += c;
+  }
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(ans, readFile(filename));
+}
+
+void UringDiskWriterTest::testWriteData_sameRange()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_same";
+  UringDiskWriter dw(filename, ring_.get());
+  dw.initAndOpenFile();
+  // Like zero-filled chunk of file allocation followed by the
+  // downloaded data.  The later write must win.
+  std::string zeros(256_k, '\0');
+  std::string data;
+  for (int i = 0; i < 4; ++i) {
+    data.assign(256_k, 'a' + i);
+    dw.writeData(reinterpret_cast<const unsigned char*>(zeros.data()),
+                 zeros.size(), 0);
+    dw.writeData(reinterpret_cast<const unsigned char*>(data.data()),
+                 data.size(), 0);
+    // The second write waits for the first one.
+    CPPUNIT_ASSERT_EQUAL((size_t)1, dw.getNumPendingWrites());
+  }
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(data, readFile(filename));
+}
+
+void UringDiskWriterTest::testWriteData_error()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_error";
+  createFile(filename, 0);
+  UringDiskWriter dw(filename, ring_.get());
+  dw.enableReadOnly();
+  dw.openExistingFile();
+  // The error is reported by the next operation.
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello"), 5, 0);
+  unsigned char buf[5];
+  try {
+    dw.readData(buf, sizeof(buf), 0);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+    CPPUNIT_ASSERT_EQUAL(error_code::FILE_IO_ERROR, e.getErrorCode());
+  }
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 0));
+  dw.closeFile();
+}
+
+void UringDiskWriterTest::testWriteDataOwned()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_owned";
+  UringDiskWriter dw(filename, ring_.get());
+  CPPUNIT_ASSERT(dw.acceptsDataOwnership());
+  dw.initAndOpenFile();
+  auto data = make_unique<unsigned char[]>(8);
+  memcpy(data.get(), "__hello_", 8);
+  dw.writeDataOwned(std::move(data), 2, 5, 0);
+  dw.writeData(reinterpret_cast<const unsigned char*>(" world"), 6, 5);
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"), readFile(filename));
+}
+
+void UringDiskWriterTest::testReadData()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_read";
+  UringDiskWriter dw(filename, ring_.get());
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello"), 5, 0);
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 6);
+  unsigned char buf[16];
+  // The read is ordered after the write to the same range.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)3, dw.readData(buf, 3, 1));
+  CPPUNIT_ASSERT_EQUAL(std::string("ell"), std::string(&buf[0], &buf[3]));
+  // Short read at the end of file.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)2, dw.readData(buf, sizeof(buf), 9));
+  CPPUNIT_ASSERT_EQUAL(std::string("ld"), std::string(&buf[0], &buf[2]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 11));
+  dw.closeFile();
+}
+
+void UringDiskWriterTest::testWriteCache()
+{
+  if (!ring_) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_UringDiskWriterTest_cache";
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<UringDiskWriter>(filename, ring_.get()));
+  adaptor->setTotalLength(7);
+  adaptor->initAndOpenFile();
+  WrDiskCacheEntry cache{adaptor};
+  cache.cacheData(createDataCell(0, "abc"));
+  cache.cacheData(createDataCell(4, "efg"));
+  adaptor->writeCache(&cache);
+  // The buffers were handed to UringDiskWriter without copying.
+  for (auto& d : cache.getDataSet()) {
+    CPPUNIT_ASSERT(!d->data);
+  }
+  cache.clear();
+  adaptor->closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string("abc\0efg", 7), readFile(filename));
+}
+
+} // namespace aria2
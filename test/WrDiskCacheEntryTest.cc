@@ -5,6 +5,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "TestUtil.h"
+#include "WrDiskCache.h"
 #include "DirectDiskAdaptor.h"
 #include "ByteArrayDiskWriter.h"
 
@@ -14,7 +15,8 @@ class WrDiskCacheEntryTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(WrDiskCacheEntryTest);
   CPPUNIT_TEST(testWriteToDisk);
-  CPPUNIT_TEST(testAppend);
+  CPPUNIT_TEST(testCacheData);
+  CPPUNIT_TEST(testCacheData_withDiskCache);
   CPPUNIT_TEST(testClear);
   CPPUNIT_TEST_SUITE_END();
 
@@ -31,7 +33,8 @@ public:
   }
 
   void testWriteToDisk();
-  void testAppend();
+  void testCacheData();
+  void testCacheData_withDiskCache();
   void testClear();
 };
 
@@ -47,25 +50,56 @@ void WrDiskCacheEntryTest::testWriteToDisk()
   CPPUNIT_ASSERT_EQUAL(std::string("01234567890"), writer_->getString());
 }
 
-void WrDiskCacheEntryTest::testAppend()
+void WrDiskCacheEntryTest::testCacheData()
 {
   WrDiskCacheEntry e(adaptor_);
-  auto cell = new WrDiskCacheEntry::DataCell{};
-  cell->goff = 0;
-  size_t capacity = 6;
-  size_t offset = 2;
-  cell->data = new unsigned char[offset + capacity];
-  memcpy(cell->data, "??foo", 3);
-  cell->offset = offset;
-  cell->len = 3;
-  cell->capacity = capacity;
-  e.cacheData(cell);
-  CPPUNIT_ASSERT_EQUAL((size_t)3,
-                       e.append(3, (const unsigned char*)"barbaz", 6));
-  CPPUNIT_ASSERT_EQUAL((size_t)6, cell->len);
-  CPPUNIT_ASSERT_EQUAL((size_t)6, e.getSize());
+  e.cacheData(0, (const unsigned char*)"foo", 3, 8);
+  // Coalesced into the buffer of the first data cell
+  e.cacheData(3, (const unsigned char*)"bar", 3, 5);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, e.getDataSet().size());
+  // The first data cell has only 2 bytes left.  The rest is put into
+  // the new data cell.
+  e.cacheData(6, (const unsigned char*)"bazqux", 6, 6);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, e.getDataSet().size());
+  // The size is the number of bytes of the buffers: 8 + 4.
+  CPPUNIT_ASSERT_EQUAL((size_t)12, e.getSize());
+  e.cacheData(20, (const unsigned char*)"!", 1, 1);
+  e.cacheData(12, (const unsigned char*)"0123", 4, 100);
+  // The data overlapping the data cell at 20 is discarded.
+  CPPUNIT_ASSERT_EQUAL((size_t)4,
+                       e.cacheData(16, (const unsigned char*)"4567?", 5, 100));
+  e.cacheData(21, (const unsigned char*)"?", 1, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, e.getDataSet().size());
+  // The data cell at 12 has the buffer of 100 bytes.
+  CPPUNIT_ASSERT_EQUAL((size_t)114, e.getSize());
+  e.writeToDisk();
+  CPPUNIT_ASSERT_EQUAL(std::string("foobarbazqux01234567!?"),
+                       writer_->getString());
+}
 
-  CPPUNIT_ASSERT_EQUAL((size_t)0, e.append(7, (const unsigned char*)"FOO", 3));
+void WrDiskCacheEntryTest::testCacheData_withDiskCache()
+{
+  WrDiskCache dc(1_m);
+  WrDiskCacheEntry e(adaptor_);
+  dc.add(&e);
+  std::string data(WrDiskCache::BUFFER_SIZE + 1, 'a');
+  // The buffer of BUFFER_SIZE bytes is allocated.
+  e.cacheData(0, (const unsigned char*)data.c_str(), 1_k, 1_m);
+  e.cacheData(1_k, (const unsigned char*)data.c_str() + 1_k, data.size() - 1_k,
+              1_m);
+  dc.update(&e, e.getSize());
+  CPPUNIT_ASSERT_EQUAL(WrDiskCache::BUFFER_SIZE * 2, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, e.getDataSet().size());
+  CPPUNIT_ASSERT_EQUAL(WrDiskCache::BUFFER_SIZE,
+                       (*e.getDataSet().begin())->capacity);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getNumFreeBuffers());
+  auto size = static_cast<ssize_t>(e.getSize());
+  e.writeToDisk();
+  dc.update(&e, -size);
+  CPPUNIT_ASSERT_EQUAL(data, writer_->getString());
+  // The buffers of BUFFER_SIZE bytes are kept for reuse.
+  CPPUNIT_ASSERT_EQUAL((size_t)2, dc.getNumFreeBuffers());
+  dc.remove(&e);
 }
 
 void WrDiskCacheEntryTest::testClear()
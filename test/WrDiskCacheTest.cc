@@ -1,10 +1,12 @@
 #include "WrDiskCache.h"
 
 #include <cstring>
+#include <vector>
 
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "TestUtil.h"
+#include "WrDiskCacheEntry.h"
 #include "DirectDiskAdaptor.h"
 #include "ByteArrayDiskWriter.h"
 
@@ -14,6 +16,8 @@ class WrDiskCacheTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(WrDiskCacheTest);
   CPPUNIT_TEST(testAdd);
+  CPPUNIT_TEST(testEvictionOrder);
+  CPPUNIT_TEST(testReleaseBuffer);
   CPPUNIT_TEST_SUITE_END();
 
   std::shared_ptr<DirectDiskAdaptor> adaptor_;
@@ -29,6 +33,8 @@ public:
   }
 
   void testAdd();
+  void testEvictionOrder();
+  void testReleaseBuffer();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(WrDiskCacheTest);
@@ -74,4 +80,66 @@ void WrDiskCacheTest::testAdd()
   CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getSize());
 }
 
+void WrDiskCacheTest::testEvictionOrder()
+{
+  WrDiskCache dc(30);
+  std::vector<std::unique_ptr<WrDiskCacheEntry>> entries;
+  const char* data[] = {"a", "bbbbbbbbbb", "ccccc", "dddddddddd", "ee",
+                        "ffffffff", "gggggggggg"};
+  int64_t goff = 0;
+  for (auto s : data) {
+    entries.push_back(make_unique<WrDiskCacheEntry>(adaptor_));
+    entries.back()->cacheData(createDataCell(goff, s));
+    goff += strlen(s);
+  }
+  for (size_t i = 0; i < 5; ++i) {
+    CPPUNIT_ASSERT(dc.add(entries[i].get()));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)28, dc.getSize());
+  CPPUNIT_ASSERT(!dc.add(entries[0].get()));
+  // entries[1] is now more recently updated than entries[3].
+  CPPUNIT_ASSERT(dc.update(entries[1].get(), 0));
+  CPPUNIT_ASSERT(dc.remove(entries[2].get()));
+  CPPUNIT_ASSERT(!dc.remove(entries[2].get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)23, dc.getSize());
+
+  // The largest entry is flushed first.  Among the entries of the
+  // same size, the least recently updated one is flushed first.
+  CPPUNIT_ASSERT(dc.add(entries[5].get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)21, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, entries[3]->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entries[1]->getSize());
+
+  CPPUNIT_ASSERT(dc.add(entries[6].get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)21, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, entries[1]->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, entries[6]->getSize());
+
+  for (auto& e : entries) {
+    dc.remove(e.get());
+    e->clear();
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getSize());
+}
+
+void WrDiskCacheTest::testReleaseBuffer()
+{
+  WrDiskCache dc(WrDiskCache::BUFFER_SIZE * 2);
+  auto a = dc.allocateBuffer();
+  auto b = dc.allocateBuffer();
+  auto c = dc.allocateBuffer();
+  dc.releaseBuffer(a, WrDiskCache::BUFFER_SIZE);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, dc.getNumFreeBuffers());
+  // Other sizes are not kept.
+  dc.releaseBuffer(new unsigned char[10], 10);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, dc.getNumFreeBuffers());
+  CPPUNIT_ASSERT(a == dc.allocateBuffer());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getNumFreeBuffers());
+  dc.releaseBuffer(a, WrDiskCache::BUFFER_SIZE);
+  dc.releaseBuffer(b, WrDiskCache::BUFFER_SIZE);
+  // At most limit / BUFFER_SIZE buffers are kept.
+  dc.releaseBuffer(c, WrDiskCache::BUFFER_SIZE);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, dc.getNumFreeBuffers());
+}
+
 } // namespace aria2
@@ -5,6 +5,7 @@
 #include "DHTNode.h"
 #include <cstring>
 #include <algorithm>
+#include <deque>
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
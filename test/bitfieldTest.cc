@@ -2,6 +2,9 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <vector>
+#include <iterator>
+
 #include "TimerA2.h"
 
 namespace aria2 {
@@ -13,6 +16,13 @@ class bitfieldTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountBit32);
   CPPUNIT_TEST(testCountSetBit);
   CPPUNIT_TEST(testLastByteMask);
+  CPPUNIT_TEST(testCountBit64);
+  CPPUNIT_TEST(testCountSetBitAnd);
+  CPPUNIT_TEST(testAndBits);
+  CPPUNIT_TEST(testForEachSetBit);
+  CPPUNIT_TEST(testForEachChangedBit);
+  CPPUNIT_TEST(testGetFirstSetBitIndex);
+  CPPUNIT_TEST(testGetFirstNSetBitIndex);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -21,6 +31,13 @@ public:
   void testCountBit32();
   void testCountSetBit();
   void testLastByteMask();
+  void testCountBit64();
+  void testCountSetBitAnd();
+  void testAndBits();
+  void testForEachSetBit();
+  void testForEachChangedBit();
+  void testGetFirstSetBitIndex();
+  void testGetFirstNSetBitIndex();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(bitfieldTest);
@@ -71,4 +88,116 @@ void bitfieldTest::testLastByteMask()
                        (unsigned int)bitfield::lastByteMask(16));
 }
 
+void bitfieldTest::testCountBit64()
+{
+  CPPUNIT_ASSERT_EQUAL((size_t)64, bitfield::countBit64(UINT64_MAX));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countBit64(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, bitfield::countBit64(0x8000000000000001ULL));
+}
+
+void bitfieldTest::testCountSetBitAnd()
+{
+  unsigned char a[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                       0xff, 0xff, 0xff, 0xff, 0xff};
+  unsigned char b[] = {0x0f, 0xff, 0xff, 0xff, 0xff, 0xff,
+                       0xff, 0xff, 0xff, 0x00, 0xff};
+  CPPUNIT_ASSERT_EQUAL((size_t)76, bitfield::countSetBitAnd(a, b, 88));
+  CPPUNIT_ASSERT_EQUAL((size_t)71, bitfield::countSetBitAnd(a, b, 83));
+  CPPUNIT_ASSERT_EQUAL((size_t)68, bitfield::countSetBitAnd(a, b, 72));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, bitfield::countSetBitAnd(a, b, 6));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countSetBitAnd(a, b, 0));
+}
+
+void bitfieldTest::testAndBits()
+{
+  unsigned char dst[] = {0xff, 0xff, 0xff, 0xff, 0xff,
+                         0xff, 0xff, 0xff, 0xff, 0xf0};
+  unsigned char src[] = {0x0f, 0x00, 0xff, 0x00, 0x00,
+                         0x00, 0x00, 0x01, 0x80, 0x3c};
+  unsigned char ans1[] = {0x0f, 0x00, 0xff, 0x00, 0x00,
+                          0x00, 0x00, 0x01, 0x80, 0x30};
+  unsigned char ans2[] = {0x00, 0x00, 0x00, 0x00, 0x00,
+                          0x00, 0x00, 0x00, 0x00, 0x00};
+  bitfield::andBits(dst, src, sizeof(dst));
+  CPPUNIT_ASSERT(memcmp(ans1, dst, sizeof(dst)) == 0);
+  bitfield::andNotBits(dst, src, sizeof(dst));
+  CPPUNIT_ASSERT(memcmp(ans2, dst, sizeof(dst)) == 0);
+  memset(dst, 0xff, sizeof(dst));
+  bitfield::andNotBits(dst, src, sizeof(dst));
+  for (size_t i = 0; i < sizeof(dst); ++i) {
+    CPPUNIT_ASSERT_EQUAL((int)(~src[i] & 0xff), (int)dst[i]);
+  }
+}
+
+namespace {
+std::vector<size_t> collectSetBits(const unsigned char* bitfield, size_t nbits)
+{
+  std::vector<size_t> res;
+  bitfield::forEachSetBit(bitfield, nbits,
+                          [&res](size_t index) { res.push_back(index); });
+  return res;
+}
+} // namespace
+
+void bitfieldTest::testForEachSetBit()
+{
+  unsigned char bitfield[] = {0x80, 0x00, 0x00, 0x00, 0x00,
+                              0x00, 0x00, 0x01, 0x00, 0x41};
+  std::vector<size_t> ans{0, 63, 73, 79};
+  CPPUNIT_ASSERT(ans == collectSetBits(bitfield, 80));
+  // Bits beyond nbits are ignored.
+  ans.pop_back();
+  CPPUNIT_ASSERT(ans == collectSetBits(bitfield, 78));
+  ans.pop_back();
+  CPPUNIT_ASSERT(ans == collectSetBits(bitfield, 64));
+  ans.pop_back();
+  CPPUNIT_ASSERT(ans == collectSetBits(bitfield, 63));
+  CPPUNIT_ASSERT(collectSetBits(bitfield, 0).empty());
+}
+
+void bitfieldTest::testForEachChangedBit()
+{
+  unsigned char oldBitfield[] = {0xf0, 0x00, 0x00, 0x00, 0x00,
+                                 0x00, 0x00, 0x00, 0xff, 0x80};
+  unsigned char newBitfield[] = {0x3c, 0x00, 0x00, 0x00, 0x00,
+                                 0x00, 0x00, 0x01, 0x0f, 0xc0};
+  std::vector<size_t> set, unset;
+  bitfield::forEachChangedBit(newBitfield, oldBitfield, 73,
+                              [&set](size_t index) { set.push_back(index); },
+                              [&unset](size_t index) {
+                                unset.push_back(index);
+                              });
+  std::vector<size_t> setAns{4, 5, 63};
+  std::vector<size_t> unsetAns{0, 1, 64, 65, 66, 67};
+  CPPUNIT_ASSERT(setAns == set);
+  CPPUNIT_ASSERT(unsetAns == unset);
+}
+
+void bitfieldTest::testGetFirstSetBitIndex()
+{
+  unsigned char bitfield[] = {0x00, 0x00, 0x10, 0x01};
+  size_t index;
+  CPPUNIT_ASSERT(bitfield::getFirstSetBitIndex(index, bitfield, 32));
+  CPPUNIT_ASSERT_EQUAL((size_t)19, index);
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, bitfield, 19));
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, bitfield, 0));
+}
+
+void bitfieldTest::testGetFirstNSetBitIndex()
+{
+  unsigned char bitfield[] = {0x00, 0x81, 0x10, 0x01};
+  std::vector<size_t> out;
+  CPPUNIT_ASSERT_EQUAL((size_t)3, bitfield::getFirstNSetBitIndex(
+                                      std::back_inserter(out), 3, bitfield, 32));
+  std::vector<size_t> ans{8, 15, 19};
+  CPPUNIT_ASSERT(ans == out);
+  out.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)4, bitfield::getFirstNSetBitIndex(
+                                      std::back_inserter(out), 5, bitfield, 32));
+  CPPUNIT_ASSERT_EQUAL((size_t)31, out.back());
+  out.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, bitfield::getFirstNSetBitIndex(
+                                      std::back_inserter(out), 5, bitfield, 19));
+}
+
 } // namespace aria2